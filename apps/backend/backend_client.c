@@ -42,6 +42,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <inttypes.h>
 #include <errno.h>
 #include <signal.h>
 #include <fcntl.h>
@@ -50,6 +51,7 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/param.h>
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -85,6 +87,199 @@ ce_find_byid(struct client_entry *ce_list,
     return NULL;
 }
 
+/* Input buffers larger than this are freed when empty */
+#define CE_IBUF_KEEP (1024*1024)
+
+static int ce_output_cb(int s, void *arg);
+
+/*! Check if a client entry still exists, ie has not been removed
+ * @param[in] h   Clicon handle
+ * @param[in] ce  Client entry
+ * @retval    1   Exists
+ * @retval    0   Removed, eg by kill-session
+ */
+static int
+ce_exists(clicon_handle        h,
+	  struct client_entry *ce)
+{
+    struct client_entry *c;
+
+    for (c = backend_client_list(h); c; c = c->ce_next)
+	if (c == ce)
+	    return 1;
+    return 0;
+}
+
+/*! Free a message in a client output queue
+ * @param[in]  om   Queued message
+ */
+static int
+ce_outmsg_free(struct ce_outmsg *om)
+{
+    if (om->om_sm)
+	stream_msg_unref(om->om_sm);
+    else if (om->om_data)
+	free(om->om_data);
+    free(om);
+    return 0;
+}
+
+/*! Send a framed message to a client without blocking
+ *
+ * The message is written directly from the io-vector if the output queue is
+ * empty. What could not be written is copied to the output queue and written
+ * from the event loop when the socket is writable, see ce_output_cb.
+ * A shared notification message is referenced by the queue instead of copied.
+ * @param[in]  ce     Client entry
+ * @param[in]  iov    Message as io-vector, eg header and body. Modified by call
+ * @param[in]  iovcnt Number of elements in iov
+ * @param[in]  sm     If set, iov is the single buffer of this shared message
+ * @param[in]  drop   If set, drop message if output queue is full (notifications)
+ * @retval     0      OK, message sent, queued or dropped
+ * @retval    -1      Error, errno set, eg EPIPE if client has closed socket
+ */
+static int
+ce_msg_sendv(struct client_entry *ce,
+	     struct iovec        *iov,
+	     int                  iovcnt,
+	     struct stream_msg   *sm,
+	     int                  drop)
+{
+    int               retval = -1;
+    size_t            len = 0;
+    ssize_t           n = 0;
+    struct ce_outmsg *om = NULL;
+    char             *p;
+    int               i;
+
+    for (i=0; i<iovcnt; i++)
+	len += iov[i].iov_len;
+    if (ce->ce_s == 0) /* closed */
+	goto ok;
+    if (ce->ce_oq == NULL){
+	if ((n = writev(ce->ce_s, iov, iovcnt)) < 0){
+	    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+		clicon_err(OE_PROTO, errno, "writev");
+		goto done;
+	    }
+	    n = 0;
+	}
+	if (n == len){
+	    ce->ce_stat_out++;
+	    goto ok;
+	}
+    }
+    else if (drop && ce->ce_oq_max && ce->ce_oq_bytes + len > ce->ce_oq_max){
+	if (ce->ce_stat_drop++ == 0)
+	    clicon_log(LOG_WARNING, "client %d: output queue full, dropping notifications",
+		       ce->ce_nr);
+	goto ok;
+    }
+    /* Queue what could not be written */
+    if ((om = malloc(sizeof(*om))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(om, 0, sizeof(*om));
+    if (sm){
+	om->om_sm = sm;
+	sm->sm_refcnt++;
+	om->om_data = sm->sm_data;
+	om->om_len = sm->sm_len;
+	om->om_pos = n;
+    }
+    else {
+	om->om_len = len - n;
+	if ((om->om_data = malloc(om->om_len)) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	p = om->om_data;
+	for (i=0; i<iovcnt; i++){
+	    if (n >= iov[i].iov_len){ /* Already written */
+		n -= iov[i].iov_len;
+		continue;
+	    }
+	    memcpy(p, (char*)iov[i].iov_base + n, iov[i].iov_len - n);
+	    p += iov[i].iov_len - n;
+	    n = 0;
+	}
+    }
+    if (ce->ce_oq == NULL &&
+	event_reg_fd_write(ce->ce_s, ce_output_cb, ce, "client output queue") < 0)
+	goto done;
+    ADDQ(om, ce->ce_oq);
+    ce->ce_oq_bytes += om->om_len - om->om_pos;
+    om = NULL;
+    ce->ce_oq_nr++;
+    if (ce->ce_oq_bytes > ce->ce_oq_peak)
+	ce->ce_oq_peak = ce->ce_oq_bytes;
+    clicon_debug(2, "%s client %d queue: %d msgs %zu bytes", __FUNCTION__,
+		 ce->ce_nr, ce->ce_oq_nr, ce->ce_oq_bytes);
+ ok:
+    retval = 0;
+ done:
+    if (om)
+	ce_outmsg_free(om);
+    return retval;
+}
+
+/*! Send header and body of a message to a client, without copying the body
+ * @param[in]  ce      Client entry
+ * @param[in]  data    Message body as byte-string.
+ * @param[in]  datalen Length of body, including null character
+ * @param[in]  drop    If set, drop message if output queue is full
+ * @retval     0       OK
+ * @retval    -1       Error, errno set
+ * @see send_msg_reply
+ */
+static int
+ce_send_msg(struct client_entry *ce,
+	    char                *data,
+	    uint32_t             datalen,
+	    int                  drop)
+{
+    struct clicon_msg hdr;
+    struct iovec      iov[2];
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.op_len = htonl(sizeof(hdr) + datalen);
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = data;
+    iov[1].iov_len = datalen;
+    return ce_msg_sendv(ce, iov, 2, NULL, drop);
+}
+
+/*! Send a notification to a client, dropped if client output queue is full
+ * The event is serialized once and shared by all clients it is sent to
+ * @param[in]  ce      Client entry
+ * @param[in]  xev     Event as XML
+ * @retval     0       OK
+ * @retval    -1       Error, errno set
+ * @see send_msg_notify_xml
+ */
+static int
+ce_send_notify(struct client_entry *ce,
+	       cxobj               *xev)
+{
+    int                retval = -1;
+    struct stream_msg *sm = NULL;
+    struct iovec       iov[1];
+
+    if ((sm = stream_msg_get(xev)) == NULL)
+	goto done;
+    iov[0].iov_base = sm->sm_data;
+    iov[0].iov_len = sm->sm_len;
+    if (ce_msg_sendv(ce, iov, 1, sm, 1) < 0)
+	goto done;
+    retval = 0;
+  done:
+    if (sm)
+	stream_msg_unref(sm);
+    return retval;
+}
+
 /*! Stream callback for netconf stream notification (RFC 5277)
  * @param[in]  h     Clicon handle
  * @param[in]  op    0:event, 1:rm
@@ -108,7 +303,7 @@ ce_event_cb(clicon_handle h,
 	    backend_client_rm(h, ce);
 	break;
     default:
-	if (send_msg_notify_xml(h, ce->ce_s, event) < 0){
+	if (ce_send_notify(ce, event) < 0){
 	    if (errno == ECONNRESET || errno == EPIPE){
 		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
 	    }
@@ -141,7 +336,18 @@ backend_client_rm(clicon_handle        h,
     for (c = *ce_prev; c; c = c->ce_next){
 	if (c == ce){
 	    if (ce->ce_s){
-		event_unreg_fd(ce->ce_s, from_client);
+		if (!ce->ce_iblocked)
+		    event_unreg_fd(ce->ce_s, from_client);
+		if (ce->ce_oq)
+		    event_unreg_fd_write(ce->ce_s, ce_output_cb);
+		if (ce->ce_stat_drop || ce->ce_stat_blocked)
+		    clicon_log(LOG_NOTICE, "client %d closed: in:%d out:%d queue peak:%zu dropped:%d paused:%d",
+			       ce->ce_nr, ce->ce_stat_in, ce->ce_stat_out,
+			       ce->ce_oq_peak, ce->ce_stat_drop, ce->ce_stat_blocked);
+		else
+		    clicon_debug(1, "%s client %d in:%d out:%d queue peak:%zu",
+				 __FUNCTION__, ce->ce_nr, ce->ce_stat_in, ce->ce_stat_out,
+				 ce->ce_oq_peak);
 		close(ce->ce_s);
 		ce->ce_s = 0;
 	    }
@@ -152,6 +358,35 @@ backend_client_rm(clicon_handle        h,
     return backend_client_delete(h, ce); /* actually purge it */
 }
 
+/*! Get output queue state of all backend clients
+ * @param[in]  h    Clicon handle
+ * @param[out] cb   <backend-clients> element
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon-lib.yang backend-clients
+ */
+static int
+client_queue_state(clicon_handle h,
+		   cbuf         *cb)
+{
+    struct client_entry *ce;
+
+    cprintf(cb, "<backend-clients xmlns=\"http://clicon.org/lib\">");
+    for (ce = backend_client_list(h); ce; ce = ce->ce_next){
+	cprintf(cb, "<client><number>%d</number><session-id>%d</session-id>",
+		ce->ce_nr, ce->ce_id);
+	cprintf(cb, "<in-msgs>%d</in-msgs><out-msgs>%d</out-msgs>",
+		ce->ce_stat_in, ce->ce_stat_out);
+	cprintf(cb, "<queue-msgs>%d</queue-msgs><queue-bytes>%zu</queue-bytes><queue-peak>%zu</queue-peak>",
+		ce->ce_oq_nr, ce->ce_oq_bytes, ce->ce_oq_peak);
+	cprintf(cb, "<dropped>%d</dropped><paused>%d</paused>",
+		ce->ce_stat_drop, ce->ce_stat_blocked);
+	cprintf(cb, "</client>");
+    }
+    cprintf(cb, "</backend-clients>");
+    return 0;
+}
+
 /*!
  * Maybe should be in the restconf client instead of backend?
  * @param[in]     h       Clicon handle
@@ -181,6 +416,8 @@ client_get_capabilities(clicon_handle h,
 	goto done;
     if (xml_parse_va(&xcap, yspec, "<capability>urn:ietf:params:restconf:capability:depth:1.0</capability>") < 0)
 	goto done;
+    if (xml_parse_va(&xcap, yspec, "<capability>urn:ietf:params:restconf:capability:with-defaults:1.0</capability>") < 0)
+	goto done;
     retval = 0;
  done:
     return retval;
@@ -271,6 +508,7 @@ client_statedata(clicon_handle h,
     yang_stmt *ymod;
     int        ret;
     char      *namespace;
+    cbuf      *cb = NULL;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
@@ -316,6 +554,24 @@ client_statedata(clicon_handle h,
 	if (ret == 0)
 	    goto fail;
     }
+    /* Value indexes of datastores, see CLICON_XMLDB_VALUE_INDEX */
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (xmldb_index_state(h, cb) < 0)
+	goto done;
+    if (cbuf_len(cb) &&
+	xml_parse_va(xret, yspec, "%s", cbuf_get(cb)) < 0)
+	goto done;
+    /* Output queues of backend clients, see CLICON_BACKEND_QUEUE_MAX */
+    if (clicon_option_bool(h, "CLICON_BACKEND_CLIENT_STATE")){
+	cbuf_reset(cb);
+	if (client_queue_state(h, cb) < 0)
+	    goto done;
+	if (xml_parse_va(xret, yspec, "%s", cbuf_get(cb)) < 0)
+	    goto done;
+    }
     if ((ret = clixon_plugin_statedata(h, yspec, nsc, xpath, xret)) < 0)
 	goto done;
     if (ret == 0)
@@ -344,6 +600,8 @@ client_statedata(clicon_handle h,
     retval = 1; /* OK */
  done:
     clicon_debug(1, "%s %d", __FUNCTION__, retval);
+    if (cb)
+	cbuf_free(cb);
     if (xvec)
 	free(xvec);
     return retval;
@@ -352,6 +610,56 @@ client_statedata(clicon_handle h,
     goto done;
 }
 
+/*! Get with-defaults mode of get and get-config request
+ *
+ * RFC 6243 Sec 4.5.1 <with-defaults> parameter, or Clixon extension with-defaults
+ * attribute with the same values
+ * @param[in]  xe      Request: <get-config>, <get>
+ * @param[out] cbret   Return xml tree, eg <rpc-error.. if ret is 0
+ * @param[out] wdef    With-defaults mode, report-all if not given
+ * @retval     1       OK
+ * @retval     0       Invalid value, error message in cbret
+ * @retval    -1       Error
+ */
+static int
+from_client_withdefaults(cxobj                  *xe,
+			 cbuf                   *cbret,
+			 enum withdefaults_type *wdef)
+{
+    cxobj *x;
+    char  *ns = NULL;
+    char  *str = NULL;
+    int    val;
+
+    if ((x = xml_find_type(xe, NULL, "with-defaults", CX_ELMNT)) != NULL){
+	if (xml2ns(x, xml_prefix(x), &ns) < 0)
+	    return -1;
+	if (ns == NULL || strcmp(ns, NETCONF_WITHDEFAULTS_NAMESPACE) != 0)
+	    x = NULL;
+    }
+    if (x != NULL){
+	if ((str = xml_body(x)) == NULL ||
+	    (val = netconf_withdefaults_str2int(str)) == -1){
+	    if (netconf_bad_element(cbret, "application", "with-defaults",
+				    "Unrecognized value of with-defaults parameter") < 0)
+		return -1;
+	    return 0;
+	}
+    }
+    else{
+	if ((str = xml_find_type_value(xe, NULL, "with-defaults", CX_ATTR)) == NULL)
+	    return 1;
+	if ((val = netconf_withdefaults_str2int(str)) == -1){
+	    if (netconf_bad_attribute(cbret, "application",
+				      "<bad-attribute>with-defaults</bad-attribute>", "Unrecognized value of with-defaults attribute") < 0)
+		return -1;
+	    return 0;
+	}
+    }
+    *wdef = val;
+    return 1;
+}
+
 /*! Retrieve all or part of a specified configuration.
  * 
  * @param[in]  h       Clicon handle 
@@ -382,6 +690,7 @@ from_client_get_config(clicon_handle h,
     char   *username;
     cvec   *nsc = NULL; /* Create a netconf namespace context from filter */
     yang_stmt *yspec;
+    enum withdefaults_type wdef = WITHDEFAULTS_REPORT_ALL;
     
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -421,6 +730,11 @@ from_client_get_config(clicon_handle h,
 	    xml_nsctx_free(nsc);
 	nsc = nsc1;
     }
+    /* RFC 6243 with-defaults */
+    if ((ret = from_client_withdefaults(xe, cbret, &wdef)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
     /* Note xret can be pruned by nacm below (and change name),
      * so zero-copy cant be used
      * Also, must use external namespace context here due to <filter stmt
@@ -446,7 +760,7 @@ from_client_get_config(clicon_handle h,
     else{
 	if (xml_name_set(xret, "data") < 0)
 	    goto done;
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, -1) < 0)
+	if (clicon_xml2cbuf_wdef(cbret, xret, 0, 0, -1, wdef) < 0)
 	    goto done;
     }
     cprintf(cbret, "</rpc-reply>");
@@ -500,6 +814,7 @@ from_client_edit_config(clicon_handle h,
     int                 ret;
     char               *username;
     cxobj              *xret = NULL;
+    cxobj              *xch;
 
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -570,7 +885,23 @@ from_client_edit_config(clicon_handle h,
 	 */
 	if (xml_apply0(xc, CX_ELMNT, xml_sort, h) < 0)
 	    goto done;
-	if ((ret = xmldb_put(h, target, operation, xc, username, cbret)) < 0){
+	/* The request is parsed into an arena, whose nodes are copied, not moved,
+	 * into the datastore. Replace config with a heap copy so that new subtrees
+	 * are moved (bulk load), see text_modify. The copy stays in the request,
+	 * for namespace context, and is freed with it */
+	if (xml_arena_get(xc) != NULL){
+	    if ((xch = xml_dup(xc)) == NULL)
+		goto done;
+	    if (xml_addsub(xml_parent(xc), xch) < 0){
+		xml_free(xch);
+		goto done;
+	    }
+	    if (xml_purge(xc) < 0)
+		goto done;
+	    xc = xch;
+	}
+	/* xc is not used after this, new subtrees are moved to the datastore */
+	if ((ret = xmldb_put_move(h, target, operation, xc, username, cbret)) < 0){
 	    clicon_debug(1, "%s ERROR PUT", __FUNCTION__);	
 	    if (netconf_operation_failed(cbret, "protocol", clicon_err_reason)< 0)
 		goto done;
@@ -866,6 +1197,96 @@ from_client_unlock(clicon_handle h,
     return retval;
 }
 
+/*! Get generation and modification time of the NACM rules
+ * The generation of the nacm subtree of running if internal, or the modification
+ * time of CLICON_NACM_FILE if external.
+ * @param[in]  h     Clicon handle 
+ * @param[out] ngen  Generation of NACM rules, 0 if NACM is disabled
+ * @param[out] ntv   Time of last modification of NACM rules, 0 if NACM is disabled
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+client_nacm_generation(clicon_handle   h,
+		       uint64_t       *ngen,
+		       struct timeval *ntv)
+{
+    int         retval = -1;
+    char       *mode;
+    char       *filename;
+    struct stat st;
+
+    *ngen = 0;
+    timerclear(ntv);
+    if ((mode = clicon_option_str(h, "CLICON_NACM_MODE")) != NULL){
+	if (strcmp(mode, "internal") == 0){
+	    if (xmldb_generation(h, "running", "ietf-netconf-acm:nacm", ngen, ntv) < 0)
+		goto done;
+	}
+	else if (strcmp(mode, "external") == 0 &&
+		 (filename = clicon_option_str(h, "CLICON_NACM_FILE")) != NULL &&
+		 stat(filename, &st) == 0){
+	    *ngen = (uint64_t)st.st_mtime;
+	    ntv->tv_sec = st.st_mtime;
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add generation and modification time of running config as attributes of get reply
+ * The NACM rules are also covered, see client_nacm_generation().
+ * Used by restconf for entity-tags without a separate generation rpc.
+ * @param[in]  h        Clicon handle 
+ * @param[in]  subtree  Top-level subtree, <module>:<name>, or NULL for whole datastore
+ * @param[in]  xd       Reply data, eg <data generation="12" nacm-generation="3" modified="1584...">
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xmldb_generation
+ */
+static int
+client_get_generation(clicon_handle h,
+		      char         *subtree,
+		      cxobj        *xd)
+{
+    int            retval = -1;
+    uint64_t       gen;
+    struct timeval tv;
+    uint64_t       ngen;
+    struct timeval ntv;
+    cxobj         *xa;
+    char           str[32];
+
+    if (xmldb_generation(h, "running", subtree, &gen, &tv) < 0)
+	goto done;
+    if (client_nacm_generation(h, &ngen, &ntv) < 0)
+	goto done;
+    if (ntv.tv_sec > tv.tv_sec)
+	tv = ntv;
+    if ((xa = xml_new("generation", xd, NULL)) == NULL)
+	goto done;
+    xml_type_set(xa, CX_ATTR);
+    snprintf(str, sizeof(str), "%" PRIu64, gen);
+    if (xml_value_set(xa, str) < 0)
+	goto done;
+    if ((xa = xml_new("nacm-generation", xd, NULL)) == NULL)
+	goto done;
+    xml_type_set(xa, CX_ATTR);
+    snprintf(str, sizeof(str), "%" PRIu64, ngen);
+    if (xml_value_set(xa, str) < 0)
+	goto done;
+    if ((xa = xml_new("modified", xd, NULL)) == NULL)
+	goto done;
+    xml_type_set(xa, CX_ATTR);
+    snprintf(str, sizeof(str), "%ld", (long)tv.tv_sec);
+    if (xml_value_set(xa, str) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Retrieve running configuration and device state information.
  * 
  * @param[in]  h       Clicon handle 
@@ -898,7 +1319,9 @@ from_client_get(clicon_handle h,
     char   *attr;
     netconf_content content = CONTENT_ALL;
     int32_t depth = -1; /* Nr of levels to print, -1 is all, 0 is none */
+    enum withdefaults_type wdef = WITHDEFAULTS_REPORT_ALL;
     yang_stmt *yspec;
+    char   *generation;
     
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -923,9 +1346,14 @@ from_client_get(clicon_handle h,
 	    xml_nsctx_free(nsc);
 	nsc = nsc1;
     }
-    /* Clixon extensions: depth and content */
+    /* Clixon extensions: depth, content and generation. And RFC 6243 with-defaults */
     if ((attr = xml_find_value(xe, "content")) != NULL)
 	content = netconf_content_str2int(attr);
+    generation = xml_find_value(xe, "generation");
+    if ((ret = from_client_withdefaults(xe, cbret, &wdef)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
     
     if ((attr = xml_find_value(xe, "depth")) != NULL){
 	    char *reason = NULL;
@@ -973,6 +1401,14 @@ from_client_get(clicon_handle h,
 	if (nacm_datanode_read(xret, xvec, xlen, username, xnacm) < 0) 
 	    goto done;
     }
+    /* Clixon extension: generation="<module>:<name>" of top-level subtree or "/" */
+    if (generation != NULL){
+	if (xret == NULL &&
+	    (xret = xml_new("data", NULL, NULL)) == NULL)
+	    goto done;
+	if (client_get_generation(h, strcmp(generation, "/")==0?NULL:generation, xret) < 0)
+	    goto done;
+    }
     cprintf(cbret, "<rpc-reply>");     /* OK */
     if (xret==NULL)
 	cprintf(cbret, "<data/>");
@@ -980,7 +1416,7 @@ from_client_get(clicon_handle h,
 	if (xml_name_set(xret, "data") < 0)
 	    goto done;
 	/* Top level is data, so add 1 to depth if significant */
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
+	if (clicon_xml2cbuf_wdef(cbret, xret, 0, 0, depth>0?depth+1:depth, wdef) < 0)
 	    goto done;
     }
     cprintf(cbret, "</rpc-reply>");
@@ -1238,6 +1674,69 @@ from_client_ping(clicon_handle h,
     return 0;
 }
 
+/*! Get generation of a datastore or of a top-level subtree of a datastore
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * Generation changes whenever the (sub)tree is modified, used as entity-tag by restconf.
+ * The generation of the NACM rules is also returned, see client_nacm_generation().
+ * @see xmldb_generation
+ */
+static int
+from_client_generation(clicon_handle h,
+		       cxobj        *xe,
+		       cbuf         *cbret,
+		       void         *arg,
+		       void         *regarg)
+{
+    int            retval = -1;
+    char          *db;
+    char          *subtree;
+    uint64_t       gen;
+    struct timeval tv;
+    uint64_t       ngen;
+    struct timeval ntv;
+    cbuf          *cbx = NULL;
+
+    if ((db = xml_find_body(xe, "datastore")) == NULL)
+	db = "running";
+    if (xmldb_validate_db(db) < 0){
+	if ((cbx = cbuf_new()) == NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new");
+	    goto done;
+	}	
+	cprintf(cbx, "No such database: %s", db);
+	if (netconf_invalid_value(cbret, "protocol", cbuf_get(cbx))< 0)
+	    goto done;
+	goto ok;
+    }
+    subtree = xml_find_body(xe, "subtree");
+    if (xmldb_generation(h, db, subtree, &gen, &tv) < 0)
+	goto done;
+    if (client_nacm_generation(h, &ngen, &ntv) < 0)
+	goto done;
+    if (ntv.tv_sec > tv.tv_sec)
+	tv = ntv;
+    cprintf(cbret, "<rpc-reply>");
+    cprintf(cbret, "<generation xmlns=\"http://clicon.org/lib\">%" PRIu64 "</generation>",
+	    gen);
+    cprintf(cbret, "<nacm-generation xmlns=\"http://clicon.org/lib\">%" PRIu64 "</nacm-generation>",
+	    ngen);
+    cprintf(cbret, "<modified xmlns=\"http://clicon.org/lib\">%ld</modified>",
+	    (long)tv.tv_sec);
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (cbx)
+	cbuf_free(cbx);
+    return retval;
+}
+
 /*! Verify nacm user with  peer uid credentials
  * @param[in]  mode      Peer credential mode: none, exact or except
  * @param[in]  peername  Peer username if any
@@ -1360,7 +1859,10 @@ from_client_msg(clicon_handle        h,
 	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
     }
-    /* Decode msg from client -> xml top (ct) and session id */
+    /* Decode msg from client -> xml top (ct) and session id 
+     * The request is parsed into an arena, it is freed after the reply */
+    if ((xt = xml_new_arena("top", NULL)) == NULL)
+	goto done;
     if (clicon_msg_decode(msg, yspec, &id, &xt) < 0){
 	if (netconf_malformed_message(cbret, "XML parse error")< 0)
 	    goto done;
@@ -1448,9 +1950,12 @@ from_client_msg(clicon_handle        h,
 	if (netconf_operation_failed(cbret, "application", clicon_errno?clicon_err_reason:"unknown")< 0)
 	    goto done;
     clicon_debug(1, "%s cbret:%s", __FUNCTION__, cbuf_get(cbret));
+    /* Client may have been removed, eg by killing its own session */
+    if (!ce_exists(h, ce))
+	goto ok;
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
+    if (ce_send_msg(ce, cbuf_get(cbret), cbuf_len(cbret)+1, 0) < 0){
 	switch (errno){
 	case EPIPE:
 	    /* man (2) write: 
@@ -1467,7 +1972,7 @@ from_client_msg(clicon_handle        h,
 	    goto done;
 	}
     }
-    // ok:
+  ok:
     retval = 0;
   done:  
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
@@ -1487,7 +1992,188 @@ from_client_msg(clicon_handle        h,
     return retval;// -1 here terminates backend
 }
 
-/*! An internal clicon message has arrived from a client. Receive and dispatch.
+/*! Read what is available on a non-blocking client socket into its input buffer
+ * @param[in]  ce   Client entry
+ * @retval     0    OK, ce_ieof is set if client has closed the socket
+ * @retval    -1    Error
+ */
+static int
+ce_input_read(struct client_entry *ce)
+{
+    ssize_t n;
+    size_t  imax;
+
+    /* Move partial message not yet dispatched to start of buffer */
+    if (ce->ce_ioff){
+	ce->ce_ilen -= ce->ce_ioff;
+	memmove(ce->ce_ibuf, ce->ce_ibuf + ce->ce_ioff, ce->ce_ilen);
+	ce->ce_ioff = 0;
+    }
+    while (1){
+	if (ce->ce_imax - ce->ce_ilen < BUFSIZ){
+	    imax = ce->ce_imax?2*ce->ce_imax:4*BUFSIZ;
+	    if ((ce->ce_ibuf = realloc(ce->ce_ibuf, imax)) == NULL){
+		clicon_err(OE_UNIX, errno, "realloc");
+		return -1;
+	    }
+	    ce->ce_imax = imax;
+	}
+	if ((n = read(ce->ce_s, ce->ce_ibuf + ce->ce_ilen, 
+		      ce->ce_imax - ce->ce_ilen)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		break;
+	    if (errno == ECONNRESET){ /* Connection reset by peer */
+		ce->ce_ieof = 1;
+		break;
+	    }
+	    clicon_err(OE_PROTO, errno, "read");
+	    return -1;
+	}
+	if (n == 0){
+	    ce->ce_ieof = 1;
+	    break;
+	}
+	ce->ce_ilen += n;
+	if (ce->ce_ilen < ce->ce_imax) /* Short read: nothing more to read */
+	    break;
+    }
+    return 0;
+}
+
+/*! Dispatch all complete messages in the input buffer of a client
+ *
+ * Dispatched messages are skipped with ce_ioff, the buffer is compacted on
+ * next read, see ce_input_read.
+ * If the output queue of the client grows beyond its limit (the client does
+ * not read its replies), input from the client is paused until ce_output_cb
+ * has drained the queue.
+ * @param[in]  h    Clicon handle
+ * @param[in]  ce   Client entry, may be removed when function returns
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ce_input_dispatch(clicon_handle        h,
+		  struct client_entry *ce)
+{
+    int                retval = -1;
+    struct clicon_msg *msg;
+    uint32_t           mlen;
+
+    while (ce->ce_ilen - ce->ce_ioff >= sizeof(*msg)){
+	msg = (struct clicon_msg *)(ce->ce_ibuf + ce->ce_ioff);
+	mlen = ntohl(msg->op_len);
+	if (mlen <= sizeof(*msg)){
+	    clicon_log(LOG_WARNING, "client %d: bad message length %u", 
+		       ce->ce_nr, mlen);
+	    backend_client_rm(h, ce);
+	    goto ok;
+	}
+	if (ce->ce_ilen - ce->ce_ioff < mlen)
+	    break; /* Partial message, wait for more input */
+	if (debug > 1)
+	    clicon_debug(2, "%s: rcv msg len=%d", __FUNCTION__, mlen);
+	ce->ce_stat_in++;
+	if (from_client_msg(h, ce, msg) < 0)
+	    goto done;
+	if (!ce_exists(h, ce))
+	    goto ok;
+	/* Skip message in input buffer */
+	ce->ce_ioff += mlen;
+	if (ce->ce_oq_max && ce->ce_oq_bytes > ce->ce_oq_max){
+	    if (!ce->ce_iblocked){
+		ce->ce_iblocked = 1;
+		ce->ce_stat_blocked++;
+		event_unreg_fd(ce->ce_s, from_client);
+		clicon_debug(1, "%s client %d: output queue full, input paused",
+			     __FUNCTION__, ce->ce_nr);
+	    }
+	    goto ok;
+	}
+    }
+    if (ce->ce_ieof){
+	backend_client_rm(h, ce);
+	goto ok;
+    }
+    if (ce->ce_ioff == ce->ce_ilen){
+	ce->ce_ilen = 0;
+	ce->ce_ioff = 0;
+    }
+    if (ce->ce_ilen == 0 && ce->ce_imax > CE_IBUF_KEEP){
+	free(ce->ce_ibuf);
+	ce->ce_ibuf = NULL;
+	ce->ce_imax = 0;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Write queued output to a client when its socket is writable
+ *
+ * Deregisters itself when the queue is empty, and resumes paused input when
+ * the queue has drained below half its limit. A write error other than EINTR
+ * or EAGAIN closes the client.
+ * @param[in]   s    Client socket
+ * @param[in]   arg  Client entry
+ * @retval      0    OK
+ * @retval      -1   Error Terminates backend
+ * @see ce_msg_sendv
+ */
+static int
+ce_output_cb(int   s, 
+	     void *arg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    clicon_handle        h = ce->ce_handle;
+    struct ce_outmsg    *om;
+    ssize_t              n;
+
+    while ((om = ce->ce_oq) != NULL){
+	if ((n = write(s, om->om_data + om->om_pos, om->om_len - om->om_pos)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		break;
+	    /* Close the client, not the backend, on other errors */
+	    if (errno == EPIPE || errno == ECONNRESET)
+		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+	    else
+		clicon_log(LOG_WARNING, "client %d write: %s", ce->ce_nr, strerror(errno));
+	    backend_client_rm(h, ce);
+	    goto ok;
+	}
+	om->om_pos += n;
+	ce->ce_oq_bytes -= n;
+	if (om->om_pos < om->om_len)
+	    break; /* Socket is full */
+	DELQ(om, ce->ce_oq, struct ce_outmsg *);
+	ce_outmsg_free(om);
+	ce->ce_oq_nr--;
+	ce->ce_stat_out++;
+    }
+    if (ce->ce_oq == NULL)
+	event_unreg_fd_write(s, ce_output_cb);
+    if (ce->ce_iblocked && ce->ce_oq_bytes <= ce->ce_oq_max/2){
+	ce->ce_iblocked = 0;
+	if (event_reg_fd(s, from_client, (void*)ce, "local netconf client socket") < 0)
+	    goto done;
+	clicon_debug(1, "%s client %d: input resumed", __FUNCTION__, ce->ce_nr);
+	/* Messages may be waiting in input buffer */
+	if (ce_input_dispatch(h, ce) < 0)
+	    goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Input has arrived from a client. Receive and dispatch all complete messages
  * @param[in]   s    Socket where message arrived. read from this.
  * @param[in]   arg  Client entry (from).
  * @retval      0    OK
@@ -1499,25 +2185,17 @@ from_client(int   s,
 	    void* arg)
 {
     int                  retval = -1;
-    struct clicon_msg   *msg = NULL;
     struct client_entry *ce = (struct client_entry *)arg;
     clicon_handle        h = ce->ce_handle;
-    int                  eof;
 
     clicon_debug(1, "%s", __FUNCTION__);
-    // assert(s == ce->ce_s);
-    if (clicon_msg_rcv(ce->ce_s, &msg, &eof) < 0)
+    if (ce_input_read(ce) < 0)
+	goto done;
+    if (ce_input_dispatch(h, ce) < 0)
 	goto done;
-    if (eof)
-	backend_client_rm(h, ce); 
-    else
-	if (from_client_msg(h, ce, msg) < 0)
-	    goto done;
     retval = 0;
   done:
     clicon_debug(1, "%s retval=%d", __FUNCTION__, retval);
-    if (msg)
-	free(msg);
     return retval; /* -1 here terminates backend */
 }
 
@@ -1587,6 +2265,9 @@ backend_rpc_init(clicon_handle h)
     if (rpc_callback_register(h, from_client_ping, NULL,
 			      "http://clicon.org/lib", "ping") < 0)
 	goto done;
+    if (rpc_callback_register(h, from_client_generation, NULL,
+			      "http://clicon.org/lib", "generation") < 0)
+	goto done;
     retval =0;
  done:
     return retval;
@@ -38,9 +38,23 @@
 /*
  * Types
  */ 
+/*
+ * Message waiting in the output queue of a client
+ */
+struct ce_outmsg{
+    qelem_t               om_qelem;   /* List header */
+    char                 *om_data;    /* Framed message, malloced if not om_sm */
+    size_t                om_len;     /* Length of message */
+    size_t                om_pos;     /* Bytes already written */
+    struct stream_msg    *om_sm;      /* Shared notification, referenced */
+};
+
 /*
  * Client entry.
  * Keep state about every connected client.
+ * The client socket is non-blocking: input is reassembled into complete
+ * messages in ce_ibuf, and output that cannot be written directly is queued
+ * in ce_oq and written when the socket becomes writable.
  */
 struct client_entry{
     struct client_entry  *ce_next;    /* The clients linked list */
@@ -52,6 +66,20 @@ struct client_entry{
     int                   ce_id;      /* Session id */
     char                 *ce_username;/* Translated from peer user cred */
     clicon_handle         ce_handle;  /* clicon config handle (all clients have same?) */
+    char                 *ce_ibuf;    /* Input buffer of partial messages */
+    size_t                ce_ilen;    /* Bytes in input buffer */
+    size_t                ce_ioff;    /* Bytes of input buffer dispatched */
+    size_t                ce_imax;    /* Allocated size of input buffer */
+    int                   ce_ieof;    /* Client has closed its socket */
+    int                   ce_iblocked;/* Input paused, output queue is full */
+    struct ce_outmsg     *ce_oq;      /* Output queue */
+    size_t                ce_oq_bytes;/* Bytes in output queue */
+    int                   ce_oq_nr;   /* Messages in output queue */
+    size_t                ce_oq_peak; /* Max bytes in output queue (stats) */
+    size_t                ce_oq_max;  /* Output queue limit, see 
+					 CLICON_BACKEND_QUEUE_MAX */
+    int                   ce_stat_drop;/* Nr of dropped notifications */
+    int                   ce_stat_blocked; /* Nr of times input was paused */
 };
 
 
@@ -692,6 +692,10 @@ main(int    argc,
     /* Connect to plugin to get a handle */
     if (xmldb_connect(h) < 0)
 	goto done;
+    /* Datastore change notifications, eg used by restconf response cache */
+    if (clicon_option_bool(h, "CLICON_XMLDB_CHANGE_STREAM") &&
+	stream_add(h, XMLDB_CHANGE_STREAM, "Clixon datastore changes", 0, NULL) < 0)
+	goto done;
 
     /* Add (hardcoded) netconf features in case ietf-netconf loaded here
      * Otherwise it is loaded in netconf_module_load below
@@ -244,9 +244,17 @@ backend_accept_client(int   fd,
 	clicon_err(OE_UNIX, errno, "accept");
 	goto done;
     }
+    /* Client socket is non-blocking, see from_client and ce_output_cb */
+    if (fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	close(s);
+	goto done;
+    }
     if ((ce = backend_client_add(h, &from)) == NULL)
 	goto done;
     ce->ce_handle = h;
+    if (clicon_option_exists(h, "CLICON_BACKEND_QUEUE_MAX"))
+	ce->ce_oq_max = clicon_option_int(h, "CLICON_BACKEND_QUEUE_MAX");
 
     /* 
      * Get credentials of connected peer - only for unix socket 
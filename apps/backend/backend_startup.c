@@ -181,8 +181,8 @@ load_extraxml(clicon_handle h,
     /* Replace parent w first child */
     if (xml_rootchild(xt, 0, &xt) < 0)
 	goto done;
-    /* Merge user reset state */
-    retval = xmldb_put(h, (char*)db, OP_MERGE, xt, clicon_username_get(h), cbret);
+    /* Merge user reset state, xt is freed after */
+    retval = xmldb_put_move(h, (char*)db, OP_MERGE, xt, clicon_username_get(h), cbret);
  done:
     if (fd != -1)
 	close(fd);
@@ -171,6 +171,7 @@ backend_client_delete(clicon_handle        h,
     struct client_entry   *c;
     struct client_entry  **ce_prev;
     struct backend_handle *bh = handle(h);
+    struct ce_outmsg      *om;
 
     ce_prev = &bh->bh_ce_list;
     for (c = *ce_prev; c; c = c->ce_next){
@@ -178,6 +179,16 @@ backend_client_delete(clicon_handle        h,
 	    *ce_prev = c->ce_next;
 	    if (ce->ce_username)
 		free(ce->ce_username);
+	    if (ce->ce_ibuf)
+		free(ce->ce_ibuf);
+	    while ((om = ce->ce_oq) != NULL){
+		DELQ(om, ce->ce_oq, struct ce_outmsg *);
+		if (om->om_sm)
+		    stream_msg_unref(om->om_sm);
+		else
+		    free(om->om_data);
+		free(om);
+	    }
 	    free(ce);
 	    break;
 	}
@@ -188,6 +188,36 @@ transaction_clen(transaction_data td)
   return ((transaction_data_t *)td)->td_clen;
 }
 
+/*! Get value of a child leaf of a node in a transaction tree, or its default value
+ * Default values are not added to the transaction trees. If the leaf is absent
+ * and has a yang default, the default value is returned.
+ * @param[in]  x     XML node in a transaction tree, eg from transaction_target()
+ * @param[in]  name  Name of child leaf
+ * @retval     str   Value of leaf, or default value. Do not free
+ * @retval     NULL  No such leaf and no default value, or error
+ * @code
+ *   if ((enabled = transaction_default_get(xif, "enabled")) != NULL &&
+ *       strcmp(enabled, "true") == 0)
+ *      ...
+ * @endcode
+ * @see xml_default_child  Virtual default leaf, also seen by XPath
+ */
+char *
+transaction_default_get(cxobj *x,
+			char  *name)
+{
+    cxobj     *xc;
+    yang_stmt *y;
+
+    if ((xc = xml_find_type(x, NULL, name, CX_ELMNT)) != NULL)
+	return xml_body(xc);
+    if ((y = xml_default_leaf(x, name)) == NULL)
+	return NULL;
+    if (xml_default_child(x, y, &xc) < 0)
+	return NULL;
+    return xml_body(xc);
+}
+
 /*! Print transaction on FILE for debug
  * @see transaction_log
  */
@@ -58,6 +58,7 @@ size_t  transaction_alen(transaction_data td);
 cxobj **transaction_scvec(transaction_data td);
 cxobj **transaction_tcvec(transaction_data td);
 size_t  transaction_clen(transaction_data td);
+char   *transaction_default_get(cxobj *x, char *name);
 
 int transaction_print(FILE *f, transaction_data th);
 int transaction_log(clicon_handle h, transaction_data th, int level, const char *id);
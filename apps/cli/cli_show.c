@@ -482,7 +482,7 @@ cli_show_config1(clicon_handle h,
 	    clicon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
 	    goto done;
 	}
-	if (clicon_rpc_get(h, cbuf_get(cbxpath), nsc, CONTENT_ALL, -1, &xt) < 0)
+	if (clicon_rpc_get(h, cbuf_get(cbxpath), nsc, CONTENT_ALL, -1, WITHDEFAULTS_REPORT_ALL, &xt) < 0)
 	    goto done;
     }
     if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
@@ -732,7 +732,7 @@ cli_show_auto1(clicon_handle h,
 	    clicon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
 	    goto done;
 	}
-	if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, &xt) < 0)
+	if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, WITHDEFAULTS_REPORT_ALL, &xt) < 0)
 	    goto done;
     }
 
@@ -180,6 +180,10 @@ xml_filter_recursive(cxobj *xfilter,
 	}
 	sprev = s;
     }
+    /* Containment node without selected children is not included, as when 
+     * translated to xpath, see xml_filter2xpath */
+    if (xml_child_nr_type(xparent, CX_ELMNT) == 0)
+	goto nomatch;
 
   match:
     return 0;
@@ -209,3 +213,206 @@ xml_filter(cxobj *xfilter,
     return retval;
 }
 
+
+/*! Check that a filter node only has namespace declaration attributes
+ * Attribute match nodes are not translated to xpath
+ */
+static int
+filter_xmlns_only(cxobj *xf)
+{
+    cxobj *xa = NULL;
+    char  *prefix;
+
+    while ((xa = xml_child_each(xf, xa, CX_ATTR)) != NULL) {
+	prefix = xml_prefix(xa);
+	if (prefix == NULL && strcmp(xml_name(xa), "xmlns") == 0)
+	    continue;
+	if (prefix && strcmp(prefix, "xmlns") == 0)
+	    continue;
+	return 0;
+    }
+    return 1;
+}
+
+/* Return value of content match node, NULL if selection or containment node
+ * Unlike leafstring, namespace declarations and whitespace are allowed
+ */
+static char *
+filter_content(cxobj *xf)
+{
+    cxobj *xb;
+    char  *val;
+
+    if (xml_child_each(xf, NULL, CX_ELMNT) != NULL)
+	return NULL;
+    if ((xb = xml_body_get(xf)) == NULL ||
+	(val = xml_value(xb)) == NULL)
+	return NULL;
+    if (strspn(val, " \t\r\n") == strlen(val))
+	return NULL;
+    return val;
+}
+
+/*! Get xpath node test of filter node, ie <prefix>:<name>
+ * A prefix is generated for each namespace of the filter.
+ * @retval  1   OK, nodetest in cb
+ * @retval  0   No data namespace
+ * @retval -1   Error
+ */
+static int
+filter_nodetest(cxobj *xf,
+		cvec  *nsc,
+		cbuf  *cb)
+{
+    int   retval = -1;
+    char *ns = NULL;
+    char *prefix = NULL;
+    char  pbuf[16];
+
+    if (xml2ns(xf, xml_prefix(xf), &ns) < 0)
+	goto done;
+    /* No namespace, or inherited from <rpc> */
+    if (ns == NULL || strcmp(ns, NETCONF_BASE_NAMESPACE) == 0)
+	goto fail;
+    if (xml_nsctx_get_prefix(nsc, ns, &prefix) == 0){
+	snprintf(pbuf, sizeof(pbuf), "nf%d", cvec_len(nsc));
+	if (xml_nsctx_add(nsc, pbuf, ns) < 0)
+	    goto done;
+	prefix = pbuf;
+    }
+    cprintf(cb, "%s:%s", prefix, xml_name(xf));
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Internal recursive part of xml_filter2xpath
+ * @param[in]  xf    Selection or containment node in filter
+ * @param[in]  path  Location path of parent of xf
+ * @param[in]  nsc   Namespace context, prefixes are added
+ * @param[out] cb    Union of location paths
+ * @retval     1     OK
+ * @retval     0     Filter cannot be translated
+ * @retval    -1     Error
+ */
+static int
+filter2xpath_recursive(cxobj *xf,
+		       char  *path,
+		       cvec  *nsc,
+		       cbuf  *cb)
+{
+    int    retval = -1;
+    cbuf  *cbp = NULL;
+    cxobj *f;
+    char  *val;
+    int    containments = 0;
+    int    ret;
+
+    if (!filter_xmlns_only(xf))
+	goto fail;
+    if ((cbp = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cbp, "%s/", path);
+    if ((ret = filter_nodetest(xf, nsc, cbp)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    /* Content match nodes are predicates of this node */
+    f = NULL;
+    while ((f = xml_child_each(xf, f, CX_ELMNT)) != NULL) {
+	if ((val = filter_content(f)) == NULL){
+	    containments++;
+	    continue;
+	}
+	if (!filter_xmlns_only(f) || strpbrk(val, "'\"<>&") != NULL)
+	    goto fail;
+	cprintf(cbp, "[");
+	if ((ret = filter_nodetest(f, nsc, cbp)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	cprintf(cbp, "='%s']", val);
+    }
+    /* No selection or containment nodes: select the whole node */
+    if (containments == 0){
+	cprintf(cb, "%s%s", cbuf_len(cb)?" | ":"", cbuf_get(cbp));
+	goto ok;
+    }
+    /* Otherwise select the content match nodes and the selection and 
+     * containment nodes */
+    f = NULL;
+    while ((f = xml_child_each(xf, f, CX_ELMNT)) != NULL) {
+	if (filter_content(f) == NULL){
+	    if ((ret = filter2xpath_recursive(f, cbuf_get(cbp), nsc, cb)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	    continue;
+	}
+	cprintf(cb, "%s%s/", cbuf_len(cb)?" | ":"", cbuf_get(cbp));
+	if ((ret = filter_nodetest(f, nsc, cb)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    if (cbp)
+	cbuf_free(cbp);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Translate a subtree filter to an xpath selecting the same nodes
+ *
+ * So that the filter can be evaluated in the backend and only matching data
+ * is copied and sent. Each selection or containment node without selection or
+ * containment children is a location path, with its content match children
+ * as predicates. Content match nodes are also selected. The result is the
+ * union of the location paths, eg:
+ *   <x xmlns="urn:example"><y><a>1</a><b/></y></x>
+ * is translated to:
+ *   /nf0:x/nf0:y[nf0:a='1']/nf0:b | /nf0:x/nf0:y[nf0:a='1']/nf0:a
+ * The xpath may select more than the filter, eg ancestor list keys, so the
+ * result should still be pruned with xml_filter.
+ * @param[in]  xfilter  Filter xml, ie <filter type="subtree">
+ * @param[out] cb       XPath
+ * @param[out] nsc      Namespace context of xpath, with generated prefixes
+ * @retval     1        OK
+ * @retval     0        Filter cannot be translated, eg attribute match, 
+ *                      no namespace or empty filter
+ * @retval    -1        Error
+ * @see xml_filter
+ */
+int
+xml_filter2xpath(cxobj *xfilter, 
+		 cbuf  *cb,
+		 cvec  *nsc)
+{
+    int    retval = -1;
+    cxobj *f = NULL;
+    int    ret;
+
+    while ((f = xml_child_each(xfilter, f, CX_ELMNT)) != NULL) {
+	if ((ret = filter2xpath_recursive(f, "", nsc, cb)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    if (cbuf_len(cb) == 0)
+	goto fail;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
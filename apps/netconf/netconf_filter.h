@@ -41,5 +41,6 @@
  * Prototypes
  */ 
 int xml_filter(cxobj *xf, cxobj *xn);
+int xml_filter2xpath(cxobj *xfilter, cbuf *cb, cvec *nsc);
 
 #endif  /* _NETCONF_FILTER_H_ */
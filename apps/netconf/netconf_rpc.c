@@ -104,6 +104,70 @@ ok:
     return retval;
 }
 
+/*! Rewrite a subtree filter of a request to an xpath filter evaluated in the backend
+ *
+ * The original subtree filter is returned and is used to prune the reply, which
+ * now only contains data matching the xpath. If the filter cannot be translated,
+ * the request is left as is and the backend returns all data.
+ * @param[in]  xfilter  Filter of request: <filter type="subtree">, rewritten
+ * @param[out] xsubtree Copy of subtree filter. Free with xml_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xml_filter2xpath
+ */
+static int
+netconf_filter_xpath(cxobj  *xfilter,
+		     cxobj **xsubtree)
+{
+    int     retval = -1;
+    cbuf   *cb = NULL;
+    cvec   *nsc = NULL;
+    cxobj  *xc;
+    cxobj  *xa;
+    cg_var *cv = NULL;
+    int     ret;
+
+    if ((*xsubtree = xml_dup(xfilter)) == NULL)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((nsc = xml_nsctx_init(NULL, NULL)) == NULL)
+	goto done;
+    if ((ret = xml_filter2xpath(xfilter, cb, nsc)) < 0)
+	goto done;
+    if (ret == 0) /* Get all, and filter locally */
+	goto ok;
+    /* <filter type="xpath" select="<xpath>" xmlns:<prefix>="<ns>"/> */
+    xc = NULL;
+    while ((xc = xml_child_each(xfilter, xc, -1)) != NULL) 
+	if (xml_type(xc) != CX_ATTR){
+	    xml_purge(xc);
+	    xc = NULL; /* restart */
+	}
+    if ((xa = xml_find_type(xfilter, NULL, "type", CX_ATTR)) == NULL ||
+	xml_value_set(xa, "xpath") < 0)
+	goto done;
+    if ((xa = xml_new("select", xfilter, NULL)) == NULL)
+	goto done;
+    xml_type_set(xa, CX_ATTR);
+    if (xml_value_set(xa, cbuf_get(cb)) < 0)
+	goto done;
+    while ((cv = cvec_each(nsc, cv)) != NULL)
+	if (xmlns_set(xfilter, cv_name_get(cv), cv_string_get(cv)) < 0)
+	    goto done;
+    clicon_debug(1, "%s xpath:%s", __FUNCTION__, cbuf_get(cb));
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    return retval;
+}
+
 /*! Get configuration
  * @param[in]  h       Clicon handle
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
@@ -158,6 +222,7 @@ netconf_get_config(clicon_handle h,
 		   cxobj       **xret)
 {
      cxobj      *xfilter; /* filter */
+     cxobj      *xsubtree = NULL; /* copy of subtree filter */
      int         retval = -1;
      char       *ftype = NULL;
 
@@ -169,12 +234,14 @@ netconf_get_config(clicon_handle h,
 	     goto done;	
      }
      else if (strcmp(ftype, "subtree")==0){
-	 /* Get whole config first, then filter. This is suboptimal
+	 /* Translate filter to xpath so that the backend only returns 
+	  * matching data, then filter the reply with the subtree filter
 	  */
+	 if (netconf_filter_xpath(xfilter, &xsubtree) < 0)
+	     goto done;
 	 if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
 	     goto done;	
-	 /* Now filter on whole tree */
-	 if (netconf_get_config_subtree(h, xfilter, xret) < 0)
+	 if (netconf_get_config_subtree(h, xsubtree, xret) < 0)
 	     goto done;
      }
      else{
@@ -188,6 +255,8 @@ netconf_get_config(clicon_handle h,
      }
     retval = 0;
  done:
+    if (xsubtree)
+	xml_free(xsubtree);
     return retval;
 }
 
@@ -355,6 +424,7 @@ netconf_get(clicon_handle h,
 	    cxobj       **xret)
 {
      cxobj      *xfilter; /* filter */
+     cxobj      *xsubtree = NULL; /* copy of subtree filter */
      int         retval = -1;
      char       *ftype = NULL;
 
@@ -366,12 +436,14 @@ netconf_get(clicon_handle h,
 	     goto done;	
      }
      else if (strcmp(ftype, "subtree")==0){
-	 /* Get whole config + state first, then filter. This is suboptimal
+	 /* Translate filter to xpath so that the backend only returns 
+	  * matching data, then filter the reply with the subtree filter
 	  */
+	 if (netconf_filter_xpath(xfilter, &xsubtree) < 0)
+	     goto done;
 	 if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
 	     goto done;	
-	 /* Now filter on whole tree */
-	 if (netconf_get_config_subtree(h, xfilter, xret) < 0)
+	 if (netconf_get_config_subtree(h, xsubtree, xret) < 0)
 	     goto done;
      }
      else{
@@ -385,6 +457,8 @@ netconf_get(clicon_handle h,
      }
     retval = 0;
  done:
+    if (xsubtree)
+	xml_free(xsubtree);
     return retval;
 }
 
@@ -55,6 +55,7 @@ typedef enum restconf_media restconf_media;
 int restconf_err2code(char *tag);
 const char *restconf_code2reason(int code);
 
+int restconf_exit_status(FCGX_Request *r, int status);
 int badrequest(FCGX_Request *r);
 int unauthorized(FCGX_Request *r);
 int forbidden(FCGX_Request *r);
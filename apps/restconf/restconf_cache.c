@@ -0,0 +1,546 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2020 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+
+  Response cache of config data GET replies, see CLICON_RESTCONF_CACHE_MAX.
+
+  Replies are cached per user, request URI, media type and the content, depth
+  and with-defaults query parameters, together with their entity-tag, so that
+  repeated identical requests are served without any backend rpc.
+  The cache subscribes to datastore change notifications from the backend
+  (XMLDB_CHANGE_STREAM). When running changes, replies of the changed top-level
+  subtrees, and of the datastore root, are removed. Pending notifications are
+  read before every lookup, so that a reply is never older than the changes 
+  the backend has made before the request.
+  Least recently used replies are evicted to stay below the memory limit.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <time.h>
+#include <poll.h>
+#include <inttypes.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include <fcgiapp.h> /* Need to be after clixon_xml.h due to attribute format */
+
+#include "restconf_lib.h"
+#include "restconf_cache.h"
+
+/*
+ * Constants
+ */
+/* Seconds before a failed subscription to datastore changes is tried again */
+#define CACHE_SUBSCRIBE_RETRY 10
+
+/*
+ * Types
+ */
+/* A cached reply */
+struct cache_entry{
+    qelem_t  ce_q;        /* LRU queue header, most recently used first */
+    char    *ce_key;      /* Request key, see restconf_cache_key() */
+    char    *ce_subtree;  /* Top-level subtree as <module>:<name>, NULL if root */
+    char    *ce_etag;     /* Entity-tag of reply */
+    time_t   ce_modified; /* Last-modified of reply */
+    char    *ce_body;     /* Reply body */
+    size_t   ce_size;     /* Memory used by entry */
+};
+
+/*
+ * Variables
+ */
+/* Cached replies in LRU order, and hash of request key to entry */
+static struct cache_entry *CACHE_LRU = NULL;
+static clicon_hash_t      *CACHE_HASH = NULL;
+
+/* Backend subscription socket of datastore changes, -1 if not subscribed */
+static int    CACHE_S = -1;
+static time_t CACHE_FAILED = 0;  /* Time of last failed subscription */
+
+/* Incremented for every datastore change, see restconf_cache_add() */
+static uint64_t CACHE_EPOCH = 0;
+
+/* Statistics, see clixon-restconf.yang */
+static uint64_t CACHE_HITS = 0;
+static uint64_t CACHE_MISSES = 0;
+static uint64_t CACHE_EVICTIONS = 0;
+static uint64_t CACHE_INVALIDATIONS = 0;
+static uint32_t CACHE_ENTRIES = 0;
+static size_t   CACHE_SIZE = 0;
+
+static int restconf_cache_notify_cb(int s, void *arg);
+
+/*! Remove and free a cached reply
+ * @param[in]  ce   Cache entry
+ */
+static int
+cache_entry_free(struct cache_entry *ce)
+{
+    DELQ(ce, CACHE_LRU, struct cache_entry *);
+    if (CACHE_HASH)
+	clicon_hash_del(CACHE_HASH, ce->ce_key);
+    CACHE_ENTRIES--;
+    CACHE_SIZE -= ce->ce_size;
+    if (ce->ce_key)
+	free(ce->ce_key);
+    if (ce->ce_subtree)
+	free(ce->ce_subtree);
+    if (ce->ce_etag)
+	free(ce->ce_etag);
+    if (ce->ce_body)
+	free(ce->ce_body);
+    free(ce);
+    return 0;
+}
+
+/*! Remove cached replies of a top-level subtree
+ * @param[in]  subtree  Top-level subtree, or NULL for all replies
+ * Replies of the datastore root are always removed
+ */
+static int
+cache_invalidate(char *subtree)
+{
+    struct cache_entry *ce;
+    struct cache_entry *next;
+    uint32_t            n;
+
+    ce = CACHE_LRU;
+    for (n = CACHE_ENTRIES; n > 0; n--){
+	next = NEXTQ(struct cache_entry *, ce);
+	if (subtree == NULL ||
+	    ce->ce_subtree == NULL ||
+	    strcmp(ce->ce_subtree, subtree) == 0){
+	    cache_entry_free(ce);
+	    CACHE_INVALIDATIONS++;
+	}
+	ce = next;
+    }
+    return 0;
+}
+
+/*! Close subscription of datastore changes and remove all cached replies
+ * Without notifications, cached replies may become stale.
+ */
+static int
+cache_unsubscribe(void)
+{
+    if (CACHE_S != -1){
+	event_unreg_fd(CACHE_S, restconf_cache_notify_cb);
+	close(CACHE_S);
+	CACHE_S = -1;
+    }
+    while (CACHE_LRU)
+	cache_entry_free(CACHE_LRU);
+    return 0;
+}
+
+/*! Read a datastore change notification from the backend and remove stale replies
+ * @param[in]  s    Backend subscription socket
+ * @param[in]  arg  Clicon handle
+ * @see clixon-lib.yang datastore-change notification
+ */
+static int
+restconf_cache_notify_cb(int   s,
+			 void *arg)
+{
+    int                retval = -1;
+    struct clicon_msg *reply = NULL;
+    int                eof = 0;
+    cxobj             *xtop = NULL;
+    cxobj             *xn;
+    cxobj             *x;
+    char              *db;
+    char              *subtree;
+    int                all = 1;
+
+    if (clicon_msg_rcv(s, &reply, &eof) < 0)
+	goto done;
+    if (eof){
+	clicon_debug(1, "%s backend closed subscription", __FUNCTION__);
+	cache_unsubscribe();
+	goto ok;
+    }
+    if (clicon_msg_decode(reply, NULL, NULL, &xtop) < 0) 
+	goto done;
+    if ((xn = xpath_first(xtop, NULL, "notification/datastore-change")) == NULL)
+	goto ok;
+    if ((db = xml_find_body(xn, "datastore")) == NULL ||
+	strcmp(db, "running") != 0)
+	goto ok;
+    CACHE_EPOCH++;
+    x = NULL;
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL){
+	if (strcmp(xml_name(x), "subtree") != 0 ||
+	    (subtree = xml_body(x)) == NULL)
+	    continue;
+	/* Changed NACM rules may change any reply */
+	if (strcmp(subtree, "ietf-netconf-acm:nacm") == 0){
+	    all = 1;
+	    break;
+	}
+	all = 0;
+	cache_invalidate(subtree);
+    }
+    if (all)
+	cache_invalidate(NULL);
+ ok:
+    retval = 0;
+ done:
+    if (xtop)
+	xml_free(xtop);
+    if (reply)
+	free(reply);
+    return retval;
+}
+
+/*! Subscribe to datastore changes from the backend, if not already subscribed
+ * @param[in]  h   Clicon handle
+ * @retval     1   Subscribed
+ * @retval     0   Not subscribed, do not use cache
+ * A failed subscription (eg the backend has no CLIXON stream) is retried
+ * after CACHE_SUBSCRIBE_RETRY seconds.
+ */
+static int
+cache_subscribe(clicon_handle h)
+{
+    int    s = -1;
+    time_t now;
+
+    if (CACHE_S != -1)
+	return 1;
+    now = time(NULL);
+    if (CACHE_FAILED && now < CACHE_FAILED + CACHE_SUBSCRIBE_RETRY)
+	return 0;
+    if (clicon_rpc_create_subscription(h, XMLDB_CHANGE_STREAM, NULL, &s) < 0){
+	clicon_log(LOG_WARNING, "%s: No datastore change notifications from backend, response cache not used: %s",
+		   __FUNCTION__, clicon_err_reason);
+	clicon_err_reset();
+	if (s != -1)
+	    close(s);
+	CACHE_FAILED = now;
+	return 0;
+    }
+    if (event_reg_fd(s, restconf_cache_notify_cb, h, "restconf cache") < 0){
+	close(s);
+	CACHE_FAILED = now;
+	return 0;
+    }
+    CACHE_S = s;
+    CACHE_FAILED = 0;
+    CACHE_EPOCH++;
+    return 1;
+}
+
+/*! Read all pending datastore change notifications 
+ * @param[in]  h   Clicon handle
+ * Called before the cache is used, so that all changes made by the backend
+ * before the request are seen.
+ */
+static int
+cache_drain(clicon_handle h)
+{
+    struct pollfd pfd;
+
+    while (CACHE_S != -1){
+	pfd.fd = CACHE_S;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) <= 0 || pfd.revents == 0)
+	    break;
+	if (restconf_cache_notify_cb(CACHE_S, h) < 0){
+	    cache_unsubscribe();
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+/*! Check if response cache is enabled
+ * @param[in]  h   Clicon handle
+ * @retval     1   Enabled, see CLICON_RESTCONF_CACHE_MAX
+ * @retval     0   Disabled
+ */
+int
+restconf_cache_enabled(clicon_handle h)
+{
+    return clicon_option_int(h, "CLICON_RESTCONF_CACHE_MAX") > 0;
+}
+
+/*! Make a cache key of a GET request
+ * @param[in]  h      Clicon handle
+ * @param[in]  r      Fastcgi request handle
+ * @param[in]  qvec   Vector of query string (QUERY_STRING)
+ * @param[in]  media  Output media
+ * @param[out] cb     Key
+ * @retval     1      OK, key in cb
+ * @retval     0      Request not cacheable (other query parameters)
+ * The key is the user, media type, raw request URI path and the content, depth
+ * and with-defaults query parameters in a fixed order.
+ */
+int
+restconf_cache_key(clicon_handle  h,
+		   FCGX_Request  *r,
+		   cvec          *qvec,
+		   restconf_media media,
+		   cbuf          *cb)
+{
+    cg_var *cv = NULL;
+    char   *name;
+    char   *uri;
+    char   *username;
+    char   *val;
+
+    while ((cv = cvec_each(qvec, cv)) != NULL){
+	name = cv_name_get(cv);
+	if (strcmp(name, "content") != 0 &&
+	    strcmp(name, "depth") != 0 &&
+	    strcmp(name, "with-defaults") != 0)
+	    return 0;
+    }
+    if ((uri = FCGX_GetParam("REQUEST_URI", r->envp)) == NULL)
+	return 0;
+    username = clicon_username_get(h);
+    cprintf(cb, "%s\n%s\n", username?username:"", restconf_media_int2str(media));
+    cprintf(cb, "%.*s\n", (int)strcspn(uri, "?"), uri);
+    if ((val = cvec_find_str(qvec, "content")) != NULL)
+	cprintf(cb, "content=%s", val);
+    cprintf(cb, "&");
+    if ((val = cvec_find_str(qvec, "depth")) != NULL)
+	cprintf(cb, "depth=%s", val);
+    cprintf(cb, "&");
+    if ((val = cvec_find_str(qvec, "with-defaults")) != NULL)
+	cprintf(cb, "with-defaults=%s", val);
+    return 1;
+}
+
+/*! Look up a cached reply
+ * @param[in]  h        Clicon handle
+ * @param[in]  key      Request key, see restconf_cache_key()
+ * @param[out] body     Reply body (if hit), valid until the cache is used again
+ * @param[out] etag     Entity-tag of reply (if hit)
+ * @param[out] modified Last-modified of reply (if hit)
+ * @param[out] epoch    Cache epoch (if miss), to be given to restconf_cache_add()
+ * @retval    -1        Error
+ * @retval     0        Miss
+ * @retval     1        Hit
+ */
+int
+restconf_cache_lookup(clicon_handle h,
+		      char         *key,
+		      char        **body,
+		      char        **etag,
+		      time_t       *modified,
+		      uint64_t     *epoch)
+{
+    struct cache_entry **cep;
+    struct cache_entry  *ce;
+
+    *epoch = 0;
+    if (cache_subscribe(h) == 0)
+	return 0;
+    if (cache_drain(h) < 0)
+	return -1;
+    *epoch = CACHE_EPOCH;
+    if (CACHE_HASH == NULL ||
+	(cep = clicon_hash_value(CACHE_HASH, key, NULL)) == NULL){
+	CACHE_MISSES++;
+	return 0;
+    }
+    ce = *cep;
+    /* Move to front of LRU queue */
+    if (ce != CACHE_LRU){
+	DELQ(ce, CACHE_LRU, struct cache_entry *);
+	INSQ(ce, CACHE_LRU);
+    }
+    *body = ce->ce_body;
+    *etag = ce->ce_etag;
+    *modified = ce->ce_modified;
+    CACHE_HITS++;
+    return 1;
+}
+
+/*! Add a reply to the cache
+ * @param[in]  h        Clicon handle
+ * @param[in]  key      Request key, see restconf_cache_key()
+ * @param[in]  subtree  Top-level subtree of request, or NULL if root
+ * @param[in]  body     Reply body
+ * @param[in]  etag     Entity-tag of reply
+ * @param[in]  modified Last-modified of reply
+ * @param[in]  epoch    Cache epoch from restconf_cache_lookup() before reply was read
+ * @retval    -1        Error
+ * @retval     0        OK
+ * The reply is not added if the datastore has changed since the epoch was taken,
+ * since the reply may then be stale.
+ */
+int
+restconf_cache_add(clicon_handle h,
+		   char         *key,
+		   char         *subtree,
+		   char         *body,
+		   char         *etag,
+		   time_t        modified,
+		   uint64_t      epoch)
+{
+    int                  retval = -1;
+    struct cache_entry  *ce = NULL;
+    struct cache_entry **cep;
+    size_t               size;
+    size_t               max;
+
+    if (cache_drain(h) < 0)
+	goto done;
+    if (CACHE_S == -1 || epoch != CACHE_EPOCH){
+	retval = 0;
+	goto done;
+    }
+    max = clicon_option_int(h, "CLICON_RESTCONF_CACHE_MAX");
+    size = sizeof(*ce) + strlen(key) + strlen(body) + strlen(etag) + 3;
+    if (subtree)
+	size += strlen(subtree) + 1;
+    if (size > max){
+	retval = 0;
+	goto done;
+    }
+    if (CACHE_HASH == NULL &&
+	(CACHE_HASH = clicon_hash_init()) == NULL)
+	goto done;
+    if ((cep = clicon_hash_value(CACHE_HASH, key, NULL)) != NULL)
+	cache_entry_free(*cep);
+    /* Evict least recently used */
+    while (CACHE_LRU && CACHE_SIZE + size > max){
+	cache_entry_free(PREVQ(struct cache_entry *, CACHE_LRU));
+	CACHE_EVICTIONS++;
+    }
+    if ((ce = malloc(sizeof(*ce))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(ce, 0, sizeof(*ce));
+    if ((ce->ce_key = strdup(key)) == NULL ||
+	(subtree && (ce->ce_subtree = strdup(subtree)) == NULL) ||
+	(ce->ce_etag = strdup(etag)) == NULL ||
+	(ce->ce_body = strdup(body)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    ce->ce_modified = modified;
+    ce->ce_size = size;
+    if (clicon_hash_add(CACHE_HASH, key, &ce, sizeof(ce)) == NULL)
+	goto done;
+    INSQ(ce, CACHE_LRU);
+    CACHE_ENTRIES++;
+    CACHE_SIZE += size;
+    ce = NULL;
+    retval = 0;
+ done:
+    if (ce){
+	if (ce->ce_key)
+	    free(ce->ce_key);
+	if (ce->ce_subtree)
+	    free(ce->ce_subtree);
+	if (ce->ce_etag)
+	    free(ce->ce_etag);
+	if (ce->ce_body)
+	    free(ce->ce_body);
+	free(ce);
+    }
+    return retval;
+}
+
+/*! Add response cache state to restconf-state in a get reply
+ * @param[in]  h      Clicon handle
+ * @param[in]  xdata  Reply data, <data>...
+ * @retval    -1      Error
+ * @retval     0      OK
+ * @see clixon-restconf.yang
+ */
+int
+restconf_cache_state(clicon_handle h,
+		     cxobj        *xdata)
+{
+    int    retval = -1;
+    cxobj *xs;
+
+    if ((xs = xml_find_type(xdata, NULL, "restconf-state", CX_ELMNT)) == NULL){
+	if (xml_parse_va(&xdata, NULL, "<restconf-state xmlns=\"urn:ietf:params:xml:ns:yang:ietf-restconf-monitoring\"/>") < 0)
+	    goto done;
+	if ((xs = xml_find_type(xdata, NULL, "restconf-state", CX_ELMNT)) == NULL){
+	    clicon_err(OE_XML, 0, "restconf-state not found (internal error)");
+	    goto done;
+	}
+    }
+    if (xml_parse_va(&xs, NULL, "<response-cache xmlns=\"http://clicon.org/restconf\">"
+		     "<hits>%" PRIu64 "</hits>"
+		     "<misses>%" PRIu64 "</misses>"
+		     "<evictions>%" PRIu64 "</evictions>"
+		     "<invalidations>%" PRIu64 "</invalidations>"
+		     "<entries>%u</entries>"
+		     "<size>%zu</size>"
+		     "<max-size>%d</max-size>"
+		     "</response-cache>",
+		     CACHE_HITS, CACHE_MISSES, CACHE_EVICTIONS, CACHE_INVALIDATIONS,
+		     CACHE_ENTRIES, CACHE_SIZE,
+		     clicon_option_int(h, "CLICON_RESTCONF_CACHE_MAX")) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free response cache and close subscription of datastore changes
+ * @param[in]  h   Clicon handle
+ */
+int
+restconf_cache_exit(clicon_handle h)
+{
+    cache_unsubscribe();
+    if (CACHE_HASH){
+	clicon_hash_free(CACHE_HASH);
+	CACHE_HASH = NULL;
+    }
+    return 0;
+}
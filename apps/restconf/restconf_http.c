@@ -0,0 +1,1124 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2020 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  Native HTTP/1.1 listener, serving restconf directly without a webserver
+  and FastCGI, see CLICON_RESTCONF_HTTP_PORT.
+
+  A HTTP request is translated to a FCGX_Request with CGI parameters as set by
+  a webserver (REQUEST_METHOD, REQUEST_URI, HTTP_ACCEPT, etc), and input and
+  output FCGX streams whose buffer callbacks read the request body from and
+  write the response to the HTTP connection. The request is then handled by the
+  same code as FastCGI requests. The CGI response (Status and other header
+  lines, and body) is translated to a HTTP/1.1 response.
+  - Connections are kept alive according to HTTP/1.1 (or HTTP/1.0 keep-alive)
+  - Pipelined requests are processed in order as they are read
+  - Responses are sent with Content-Length, or chunked if they are large or
+    are event streams (SSE).
+  - Chunked request bodies are not supported.
+  - Client sockets are non-blocking. Responses are appended to an output queue
+    of the connection, which is written when the socket is writable, so that a
+    slow client does not block other connections. Requests of a client are not
+    read while its output queue is larger than HTTP_WQ_MAX.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include <fcgiapp.h> /* Need to be after clixon_xml.h due to attribute format */
+
+#include "restconf_lib.h"
+#include "restconf_http.h"
+
+/*
+ * Constants
+ */
+/* Size of response stream buffer */
+#define HTTP_OBUFLEN 8192
+
+/* Responses larger than this are sent chunked, not buffered for Content-Length */
+#define HTTP_CHUNK_MIN (64*1024)
+
+/* Max size of a request header */
+#define HTTP_HDR_MAX (64*1024)
+
+/* Max size of a request body */
+#define HTTP_BODY_MAX (256*1024*1024)
+
+/* Initial size of input buffer */
+#define HTTP_IBUFLEN 4096
+
+/* Stop reading requests of a connection while more than this is queued for output */
+#define HTTP_WQ_MAX (1024*1024)
+
+/*
+ * Types
+ */
+/* A HTTP client connection */
+struct http_conn{
+    qelem_t        hc_q;          /* queue header */
+    clicon_handle  hc_h;
+    int            hc_s;          /* Client socket */
+    char          *hc_ibuf;       /* Input buffer */
+    size_t         hc_ilen;       /* Bytes in input buffer */
+    size_t         hc_isize;      /* Size of input buffer */
+    int            hc_continue;   /* 100 Continue sent for current request */
+    int            hc_keepalive;  /* Keep connection after current response */
+    int            hc_stream;     /* Connection taken over by a stream subscriber */
+    int            hc_rreg;       /* Read callback registered */
+    int            hc_wreg;       /* Write callback registered */
+    int            hc_closing;    /* Close when output queue is written */
+    FCGX_Request   hc_r;          /* Request passed to restconf code */
+    char         **hc_envp;       /* CGI parameters of current request */
+    int            hc_envlen;     /* Nr of CGI parameters */
+    FCGX_Stream    hc_in;         /* Request body */
+    FCGX_Stream    hc_out;        /* Response */
+    FCGX_Stream    hc_err;        /* Error stream, discarded */
+    unsigned char  hc_obuf[HTTP_OBUFLEN]; /* Buffer of hc_out */
+    unsigned char  hc_ebuf[256];  /* Buffer of hc_err */
+    struct http_buf hc_resp;      /* CGI response not yet sent */
+    int            hc_chunked;    /* HTTP header sent, body is sent chunked */
+    struct http_buf hc_wq;        /* Output queue */
+};
+
+/* Linked list of HTTP connections */
+static struct http_conn *HTTP_CONNS = NULL;
+
+/* Request dispatcher, see restconf_http_open */
+static restconf_dispatch_fn_t *_http_dispatch = NULL;
+
+static int http_read_cb(int s, void *arg);
+static int http_write_cb(int s, void *arg);
+static int http_process(int s);
+
+/*! Find HTTP connection of a client socket */
+static struct http_conn *
+http_conn_find(int s)
+{
+    struct http_conn *hc;
+
+    if ((hc = HTTP_CONNS) != NULL){
+	do {
+	    if (hc->hc_s == s)
+		return hc;
+	    hc = NEXTQ(struct http_conn *, hc);
+	} while (hc && hc != HTTP_CONNS);
+    }
+    return NULL;
+}
+
+/*! Append data to a buffer
+ * @param[in]  hb   Buffer
+ * @param[in]  data Data, may contain NUL bytes
+ * @param[in]  len  Length of data
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+http_buf_append(struct http_buf *hb,
+		const char      *data,
+		size_t           len)
+{
+    char  *buf;
+    size_t size;
+
+    if (hb->hb_len + len + 1 > hb->hb_size){ /* Room for data and NUL */
+	size = hb->hb_size ? hb->hb_size : HTTP_IBUFLEN;
+	while (hb->hb_len + len + 1 > size)
+	    size *= 2;
+	if ((buf = realloc(hb->hb_buf, size)) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	hb->hb_buf = buf;
+	hb->hb_size = size;
+    }
+    memcpy(hb->hb_buf + hb->hb_len, data, len);
+    hb->hb_len += len;
+    hb->hb_buf[hb->hb_len] = '\0';
+    return 0;
+}
+
+/*! Empty a buffer, memory is kept for reuse */
+void
+http_buf_reset(struct http_buf *hb)
+{
+    hb->hb_len = 0;
+    hb->hb_off = 0;
+    if (hb->hb_buf)
+	hb->hb_buf[0] = '\0';
+}
+
+/*! Write as much of the output queue of a HTTP connection as the socket accepts
+ * If data remains, a write callback is registered that writes the rest when
+ * the socket is writable.
+ * @param[in]  hc   HTTP connection
+ * @retval     0    OK
+ * @retval    -1    Write error, errno set
+ */
+static int
+http_flush(struct http_conn *hc)
+{
+    struct http_buf *wq = &hc->hc_wq;
+    ssize_t          n;
+
+    while (wq->hb_off < wq->hb_len){
+	if ((n = send(hc->hc_s, wq->hb_buf + wq->hb_off, wq->hb_len - wq->hb_off,
+		      MSG_NOSIGNAL)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		break;
+	    return -1;
+	}
+	wq->hb_off += n;
+    }
+    if (wq->hb_off == wq->hb_len){
+	http_buf_reset(wq);
+	if (hc->hc_wreg){
+	    event_unreg_fd_write(hc->hc_s, http_write_cb);
+	    hc->hc_wreg = 0;
+	}
+    }
+    else if (hc->hc_wreg == 0){
+	if (event_reg_fd_write(hc->hc_s, http_write_cb, hc, "restconf http output") < 0)
+	    return -1;
+	hc->hc_wreg = 1;
+    }
+    return 0;
+}
+
+/*! Queue data for output on a HTTP connection and write what the socket accepts
+ * @param[in]  hc   HTTP connection
+ * @param[in]  buf  Data, may contain NUL bytes
+ * @param[in]  len  Length of data
+ * @retval     0    OK
+ * @retval    -1    Write error, errno set
+ */
+static int
+http_write(struct http_conn *hc,
+	   char             *buf,
+	   size_t            len)
+{
+    if (http_buf_append(&hc->hc_wq, buf, len) < 0)
+	return -1;
+    return http_flush(hc);
+}
+
+/*! Translate CGI response header to HTTP/1.1 response header
+ * @param[in]  hc      HTTP connection
+ * @param[in]  hdr     CGI header lines (terminated by empty line)
+ * @param[in]  hdrlen  Length of hdr
+ * @param[in]  bodylen Length of body for Content-Length, or -1 for chunked
+ * @param[out] cb      HTTP header
+ */
+static int
+http_header(struct http_conn *hc,
+	    char             *hdr,
+	    size_t            hdrlen,
+	    ssize_t           bodylen,
+	    cbuf             *cb)
+{
+    char  *line;
+    char  *eol;
+    char  *end = hdr + hdrlen;
+    int    status = 0;
+    int    code = 200;
+    size_t len;
+
+    /* Status line first */
+    for (line = hdr; line < end; line = eol + 1){
+	if ((eol = memchr(line, '\n', end - line)) == NULL)
+	    eol = end;
+	len = eol - line;
+	if (len && line[len-1] == '\r')
+	    len--;
+	if (len > 7 && strncasecmp(line, "Status:", 7) == 0){
+	    line += 7;
+	    len -= 7;
+	    while (len && *line == ' '){
+		line++;
+		len--;
+	    }
+	    cprintf(cb, "HTTP/1.1 %.*s\r\n", (int)len, line);
+	    code = atoi(line);
+	    status++;
+	    break;
+	}
+    }
+    if (status == 0)
+	cprintf(cb, "HTTP/1.1 200 OK\r\n");
+    for (line = hdr; line < end; line = eol + 1){
+	if ((eol = memchr(line, '\n', end - line)) == NULL)
+	    eol = end;
+	len = eol - line;
+	if (len && line[len-1] == '\r')
+	    len--;
+	if (len == 0 ||
+	    (len > 7 && strncasecmp(line, "Status:", 7) == 0) ||
+	    (len > 11 && strncasecmp(line, "Connection:", 11) == 0))
+	    continue;
+	cprintf(cb, "%.*s\r\n", (int)len, line);
+    }
+    /* 1xx, 204 and 304 responses have no body, and no Content-Length (RFC 7230 3.3.2) */
+    if (code < 200 || code == 204 || code == 304)
+	;
+    else if (bodylen < 0)
+	cprintf(cb, "Transfer-Encoding: chunked\r\n");
+    else
+	cprintf(cb, "Content-Length: %zd\r\n", bodylen);
+    if (hc->hc_keepalive == 0)
+	cprintf(cb, "Connection: close\r\n");
+    cprintf(cb, "\r\n");
+    return 0;
+}
+
+/*! Split CGI response into header and body
+ * @param[in]  resp   CGI response
+ * @param[out] hdrlen Length of header including empty line, 0 if not complete
+ */
+static size_t
+http_resp_hdrlen(struct http_buf *resp)
+{
+    char *str = resp->hb_buf;
+    char *p;
+
+    if (str == NULL)
+	return 0;
+    if ((p = strstr(str, "\r\n\r\n")) != NULL)
+	return p - str + 4;
+    if ((p = strstr(str, "\n\n")) != NULL)
+	return p - str + 2;
+    return 0;
+}
+
+/*! Check if a CGI response is an event stream
+ * @param[in]  resp   CGI response
+ * @param[in]  hdrlen Length of header
+ */
+static int
+http_resp_stream(struct http_buf *resp,
+		 size_t           hdrlen)
+{
+    char *p;
+
+    if ((p = strstr(resp->hb_buf, "Content-Type: text/event-stream")) == NULL)
+	return 0;
+    return p < resp->hb_buf + hdrlen;
+}
+
+/*! Send the CGI response buffered so far as chunk, and the header if not sent
+ * Called when the response is large or is an event stream.
+ * @param[in]  hc     HTTP connection
+ * @retval     0      OK, chunk queued for output
+ * @retval    -1      Error
+ */
+static int
+http_send_chunk(struct http_conn *hc)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    char  *str;
+    size_t hdrlen = 0;
+    size_t len;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    str = hc->hc_resp.hb_buf;
+    if (hc->hc_chunked == 0){
+	if ((hdrlen = http_resp_hdrlen(&hc->hc_resp)) == 0)
+	    goto ok; /* Wait for complete header */
+	if (http_header(hc, str, hdrlen, -1, cb) < 0)
+	    goto done;
+	hc->hc_chunked = 1;
+    }
+    /* An empty chunk would end the response */
+    if ((len = hc->hc_resp.hb_len - hdrlen) > 0)
+	cprintf(cb, "%zx\r\n", len);
+    if (http_buf_append(&hc->hc_wq, cbuf_get(cb), cbuf_len(cb)) < 0)
+	goto done;
+    if (len > 0 &&
+	(http_buf_append(&hc->hc_wq, str + hdrlen, len) < 0 ||
+	 http_buf_append(&hc->hc_wq, "\r\n", 2) < 0))
+	goto done;
+    if (http_flush(hc) < 0)
+	goto done;
+    http_buf_reset(&hc->hc_resp);
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Response stream buffer is full, flushed or closed
+ * The buffer is appended to the response. A response that is an event stream
+ * or is large is sent chunked, otherwise it is sent when the request is finished.
+ * @see FCGX_Stream emptyBuffProc
+ */
+static void
+http_out_empty(FCGX_Stream *stream,
+	       int          doClose)
+{
+    struct http_conn *hc = (struct http_conn *)stream->data;
+    size_t            len;
+    size_t            hdrlen;
+
+    if ((len = stream->wrNext - hc->hc_obuf) > 0 &&
+	http_buf_append(&hc->hc_resp, (char*)hc->hc_obuf, len) < 0){
+	stream->FCGI_errno = ENOMEM;
+	stream->isClosed = 1;
+	return;
+    }
+    stream->wrNext = hc->hc_obuf;
+    if (doClose)
+	return;
+    if (hc->hc_chunked == 0 && hc->hc_resp.hb_len < HTTP_CHUNK_MIN){
+	if ((hdrlen = http_resp_hdrlen(&hc->hc_resp)) == 0 ||
+	    !http_resp_stream(&hc->hc_resp, hdrlen))
+	    return;
+    }
+    if (http_send_chunk(hc) < 0){
+	stream->FCGI_errno = errno?errno:EPIPE;
+	stream->isClosed = 1;
+    }
+}
+
+/*! Error stream buffer is full, discard it
+ */
+static void
+http_err_empty(FCGX_Stream *stream,
+	       int          doClose)
+{
+    struct http_conn *hc = (struct http_conn *)stream->data;
+
+    stream->wrNext = hc->hc_ebuf;
+}
+
+/*! Request body is read, there is no more
+ */
+static void
+http_in_fill(FCGX_Stream *stream)
+{
+    stream->isClosed = 1;
+}
+
+/*! Free CGI parameters of a request */
+static int
+http_envp_free(struct http_conn *hc)
+{
+    int i;
+
+    if (hc->hc_envp){
+	for (i=0; i<hc->hc_envlen; i++)
+	    free(hc->hc_envp[i]);
+	free(hc->hc_envp);
+	hc->hc_envp = NULL;
+    }
+    hc->hc_envlen = 0;
+    return 0;
+}
+
+/*! Add CGI parameter to a request */
+static int
+http_envp_add(struct http_conn *hc,
+	      char             *name,
+	      char             *val,
+	      size_t            vlen)
+{
+    int    retval = -1;
+    char **envp;
+    char  *str;
+    size_t len;
+
+    len = strlen(name) + 1 + vlen + 1;
+    if ((str = malloc(len)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    snprintf(str, len, "%s=%.*s", name, (int)vlen, val);
+    if ((envp = realloc(hc->hc_envp, (hc->hc_envlen+2)*sizeof(char*))) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	free(str);
+	goto done;
+    }
+    hc->hc_envp = envp;
+    hc->hc_envp[hc->hc_envlen++] = str;
+    hc->hc_envp[hc->hc_envlen] = NULL;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Close and free a HTTP connection, queued output is discarded
+ */
+static int
+http_conn_free(struct http_conn *hc)
+{
+    clicon_debug(1, "%s %d", __FUNCTION__, hc->hc_s);
+    if (hc->hc_rreg)
+	event_unreg_fd(hc->hc_s, http_read_cb);
+    if (hc->hc_wreg)
+	event_unreg_fd_write(hc->hc_s, http_write_cb);
+    close(hc->hc_s);
+    DELQ(hc, HTTP_CONNS, struct http_conn *);
+    http_envp_free(hc);
+    if (hc->hc_ibuf)
+	free(hc->hc_ibuf);
+    if (hc->hc_resp.hb_buf)
+	free(hc->hc_resp.hb_buf);
+    if (hc->hc_wq.hb_buf)
+	free(hc->hc_wq.hb_buf);
+    free(hc);
+    return 0;
+}
+
+/*! Close a HTTP connection when its queued output is written
+ * No more requests are read from the connection.
+ */
+static int
+http_conn_close(struct http_conn *hc)
+{
+    if (hc->hc_wq.hb_len == 0)
+	return http_conn_free(hc);
+    hc->hc_closing = 1;
+    if (hc->hc_rreg){
+	event_unreg_fd(hc->hc_s, http_read_cb);
+	hc->hc_rreg = 0;
+    }
+    return 0;
+}
+
+/*! HTTP connection is writable: write queued output
+ * When all output is written, a closing connection is closed, and reading of
+ * requests is resumed if it was stopped due to a large output queue.
+ * @param[in]  s    Client socket
+ * @param[in]  arg  HTTP connection
+ */
+static int
+http_write_cb(int   s,
+	      void *arg)
+{
+    int               retval = -1;
+    struct http_conn *hc = (struct http_conn *)arg;
+
+    if (http_flush(hc) < 0){
+	clicon_debug(1, "%s send: %s", __FUNCTION__, strerror(errno));
+	http_conn_free(hc);
+	goto ok;
+    }
+    if (hc->hc_wq.hb_len)
+	goto ok;
+    if (hc->hc_closing){
+	http_conn_free(hc);
+	goto ok;
+    }
+    if (hc->hc_rreg == 0 && hc->hc_stream == 0){
+	if (event_reg_fd(s, http_read_cb, hc, "restconf http connection") < 0)
+	    goto done;
+	hc->hc_rreg = 1;
+	/* Requests may already be in the input buffer */
+	if (http_process(s) < 0)
+	    goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send a HTTP error response directly, without restconf processing
+ * Used for requests that cannot be translated to a restconf request
+ */
+static int
+http_error(struct http_conn *hc,
+	   int               code)
+{
+    int         retval = -1;
+    cbuf       *cb = NULL;
+    const char *reason;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((reason = restconf_code2reason(code)) == NULL)
+	reason = "";
+    hc->hc_keepalive = 0;
+    cprintf(cb, "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n",
+	    code, reason);
+    (void)http_write(hc, cbuf_get(cb), cbuf_len(cb));
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Parse request line and header fields of a HTTP request into CGI parameters
+ * @param[in]  hc       HTTP connection
+ * @param[in]  hdrlen   Length of header in input buffer
+ * @param[out] bodylen  Content-Length of request
+ * @param[out] code     HTTP error code if invalid
+ * @retval     1        OK
+ * @retval     0        Invalid or unsupported request, error code in code
+ * @retval    -1        Error
+ */
+static int
+http_parse(struct http_conn *hc,
+	   size_t            hdrlen,
+	   size_t           *bodylen,
+	   int              *code)
+{
+    char  *hdr = NULL;
+    char  *line;
+    char  *eol;
+    char  *end;
+    char  *p;
+    char  *method;
+    char  *uri;
+    char  *q;
+    char  *version;
+    size_t len;
+    char  *name;
+    size_t nlen;
+    char  *val;
+    cbuf  *cb = NULL;
+    int    i;
+    int    retval = -1;
+
+    *bodylen = 0;
+    *code = 400;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    /* Parse a copy, input buffer is kept until body is read */
+    if ((hdr = strndup(hc->hc_ibuf, hdrlen)) == NULL){
+	clicon_err(OE_UNIX, errno, "strndup");
+	goto done;
+    }
+    end = hdr + hdrlen;
+    /* Request line: method SP request-target SP HTTP-version */
+    line = hdr;
+    eol = memchr(line, '\n', end - line);
+    len = eol - line;
+    if (len && line[len-1] == '\r')
+	len--;
+    line[len] = '\0';
+    method = line;
+    if ((uri = strchr(method, ' ')) == NULL)
+	goto fail;
+    *uri++ = '\0';
+    if ((version = strchr(uri, ' ')) == NULL)
+	goto fail;
+    *version++ = '\0';
+    if (strncmp(version, "HTTP/1.", 7) != 0){
+	*code = 505;
+	goto fail;
+    }
+    hc->hc_keepalive = strcmp(version, "HTTP/1.0") != 0;
+    if (http_envp_add(hc, "REQUEST_METHOD", method, strlen(method)) < 0 ||
+	http_envp_add(hc, "REQUEST_URI", uri, strlen(uri)) < 0 ||
+	http_envp_add(hc, "SERVER_PROTOCOL", version, strlen(version)) < 0)
+	goto done;
+    if ((q = strchr(uri, '?')) != NULL){
+	if (http_envp_add(hc, "DOCUMENT_URI", uri, q - uri) < 0 ||
+	    http_envp_add(hc, "QUERY_STRING", q+1, strlen(q+1)) < 0)
+	    goto done;
+    }
+    else
+	if (http_envp_add(hc, "DOCUMENT_URI", uri, strlen(uri)) < 0 ||
+	    http_envp_add(hc, "QUERY_STRING", "", 0) < 0)
+	    goto done;
+    /* Header fields: field-name ":" OWS field-value OWS */
+    for (line = eol + 1; line < end; line = eol + 1){
+	eol = memchr(line, '\n', end - line);
+	len = eol - line;
+	if (len && line[len-1] == '\r')
+	    len--;
+	if (len == 0)
+	    break;
+	line[len] = '\0';
+	if ((p = strchr(line, ':')) == NULL)
+	    goto fail;
+	name = line;
+	nlen = p - line;
+	val = p + 1;
+	while (*val == ' ' || *val == '\t')
+	    val++;
+	len = strlen(val);
+	while (len && (val[len-1] == ' ' || val[len-1] == '\t'))
+	    len--;
+	val[len] = '\0';
+	/* CGI name: HTTP_ prefix, upper case, '-' replaced by '_' */
+	cbuf_reset(cb);
+	cprintf(cb, "HTTP_");
+	for (i=0; i<nlen; i++)
+	    cprintf(cb, "%c", name[i]=='-'?'_':toupper(name[i]));
+	if (http_envp_add(hc, cbuf_get(cb), val, len) < 0)
+	    goto done;
+	if (strcmp(cbuf_get(cb), "HTTP_CONTENT_LENGTH") == 0){
+	    if (http_envp_add(hc, "CONTENT_LENGTH", val, len) < 0)
+		goto done;
+	    *bodylen = strtoul(val, &p, 10);
+	    if (*p != '\0')
+		goto fail;
+	    if (*bodylen > HTTP_BODY_MAX){
+		*code = 413;
+		goto fail;
+	    }
+	}
+	else if (strcmp(cbuf_get(cb), "HTTP_CONTENT_TYPE") == 0){
+	    if (http_envp_add(hc, "CONTENT_TYPE", val, len) < 0)
+		goto done;
+	}
+	else if (strcmp(cbuf_get(cb), "HTTP_CONNECTION") == 0){
+	    if (strcasecmp(val, "close") == 0)
+		hc->hc_keepalive = 0;
+	    else if (strcasecmp(val, "keep-alive") == 0)
+		hc->hc_keepalive = 1;
+	}
+	else if (strcmp(cbuf_get(cb), "HTTP_TRANSFER_ENCODING") == 0){
+	    *code = 501; /* Chunked request body not supported */
+	    goto fail;
+	}
+    }
+    retval = 1;
+ done:
+    if (hdr)
+	free(hdr);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Process one complete request in the input buffer of a HTTP connection
+ * @param[in]  hc       HTTP connection
+ * @param[in]  hdrlen   Length of request header
+ * @param[in]  bodylen  Length of request body following header
+ */
+static int
+http_request(struct http_conn *hc,
+	     size_t            hdrlen,
+	     size_t            bodylen)
+{
+    int           retval = -1;
+    FCGX_Request *r = &hc->hc_r;
+    int           finish = 1;
+
+    /* Request body */
+    memset(&hc->hc_in, 0, sizeof(hc->hc_in));
+    hc->hc_in.rdNext = (unsigned char*)hc->hc_ibuf + hdrlen;
+    hc->hc_in.stop = hc->hc_in.rdNext + bodylen;
+    hc->hc_in.stopUnget = hc->hc_in.rdNext;
+    hc->hc_in.wrNext = hc->hc_in.stop;
+    hc->hc_in.isReader = 1;
+    hc->hc_in.fillBuffProc = http_in_fill;
+    hc->hc_in.data = hc;
+    /* Response */
+    memset(&hc->hc_out, 0, sizeof(hc->hc_out));
+    hc->hc_out.wrNext = hc->hc_obuf;
+    hc->hc_out.stop = hc->hc_obuf + sizeof(hc->hc_obuf);
+    hc->hc_out.rdNext = hc->hc_out.stop;
+    hc->hc_out.emptyBuffProc = http_out_empty;
+    hc->hc_out.data = hc;
+    memset(&hc->hc_err, 0, sizeof(hc->hc_err));
+    hc->hc_err.wrNext = hc->hc_ebuf;
+    hc->hc_err.stop = hc->hc_ebuf + sizeof(hc->hc_ebuf);
+    hc->hc_err.rdNext = hc->hc_err.stop;
+    hc->hc_err.emptyBuffProc = http_err_empty;
+    hc->hc_err.data = hc;
+    http_buf_reset(&hc->hc_resp);
+    hc->hc_chunked = 0;
+    memset(r, 0, sizeof(*r));
+    r->role = RESTCONF_HTTP_ROLE;
+    r->in = &hc->hc_in;
+    r->out = &hc->hc_out;
+    r->err = &hc->hc_err;
+    r->envp = hc->hc_envp;
+    r->ipcFd = hc->hc_s;
+    r->listen_sock = -1;
+    if ((*_http_dispatch)(hc->hc_h, r, &finish) < 0)
+	clicon_debug(1, "%s dispatch error", __FUNCTION__);
+    if (finish == 0){
+	/* Taken over by stream subscriber, see restconf_http_finish */
+	hc->hc_stream = 1;
+	if (hc->hc_rreg){
+	    event_unreg_fd(hc->hc_s, http_read_cb);
+	    hc->hc_rreg = 0;
+	}
+	goto ok;
+    }
+    if (restconf_http_finish(r, 1) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Finish a request of the native HTTP listener and send the response
+ * @param[in]  r        Request handle, from the HTTP listener
+ * @param[in]  graceful If 0, close connection without completing the response
+ * @retval     0        OK
+ * @retval    -1        Error
+ * A finished stream subscription, or a request without keep-alive, closes the
+ * connection when the response is written.
+ */
+int
+restconf_http_finish(FCGX_Request *r,
+		     int           graceful)
+{
+    int               retval = -1;
+    struct http_conn *hc = (struct http_conn *)r->out->data;
+    cbuf             *cb = NULL;
+    size_t            hdrlen;
+    size_t            len;
+    int               closeit;
+
+    closeit = !graceful || hc->hc_stream || !hc->hc_keepalive || r->out->isClosed;
+    if (!graceful || r->out->isClosed){
+	http_envp_free(hc);
+	http_conn_free(hc);
+	goto ok;
+    }
+    http_out_empty(r->out, 1);
+    if (hc->hc_chunked){
+	if (http_send_chunk(hc) < 0 ||
+	    http_write(hc, "0\r\n\r\n", 5) < 0)
+	    goto fail;
+	goto close;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((hdrlen = http_resp_hdrlen(&hc->hc_resp)) == 0) /* No body */
+	hdrlen = hc->hc_resp.hb_len;
+    len = hc->hc_resp.hb_len - hdrlen;
+    if (http_header(hc, hc->hc_resp.hb_buf?hc->hc_resp.hb_buf:"", hdrlen, len, cb) < 0)
+	goto done;
+    if (http_buf_append(&hc->hc_wq, cbuf_get(cb), cbuf_len(cb)) < 0 ||
+	(len && http_buf_append(&hc->hc_wq, hc->hc_resp.hb_buf + hdrlen, len) < 0) ||
+	http_flush(hc) < 0)
+	goto fail;
+ close:
+    http_buf_reset(&hc->hc_resp);
+    http_envp_free(hc);
+    if (closeit)
+	http_conn_close(hc);
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail: /* Write error, response cannot be sent */
+    clicon_debug(1, "%s send: %s", __FUNCTION__, strerror(errno));
+    http_envp_free(hc);
+    http_conn_free(hc);
+    goto ok;
+}
+
+/*! Process all complete requests in the input buffer of a HTTP connection
+ * Requests are processed in order (pipelining). Processing stops if the
+ * connection is closed or taken over by a stream, or if the output queue is
+ * larger than HTTP_WQ_MAX, in which case reading is stopped until the output
+ * queue is written, see http_write_cb.
+ * @param[in]  s    Client socket
+ */
+static int
+http_process(int s)
+{
+    int               retval = -1;
+    struct http_conn *hc;
+    char             *p;
+    size_t            hdrlen;
+    size_t            bodylen;
+    int               code;
+    int               ret;
+
+    while ((hc = http_conn_find(s)) != NULL &&
+	   hc->hc_stream == 0 && hc->hc_closing == 0 && hc->hc_ilen > 0){
+	if (hc->hc_wq.hb_len - hc->hc_wq.hb_off > HTTP_WQ_MAX){
+	    /* Client does not read its responses */
+	    if (hc->hc_rreg){
+		event_unreg_fd(s, http_read_cb);
+		hc->hc_rreg = 0;
+	    }
+	    break;
+	}
+	if ((p = strstr(hc->hc_ibuf, "\r\n\r\n")) == NULL){
+	    if (hc->hc_ilen > HTTP_HDR_MAX){
+		http_error(hc, 431);
+		http_conn_close(hc);
+	    }
+	    break;
+	}
+	hdrlen = p - hc->hc_ibuf + 4;
+	http_envp_free(hc);
+	if ((ret = http_parse(hc, hdrlen, &bodylen, &code)) < 0)
+	    goto done;
+	if (ret == 0){
+	    http_error(hc, code);
+	    http_conn_close(hc);
+	    break;
+	}
+	if (hc->hc_ilen < hdrlen + bodylen){ /* Wait for body */
+	    if (!hc->hc_continue &&
+		FCGX_GetParam("HTTP_EXPECT", hc->hc_envp) &&
+		strcasecmp(FCGX_GetParam("HTTP_EXPECT", hc->hc_envp), "100-continue") == 0){
+		hc->hc_continue = 1;
+		(void)http_write(hc, "HTTP/1.1 100 Continue\r\n\r\n", 25);
+	    }
+	    http_envp_free(hc);
+	    break;
+	}
+	hc->hc_continue = 0;
+	if (http_request(hc, hdrlen, bodylen) < 0)
+	    goto done;
+	/* Connection may be closed or taken over by stream */
+	if ((hc = http_conn_find(s)) == NULL || hc->hc_stream || hc->hc_closing)
+	    break;
+	hc->hc_ilen -= hdrlen + bodylen;
+	memmove(hc->hc_ibuf, hc->hc_ibuf + hdrlen + bodylen, hc->hc_ilen + 1);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Data on a HTTP connection: read and process all complete requests
+ * @param[in]  s    Client socket
+ * @param[in]  arg  HTTP connection
+ */
+static int
+http_read_cb(int   s,
+	     void *arg)
+{
+    int               retval = -1;
+    struct http_conn *hc = (struct http_conn *)arg;
+    ssize_t           n;
+    char             *ibuf;
+
+    if (hc->hc_ilen + 1 >= hc->hc_isize){ /* Room for data and NUL */
+	if ((ibuf = realloc(hc->hc_ibuf, 2*hc->hc_isize)) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    goto done;
+	}
+	hc->hc_ibuf = ibuf;
+	hc->hc_isize *= 2;
+    }
+    if ((n = read(s, hc->hc_ibuf + hc->hc_ilen, hc->hc_isize - hc->hc_ilen - 1)) < 0){
+	if (errno == EAGAIN || errno == EINTR)
+	    goto ok;
+	clicon_debug(1, "%s read: %s", __FUNCTION__, strerror(errno));
+	http_conn_free(hc);
+	goto ok;
+    }
+    if (n == 0){ /* Closed by client */
+	http_conn_free(hc);
+	goto ok;
+    }
+    hc->hc_ilen += n;
+    hc->hc_ibuf[hc->hc_ilen] = '\0';
+    if (http_process(s) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! New connection on the HTTP listen socket
+ * @param[in]  s    Listen socket
+ * @param[in]  arg  Clicon handle
+ */
+static int
+http_accept_cb(int   s,
+	       void *arg)
+{
+    int               retval = -1;
+    clicon_handle     h = (clicon_handle)arg;
+    struct http_conn *hc = NULL;
+    int               ss;
+
+    if ((ss = accept(s, NULL, NULL)) < 0){
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ||
+	    errno == ECONNABORTED) /* Eg taken by another worker */
+	    goto ok;
+	clicon_err(OE_UNIX, errno, "accept");
+	goto done;
+    }
+    clicon_debug(1, "%s %d", __FUNCTION__, ss);
+    if ((hc = malloc(sizeof(*hc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(hc, 0, sizeof(*hc));
+    hc->hc_h = h;
+    hc->hc_s = ss;
+    ss = -1;
+    ADDQ(hc, HTTP_CONNS);
+    if (fcntl(hc->hc_s, F_SETFL, fcntl(hc->hc_s, F_GETFL, 0) | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	goto done;
+    }
+    if ((hc->hc_ibuf = malloc(HTTP_IBUFLEN)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    hc->hc_isize = HTTP_IBUFLEN;
+    if (event_reg_fd(hc->hc_s, http_read_cb, hc, "restconf http connection") < 0)
+	goto done;
+    hc->hc_rreg = 1;
+    hc = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (hc)
+	http_conn_free(hc);
+    if (ss != -1)
+	close(ss);
+    return retval;
+}
+
+/*! Open the native HTTP listen socket, if CLICON_RESTCONF_HTTP_PORT is set
+ * @param[in]  h        Clicon handle
+ * @param[in]  dispatch Function called for each request
+ * @retval     0        OK (also if not enabled)
+ * @retval    -1        Error
+ * The listen socket is non-blocking, so that several workers may share it.
+ */
+int
+restconf_http_open(clicon_handle           h,
+		   restconf_dispatch_fn_t *dispatch)
+{
+    int                  retval = -1;
+    int                  port;
+    char                *addr;
+    int                  s = -1;
+    int                  one = 1;
+    struct sockaddr_in   sin = {0,};
+    struct sockaddr_in6  sin6 = {0,};
+    struct sockaddr     *sa;
+    socklen_t            salen;
+
+    if ((port = clicon_option_int(h, "CLICON_RESTCONF_HTTP_PORT")) <= 0)
+	goto ok;
+    if ((addr = clicon_option_str(h, "CLICON_RESTCONF_HTTP_ADDR")) == NULL)
+	addr = "127.0.0.1";
+    if (inet_pton(AF_INET, addr, &sin.sin_addr) == 1){
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(port);
+	sa = (struct sockaddr *)&sin;
+	salen = sizeof(sin);
+    }
+    else if (inet_pton(AF_INET6, addr, &sin6.sin6_addr) == 1){
+	sin6.sin6_family = AF_INET6;
+	sin6.sin6_port = htons(port);
+	sa = (struct sockaddr *)&sin6;
+	salen = sizeof(sin6);
+    }
+    else{
+	clicon_err(OE_CFG, EINVAL, "CLICON_RESTCONF_HTTP_ADDR: %s is not an IP address", addr);
+	goto done;
+    }
+    if ((s = socket(sa->sa_family, SOCK_STREAM, 0)) < 0){
+	clicon_err(OE_UNIX, errno, "socket");
+	goto done;
+    }
+    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0){
+	clicon_err(OE_UNIX, errno, "setsockopt");
+	goto done;
+    }
+    if (fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	goto done;
+    }
+    if (bind(s, sa, salen) < 0){
+	clicon_err(OE_UNIX, errno, "bind %s:%d", addr, port);
+	goto done;
+    }
+    if (listen(s, 64) < 0){
+	clicon_err(OE_UNIX, errno, "listen");
+	goto done;
+    }
+    clicon_debug(1, "%s: Listening on %s:%d", __FUNCTION__, addr, port);
+    _http_dispatch = dispatch;
+    if (event_reg_fd(s, http_accept_cb, h, "restconf http socket") < 0)
+	goto done;
+    s = -1;
+ ok:
+    retval = 0;
+ done:
+    if (s != -1)
+	close(s);
+    return retval;
+}
+
+/*! Close all native HTTP connections
+ * @param[in]  h        Clicon handle
+ */
+int
+restconf_http_close(clicon_handle h)
+{
+    while (HTTP_CONNS != NULL)
+	http_conn_free(HTTP_CONNS);
+    return 0;
+}
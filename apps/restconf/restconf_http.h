@@ -0,0 +1,67 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2020 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Native HTTP/1.1 restconf listener
+ */
+
+#ifndef _RESTCONF_HTTP_H_
+#define _RESTCONF_HTTP_H_
+
+/*
+ * Types
+ */
+/* Data buffer, may contain NUL bytes, and is NUL-terminated for header parsing */
+struct http_buf{
+    char          *hb_buf;
+    size_t         hb_len;        /* Bytes in buffer */
+    size_t         hb_size;       /* Allocated size */
+    size_t         hb_off;        /* Bytes already sent, output queue only */
+};
+
+/*! Process a restconf request, same for FastCGI and native HTTP requests
+ * @param[in]  h       Clicon handle
+ * @param[in]  r       Request handle
+ * @param[out] finish  Set to 0 if request is taken over (stream subscription)
+ */
+typedef int (restconf_dispatch_fn_t)(clicon_handle h, FCGX_Request *r, int *finish);
+
+/*
+ * Prototypes
+ */
+int restconf_http_open(clicon_handle h, restconf_dispatch_fn_t *dispatch);
+int restconf_http_finish(FCGX_Request *r, int graceful);
+int restconf_http_close(clicon_handle h);
+int http_buf_append(struct http_buf *hb, const char *data, size_t len);
+void http_buf_reset(struct http_buf *hb);
+
+#endif /* _RESTCONF_HTTP_H_ */
@@ -198,6 +198,22 @@ restconf_content_type(FCGX_Request *r)
     return m;
 }
 
+/*! Set FastCGI application exit status of a request
+ * Requests of the native HTTP listener have no FastCGI exit status, the HTTP 
+ * status is given by the Status header line in both cases.
+ * @param[in]  r        Fastcgi request handle
+ * @param[in]  status   Exit status (HTTP status code)
+ * @see RESTCONF_HTTP_ROLE
+ */
+int
+restconf_exit_status(FCGX_Request *r,
+		     int           status)
+{
+    if (r->role != RESTCONF_HTTP_ROLE)
+	FCGX_SetExitStatus(status, r->out);
+    return 0;
+}
+
 /*! HTTP error 400
  * @param[in]  r        Fastcgi request handle
  */
@@ -207,7 +223,7 @@ restconf_badrequest(FCGX_Request *r)
     char *path;
 
     path = FCGX_GetParam("DOCUMENT_URI", r->envp);
-    FCGX_SetExitStatus(400, r->out);
+    restconf_exit_status(r, 400);
     FCGX_FPrintF(r->out, "Status: 400 Bad Request\r\n"); /* 400 bad request */
     FCGX_FPrintF(r->out, "Content-Type: text/html\r\n\r\n");
     FCGX_FPrintF(r->out, "<h1>Clixon Bad request/h1>\n");
@@ -225,7 +241,7 @@ restconf_unauthorized(FCGX_Request *r)
     char *path;
 
     path = FCGX_GetParam("DOCUMENT_URI", r->envp);
-    FCGX_SetExitStatus(401, r->out);
+    restconf_exit_status(r, 401);
     FCGX_FPrintF(r->out, "Status: 401 Unauthorized\r\n"); /* 401 unauthorized */
     FCGX_FPrintF(r->out, "Content-Type: text/html\r\n\r\n");
     FCGX_FPrintF(r->out, "<error-tag>access-denied</error-tag>\n");
@@ -242,7 +258,7 @@ restconf_forbidden(FCGX_Request *r)
     char *path;
 
     path = FCGX_GetParam("DOCUMENT_URI", r->envp);
-    FCGX_SetExitStatus(403, r->out);
+    restconf_exit_status(r, 403);
     FCGX_FPrintF(r->out, "Status: 403 Forbidden\r\n"); /* 403 forbidden */
     FCGX_FPrintF(r->out, "Content-Type: text/html\r\n\r\n");
     FCGX_FPrintF(r->out, "<h1>Forbidden</h1>\n");
@@ -259,7 +275,7 @@ restconf_notfound(FCGX_Request *r)
     char *path;
 
     path = FCGX_GetParam("DOCUMENT_URI", r->envp);
-    FCGX_SetExitStatus(404, r->out);
+    restconf_exit_status(r, 404);
     FCGX_FPrintF(r->out, "Status: 404 Not Found\r\n"); /* 404 not found */
     FCGX_FPrintF(r->out, "Content-Type: text/html\r\n\r\n");
     FCGX_FPrintF(r->out, "<h1>Not Found</h1>\n");
@@ -278,7 +294,7 @@ restconf_notacceptable(FCGX_Request *r)
     char *path;
 
     path = FCGX_GetParam("DOCUMENT_URI", r->envp);
-    FCGX_SetExitStatus(406, r->out);
+    restconf_exit_status(r, 406);
     FCGX_FPrintF(r->out, "Status: 406 Not Acceptable\r\n"); /* 406 not acceptible */
 
     FCGX_FPrintF(r->out, "Content-Type: text/html\r\n\r\n");
@@ -295,7 +311,7 @@ restconf_notacceptable(FCGX_Request *r)
 int
 restconf_conflict(FCGX_Request *r)
 {
-    FCGX_SetExitStatus(409, r->out);
+    restconf_exit_status(r, 409);
     FCGX_FPrintF(r->out, "Status: 409 Conflict\r\n"); /* 409 Conflict */
     FCGX_FPrintF(r->out, "Content-Type: text/html\r\n\r\n");
     FCGX_FPrintF(r->out, "<h1>Data resource already exists</h1>\n");
@@ -308,7 +324,7 @@ restconf_conflict(FCGX_Request *r)
 int
 restconf_unsupported_media(FCGX_Request *r)
 {
-    FCGX_SetExitStatus(415, r->out);
+    restconf_exit_status(r, 415);
     FCGX_FPrintF(r->out, "Status: 415 Unsupported Media Type\r\n"); 
     FCGX_FPrintF(r->out, "Content-Type: text/html\r\n\r\n");
     FCGX_FPrintF(r->out, "<h1>Unsupported Media Type</h1>\n");
@@ -491,7 +507,7 @@ api_return_err(clicon_handle h,
 	reason_phrase="";
     if (xml_name_set(xerr, "error") < 0)
 	goto done;
-    FCGX_SetExitStatus(code, r->out); /* Created */
+    restconf_exit_status(r, code); /* Created */
     FCGX_FPrintF(r->out, "Status: %d %s\r\n", code, reason_phrase);
     FCGX_FPrintF(r->out, "Content-Type: %s\r\n\r\n", restconf_media_int2str(media));
     switch (media){
@@ -41,6 +41,10 @@
  */
 #define RESTCONF_API       "restconf"
 
+/* FCGX_Request role of requests from the native HTTP listener. FastCGI roles 
+ * are 1-3, see restconf_http.c */
+#define RESTCONF_HTTP_ROLE 0
+
 /*
  * Types
  */
@@ -66,6 +70,7 @@ const char *restconf_code2reason(int code);
 const restconf_media restconf_media_str2int(char *media);
 const char *restconf_media_int2str(restconf_media media);
 restconf_media restconf_content_type(FCGX_Request *r);
+int restconf_exit_status(FCGX_Request *r, int status);
 int restconf_badrequest(FCGX_Request *r);
 int restconf_unauthorized(FCGX_Request *r);
 int restconf_forbidden(FCGX_Request *r);
@@ -80,7 +80,9 @@
 #include "restconf_methods.h"
 #include "restconf_methods_get.h"
 #include "restconf_methods_post.h"
+#include "restconf_http.h"
 #include "restconf_stream.h"
+#include "restconf_cache.h"
 
 /* Command line options to be passed to getopt(3) */
 #define RESTCONF_OPTS "hD:f:l:p:d:y:a:u:o:"
@@ -193,7 +195,7 @@ api_well_known(clicon_handle h,
     FCGX_FPrintF(r->out, "Cache-Control: no-cache\r\n");
     FCGX_FPrintF(r->out, "Content-Type: application/xrd+xml\r\n");
     FCGX_FPrintF(r->out, "\r\n");
-    FCGX_SetExitStatus(200, r->out); /* OK */
+    restconf_exit_status(r, 200); /* OK */
     FCGX_FPrintF(r->out, "<XRD xmlns='http://docs.oasis-open.org/ns/xri/xrd-1.0'>\n");
     FCGX_FPrintF(r->out, "   <Link rel='restconf' href='/restconf'/>\n");
     FCGX_FPrintF(r->out, "</XRD>\r\n");
@@ -224,7 +226,7 @@ api_root(clicon_handle  h,
 	clicon_err(OE_FATAL, 0, "No DB_SPEC");
 	goto done;
     }
-    FCGX_SetExitStatus(200, r->out); /* OK */
+    restconf_exit_status(r, 200); /* OK */
     FCGX_FPrintF(r->out, "Status: 200 OK\r\n");
     FCGX_FPrintF(r->out, "Cache-Control: no-cache\r\n");
 
@@ -280,7 +282,7 @@ api_yang_library_version(clicon_handle h,
     char  *ietf_yang_library_revision = "2016-06-21"; /* XXX */
 
     clicon_debug(1, "%s", __FUNCTION__);
-    FCGX_SetExitStatus(200, r->out); /* OK */
+    restconf_exit_status(r, 200); /* OK */
     FCGX_FPrintF(r->out, "Cache-Control: no-cache\r\n");
     FCGX_FPrintF(r->out, "Content-Type: %s\r\n", restconf_media_int2str(media_out));
     FCGX_FPrintF(r->out, "\r\n");
@@ -469,20 +471,34 @@ api_restconf(clicon_handle h,
 /* Need global variable to for signal handler XXX */
 static clicon_handle _CLICON_HANDLE = NULL;
 
+/* Pids of worker processes, only set in the parent, see restconf_workers */
+static pid_t *_WORKERS = NULL;
+static int    _NWORKERS = 0;
+
 /*! Signall terminates process
  */
 static void
 restconf_sig_term(int arg)
 {
-    static int i=0;
+    static int k=0;
+    int        i;
 
-    if (i++ == 0)
+    if (k++ == 0)
 	clicon_log(LOG_NOTICE, "%s: %s: pid: %u Signal %d", 
 		   __PROGRAM__, __FUNCTION__, getpid(), arg);
     else
 	exit(-1);
+    if (_WORKERS){
+	for (i=0; i<_NWORKERS; i++)
+	    if (_WORKERS[i] > 0)
+		kill(_WORKERS[i], SIGTERM);
+	free(_WORKERS);
+	_WORKERS = NULL;
+    }
     if (_CLICON_HANDLE){
-	stream_child_freeall(_CLICON_HANDLE);
+	stream_mux_freeall(_CLICON_HANDLE);
+	restconf_http_close(_CLICON_HANDLE);
+	restconf_cache_exit(_CLICON_HANDLE);
 	restconf_terminate(_CLICON_HANDLE);
     }
     clicon_exit_set(); /* checked in event_loop() */
@@ -527,14 +543,151 @@ restconf_main_extension_cb(clicon_handle h,
     return retval;
 }
 
-static void
-restconf_sig_child(int arg)
+/*! Process a restconf request, from FastCGI or the native HTTP listener
+ * @param[in]  h       Clicon handle
+ * @param[in]  r       Request handle
+ * @param[out] finish  Set to 0 if request is taken over by a stream subscriber
+ * @see restconf_dispatch_fn_t
+ */
+static int
+restconf_request(clicon_handle h,
+		 FCGX_Request *r,
+		 int          *finish)
+{
+    char *path;
+    char *stream_path;
+
+    clicon_debug(1, "------------");
+    stream_path = clicon_option_str(h, "CLICON_STREAM_PATH");
+    if ((path = FCGX_GetParam("REQUEST_URI", r->envp)) != NULL){
+	clicon_debug(1, "path: %s", path);
+	if (strncmp(path, "/" RESTCONF_API, strlen("/" RESTCONF_API)) == 0)
+	    api_restconf(h, r); /* This is the function */
+	else if (strncmp(path+1, stream_path, strlen(stream_path)) == 0) {
+	    api_stream(h, r, stream_path, finish); 
+	}
+	else if (strncmp(path, RESTCONF_WELL_KNOWN, strlen(RESTCONF_WELL_KNOWN)) == 0) {
+	    api_well_known(h, r); /*  */
+	}
+	else{
+	    clicon_debug(1, "top-level %s not found", path);
+	    restconf_notfound(r);
+	}
+    }
+    else
+	clicon_debug(1, "NULL URI");
+    return 0;
+}
+
+/*! Accept and process a FastCGI request, called when the FastCGI socket is readable
+ * Every accepted request has its own request handle, since stream requests are
+ * kept open by stream subscribers, served by the event loop together with new
+ * requests.
+ * @param[in]  s    FastCGI listen socket
+ * @param[in]  arg  Clicon handle
+ */
+static int
+restconf_fcgi_cb(int   s,
+		 void *arg)
+{
+    int           retval = -1;
+    clicon_handle h = (clicon_handle)arg;
+    FCGX_Request *r = NULL;
+    int           finish = 1; /* If zero, request is taken over by subscriber */
+    int           ret;
+
+    if ((r = malloc(sizeof(*r))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    if (FCGX_InitRequest(r, s, 0) != 0){
+	clicon_err(OE_CFG, errno, "FCGX_InitRequest");
+	goto done;
+    }
+    if ((ret = FCGX_Accept_r(r)) < 0) {
+	if (ret == -EAGAIN || ret == -EWOULDBLOCK) /* Taken by another worker */
+	    goto ok;
+	clicon_err(OE_CFG, errno, "FCGX_Accept_r");
+	goto done;
+    }
+    ret = restconf_request(h, r, &finish);
+    if (finish)
+	FCGX_Finish_r(r);
+    else /* Owned and freed by stream subscriber */
+	r = NULL;
+    if (ret < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (r)
+	free(r);
+    return retval;
+}
+
+/*! Fork worker processes accepting requests on the FastCGI socket
+ * The parent does not serve requests, it waits for the workers and restarts
+ * a worker if it exits. This only returns in the workers (or on error).
+ * @param[in]  h     Clicon handle
+ * @param[in]  sock  FastCGI listen socket
+ * @param[in]  n     Number of workers
+ * @see CLICON_RESTCONF_WORKERS
+ */
+static int
+restconf_workers(clicon_handle h,
+		 int           sock,
+		 int           n)
 {
-    int status;
-    int pid;
+    int   retval = -1;
+    int   i;
+    pid_t pid;
+    int   status;
 
-    if ((pid = waitpid(-1, &status, 0)) != -1 && WIFEXITED(status))
-	stream_child_free(_CLICON_HANDLE, pid);
+    /* Workers wait for the socket in the event loop and may lose the race 
+     * for a new connection: accept must not block */
+    if (fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	goto done;
+    }
+    if ((_WORKERS = calloc(n, sizeof(pid_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    _NWORKERS = n;
+    while (1){
+	for (i=0; i<n; i++){
+	    if (_WORKERS[i] != 0)
+		continue;
+	    if ((pid = fork()) < 0){
+		clicon_err(OE_UNIX, errno, "fork");
+		goto done;
+	    }
+	    if (pid == 0){ /* worker */
+		free(_WORKERS);
+		_WORKERS = NULL;
+		_NWORKERS = 0;
+		goto ok;
+	    }
+	    _WORKERS[i] = pid;
+	}
+	if ((pid = waitpid(-1, &status, 0)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "waitpid");
+	    goto done;
+	}
+	for (i=0; i<n; i++)
+	    if (_WORKERS[i] == pid){
+		clicon_log(LOG_WARNING, "%s: worker %u exited with status %d, restarting",
+			   __FUNCTION__, pid, status);
+		_WORKERS[i] = 0;
+		sleep(1); /* Avoid fork loop if workers fail at once */
+	    }
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
 }
 
 /*! Usage help routine
@@ -573,22 +726,16 @@ main(int    argc,
     int            retval = -1;
     int            sock;
     char	  *argv0 = argv[0];
-    FCGX_Request   request;
-    FCGX_Request  *r = &request;
     int            c;
     char          *sockpath;
-    char          *path;
     clicon_handle  h;
     char          *dir;
     int            logdst = CLICON_LOG_SYSLOG;
     yang_stmt     *yspec = NULL;
-    char          *stream_path;
-    int            finish = 0;
-    int            start = 1;
     char          *str;
     clixon_plugin *cp = NULL;
-    uint32_t       id = 0;
     cvec          *nsctx_global = NULL; /* Global namespace context */
+    int            nworkers;
     
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__PROGRAM__, LOG_INFO, logdst); 
@@ -636,16 +783,11 @@ main(int    argc,
 	clicon_err(OE_DAEMON, errno, "Setting signal");
 	goto done;
     }
-    if (set_signal(SIGCHLD, restconf_sig_child, NULL) < 0){
-	clicon_err(OE_DAEMON, errno, "Setting signal");
-	goto done;
-    }
 
     /* Find and read configfile */
     if (clicon_options_main(h) < 0)
 	goto done;
 
-    stream_path = clicon_option_str(h, "CLICON_STREAM_PATH");
     /* Now rest of options, some overwrite option file */
     optind = 1;
     opterr = 0;
@@ -756,6 +898,10 @@ main(int    argc,
      if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277") &&
 	 yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
 	 goto done;
+     /* Response cache state augments restconf-state */
+     if (restconf_cache_enabled(h) &&
+	 yang_spec_parse_module(h, "clixon-restconf", NULL, yspec)< 0)
+	 goto done;
 
      /* Here all modules are loaded 
       * Compute and set canonical namespace context
@@ -795,61 +941,25 @@ main(int    argc,
 	clicon_err(OE_UNIX, errno, "chmod");
 	goto done;
     }
-    if (FCGX_InitRequest(r, sock, 0) != 0){
-	clicon_err(OE_CFG, errno, "FCGX_InitRequest");
-	goto done;
-    }
-    while (1) {
-	finish = 1; /* If zero, dont finish request, initiate new */
-
-	if (FCGX_Accept_r(r) < 0) {
-	    clicon_err(OE_CFG, errno, "FCGX_Accept_r");
+    /* Optional native HTTP listener, shared by workers */
+    if (restconf_http_open(h, restconf_request) < 0)
+	goto done;
+    if ((nworkers = clicon_option_int(h, "CLICON_RESTCONF_WORKERS")) == 0)
+	nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nworkers > 1){
+	clicon_debug(1, "restconf_main: Starting %d workers", nworkers);
+	if (restconf_workers(h, sock, nworkers) < 0)
 	    goto done;
-	}
-	clicon_debug(1, "------------");
-
-	if (start == 0){
-	    /* Send hello request to backend to get session-id back
-	     * This is done once at the beginning of the session and then this is
-	     * used by the client, even though new TCP sessions are created for
-	     * each message sent to the backend.
-	     */
-	    if (clicon_hello_req(h, &id) < 0)
-		goto done;
-	    clicon_session_id_set(h, id);
-	    start++;
-	}
-
-	if ((path = FCGX_GetParam("REQUEST_URI", r->envp)) != NULL){
-	    clicon_debug(1, "path: %s", path);
-	    if (strncmp(path, "/" RESTCONF_API, strlen("/" RESTCONF_API)) == 0)
-		api_restconf(h, r); /* This is the function */
-	    else if (strncmp(path+1, stream_path, strlen(stream_path)) == 0) {
-		api_stream(h, r, stream_path, &finish); 
-	    }
-	    else if (strncmp(path, RESTCONF_WELL_KNOWN, strlen(RESTCONF_WELL_KNOWN)) == 0) {
-		api_well_known(h, r); /*  */
-	    }
-	    else{
-		clicon_debug(1, "top-level %s not found", path);
-		restconf_notfound(r);
-	    }
-	}
-	else
-	    clicon_debug(1, "NULL URI");
-	if (finish)
-	    FCGX_Finish_r(r);
-	else{ /* A handler is forked so we initiate a new request after instead 
-		 of finnishing the old */
-	    if (FCGX_InitRequest(r, sock, 0) != 0){
-		clicon_err(OE_CFG, errno, "FCGX_InitRequest");
-		goto done;
-	    }
-	}
     }
+    if (event_reg_fd(sock, restconf_fcgi_cb, (void*)h, "restconf fastcgi socket") < 0)
+	goto done;
+    if (event_loop() < 0)
+	goto done;
     retval = 0;
  done:
-    stream_child_freeall(h);
+    stream_mux_freeall(h);
+    restconf_http_close(h);
+    restconf_cache_exit(h);
     restconf_terminate(h);
     return retval;
 }
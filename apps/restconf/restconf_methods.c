@@ -140,7 +140,7 @@ api_data_options(clicon_handle h,
 		 FCGX_Request *r)
 {
     clicon_debug(1, "%s", __FUNCTION__);
-    FCGX_SetExitStatus(200, r->out); /* OK */
+    restconf_exit_status(r, 200); /* OK */
     FCGX_FPrintF(r->out, "Allow: OPTIONS,HEAD,GET,POST,PUT,PATCH,DELETE\r\n");
     FCGX_FPrintF(r->out, "Accept-Patch: application/yang-data+xml,application/yang-data+json\r\n");
     FCGX_FPrintF(r->out, "\r\n");
@@ -652,11 +652,11 @@ api_data_write(clicon_handle h,
     }
     /* Check if it was created, or if we tried again and replaced it */
     if (op == OP_CREATE){
-	FCGX_SetExitStatus(201, r->out); /* Created */
+	restconf_exit_status(r, 201); /* Created */
 	FCGX_FPrintF(r->out, "Status: 201 Created\r\n");
     }
     else{
-	FCGX_SetExitStatus(204, r->out); /* Replaced */
+	restconf_exit_status(r, 204); /* Replaced */
 	FCGX_FPrintF(r->out, "Status: 204 No Content\r\n");
     }
     FCGX_FPrintF(r->out, "\r\n");
@@ -919,7 +919,7 @@ api_data_delete(clicon_handle h,
 	    clicon_log(LOG_WARNING, "%s: copy-config running->startup failed", __FUNCTION__);
 	}
     }
-    FCGX_SetExitStatus(204, r->out);
+    restconf_exit_status(r, 204);
     FCGX_FPrintF(r->out, "Status: 204 No Content\r\n");
     FCGX_FPrintF(r->out, "Content-Type: text/plain\r\n");
     FCGX_FPrintF(r->out, "\r\n");
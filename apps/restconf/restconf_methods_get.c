@@ -47,6 +47,7 @@
 #include <time.h>
 #include <signal.h>
 #include <limits.h>
+#include <inttypes.h>
 #include <sys/time.h>
 #include <sys/wait.h>
 
@@ -59,8 +60,234 @@
 #include <fcgiapp.h> /* Need to be after clixon_xml-h due to attribute format */
 
 #include "restconf_lib.h"
+#include "restconf_cache.h"
 #include "restconf_methods_get.h"
 
+/*! Check if a yang node and all its descendants are config data
+ * @param[in]  ys   Yang node, or yang spec for all modules
+ * @retval     1    Only config data 
+ * @retval     0    Some node is config false (state data)
+ */
+static int
+api_data_config_only(yang_stmt *ys)
+{
+    yang_stmt *yc = NULL;
+
+    while ((yc = yn_each(ys, yc)) != NULL){
+	switch (yang_keyword_get(yc)){
+	case Y_CONTAINER:
+	case Y_LIST:
+	case Y_LEAF:
+	case Y_LEAF_LIST:
+	case Y_ANYXML:
+	    if (yang_config(yc) == 0)
+		return 0;
+	    /* fall thru */
+	case Y_MODULE:
+	case Y_CHOICE:
+	case Y_CASE:
+	    if (api_data_config_only(yc) == 0)
+		return 0;
+	    break;
+	default:
+	    break;
+	}
+    }
+    return 1;
+}
+
+/*! Check if a data resource is config data only
+ * Only config data is covered by backend generations and the response cache
+ * @param[in]  h        Clixon handle
+ * @param[in]  pcvec    Vector of path ie DOCUMENT_URI element 
+ * @param[in]  pi       Offset, where path starts  
+ * @param[in]  content  Content query parameter
+ * @retval    -1        Error
+ * @retval     0        Resource may contain state data, or is not found
+ * @retval     1        Config data only
+ */
+static int
+api_data_config(clicon_handle   h,
+		cvec           *pcvec,
+		int             pi,
+		netconf_content content)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    yang_stmt *ymod;
+    yang_stmt *y = NULL;
+    char      *prefix = NULL;
+    char      *name = NULL;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_FATAL, 0, "No DB_SPEC");
+	goto done;
+    }
+    if (content == CONTENT_NONCONFIG)
+	goto fail;
+    if (pi < cvec_len(pcvec)){
+	if (nodeid_split(cv_name_get(cvec_i(pcvec, pi)), &prefix, &name) < 0)
+	    goto done;
+	if (prefix == NULL ||
+	    (ymod = yang_find_module_by_name(yspec, prefix)) == NULL ||
+	    (y = yang_find_datanode(ymod, name)) == NULL)
+	    goto fail; /* Error is returned by regular get */
+    }
+    if (content == CONTENT_ALL){
+	if (y != NULL){
+	    if (yang_config(y) == 0 || api_data_config_only(y) == 0)
+		goto fail;
+	}
+	else if (api_data_config_only(yspec) == 0)
+	    goto fail;
+    }
+    retval = 1;
+ done:
+    if (prefix)
+	free(prefix);
+    if (name)
+	free(name);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Make entity-tag of a config data resource
+ * The entity-tag is made from the backend generation of the top-level subtree of 
+ * the resource, returned with the data, see clicon_rpc_get_generation(). With
+ * If-None-Match, only the generation is requested first, see clicon_rpc_generation().
+ * With NACM, the generation of the NACM rules (modification time of the NACM file
+ * if external) and the user is also part of the tag.
+ * @param[in]  h        Clixon handle
+ * @param[in]  gen      Generation of top-level subtree
+ * @param[in]  ngen     Generation of NACM rules
+ * @param[out] etag     Entity-tag, eg W/"16b3e8c0d9a12"
+ * See RFC 8040 Sec 3.4.1.2 and 3.4.1.3
+ * @see api_data_config  Check that resource is config data
+ */
+static void
+api_data_etag(clicon_handle h,
+	      uint64_t      gen,
+	      uint64_t      ngen,
+	      cbuf         *etag)
+{
+    char      *mode;
+    char      *username;
+    uint32_t   uhash = 2166136261U; /* FNV-1a */
+
+    cprintf(etag, "W/\"%" PRIx64, gen);
+    if ((mode = clicon_option_str(h, "CLICON_NACM_MODE")) != NULL &&
+	strcmp(mode, "disabled") != 0){
+	cprintf(etag, "-%" PRIx64, ngen);
+	if ((username = clicon_username_get(h)) != NULL)
+	    for (; *username; username++)
+		uhash = (uhash ^ (unsigned char)*username) * 16777619U;
+	cprintf(etag, "-%x", uhash);
+    }
+    cprintf(etag, "\"");
+}
+
+/*! Check if an entity-tag matches a If-None-Match request header
+ * @param[in]  hdr   Value of If-None-Match, eg W/"1a2b", "3c4d"
+ * @param[in]  etag  Entity-tag of resource
+ * @retval     1     Match, ie "304 Not Modified"
+ * @retval     0     No match
+ * Uses weak comparison, see RFC 7232 Sec 2.3.2 and 3.2
+ */
+static int
+api_data_etag_match(char *hdr,
+		    char *etag)
+{
+    char  *s;
+    char  *e;
+    size_t len;
+
+    if (strncmp(etag, "W/", 2) == 0)
+	etag += 2;
+    len = strlen(etag);
+    s = hdr;
+    while (*s){
+	while (*s == ' ' || *s == '\t' || *s == ',')
+	    s++;
+	if (strncmp(s, "W/", 2) == 0)
+	    s += 2;
+	if ((e = strchr(s, ',')) == NULL)
+	    e = s + strlen(s);
+	while (e > s && (e[-1] == ' ' || e[-1] == '\t'))
+	    e--;
+	if (e - s == len && strncmp(s, etag, len) == 0)
+	    return 1;
+	s = e;
+	while (*s && *s != ',')
+	    s++;
+    }
+    return 0;
+}
+
+/*! Print ETag and Last-Modified response headers, if there is an entity-tag
+ * @param[in]  r        Fastcgi request handle
+ * @param[in]  etag     Entity-tag, or NULL
+ * @param[in]  modified Last-modified time
+ */
+static int
+api_data_etag_headers(FCGX_Request *r,
+		      char         *etag,
+		      time_t        modified)
+{
+    struct tm tm;
+    char      date[64];
+
+    if (etag == NULL)
+	return 0;
+    FCGX_FPrintF(r->out, "ETag: %s\r\n", etag);
+    if (modified && gmtime_r(&modified, &tm) != NULL &&
+	strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm) > 0)
+	FCGX_FPrintF(r->out, "Last-Modified: %s\r\n", date);
+    return 0;
+}
+
+/*! Reply to a GET or HEAD of a data resource
+ * @param[in]  r         Fastcgi request handle
+ * @param[in]  etag      Entity-tag, or NULL
+ * @param[in]  modified  Last-modified time
+ * @param[in]  media_out Output media
+ * @param[in]  body      Reply body
+ * @param[in]  head      If 1 is HEAD, otherwise GET
+ * @param[in]  inm       If-None-Match request header, or NULL
+ * If the entity-tag matches If-None-Match, "304 Not Modified" is sent without body
+ */
+static int
+api_data_get_reply(FCGX_Request  *r,
+		   char          *etag,
+		   time_t         modified,
+		   restconf_media media_out,
+		   char          *body,
+		   int            head,
+		   char          *inm)
+{
+    if (etag && inm && api_data_etag_match(inm, etag)){
+	restconf_exit_status(r, 304); /* Not Modified */
+	FCGX_FPrintF(r->out, "Status: 304 Not Modified\r\n");
+	api_data_etag_headers(r, etag, modified);
+	FCGX_FPrintF(r->out, "\r\n");
+	return 0;
+    }
+    restconf_exit_status(r, 200); /* OK */
+    api_data_etag_headers(r, etag, modified);
+    if (head){
+	FCGX_FPrintF(r->out, "Content-Type: %s\r\n", restconf_media_int2str(media_out));
+	FCGX_FPrintF(r->out, "\r\n");
+	return 0;
+    }
+    FCGX_FPrintF(r->out, "Cache-Control: no-cache\r\n");
+    FCGX_FPrintF(r->out, "Content-Type: %s\r\n", restconf_media_int2str(media_out));
+    FCGX_FPrintF(r->out, "\r\n");
+    FCGX_FPrintF(r->out, "%s", body?body:"");
+    FCGX_FPrintF(r->out, "\r\n\r\n");
+    return 0;
+}
+
 /*! Generic GET (both HEAD and GET)
  * According to restconf 
  * @param[in]  h      Clixon handle
@@ -116,6 +343,18 @@ api_data_get2(clicon_handle h,
     char      *attr; /* attribute value string */
     netconf_content content = CONTENT_ALL;
     int32_t    depth = -1;  /* Nr of levels to print, -1 is all, 0 is none */
+    enum withdefaults_type wdef = WITHDEFAULTS_REPORT_ALL;
+    cbuf      *cbetag = NULL; /* Entity-tag if config data */
+    time_t     modified = 0;
+    char      *inm = NULL;    /* If-None-Match request header */
+    cbuf      *cbkey = NULL;  /* Response cache key */
+    char      *body = NULL;   /* Cached reply */
+    char      *etag = NULL;   /* Entity-tag of cached reply */
+    uint64_t   epoch = 0;
+    int        config = 0;    /* Config data only: entity-tag */
+    uint64_t   gen = 0;
+    uint64_t   ngen = 0;
+    char      *subtree = NULL; /* Top-level subtree of resource */
     
     clicon_debug(1, "%s", __FUNCTION__);
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
@@ -161,6 +400,22 @@ api_data_get2(clicon_handle h,
 	    }
 	}
     }
+    /* Check for with-defaults attribute, RFC 8040 Sec 4.8.9 */
+    if ((attr = cvec_find_str(qvec, "with-defaults")) != NULL){
+	clicon_debug(1, "%s with-defaults=%s", __FUNCTION__, attr);
+	if ((int)(wdef = netconf_withdefaults_str2int(attr)) == -1){
+	    if (netconf_bad_attribute_xml(&xerr, "application",
+					  "<bad-attribute>with-defaults</bad-attribute>", "Unrecognized value of with-defaults attribute") < 0)
+		goto done;
+	    if ((xe = xpath_first(xerr, NULL, "rpc-error")) == NULL){
+		clicon_err(OE_XML, EINVAL, "rpc-error not found (internal error)");
+		goto done;
+	    }
+	    if (api_return_err(h, r, xe, pretty, media_out, 0) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
     if ((cbpath = cbuf_new()) == NULL)
         goto done;
     cprintf(cbpath, "/");
@@ -181,11 +436,66 @@ api_data_get2(clicon_handle h,
     }
     xpath = cbuf_get(cbpath);
     clicon_debug(1, "%s path:%s", __FUNCTION__, xpath);
+    /* Config data has entity-tag and may be in response cache */
+    if ((ret = api_data_config(h, pcvec, pi, content)) < 0)
+	goto done;
+    if (ret == 1){
+	config = 1;
+	if (pi < cvec_len(pcvec))
+	    subtree = cv_name_get(cvec_i(pcvec, pi));
+	inm = FCGX_GetParam("HTTP_IF_NONE_MATCH", r->envp);
+	if (restconf_cache_enabled(h)){
+	    if ((cbkey = cbuf_new()) == NULL)
+		goto done;
+	    if (restconf_cache_key(h, r, qvec, media_out, cbkey) == 0){
+		cbuf_free(cbkey);
+		cbkey = NULL;
+	    }
+	    else{
+		if ((ret = restconf_cache_lookup(h, cbuf_get(cbkey), &body, &etag,
+						 &modified, &epoch)) < 0)
+		    goto done;
+		if (ret == 1){ /* Hit: no backend rpc */
+		    if (api_data_get_reply(r, etag, modified, media_out, body, head, inm) < 0)
+			goto done;
+		    goto ok;
+		}
+	    }
+	}
+	/* Conditional request: only generation, no data if not modified */
+	if (inm){
+	    if (clicon_rpc_generation(h, "running", subtree, &gen, &ngen, &modified) < 0){
+		if (netconf_operation_failed_xml(&xerr, "protocol", clicon_err_reason) < 0)
+		    goto done;
+		if ((xe = xpath_first(xerr, NULL, "rpc-error")) == NULL){
+		    clicon_err(OE_XML, EINVAL, "rpc-error not found (internal error)");
+		    goto done;
+		}
+		if (api_return_err(h, r, xe, pretty, media_out, 0) < 0)
+		    goto done;
+		goto ok;
+	    }
+	    if ((cbetag = cbuf_new()) == NULL)
+		goto done;
+	    api_data_etag(h, gen, ngen, cbetag);
+	    if (api_data_etag_match(inm, cbuf_get(cbetag))){
+		if (api_data_get_reply(r, cbuf_get(cbetag), modified, media_out, NULL, head, inm) < 0)
+		    goto done;
+		goto ok;
+	    }
+	    cbuf_free(cbetag);
+	    cbetag = NULL;
+	}
+    }
     switch (content){
     case CONTENT_CONFIG:
     case CONTENT_NONCONFIG:
     case CONTENT_ALL:
-	ret = clicon_rpc_get(h, xpath, nsc, content, depth, &xret);
+	if (config) /* Generation is returned with the data */
+	    ret = clicon_rpc_get_generation(h, xpath, nsc, content, depth, wdef, subtree,
+					    &xret, &gen, &ngen, &modified);
+	else
+	    ret = clicon_rpc_get(h, xpath, nsc, content, depth, wdef, &xret);
 	break;
     default:
 	clicon_err(OE_XML, EINVAL, "Invalid content attribute %d", content);
@@ -203,6 +513,14 @@ api_data_get2(clicon_handle h,
 	    goto done;
 	goto ok;
     }
+    /* Add response cache state to restconf-state */
+    if (restconf_cache_enabled(h) &&
+	content != CONTENT_CONFIG &&
+	strcmp(xml_name(xret), "data") == 0 &&
+	(pi == cvec_len(pcvec) ||
+	 strcmp(cv_name_get(cvec_i(pcvec, pi)), "ietf-restconf-monitoring:restconf-state") == 0))
+	if (restconf_cache_state(h, xret) < 0)
+	    goto done;
     if (xml_apply(xret, CX_ELMNT, xml_spec_populate, yspec) < 0)
 	goto done;
     /* We get return via netconf which is complete tree from root 
@@ -222,13 +540,24 @@ api_data_get2(clicon_handle h,
 	    goto done;
 	goto ok;
     }
+    /* Entity-tag from generation returned with the data */
+    if (config && gen != 0){
+	if ((cbetag = cbuf_new()) == NULL)
+	    goto done;
+	api_data_etag(h, gen, ngen, cbetag);
+	if (inm && api_data_etag_match(inm, cbuf_get(cbetag))){
+	    if (api_data_get_reply(r, cbuf_get(cbetag), modified, media_out, NULL, head, inm) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
     /* Normal return, no error */
     if ((cbx = cbuf_new()) == NULL)
 	goto done;
     if (head){
-	FCGX_SetExitStatus(200, r->out); /* OK */
-	FCGX_FPrintF(r->out, "Content-Type: %s\r\n", restconf_media_int2str(media_out));
-	FCGX_FPrintF(r->out, "\r\n");
+	if (api_data_get_reply(r, cbetag?cbuf_get(cbetag):NULL, modified, media_out,
+			       NULL, 1, NULL) < 0)
+	    goto done;
 	goto ok;
     }
     if (xpath==NULL || strcmp(xpath,"/")==0){ /* Special case: data root */
@@ -299,12 +628,14 @@ api_data_get2(clicon_handle h,
 	}
     }
     clicon_debug(1, "%s cbuf:%s", __FUNCTION__, cbuf_get(cbx));
-    FCGX_SetExitStatus(200, r->out); /* OK */
-    FCGX_FPrintF(r->out, "Cache-Control: no-cache\r\n");
-    FCGX_FPrintF(r->out, "Content-Type: %s\r\n", restconf_media_int2str(media_out));
-    FCGX_FPrintF(r->out, "\r\n");
-    FCGX_FPrintF(r->out, "%s", cbx?cbuf_get(cbx):"");
-    FCGX_FPrintF(r->out, "\r\n\r\n");
+    if (api_data_get_reply(r, cbetag?cbuf_get(cbetag):NULL, modified, media_out,
+			   cbuf_get(cbx), 0, NULL) < 0)
+	goto done;
+    if (cbkey && cbetag &&
+	restconf_cache_add(h, cbuf_get(cbkey),
+			   pi < cvec_len(pcvec)?cv_name_get(cvec_i(pcvec, pi)):NULL,
+			   cbuf_get(cbx), cbuf_get(cbetag), modified, epoch) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -313,6 +644,10 @@ api_data_get2(clicon_handle h,
 	xml_nsctx_free(nsc);
     if (cbx)
         cbuf_free(cbx);
+    if (cbetag)
+	cbuf_free(cbetag);
+    if (cbkey)
+	cbuf_free(cbkey);
     if (cbpath)
 	cbuf_free(cbpath);
     if (xret)
@@ -490,7 +825,7 @@ api_operations_get(clicon_handle h,
     default:
 	break;
     }
-    FCGX_SetExitStatus(200, r->out); /* OK */
+    restconf_exit_status(r, 200); /* OK */
     FCGX_FPrintF(r->out, "Content-Type: %s\r\n", restconf_media_int2str(media_out));
     FCGX_FPrintF(r->out, "\r\n");
     FCGX_FPrintF(r->out, "%s", cbx?cbuf_get(cbx):"");
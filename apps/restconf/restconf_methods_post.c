@@ -386,7 +386,7 @@ api_data_post(clicon_handle h,
 	    clicon_log(LOG_WARNING, "%s: copy-config running->startup failed", __FUNCTION__);
 	}
     }
-    FCGX_SetExitStatus(201, r->out);
+    restconf_exit_status(r, 201);
     FCGX_FPrintF(r->out, "Status: 201 Created\r\n");
     http_location(r, xdata);
     FCGX_GetParam("HTTP_ACCEPT", r->envp);
@@ -663,7 +663,7 @@ api_operations_post_output(clicon_handle h,
 	 strcmp(xml_name(xok),"ok")==0);
     if (isempty) {
 	/* Internal error - invalid output from rpc handler */
-	FCGX_SetExitStatus(204, r->out); /* OK */
+	restconf_exit_status(r, 204); /* OK */
 	FCGX_FPrintF(r->out, "Status: 204 No Content\r\n");
 	FCGX_FPrintF(r->out, "\r\n");
 	goto fail;
@@ -933,7 +933,7 @@ api_operations_post(clicon_handle h,
     if (ret == 0)
 	goto ok;
     /* xoutput should now look: <output xmlns="uri"><x>0</x></output> */
-    FCGX_SetExitStatus(200, r->out); /* OK */
+    restconf_exit_status(r, 200); /* OK */
 
     FCGX_FPrintF(r->out, "Content-Type: %s\r\n", restconf_media_int2str(media_out));
     FCGX_FPrintF(r->out, "\r\n");
@@ -55,6 +55,10 @@
    query parameters, defined in Section 4.8.  Refer to Appendix B.3.6
    for filter parameter examples.
 
+   All stream subscriptions are served by the restconf process itself, from
+   the clixon event loop. Subscribers of the same stream and filter without
+   replay share one backend subscription, and every event received from the 
+   backend is written to all of them.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -70,10 +74,10 @@
 #include <fcntl.h>
 #include <time.h>
 #include <limits.h>
+#include <inttypes.h>
 
-#include <signal.h>
 #include <sys/time.h>
-#include <sys/wait.h>
+#include <sys/socket.h>
 #include <libgen.h>
 
 /* cligen */
@@ -83,84 +87,391 @@
 #include <clixon/clixon.h>
 
 #include <fcgiapp.h> /* Need to be after clixon_xml.h due to attribute format */
+#include <fastcgi.h>
 
 #include "restconf_lib.h"
+#include "restconf_http.h"
 #include "restconf_stream.h"
 
 /*
- * Constants
+ * Types
  */
-/* Enable for forking stream subscription loop. 
- * Disable to get single threading but blocking on streams
+struct stream_sub;
+
+/* A restconf stream subscriber, ie an SSE response on a FastCGI request or on
+ * a native HTTP connection.
+ * The FastCGI connection is non-blocking and owned by the subscriber, which
+ * writes the response as FastCGI records itself, see stream_fcgi_record.
  */
-#define STREAM_FORK 1
+struct stream_consumer{
+    qelem_t                     sc_q;      /* queue header */
+    struct stream_sub          *sc_sub;    /* Backend subscription, NULL if closing */
+    FCGX_Request               *sc_r;      /* FCGI stream data, freed with FastCGI subscriber */
+    struct http_buf             sc_out;    /* Output not yet written (FastCGI records) */
+    struct http_buf             sc_in;     /* FastCGI records from webserver */
+    int                         sc_wreg;   /* Write callback registered */
+    int                         sc_closing;/* End of request queued, close when written */
+};
 
-/* Keep track of children - whjen they exit - their FCGX handle needs to be 
- * freed with  FCGX_Free(&rbk, 0);
+/* A backend subscription, shared by subscribers of the same user, stream and
+ * filter, unless the subscription uses replay (start-time / stop-time).
+ * The user is part of the key since the backend authorizes the subscription
+ * and filters its events with NACM of the user who created it.
  */
-struct stream_child{
-    qelem_t                     sc_q;   /* queue header */
-    int                         sc_pid; /* Child process id */
-    FCGX_Request                sc_r;   /* FCGI stream data */
+struct stream_sub{
+    qelem_t                     ss_q;         /* queue header */
+    clicon_handle               ss_h;
+    char                       *ss_stream;    /* Stream name */
+    char                       *ss_filter;    /* Xpath filter or NULL */
+    char                       *ss_username;  /* User of subscription or NULL */
+    int                         ss_shared;    /* May be shared (no replay) */
+    int                         ss_s;         /* Backend notification socket */
+    struct stream_consumer     *ss_consumers; /* Subscribers */
+    uint64_t                    ss_events;    /* Nr of events received */
+    uint64_t                    ss_dropped;   /* Nr of subscribers dropped as slow */
 };
-/* Linked list of children
- * @note could hang STREAM_CHILD list on clicon handle instead.
+
+/* Linked list of backend subscriptions
+ * @note could hang STREAM_SUBS list on clicon handle instead.
  */
-static struct stream_child *STREAM_CHILD = NULL; 
+static struct stream_sub *STREAM_SUBS = NULL; 
 
-/*! Find restconf child using PID and cleanup FCGI Request data
- * @param[in]  h   Clicon handle
- * @param[in]  pid Process id of child
- * @note could hang STREAM_CHILD list on clicon handle instead.
+/* Linked list of FastCGI subscribers whose end of request is being written */
+static struct stream_consumer *STREAM_CLOSING = NULL; 
+
+static int stream_consumer_read_cb(int s, void *arg);
+static int stream_consumer_write_cb(int s, void *arg);
+static int restconf_stream_cb(int s, void *arg);
+
+/*! Close and free a backend subscription, the backend removes the subscription
+ * @param[in]  ss   Backend subscription
  */
-int
-stream_child_free(clicon_handle h,
-		  int           pid)
+static int
+stream_sub_free(struct stream_sub *ss)
+{
+    event_unreg_fd(ss->ss_s, restconf_stream_cb);
+    close(ss->ss_s);
+    DELQ(ss, STREAM_SUBS, struct stream_sub *);
+    if (ss->ss_stream)
+	free(ss->ss_stream);
+    if (ss->ss_filter)
+	free(ss->ss_filter);
+    if (ss->ss_username)
+	free(ss->ss_username);
+    free(ss);
+    return 0;
+}
+
+/*! Register write callback of a subscriber, if not already registered
+ * @param[in]  sc   Stream subscriber
+ */
+static int
+stream_consumer_wreg(struct stream_consumer *sc)
+{
+    if (sc->sc_wreg)
+	return 0;
+    if (event_reg_fd_write(sc->sc_r->ipcFd, 
+			   stream_consumer_write_cb, 
+			   (void*)sc,
+			   "stream subscriber") < 0)
+	return -1;
+    sc->sc_wreg = 1;
+    return 0;
+}
+
+/*! Append FastCGI records to the output of a FastCGI subscriber
+ * Data longer than FCGI_MAX_LENGTH is split into several records. No data gives
+ * an empty record, which for FCGI_STDOUT ends the response.
+ * @param[in]  sc    Stream subscriber
+ * @param[in]  type  Record type, eg FCGI_STDOUT
+ * @param[in]  data  Record content
+ * @param[in]  len   Length of data
+ * @see FastCGI specification, Sec 3.3
+ */
+static int
+stream_fcgi_record(struct stream_consumer *sc,
+		   int                     type,
+		   char                   *data,
+		   size_t                  len)
+{
+    FCGI_Header hdr = {0,};
+    size_t      n;
+
+    hdr.version = FCGI_VERSION_1;
+    hdr.type = type;
+    hdr.requestIdB1 = (sc->sc_r->requestId >> 8) & 0xff;
+    hdr.requestIdB0 = sc->sc_r->requestId & 0xff;
+    do {
+	n = len > FCGI_MAX_LENGTH ? FCGI_MAX_LENGTH : len;
+	hdr.contentLengthB1 = (n >> 8) & 0xff;
+	hdr.contentLengthB0 = n & 0xff;
+	if (http_buf_append(&sc->sc_out, (char*)&hdr, sizeof(hdr)) < 0 ||
+	    (n && http_buf_append(&sc->sc_out, data, n) < 0))
+	    return -1;
+	data += n;
+	len -= n;
+    } while (len > 0);
+    return 0;
+}
+
+/*! Queue data to a subscriber, it is written when the connection is writable
+ * @param[in]  sc    Stream subscriber
+ * @param[in]  data  Data
+ * @param[in]  len   Length of data, > 0
+ */
+static int
+stream_consumer_queue(struct stream_consumer *sc,
+		      char                   *data,
+		      size_t                  len)
+{
+    if (sc->sc_r->role == RESTCONF_HTTP_ROLE){
+	if (http_buf_append(&sc->sc_out, data, len) < 0)
+	    return -1;
+    }
+    else if (stream_fcgi_record(sc, FCGI_STDOUT, data, len) < 0)
+	return -1;
+    return stream_consumer_wreg(sc);
+}
+
+/*! Remove and free a stream subscriber and close its request
+ * If it is the last subscriber of its backend subscription, the backend 
+ * subscription is closed as well.
+ * A graceful close of a FastCGI subscriber queues the end of the request, and
+ * the subscriber is freed when it is written.
+ * @param[in]  sc       Stream subscriber
+ * @param[in]  graceful If set end the request, otherwise just close the connection
+ *                      (a slow or lost subscriber may not accept more data)
+ */
+static int
+stream_consumer_free(struct stream_consumer *sc,
+		     int                     graceful)
 {
-    struct stream_child *sc;
+    struct stream_sub  *ss = sc->sc_sub;
+    FCGX_Request       *r = sc->sc_r;
+    struct http_buf    *wq = &sc->sc_out;
+    FCGI_EndRequestBody end = {0,};
     
-    if ((sc = STREAM_CHILD) != NULL){
-	do {
-	    if (pid == sc->sc_pid){
-		DELQ(sc, STREAM_CHILD, struct stream_child *);
-		FCGX_Free(&sc->sc_r, 0);
-		free(sc);
-		goto done;
-	    }
-	    sc = NEXTQ(struct stream_child *, sc);
-	} while (sc && sc !=  STREAM_CHILD);
+    if (ss != NULL){
+	DELQ(sc, ss->ss_consumers, struct stream_consumer *);
+	sc->sc_sub = NULL;
+	if (ss->ss_consumers == NULL){
+	    clicon_debug(1, "%s %s: events:%" PRIu64 " dropped:%" PRIu64, __FUNCTION__,
+			 ss->ss_stream, ss->ss_events, ss->ss_dropped);
+	    stream_sub_free(ss);
+	}
     }
- done:
+    if (graceful && r->role != RESTCONF_HTTP_ROLE){
+	if (sc->sc_closing)
+	    return 0;
+	end.appStatusB3 = (r->appStatus >> 24) & 0xff;
+	end.appStatusB2 = (r->appStatus >> 16) & 0xff;
+	end.appStatusB1 = (r->appStatus >> 8) & 0xff;
+	end.appStatusB0 = r->appStatus & 0xff;
+	end.protocolStatus = FCGI_REQUEST_COMPLETE;
+	if (stream_fcgi_record(sc, FCGI_STDOUT, NULL, 0) == 0 &&
+	    stream_fcgi_record(sc, FCGI_END_REQUEST, (char*)&end, sizeof(end)) == 0 &&
+	    stream_consumer_wreg(sc) == 0){
+	    sc->sc_closing = 1;
+	    ADDQ(sc, STREAM_CLOSING);
+	    return 0;
+	}
+    }
+    event_unreg_fd(r->ipcFd, stream_consumer_read_cb);
+    if (sc->sc_wreg)
+	event_unreg_fd_write(r->ipcFd, stream_consumer_write_cb);
+    if (sc->sc_closing)
+	DELQ(sc, STREAM_CLOSING, struct stream_consumer *);
+    if (r->role == RESTCONF_HTTP_ROLE){
+	/* Output is queued on the HTTP connection */
+	if (graceful && wq->hb_off < wq->hb_len)
+	    FCGX_PutStr(wq->hb_buf + wq->hb_off, wq->hb_len - wq->hb_off, r->out);
+	restconf_http_finish(r, graceful);
+    }
+    else{
+	/* Close here, FCGX_Free would wait for the webserver to close */
+	close(r->ipcFd);
+	r->ipcFd = -1;
+	FCGX_Free(r, 0);
+	free(r);
+    }
+    if (wq->hb_buf)
+	free(wq->hb_buf);
+    if (sc->sc_in.hb_buf)
+	free(sc->sc_in.hb_buf);
+    free(sc);
     return 0;
 }
 
+/*! Free all stream subscribers and backend subscriptions
+ * @param[in]  h   Clicon handle
+ */
 int
-stream_child_freeall(clicon_handle h)
+stream_mux_freeall(clicon_handle h)
 {
-    struct stream_child *sc;
+    struct stream_sub *ss;
 
-    while ((sc = STREAM_CHILD) != NULL){
-	DELQ(sc, STREAM_CHILD, struct stream_child *);
-	FCGX_Free(&sc->sc_r, 1);
-	free(sc);
+    while ((ss = STREAM_SUBS) != NULL)
+	while (ss->ss_consumers) /* Last frees ss */
+	    stream_consumer_free(ss->ss_consumers, 0);
+    while (STREAM_CLOSING != NULL)
+	stream_consumer_free(STREAM_CLOSING, 0);
+    return 0;
+}
+
+/*! Connection of a subscriber is writable: write queued output
+ * FastCGI subscribers write to the non-blocking connection, as much as it 
+ * accepts. A closing subscriber is freed when its end of request is written.
+ * Subscribers of the native HTTP listener queue the output on the HTTP 
+ * connection, which does not block, see restconf_http.c.
+ */
+static int
+stream_consumer_write_cb(int   s, 
+			 void *arg)
+{
+    struct stream_consumer *sc = (struct stream_consumer *)arg;
+    struct http_buf        *wq = &sc->sc_out;
+    ssize_t                 n;
+
+    if (sc->sc_r->role == RESTCONF_HTTP_ROLE){
+	FCGX_PutStr(wq->hb_buf + wq->hb_off, wq->hb_len - wq->hb_off, sc->sc_r->out);
+	FCGX_FFlush(sc->sc_r->out);
+	if (FCGX_GetError(sc->sc_r->out) != 0){
+	    clicon_debug(1, "%s FCGX_GetError upstream", __FUNCTION__);
+	    stream_consumer_free(sc, 0);
+	    goto ok;
+	}
+	wq->hb_off = wq->hb_len;
+    }
+    while (wq->hb_off < wq->hb_len){
+	if ((n = send(s, wq->hb_buf + wq->hb_off, wq->hb_len - wq->hb_off,
+		      MSG_NOSIGNAL)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		goto ok; /* Rest is written when writable again */
+	    clicon_debug(1, "%s send: %s", __FUNCTION__, strerror(errno));
+	    stream_consumer_free(sc, 0);
+	    goto ok;
+	}
+	wq->hb_off += n;
     }
+    http_buf_reset(wq);
+    event_unreg_fd_write(s, stream_consumer_write_cb);
+    sc->sc_wreg = 0;
+    if (sc->sc_closing) /* End of request written */
+	stream_consumer_free(sc, 0);
+ ok:
     return 0;
 }
 
+/*! Connection of a subscriber is readable
+ * Nothing is expected from the webserver on a stream request, except that it
+ * may abort the request with FCGI_ABORT_REQUEST, which ends the request 
+ * gracefully. Other records, such as the empty FCGI_STDIN ending the request 
+ * body, are ignored. If the connection is closed the subscriber is freed.
+ * Nothing is expected on a native HTTP connection either, except a close.
+ */
+static int
+stream_consumer_read_cb(int   s, 
+			void *arg)
+{
+    int                     retval = -1;
+    struct stream_consumer *sc = (struct stream_consumer *)arg;
+    struct http_buf        *ib = &sc->sc_in;
+    char                    buf[1024];
+    ssize_t                 n;
+    FCGI_Header            *hdr;
+    size_t                  reclen;
+    int                     abort = 0;
+
+    if ((n = read(s, buf, sizeof(buf))) < 0){
+	if (errno == EAGAIN || errno == EINTR)
+	    goto ok;
+	clicon_debug(1, "%s read: %s", __FUNCTION__, strerror(errno));
+	stream_consumer_free(sc, 0);
+	goto ok;
+    }
+    if (n == 0){
+	clicon_debug(1, "%s upstream closed", __FUNCTION__);
+	stream_consumer_free(sc, 0);
+	goto ok;
+    }
+    if (sc->sc_r->role == RESTCONF_HTTP_ROLE)
+	goto ok;
+    if (http_buf_append(ib, buf, n) < 0)
+	goto done;
+    /* Complete records */
+    while (ib->hb_len - ib->hb_off >= FCGI_HEADER_LEN){
+	hdr = (FCGI_Header *)(ib->hb_buf + ib->hb_off);
+	reclen = FCGI_HEADER_LEN + hdr->paddingLength +
+	    ((hdr->contentLengthB1 << 8) | hdr->contentLengthB0);
+	if (ib->hb_len - ib->hb_off < reclen)
+	    break;
+	if (hdr->type == FCGI_ABORT_REQUEST &&
+	    ((hdr->requestIdB1 << 8) | hdr->requestIdB0) == sc->sc_r->requestId)
+	    abort++;
+	ib->hb_off += reclen;
+    }
+    if (ib->hb_off == ib->hb_len)
+	http_buf_reset(ib);
+    if (abort){
+	clicon_debug(1, "%s request aborted", __FUNCTION__);
+	stream_consumer_free(sc, 1);
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Queue an event to a subscriber
+ * If the queue of the subscriber exceeds CLICON_RESTCONF_STREAM_QUEUE_MAX, it is
+ * dropped.
+ * @param[in]  sc   Stream subscriber
+ * @param[in]  ev   Event formatted as SSE
+ * @param[in]  max  Max queued bytes, 0 is no limit
+ */
+static int
+stream_consumer_send(struct stream_consumer *sc,
+		     cbuf                   *ev,
+		     size_t                  max)
+{
+    int              retval = -1;
+    struct http_buf *wq = &sc->sc_out;
+    
+    if (max && wq->hb_len - wq->hb_off + cbuf_len(ev) > max){
+	clicon_log(LOG_NOTICE, "%s %s: slow subscriber dropped", 
+		   __FUNCTION__, sc->sc_sub->ss_stream);
+	sc->sc_sub->ss_dropped++;
+	stream_consumer_free(sc, 0);
+	goto ok;
+    }
+    if (stream_consumer_queue(sc, cbuf_get(ev), cbuf_len(ev)) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Callback when stream notifications arrive from backend
+ * The event is formatted once and queued to every subscriber of the subscription.
  */
 static int
 restconf_stream_cb(int   s, 
 		   void *arg)
 {
-    int                retval = -1;
-    FCGX_Request      *r = (FCGX_Request *)arg;
-    int                eof;
-    struct clicon_msg *reply = NULL;
-    cxobj             *xtop = NULL; /* top xml */
-    cxobj             *xn;        /* notification xml */
-    cbuf              *cb = NULL;
-    int                pretty = 0; /* XXX should be via arg */
+    int                     retval = -1;
+    struct stream_sub      *ss = (struct stream_sub *)arg;
+    struct stream_consumer *sc;
+    struct stream_consumer *scnext;
+    int                     eof;
+    struct clicon_msg      *reply = NULL;
+    cxobj                  *xtop = NULL; /* top xml */
+    cxobj                  *xn;        /* notification xml */
+    cbuf                   *cb = NULL;
+    int                     pretty = 0; /* XXX should be via arg */
+    size_t                  max;
     
     clicon_debug(1, "%s", __FUNCTION__);
     /* get msg (this is the reason this function is called) */
@@ -169,17 +480,15 @@ restconf_stream_cb(int   s,
 	goto done;
     }
     clicon_debug(1, "%s msg: %s", __FUNCTION__, reply?reply->op_body:"null");
-    /* handle close from remote end: this will exit the client */
+    /* handle close from remote end: this ends the subscription */
     if (eof){
 	clicon_debug(1, "%s eof", __FUNCTION__);
-	clicon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
-	errno = ESHUTDOWN;
-	FCGX_FPrintF(r->out, "SHUTDOWN\r\n");
-	FCGX_FPrintF(r->out, "\r\n");
-	FCGX_FFlush(r->out);
-	clicon_exit_set(); 
-	goto done;
+	while ((sc = ss->ss_consumers) != NULL) /* Last frees ss */
+	    stream_consumer_free(sc,
+				 stream_consumer_queue(sc, "SHUTDOWN\r\n\r\n", 12) == 0);
+	goto ok;
     }
+    ss->ss_events++;
     if (clicon_msg_decode(reply, NULL, NULL, &xtop) < 0)  /* XXX pass yang_spec */
 	goto done;
     /* create event */
@@ -189,23 +498,20 @@ restconf_stream_cb(int   s,
     }
     if ((xn = xpath_first(xtop, NULL, "notification")) == NULL)
 	goto ok;
-#ifdef notused
-    xt = xpath_first(xn, NULL, "eventTime");
-    if ((xe = xpath_first(xn, NULL, "event")) == NULL) /* event can depend on yang? */
-	goto ok;
-
-    if (xt)
-	FCGX_FPrintF(r->out, "M#id: %s\r\n", xml_body(xt));
-    else{ /* XXX */
-	gettimeofday(&tv, NULL);
-	FCGX_FPrintF(r->out, "M#id: %02d:0\r\n", tv.tv_sec);
-    }
-#endif
+    cprintf(cb, "data: ");
     if (clicon_xml2cbuf(cb, xn, 0, pretty, -1) < 0)
 	goto done;
-    FCGX_FPrintF(r->out, "data: %s\r\n", cbuf_get(cb));
-    FCGX_FPrintF(r->out, "\r\n");
-    FCGX_FFlush(r->out);
+    cprintf(cb, "\r\n\r\n");
+    max = clicon_option_int(ss->ss_h, "CLICON_RESTCONF_STREAM_QUEUE_MAX");
+    /* Sending may free sc, and ss after the last sc */
+    sc = ss->ss_consumers;
+    do {
+	scnext = NEXTQ(struct stream_consumer *, sc);
+	if (scnext == ss->ss_consumers)
+	    scnext = NULL;
+	if (stream_consumer_send(sc, cb, max) < 0)
+	    goto done;
+    } while ((sc = scnext) != NULL);
  ok:
     retval = 0;
  done:
@@ -219,32 +525,66 @@ restconf_stream_cb(int   s,
     return retval;
 }
 
-/*! Send subsctription to backend
- * @param[in] h    Clicon handle
- * @param[in] r    Fastcgi request handle
- * @param[in] name Stream name
- * @param[out] sp  Socket -1 if not set
+/*! Find a shared backend subscription of a user, stream and filter
+ * @param[in] name     Stream name
+ * @param[in] filter   Xpath filter or NULL
+ * @param[in] username User or NULL
+ */
+static struct stream_sub *
+stream_sub_find(char *name,
+		char *filter,
+		char *username)
+{
+    struct stream_sub *ss;
+
+    if ((ss = STREAM_SUBS) != NULL){
+	do {
+	    if (ss->ss_shared &&
+		strcmp(ss->ss_stream, name) == 0 &&
+		clicon_strcmp(ss->ss_filter, filter) == 0 &&
+		clicon_strcmp(ss->ss_username, username) == 0)
+		return ss;
+	    ss = NEXTQ(struct stream_sub *, ss);
+	} while (ss && ss != STREAM_SUBS);
+    }
+    return NULL;
+}
+
+/*! Get a backend subscription of a stream, send a new subscription if needed
+ * @param[in]  h      Clicon handle
+ * @param[in]  r      Fastcgi request handle
+ * @param[in]  name   Stream name
+ * @param[in]  qvec   Query parameters: start-time, stop-time and filter
+ * @param[in]  pretty Pretty-print error
+ * @param[in]  media_out Media of error
+ * @param[out] ssp    Backend subscription, NULL if error returned to client
  */
 static int
-restconf_stream(clicon_handle h,
-		FCGX_Request *r,
-		char         *name,
-		cvec         *qvec, 
-		int           pretty,
-		restconf_media media_out,
-		int          *sp)
+restconf_stream(clicon_handle       h,
+		FCGX_Request       *r,
+		char               *name,
+		cvec               *qvec, 
+		int                 pretty,
+		restconf_media      media_out,
+		struct stream_sub **ssp)
 {
-    int     retval = -1;
-    cxobj  *xret = NULL;
-    cxobj  *xe;
-    cbuf   *cb = NULL;
-    int     s; /* socket */
-    int     i;
-    cg_var *cv;
-    char   *vname;
+    int                retval = -1;
+    cxobj             *xret = NULL;
+    cxobj             *xe;
+    cbuf              *cb = NULL;
+    int                s = -1; /* socket */
+    int                i;
+    cg_var            *cv;
+    char              *vname;
+    char              *filter = NULL;
+    char              *enc = NULL;
+    int                replay = 0;
+    struct stream_sub *ss = NULL;
+    char              *username;
 
     clicon_debug(1, "%s", __FUNCTION__);
-    *sp = -1;
+    *ssp = NULL;
+    username = clicon_username_get(h);
     if ((cb = cbuf_new()) == NULL){
 	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
@@ -258,14 +598,26 @@ restconf_stream(clicon_handle h,
 	    cprintf(cb, "<startTime>");
 	    cv2cbuf(cv, cb);
 	    cprintf(cb, "</startTime>");
+	    replay++;
 	}
 	else if (strcmp(vname, "stop-time") == 0){
 	    cprintf(cb, "<stopTime>");
 	    cv2cbuf(cv, cb);
 	    cprintf(cb, "</stopTime>");
+	    replay++;
+	}
+	else if (strcmp(vname, "filter") == 0){
+	    filter = cv_string_get(cv);
+	    if (xml_chardata_encode(&enc, "%s", filter) < 0)
+		goto done;
+	    cprintf(cb, "<filter type=\"xpath\" select=\"%s\"/>", enc);
 	}
     }
     cprintf(cb, "</create-subscription></rpc>]]>]]>");
+    /* Subscriptions of a user without replay share the same backend
+     * subscription, which the backend has authorized for that user */
+    if (replay == 0 && (ss = stream_sub_find(name, filter, username)) != NULL)
+	goto ok;
     if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, &s) < 0)
 	goto done;
     if ((xe = xpath_first(xret, NULL, "rpc-reply/rpc-error")) != NULL){
@@ -273,20 +625,40 @@ restconf_stream(clicon_handle h,
 	    goto done;
 	goto ok;
     }
-    /* Setting up stream */
-    FCGX_SetExitStatus(201, r->out); /* Created */
-    FCGX_FPrintF(r->out, "Status: 201 Created\r\n");
-    FCGX_FPrintF(r->out, "Content-Type: text/event-stream\r\n");
-    FCGX_FPrintF(r->out, "Cache-Control: no-cache\r\n");
-    FCGX_FPrintF(r->out, "Connection: keep-alive\r\n");
-    FCGX_FPrintF(r->out, "X-Accel-Buffering: no\r\n");
-    FCGX_FPrintF(r->out, "\r\n");
-    FCGX_FFlush(r->out);
-    *sp = s;
+    if ((ss = malloc(sizeof(*ss))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    memset(ss, 0, sizeof(*ss));
+    ss->ss_h = h;
+    ss->ss_s = s;
+    s = -1;
+    ss->ss_shared = (replay == 0);
+    ADDQ(ss, STREAM_SUBS);
+    if ((ss->ss_stream = strdup(name)) == NULL ||
+	(filter && (ss->ss_filter = strdup(filter)) == NULL) ||
+	(username && (ss->ss_username = strdup(username)) == NULL)){
+	clicon_err(OE_XML, errno, "strdup");
+	goto done;
+    }
+    /* Listen to backend socket */
+    if (event_reg_fd(ss->ss_s, 
+		     restconf_stream_cb, 
+		     (void*)ss,
+		     "stream socket") < 0)
+	goto done;
  ok:
+    *ssp = ss;
+    ss = NULL;
     retval = 0;
  done:
     clicon_debug(1, "%s retval: %d", __FUNCTION__, retval);
+    if (ss && ss->ss_consumers == NULL) /* Error after new subscription */
+	stream_sub_free(ss);
+    if (s != -1)
+	close(s);
+    if (enc)
+	free(enc);
     if (xret)
 	xml_free(xret);
     if (cb)
@@ -294,47 +666,85 @@ restconf_stream(clicon_handle h,
     return retval;
 }
 
-/* restconf */
-#include "restconf_lib.h"
-#include "restconf_stream.h"
-
+/*! Add a request as subscriber of a backend subscription
+ * Send the stream HTTP header, and take over the request. A FastCGI request
+ * is freed by the subscriber, its connection is made non-blocking.
+ * @param[in]  ss   Backend subscription
+ * @param[in]  r    Request handle, owned by subscriber if FastCGI
+ */
 static int
-stream_checkuplink(int   s, 
-		   void *arg)
-{
-    FCGX_Request *r = (FCGX_Request *)arg;
-    clicon_debug(1, "%s", __FUNCTION__);
-    if (FCGX_GetError(r->out) != 0){ /* break loop */
-	clicon_debug(1, "%s FCGX_GetError upstream", __FUNCTION__);
-	clicon_exit_set();
-    }
-    return 0;
-}
-
-int
-stream_timeout(int   s,
-	       void *arg)
+stream_consumer_add(struct stream_sub *ss,
+		    FCGX_Request      *r)
 {
-    struct timeval t;
-    struct timeval t1;
-    FCGX_Request *r = (FCGX_Request *)arg;
+    int                     retval = -1;
+    struct stream_consumer *sc = NULL;
+    cbuf                   *cb = NULL;
     
-    clicon_debug(1, "%s", __FUNCTION__);
-    if (FCGX_GetError(r->out) != 0){ /* break loop */
-	clicon_debug(1, "%s FCGX_GetError upstream", __FUNCTION__);
-	clicon_exit_set();
+    /* Setting up stream */
+    restconf_exit_status(r, 201); /* Created */
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "Status: 201 Created\r\n");
+    cprintf(cb, "Content-Type: text/event-stream\r\n");
+    cprintf(cb, "Cache-Control: no-cache\r\n");
+    cprintf(cb, "Connection: keep-alive\r\n");
+    cprintf(cb, "X-Accel-Buffering: no\r\n");
+    cprintf(cb, "\r\n");
+    if ((sc = malloc(sizeof(*sc))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    memset(sc, 0, sizeof(*sc));
+    sc->sc_sub = ss;
+    sc->sc_r = r;
+    if (r->role == RESTCONF_HTTP_ROLE){
+	FCGX_PutStr(cbuf_get(cb), cbuf_len(cb), r->out);
+	FCGX_FFlush(r->out);
     }
     else{
-	gettimeofday(&t, NULL);
-	t1.tv_sec = 1; t1.tv_usec = 0;
-	timeradd(&t, &t1, &t);
-	event_reg_timeout(t, stream_timeout, arg, "Stream timeout");
+	if (fcntl(r->ipcFd, F_SETFL, fcntl(r->ipcFd, F_GETFL, 0) | O_NONBLOCK) < 0){
+	    clicon_err(OE_UNIX, errno, "fcntl");
+	    goto done;
+	}
+	if (stream_fcgi_record(sc, FCGI_STDOUT, cbuf_get(cb), cbuf_len(cb)) < 0)
+	    goto done;
     }
-    return 0;
-} 
+    ADDQ(sc, ss->ss_consumers);
+    if (event_reg_fd(r->ipcFd, 
+		     stream_consumer_read_cb, 
+		     (void*)sc,
+		     "stream subscriber") < 0){
+	DELQ(sc, ss->ss_consumers, struct stream_consumer *);
+	goto done;
+    }
+    if (sc->sc_out.hb_len && stream_consumer_wreg(sc) < 0){
+	event_unreg_fd(r->ipcFd, stream_consumer_read_cb);
+	DELQ(sc, ss->ss_consumers, struct stream_consumer *);
+	goto done;
+    }
+    sc = NULL;
+    retval = 0;
+ done:
+    if (sc){
+	if (sc->sc_out.hb_buf)
+	    free(sc->sc_out.hb_buf);
+	free(sc);
+    }
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
 
-/*! Process a FastCGI request
- * @param[in]  r        Fastcgi request handle
+/*! Process a FastCGI stream request
+ * On success, the request is taken over by a stream subscriber and finish is
+ * cleared: the caller should not finish the request. A FastCGI request is 
+ * freed by the subscriber.
+ * @param[in]  h          Clicon handle
+ * @param[in]  r          Fastcgi request handle
+ * @param[in]  streampath Stream path, see CLICON_STREAM_PATH
+ * @param[out] finish     Set to 0 if request is taken over by a subscriber
  */
 int
 api_stream(clicon_handle h,
@@ -359,11 +769,7 @@ api_stream(clicon_handle h,
     cbuf  *cbret = NULL;
     cxobj *xret = NULL;
     cxobj *xerr;
-    int    s=-1;
-#ifdef STREAM_FORK
-    int    pid;
-    struct stream_child *sc;
-#endif
+    struct stream_sub *ss = NULL;
 
     clicon_debug(1, "%s", __FUNCTION__);
     path = restconf_uripath(r);
@@ -425,66 +831,12 @@ api_stream(clicon_handle h,
 	goto ok;
     }
     clicon_debug(1, "%s auth2:%d %s", __FUNCTION__, authenticated, clicon_username_get(h));
-    if (restconf_stream(h, r, method, qvec, pretty, media_out, &s) < 0)
+    if (restconf_stream(h, r, method, qvec, pretty, media_out, &ss) < 0)
 	goto done;
-    if (s != -1){
-#ifdef STREAM_FORK
-	if ((pid = fork()) == 0){ /* child */
-	    if (pvec)
-		free(pvec);
-	    if (dvec)
-		cvec_free(dvec);
-	    if (qvec)
-		cvec_free(qvec);
-	    if (pcvec)
-		cvec_free(pcvec);
-	    if (cb)
-		cbuf_free(cb);
-	    if (cbret)
-		cbuf_free(cbret);
-	    if (xret)
-		xml_free(xret);
-#endif /* STREAM_FORK */
-	    /* Listen to backend socket */
-	    if (event_reg_fd(s, 
-			     restconf_stream_cb, 
-			     (void*)r,
-			     "stream socket") < 0)
-		goto done;
-	    if (event_reg_fd(r->listen_sock,
-			     stream_checkuplink, 
-			     (void*)r,
-			     "stream socket") < 0)
-		goto done;
-	    /* Poll upstream errors */
-	    stream_timeout(0, (void*)r);
-	    /* Start loop */
-	    event_loop();
-	    close(s);
-	    event_unreg_fd(s, restconf_stream_cb);
-	    event_unreg_fd(r->listen_sock, restconf_stream_cb);
-	    event_unreg_timeout(stream_timeout, (void*)r);
-	    clicon_exit_reset();
-#ifdef STREAM_FORK
-	    FCGX_Finish_r(r);
-	    FCGX_Free(r, 0);	    
-	    restconf_terminate(h);
-	    exit(0);
-	}
-	/* parent */
-	/* Create stream_child struct and store pid and FCGI data, when child
-	 * killed, call FCGX_Free
-	 */
-	if ((sc = malloc(sizeof(struct stream_child))) == NULL){
-	    clicon_err(OE_XML, errno, "malloc");
+    if (ss != NULL){
+	if (stream_consumer_add(ss, r) < 0)
 	    goto done;
-	}
-	memset(sc, 0, sizeof(struct stream_child));
-	sc->sc_pid = pid;
-	sc->sc_r = *r;
-	ADDQ(sc, STREAM_CHILD);
-	*finish = 0; /* If spawn child, we should not finish this stream */
-#endif /* STREAM_FORK */
+	*finish = 0; /* Request is now owned by the subscriber */
     }
  ok:
     retval = 0;
@@ -136,8 +136,11 @@ main_commit(clicon_handle    h,
     if (xpath_vec_flag(target, nsc, "//interface", XML_FLAG_ADD, &vec, &len) < 0)
 	return -1;
     if (debug)
-	for (i=0; i<len; i++)             /* Loop over added i/fs */
+	for (i=0; i<len; i++){            /* Loop over added i/fs */
 	    xml_print(stdout, vec[i]); /* Print the added interface */
+	    /* enabled is not in the tree if it has its default value */
+	    fprintf(stdout, "enabled: %s\n", transaction_default_get(vec[i], "enabled"));
+	}
   done:
     if (nsc)
 	xml_nsctx_free(nsc);
@@ -59,8 +59,11 @@
  */
 #define IDENTITYREF_KLUDGE
 
-/*! Optimize special list key searches in XPATH finds
- * Identify xpaths that search for exactly a list key, eg: "y[k=3]" and then call
- * binary search. This only works if "y" has proper yang binding and is sorted by system
+/*! Optimize list key and leaf-list value searches in XPATH finds
+ * Identify xpaths that search for list keys or leaf-list values, eg: "y[k=3]",
+ * "y[k1='a'][k2=current()/../b]" or "ll[.='x']", and then use binary search.
+ * This only works if "y" has proper yang binding and is sorted by system,
+ * otherwise the children are searched as usual.
+ * @see xpath_list_optimize_set  to disable at runtime
  */
-#undef XPATH_LIST_OPTIMIZE
+#define XPATH_LIST_OPTIMIZE
@@ -0,0 +1,72 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2020 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Arena (bump) allocator for short-lived objects, eg XPath evaluation contexts
+ * and parse-and-discard XML trees. Everything allocated from an arena is freed
+ * at once when the arena is freed.
+ */
+#ifndef _CLIXON_ARENA_H
+#define _CLIXON_ARENA_H
+
+/*
+ * Types
+ */
+typedef struct clixon_arena clixon_arena;
+
+/*! Position in an arena, see clixon_arena_mark and clixon_arena_release */
+struct clixon_arena_pos{
+    void           *ap_chunk;   /* Current chunk */
+    size_t          ap_used;    /* Bytes used in current chunk */
+    void           *ap_cleanup; /* Last registered cleanup */
+};
+typedef struct clixon_arena_pos clixon_arena_pos;
+
+/*! Cleanup function, called when the arena is freed or released */
+typedef void (clixon_arena_cleanup_fn)(void *arg);
+
+/*
+ * Prototypes
+ */
+clixon_arena *clixon_arena_new(void);
+int   clixon_arena_free(clixon_arena *xa);
+int   clixon_arena_ref(clixon_arena *xa);
+int   clixon_arena_unref(clixon_arena *xa);
+void *clixon_arena_alloc(clixon_arena *xa, size_t len);
+void *clixon_arena_grow(clixon_arena *xa, void *p, size_t len0, size_t len);
+char *clixon_arena_strdup(clixon_arena *xa, const char *str);
+int   clixon_arena_cleanup(clixon_arena *xa, clixon_arena_cleanup_fn *fn, void *arg);
+int   clixon_arena_mark(clixon_arena *xa, clixon_arena_pos *ap);
+int   clixon_arena_release(clixon_arena *xa, clixon_arena_pos *ap);
+size_t clixon_arena_size(clixon_arena *xa);
+
+#endif /* _CLIXON_ARENA_H */
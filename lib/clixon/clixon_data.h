@@ -43,12 +43,23 @@
 /*
  * Types
  */
+/* Generation of a database or of a top-level subtree, see xmldb_generation() */
+typedef struct {
+    uint64_t       dg_gen;      /* Generation number, unique and increasing */
+    struct timeval dg_modified; /* Time of last modification */
+} db_gen;
+
 /* Struct per database in hash */
 typedef struct {
-    uint32_t  de_id;  /* session id */
-    cxobj    *de_xml; /* cache */
+    uint32_t       de_id;     /* session id */
+    cxobj         *de_xml;    /* cache */
+    db_gen         de_gen;    /* Last modification of any part of database */
+    db_gen         de_gen0;   /* Last modification of whole database */
+    clicon_hash_t *de_subgen; /* db_gen per top-level subtree modified after de_gen0 */
 } db_elmnt;
 
+struct clicon_msg; /* see clixon_proto.h */
+
 /*
  * Prototypes
  */
@@ -101,4 +112,8 @@ int clicon_argv_set(clicon_handle h, char *argv0, int argc, char **argv);
 int clicon_session_id_set(clicon_handle h, uint32_t id);
 uint32_t clicon_session_id_get(clicon_handle h);
 
+/*! Set and get reusable buffer for receiving internal messages */
+struct clicon_msg *clicon_rcvbuf_get(clicon_handle h, size_t *len);
+int clicon_rcvbuf_set(clicon_handle h, struct clicon_msg *msg, size_t len);
+
 #endif  /* _CLIXON_DATA_H_ */
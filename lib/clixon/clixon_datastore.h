@@ -37,6 +37,13 @@
 #ifndef _CLIXON_DATASTORE_H
 #define _CLIXON_DATASTORE_H
 
+/*
+ * Constants
+ */
+/* Stream of datastore change notifications, if created by the backend
+ * @see clixon-lib.yang datastore-change notification */
+#define XMLDB_CHANGE_STREAM "CLIXON"
+
 /*
  * Prototypes
  * API
@@ -56,6 +63,7 @@ int xmldb_get0(clicon_handle h, const char *db,
 int xmldb_get0_clear(clicon_handle h, cxobj *x);
 int xmldb_get0_free(clicon_handle h, cxobj **xp);
 int xmldb_put(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret); /* in clixon_datastore_write.[ch] */
+int xmldb_put_move(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret); /* in clixon_datastore_write.[ch] */
 int xmldb_copy(clicon_handle h, const char *from, const char *to);
 int xmldb_lock(clicon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clicon_handle h, const char *db);
@@ -64,6 +72,10 @@ uint32_t xmldb_islocked(clicon_handle h, const char *db);
 int xmldb_exists(clicon_handle h, const char *db);
 int xmldb_delete(clicon_handle h, const char *db);
 int xmldb_create(clicon_handle h, const char *db);
+int xmldb_generation_bump(clicon_handle h, const char *db, cxobj *xt);
+int xmldb_generation(clicon_handle h, const char *db, const char *subtree, uint64_t *gen, struct timeval *tv);
+int xmldb_index(clicon_handle h, cxobj *xt);
+int xmldb_index_state(clicon_handle h, cbuf *cb);
 /* utility functions */
 int xmldb_db_reset(clicon_handle h, char *db);
 
@@ -75,14 +75,14 @@ int clicon_connect_unix(clicon_handle h, char *sockpath);
 int clicon_rpc_connect_unix(clicon_handle         h,
 			    struct clicon_msg    *msg, 
 			    char                 *sockpath,
-			    char                **ret,
+			    struct clicon_msg   **reply,
 			    int                  *sock0);
 
 int clicon_rpc_connect_inet(clicon_handle         h,
 			    struct clicon_msg    *msg, 
 			    char                 *dst, 
 			    uint16_t              port,
-			    char                **ret,
+			    struct clicon_msg   **reply,
 			    int                  *sock0);
 
 int clicon_rpc(int s, struct clicon_msg *msg, char **xret);
@@ -91,6 +91,8 @@ int clicon_msg_send(int s, struct clicon_msg *msg);
 
 int clicon_msg_rcv(int s, struct clicon_msg **msg, int *eof);
 
+int clicon_msg_rcv_buf(int s, struct clicon_msg **msg, size_t *buflen, int *eof);
+
 int send_msg_notify_xml(clicon_handle h, int s, cxobj *xev);
 
 int send_msg_reply(int s, char *data, uint32_t datalen);
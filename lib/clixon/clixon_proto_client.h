@@ -52,7 +52,8 @@ int clicon_rpc_copy_config(clicon_handle h, char *db1, char *db2);
 int clicon_rpc_delete_config(clicon_handle h, char *db);
 int clicon_rpc_lock(clicon_handle h, char *db);
 int clicon_rpc_unlock(clicon_handle h, char *db);
-int clicon_rpc_get(clicon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, cxobj **xret);
+int clicon_rpc_get(clicon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, enum withdefaults_type wdef, cxobj **xret);
+int clicon_rpc_get_generation(clicon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, enum withdefaults_type wdef, char *subtree, cxobj **xret, uint64_t *gen, uint64_t *ngen, time_t *modified);
 int clicon_rpc_close_session(clicon_handle h);
 int clicon_rpc_kill_session(clicon_handle h, uint32_t session_id);
 int clicon_rpc_validate(clicon_handle h, char *db);
@@ -61,6 +62,7 @@ int clicon_rpc_discard_changes(clicon_handle h);
 int clicon_rpc_create_subscription(clicon_handle h, char *stream, char *filter, 
 				   int *s);
 int clicon_rpc_debug(clicon_handle h, int level);
+int clicon_rpc_generation(clicon_handle h, char *db, char *subtree, uint64_t *gen, uint64_t *ngen, time_t *modified);
 int clicon_hello_req(clicon_handle h, uint32_t *id);
 
 #endif  /* _CLIXON_PROTO_CLIENT_H_ */
@@ -48,21 +48,57 @@
  */
 typedef	int (*stream_fn_t)(clicon_handle h, int op, cxobj *event, void *arg);
 
+/* Subscription filter, parsed once and shared by all subscriptions of a 
+ * stream with the same xpath. Evaluated at most once per event.
+ */
+struct stream_filter{
+    qelem_t                     sf_q;      /* queue header */
+    char                       *sf_xpath;  /* Filter selector as xpath */
+    struct xpath_tree          *sf_xptree; /* Parsed xpath */
+    int                         sf_refcnt; /* Nr of subscriptions using filter */
+    uint64_t                    sf_gen;    /* Event generation of sf_match */
+    int                         sf_match;  /* Set if filter matched event sf_gen */
+};
+
+/* Notification serialized once and shared by all subscribers it is sent to,
+ * as a framed internal message (see struct clicon_msg)
+ * @see stream_msg_get
+ */
+struct stream_msg{
+    int                         sm_refcnt; /* Free when it reaches zero */
+    size_t                      sm_len;    /* Length of sm_data */
+    char                       *sm_data;   /* Message header and XML body */
+};
+
 struct stream_subscription{
     qelem_t                     ss_q;   /* queue header */
     char                       *ss_stream; /* Name of associated stream */
     char                       *ss_xpath;  /* Filter selector as xpath */
+    struct stream_filter       *ss_filter; /* Shared parsed filter, or NULL */
     struct timeval              ss_starttime; /* Replay starttime */
     struct timeval              ss_stoptime; /* Replay stoptime */
     stream_fn_t                 ss_fn;     /* Callback when event occurs */
     void                       *ss_arg;    /* Callback argument */
 };
 
-/* Replay time-series */
+/* Replay log segment: serialized events stored back-to-back, either in memory 
+ * or in an mmap:ed file. Retention drops whole segments.
+ */
+struct stream_segment{
+    qelem_t        sg_q;    /* queue header */
+    char          *sg_buf;  /* Records, see struct stream_record in clixon_stream.c */
+    size_t         sg_size; /* Size of sg_buf */
+    size_t         sg_len;  /* Used part of sg_buf */
+    int            sg_fd;   /* File descriptor if file segment, else -1 */
+    char          *sg_file; /* File name if file segment */
+    struct timeval sg_last; /* Timestamp of last event in segment */
+};
+
+/* Replay time index: ring buffer entry pointing to an event in a segment */
 struct stream_replay{
-    qelem_t        r_q;   /* queue header */
-    struct timeval r_tv;  /* time index */
-    cxobj         *r_xml; /* event in xml form */
+    struct timeval         r_tv;  /* time index */
+    char                  *r_xml; /* event serialized as XML string */
+    struct stream_segment *r_seg; /* segment holding event */
 };
 
 /* See RFC8040 9.3, stream list, no replay support for now
@@ -72,9 +108,18 @@ struct event_stream{
     char                *es_name; /* name of notification event stream */
     char                *es_description;
     struct stream_subscription *es_subscription;
+    struct stream_filter *es_filters; /* Filters of subscriptions */
+    uint64_t             es_gen;     /* Event generation, for filter evaluation */
     int                  es_replay_enabled; /* set if replay is enables */
     struct timeval       es_retention; /* replay retention - how much to save */
-    struct stream_replay *es_replay;
+    struct stream_replay *es_replay; /* Replay index, ring buffer sorted on time */
+    size_t               es_replay_head; /* Oldest entry in ring buffer */
+    size_t               es_replay_nr;   /* Nr of entries in ring buffer */
+    size_t               es_replay_max;  /* Allocated size of ring buffer */
+    struct stream_segment *es_segments;  /* Replay log segments, oldest first */
+    char                *es_replay_dir;  /* If set, segments are files here */
+    int                  es_segment_nr;  /* Sequence nr of last segment file */
+    size_t               es_segment_size; /* Total size of replay log segments */
 
 };
 typedef struct event_stream event_stream_t;
@@ -97,6 +142,9 @@ struct stream_subscription *stream_ss_find(event_stream_t *es,
 int stream_ss_delete_all(clicon_handle h, stream_fn_t fn, void *arg);
 int stream_ss_delete(clicon_handle h, char *name, stream_fn_t fn, void *arg);
 
+struct stream_msg *stream_msg_get(cxobj *xevent);
+int stream_msg_unref(struct stream_msg *sm);
+
 int stream_notify_xml(clicon_handle h, char *stream, cxobj *xml);
 #if defined(__GNUC__) && __GNUC__ >= 3
 int stream_notify(clicon_handle h, char *stream, const char *event, ...)  __attribute__ ((format (printf, 3, 4)));
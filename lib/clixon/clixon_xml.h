@@ -53,6 +53,13 @@
  * operations, <error-info> content, and the <action> element.
  */
 #define YANG_XML_NAMESPACE "urn:ietf:params:xml:ns:yang:1"
+
+/* See RFC 6243: namespace of the <with-defaults> retrieval parameter, and of the
+ * default attribute of leafs with default values in report-all-tagged mode
+ */
+#define NETCONF_WITHDEFAULTS_NAMESPACE "urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults"
+#define NETCONF_DEFAULT_NAMESPACE "urn:ietf:params:xml:ns:netconf:default:1.0"
+#define NETCONF_DEFAULT_PREFIX "wd"
 /*
  * Types
  */
@@ -74,6 +81,17 @@ enum insert_type{ /* edit-config insert */
     INS_AFTER,  
 };
 
+/* With-defaults retrieval mode (see RFC6243 Sec 3)
+ * Default values are not stored in the XML tree, the mode is applied when
+ * printing, @see clicon_xml2cbuf_wdef
+ */
+enum withdefaults_type{
+    WITHDEFAULTS_REPORT_ALL, /* Report absent leafs with default values */
+    WITHDEFAULTS_TRIM,       /* Do not report leafs set to default value */
+    WITHDEFAULTS_EXPLICIT,   /* Report leafs as stored */
+    WITHDEFAULTS_REPORT_ALL_TAGGED, /* As report-all, default values are tagged */
+};
+
 enum cxobj_type {CX_ERROR=-1, 
 		 CX_ELMNT, 
 		 CX_ATTR, 
@@ -126,6 +144,10 @@ int       xml_parent_set(cxobj *xn, cxobj *parent);
 uint16_t  xml_flag(cxobj *xn, uint16_t flag);
 int       xml_flag_set(cxobj *xn, uint16_t flag);
 int       xml_flag_reset(cxobj *xn, uint16_t flag);
+int       xml_sorted(cxobj *xn);
+int       xml_sorted_set(cxobj *xn, int sorted);
+int       xml_indexed(cxobj *xn);
+int       xml_indexed_set(cxobj *xn, int indexed);
 
 char     *xml_value(cxobj *xn);
 int       xml_value_set(cxobj *xn, char *val);
@@ -146,10 +168,14 @@ int       xml_child_insert_pos(cxobj *x, cxobj *xc, int i);
 int       xml_childvec_set(cxobj *x, int len);
 cxobj   **xml_childvec_get(cxobj *x);
 cxobj    *xml_new(char *name, cxobj *xn_parent, yang_stmt *spec);
+cxobj    *xml_new_arena(char *name, yang_stmt *spec);
+struct clixon_arena *xml_arena_get(cxobj *x);
 yang_stmt *xml_spec(cxobj *x);
 int       xml_spec_set(cxobj *x, yang_stmt *spec);
 cg_var   *xml_cv(cxobj *x);
 int       xml_cv_set(cxobj *x, cg_var *cv);
+cg_var  **xml_keys(cxobj *x);
+int       xml_keys_set(cxobj *x, cg_var **keys);
 cxobj    *xml_find(cxobj *xn_parent, char *name);
 
 int       xml_addsub(cxobj *xp, cxobj *xc);
@@ -173,14 +199,20 @@ cxobj    *xml_find_type(cxobj *xn_parent, char *prefix, char *name, enum cxobj_t
 char     *xml_find_value(cxobj *xn_parent, char *name);
 char     *xml_find_body(cxobj *xn, char *name);
 cxobj    *xml_find_body_obj(cxobj *xt, char *name, char *val);
+yang_stmt *xml_default_leaf(cxobj *xp, char *name);
+int       xml_default_child(cxobj *xp, yang_stmt *y, cxobj **xcp);
 
 int       xml_free(cxobj *xn);
+int       xml_stats(cxobj *xt, uint64_t *nrp, size_t *szp);
+int       xml_stats_global(uint64_t *nrp, size_t *szp);
 
 int       xml_print(FILE  *f, cxobj *xn);
 int       clicon_xml2file(FILE *f, cxobj *xn, int level, int prettyprint);
 int       clicon_xml2cbuf(cbuf *xf, cxobj *xn, int level, int prettyprint, int32_t depth);
+int       clicon_xml2cbuf_wdef(cbuf *xf, cxobj *xn, int level, int prettyprint, int32_t depth, enum withdefaults_type wdef);
 int       xml_parse_file(int fd, char *endtag, yang_stmt *yspec, cxobj **xt);
 int       xml_parse_string(const char *str, yang_stmt *yspec, cxobj **xml_top);
+int       xml_parse_buffer(char *buf, size_t buflen, yang_stmt *yspec, cxobj **xml_top);
 #if defined(__GNUC__) && __GNUC__ >= 3
 int       xml_parse_va(cxobj **xt, yang_stmt *yspec, const char *format, ...)  __attribute__ ((format (printf, 3, 4)));
 #else
@@ -0,0 +1,67 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2020 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+ * Indexes of XML trees
+ */
+#ifndef _CLIXON_XML_INDEX_H
+#define _CLIXON_XML_INDEX_H
+
+/*
+ * Types
+ */
+struct xml_index; /* Defined in clixon_xml_index.c */
+
+/* Statistics of a value index, see xml_index_value_stats */
+struct xml_value_index_stats{
+    uint64_t vs_entries; /* Number of indexed leaf nodes */
+    uint64_t vs_values;  /* Number of distinct values */
+    uint64_t vs_memory;  /* Estimated memory in bytes */
+    uint64_t vs_lookups; /* Number of lookups */
+    uint64_t vs_updates; /* Number of leaf nodes added or removed */
+};
+
+/*
+ * Prototypes
+ */
+struct xml_index *xml_index_get(cxobj *x);
+int xml_index_set(cxobj *x, struct xml_index *xi);
+int xml_index_enable(cxobj *xt);
+int xml_index_reset(cxobj *xt);
+int xml_index_free(struct xml_index *xi);
+int xml_index_modified(cxobj *x);
+int xml_index_descendants(cxobj *xn, char *name, cxobj ***vec, size_t *veclen);
+int xml_index_value_enable(cxobj *xt, yang_stmt *yleaf);
+int xml_index_link(cxobj *x);
+int xml_index_unlink(cxobj *x);
+int xml_index_value_lookup(cxobj *xv, yang_stmt *yleaf, char *value, cxobj ***vec, size_t *veclen);
+int xml_index_value_stats(cxobj *xt, yang_stmt *yleaf, struct xml_value_index_stats *vs);
+
+#endif /* _CLIXON_XML_INDEX_H */
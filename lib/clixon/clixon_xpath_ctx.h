@@ -80,6 +80,8 @@ struct xp_ctx{
     cxobj          *xc_node;    /* Node in nodeset XXX maybe not needed*/
     cxobj          *xc_initial; /* RFC 7960 10.1.1 extension: for current() */
     int             xc_descendant;  /* // */
+    size_t          xc_max;     /* Allocated length of nodeset */
+    struct clixon_arena *xc_arena; /* Evaluation arena, or NULL if malloced */
     /* NYI: a set of variable bindings, set of namespace declarations */
 };
 typedef struct xp_ctx xp_ctx;
@@ -92,9 +94,13 @@ extern const map_str2int ctxmap[];
 /*
  * Prototypes
  */
+xp_ctx *ctx_new(xp_ctx *xc0, enum xp_objtype type);
 int ctx_free(xp_ctx *xc);
+xp_ctx *ctx_copy(xp_ctx *xc0, struct clixon_arena *xa);
 xp_ctx *ctx_dup(xp_ctx *xc);
+int ctx_nodeset_append(xp_ctx *xc, cxobj *x);
 int ctx_nodeset_replace(xp_ctx *xc, cxobj **vec, size_t veclen);
+int ctx_string_set(xp_ctx *xc, char *str);
 int ctx_print_cb(cbuf *cb, xp_ctx *xc, int indent, char *str);
 int ctx_print(FILE *f, xp_ctx *xc, char *str);
 int ctx2boolean(xp_ctx *xc);
@@ -37,10 +37,15 @@
 #ifndef _CLIXON_XPATH_OPTIMIZE_H
 #define _CLIXON_XPATH_OPTIMIZE_H
 
-
-int xpath_list_optimize_stats(int *hits);
-int xpath_list_optimize_set(int enable); 
+/*
+ * Prototypes
+ */
+int  xpath_list_optimize_stats(int *hits);
+int  xpath_list_optimize_set(int enable); 
 void xpath_optimize_exit(void);
-int xpath_optimize_check();
+int  xpath_lookup_free(struct xpath_lookup *xl);
+int  xpath_optimize(xpath_tree *xs);
+int  xpath_optimize_check(xpath_tree *xs, xp_ctx *xc, cxobj *xv, cvec *nsc, int localonly,
+			  cxobj ***vec, size_t *veclen);
 
 #endif /* _CLIXON_XPATH_OPTIMIZE_H */
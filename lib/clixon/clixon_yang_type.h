@@ -50,6 +50,7 @@
  */
 /* declared in clixon_yang_internal */
 typedef struct yang_type_cache yang_type_cache;
+typedef struct yang_leaftype yang_leaftype;
 
 /*
  * Prototypes
@@ -57,6 +58,9 @@ typedef struct yang_type_cache yang_type_cache;
 int        yang_type_cache_cp(yang_type_cache **ycnew, yang_type_cache *ycold);
 int        yang_type_cache_free(yang_type_cache *ycache);
 int        ys_resolve_type(yang_stmt *ys, void *arg);
+int        yang_leaftype_set(clicon_handle h, yang_stmt *ys);
+int        yang_leaftype_free(yang_leaftype *lt);
+int        yang_leaftype_cv(yang_stmt *ys, enum cv_type *cvtype, uint8_t *fraction);
 int        yang2cv_type(char *ytype, enum cv_type *cv_type);
 char      *cv2yang_type(enum cv_type cv_type);
 yang_stmt *yang_find_identity(yang_stmt *ys, char *identity);
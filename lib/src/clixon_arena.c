@@ -0,0 +1,360 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2020 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ * Arena (bump) allocator for short-lived objects
+ *
+ * Memory is allocated from a list of chunks by bumping a pointer, and is not
+ * freed individually: everything is freed at once by clixon_arena_free(), or
+ * released back to a position taken by clixon_arena_mark().
+ * Objects that own memory outside the arena register a cleanup function that
+ * is called when the arena is freed.
+ * An arena may be shared by several owners with clixon_arena_ref(), and is then
+ * freed by the last clixon_arena_unref().
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_arena.h"
+
+/*
+ * Constants
+ */
+/* Size of arena chunks, larger allocations get a chunk of their own */
+#define ARENA_CHUNK 8192
+
+/* Alignment of arena allocations */
+#define ARENA_ALIGN(len) (((len) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+
+/* Start of data of a chunk, after the aligned header */
+#define ARENA_CHUNK_DATA(ak) ((char*)(ak) + ARENA_ALIGN(sizeof(struct arena_chunk)))
+
+/*
+ * Types
+ */
+/*! Arena chunk, data follows the header */
+struct arena_chunk{
+    struct arena_chunk *ak_next;   /* Next chunk, chunks after current are unused */
+    size_t              ak_size;   /* Size of data */
+    size_t              ak_used;   /* Bytes used of data */
+};
+
+/*! Cleanup function registered in an arena, allocated from the arena */
+struct arena_cleanup{
+    struct arena_cleanup    *ac_next; /* Previously registered cleanup */
+    clixon_arena_cleanup_fn *ac_fn;
+    void                    *ac_arg;
+};
+
+struct clixon_arena{
+    struct arena_chunk   *xa_head;    /* First chunk */
+    struct arena_chunk   *xa_cur;     /* Current chunk, or NULL if nothing allocated */
+    struct arena_cleanup *xa_cleanup; /* Last registered cleanup */
+    int                   xa_refcnt;  /* Number of owners */
+    int                   xa_freeing; /* Set when cleanups are run by free */
+};
+
+/*! Run cleanups registered after a given cleanup, in reverse order
+ * @param[in]  xa   Arena
+ * @param[in]  ac0  Stop at this cleanup, or NULL for all
+ */
+static void
+arena_cleanup_run(clixon_arena         *xa,
+		  struct arena_cleanup *ac0)
+{
+    struct arena_cleanup *ac;
+
+    while ((ac = xa->xa_cleanup) != NULL && ac != ac0){
+	xa->xa_cleanup = ac->ac_next;
+	ac->ac_fn(ac->ac_arg);
+    }
+}
+
+/*! Create an arena
+ * The arena has one owner, see clixon_arena_ref
+ * @retval  xa    Arena, free with clixon_arena_free or clixon_arena_unref
+ * @retval  NULL  Error
+ * @code
+ *   clixon_arena *xa;
+ *   if ((xa = clixon_arena_new()) == NULL)
+ *      err;
+ *   p = clixon_arena_alloc(xa, len);
+ *   ...
+ *   clixon_arena_free(xa);
+ * @endcode
+ */
+clixon_arena *
+clixon_arena_new(void)
+{
+    clixon_arena *xa;
+
+    if ((xa = malloc(sizeof(*xa))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(xa, 0, sizeof(*xa));
+    xa->xa_refcnt = 1;
+    return xa;
+}
+
+/*! Free an arena and everything allocated from it
+ * Registered cleanup functions are called first, in reverse order
+ * @param[in]  xa  Arena
+ */
+int
+clixon_arena_free(clixon_arena *xa)
+{
+    struct arena_chunk *ak;
+
+    xa->xa_freeing = 1;
+    arena_cleanup_run(xa, NULL);
+    while ((ak = xa->xa_head) != NULL){
+	xa->xa_head = ak->ak_next;
+	free(ak);
+    }
+    free(xa);
+    return 0;
+}
+
+/*! Add an owner of an arena
+ * @param[in]  xa  Arena
+ * @see clixon_arena_unref
+ */
+int
+clixon_arena_ref(clixon_arena *xa)
+{
+    if (!xa->xa_freeing)
+	xa->xa_refcnt++;
+    return 0;
+}
+
+/*! Remove an owner of an arena, free the arena when there are no owners left
+ * @param[in]  xa  Arena
+ * @retval     1   Arena was freed
+ * @retval     0   Arena has other owners
+ * Unrefs from cleanup functions when the arena is being freed are ignored
+ */
+int
+clixon_arena_unref(clixon_arena *xa)
+{
+    if (xa->xa_freeing)
+	return 0;
+    if (--xa->xa_refcnt > 0)
+	return 0;
+    clixon_arena_free(xa);
+    return 1;
+}
+
+/*! Allocate memory from an arena
+ * The memory is not initialized and is valid until the arena is freed or
+ * released to a position taken before the allocation.
+ * @param[in]  xa   Arena
+ * @param[in]  len  Number of bytes
+ * @retval     p    Pointer to memory
+ * @retval     NULL Error
+ */
+void *
+clixon_arena_alloc(clixon_arena *xa,
+		   size_t        len)
+{
+    struct arena_chunk *ak;
+    struct arena_chunk *akcur = xa->xa_cur;
+    size_t              size;
+    void               *p;
+
+    len = ARENA_ALIGN(len);
+    if (akcur == NULL || akcur->ak_used + len > akcur->ak_size){
+	/* Reuse next chunk if released and large enough, otherwise add one */
+	ak = akcur ? akcur->ak_next : xa->xa_head;
+	if (ak != NULL && ak->ak_size >= len)
+	    ak->ak_used = 0;
+	else{
+	    size = len > ARENA_CHUNK ? len : ARENA_CHUNK;
+	    if ((ak = malloc(ARENA_ALIGN(sizeof(*ak)) + size)) == NULL){
+		clicon_err(OE_UNIX, errno, "malloc");
+		return NULL;
+	    }
+	    ak->ak_size = size;
+	    ak->ak_used = 0;
+	    if (akcur){
+		ak->ak_next = akcur->ak_next;
+		akcur->ak_next = ak;
+	    }
+	    else{
+		ak->ak_next = xa->xa_head;
+		xa->xa_head = ak;
+	    }
+	}
+	xa->xa_cur = akcur = ak;
+    }
+    p = ARENA_CHUNK_DATA(akcur) + akcur->ak_used;
+    akcur->ak_used += len;
+    return p;
+}
+
+/*! Grow a memory area allocated from an arena
+ * Extend in place if it is the last allocation and there is room in the chunk,
+ * otherwise allocate new memory and copy. The old area is not reused.
+ * @param[in]  xa     Arena
+ * @param[in]  p      Memory allocated from the arena, or NULL
+ * @param[in]  len0   Current size of p
+ * @param[in]  len    New size, larger than len0
+ * @retval     p      Pointer to memory
+ * @retval     NULL   Error
+ */
+void *
+clixon_arena_grow(clixon_arena *xa,
+		  void         *p,
+		  size_t        len0,
+		  size_t        len)
+{
+    struct arena_chunk *ak = xa->xa_cur;
+    void               *p1;
+
+    len0 = ARENA_ALIGN(len0);
+    len = ARENA_ALIGN(len);
+    if (p && ak &&
+	(char*)p + len0 == ARENA_CHUNK_DATA(ak) + ak->ak_used &&
+	ak->ak_used - len0 + len <= ak->ak_size){
+	ak->ak_used += len - len0;
+	return p;
+    }
+    if ((p1 = clixon_arena_alloc(xa, len)) == NULL)
+	return NULL;
+    if (p)
+	memcpy(p1, p, len0);
+    return p1;
+}
+
+/*! Copy a string to an arena
+ * @param[in]  xa   Arena
+ * @param[in]  str  String
+ * @retval     s    Copy of string in arena
+ * @retval     NULL Error
+ */
+char *
+clixon_arena_strdup(clixon_arena *xa,
+		    const char   *str)
+{
+    size_t len = strlen(str) + 1;
+    char  *s;
+
+    if ((s = clixon_arena_alloc(xa, len)) != NULL)
+	memcpy(s, str, len);
+    return s;
+}
+
+/*! Register a function to be called when the arena is freed
+ * Used by objects in the arena that own memory outside of it
+ * @param[in]  xa   Arena
+ * @param[in]  fn   Cleanup function
+ * @param[in]  arg  Argument to fn
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clixon_arena_cleanup(clixon_arena            *xa,
+		     clixon_arena_cleanup_fn *fn,
+		     void                    *arg)
+{
+    struct arena_cleanup *ac;
+
+    if ((ac = clixon_arena_alloc(xa, sizeof(*ac))) == NULL)
+	return -1;
+    ac->ac_fn = fn;
+    ac->ac_arg = arg;
+    ac->ac_next = xa->xa_cleanup;
+    xa->xa_cleanup = ac;
+    return 0;
+}
+
+/*! Get current position of an arena
+ * @param[in]  xa  Arena, or NULL
+ * @param[out] ap  Position
+ * @see clixon_arena_release
+ */
+int
+clixon_arena_mark(clixon_arena     *xa,
+		  clixon_arena_pos *ap)
+{
+    if (xa){
+	ap->ap_chunk = xa->xa_cur;
+	ap->ap_used = xa->xa_cur ? xa->xa_cur->ak_used : 0;
+	ap->ap_cleanup = xa->xa_cleanup;
+    }
+    return 0;
+}
+
+/*! Release all memory allocated from an arena after a position
+ * Cleanups registered after the position are called. The chunks are kept and
+ * reused by later allocations.
+ * @param[in]  xa  Arena, or NULL
+ * @param[in]  ap  Position taken with clixon_arena_mark
+ */
+int
+clixon_arena_release(clixon_arena     *xa,
+		     clixon_arena_pos *ap)
+{
+    if (xa){
+	arena_cleanup_run(xa, (struct arena_cleanup *)ap->ap_cleanup);
+	xa->xa_cur = (struct arena_chunk *)ap->ap_chunk;
+	if (xa->xa_cur)
+	    xa->xa_cur->ak_used = ap->ap_used;
+    }
+    return 0;
+}
+
+/*! Get number of bytes allocated by an arena from the heap
+ * @param[in]  xa  Arena
+ * @retval     size  Bytes in chunks
+ */
+size_t
+clixon_arena_size(clixon_arena *xa)
+{
+    struct arena_chunk *ak;
+    size_t              size = sizeof(*xa);
+
+    for (ak = xa->xa_head; ak; ak = ak->ak_next)
+	size += ARENA_ALIGN(sizeof(*ak)) + ak->ak_size;
+    return size;
+}
@@ -609,3 +609,48 @@ clicon_session_id_set(clicon_handle h,
     clicon_hash_add(cdat, "session-id", &id, sizeof(uint32_t));
     return 0;
 }
+
+/*! Get reusable receive buffer for internal messages
+ * @param[in]  h    Clicon handle
+ * @param[out] len  Allocated length of buffer (if not NULL)
+ * @retval     msg  Buffer, or NULL if not allocated
+ * @see clicon_msg_rcv_buf
+ */
+struct clicon_msg *
+clicon_rcvbuf_get(clicon_handle h,
+		  size_t       *len)
+{
+    clicon_hash_t     *cdat = clicon_data(h);
+    void              *p;
+    struct clicon_msg *msg = NULL;
+
+    if ((p = clicon_hash_value(cdat, "rcvbuf", NULL)) != NULL)
+	msg = *(struct clicon_msg **)p;
+    if (len){
+	*len = 0;
+	if (msg && (p = clicon_hash_value(cdat, "rcvbuf-len", NULL)) != NULL)
+	    *len = *(size_t*)p;
+    }
+    return msg;
+}
+
+/*! Set reusable receive buffer for internal messages
+ * @param[in]  h    Clicon handle
+ * @param[in]  msg  Malloced buffer, freed by clicon_handle_exit
+ * @param[in]  len  Allocated length of buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+clicon_rcvbuf_set(clicon_handle      h,
+		  struct clicon_msg *msg,
+		  size_t             len)
+{
+    clicon_hash_t  *cdat = clicon_data(h);
+
+    if (clicon_hash_add(cdat, "rcvbuf", &msg, sizeof(msg)) == NULL)
+	return -1;
+    if (clicon_hash_add(cdat, "rcvbuf-len", &len, sizeof(len)) == NULL)
+	return -1;
+    return 0;
+}
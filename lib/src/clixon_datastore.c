@@ -40,6 +40,7 @@
 #endif
 
 #include <stdlib.h>
+#include <inttypes.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
@@ -69,10 +70,12 @@
 #include "clixon_file.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
+#include "clixon_xml_index.h"
 #include "clixon_plugin.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
 #include "clixon_yang_module.h"
+#include "clixon_stream.h"
 #include "clixon_datastore.h"
 
 #include "clixon_datastore_write.h"
@@ -136,6 +139,359 @@ xmldb_validate_db(const char *db)
     return 0;
 }
 
+/*! Get next generation number, unique among all databases of this handle
+ * @param[in]  h    Clicon handle
+ * @retval     gen  Generation number
+ * @retval     0    Error
+ * The first generation is the current time in microseconds, so that generations
+ * also increase across restarts.
+ */
+static uint64_t
+xmldb_generation_next(clicon_handle h)
+{
+    clicon_hash_t  *cdat = clicon_data(h);
+    void           *p;
+    uint64_t        gen;
+    struct timeval  tv;
+
+    if ((p = clicon_hash_value(cdat, "xmldb-generation", NULL)) != NULL)
+	gen = *(uint64_t*)p + 1;
+    else{
+	gettimeofday(&tv, NULL);
+	gen = (uint64_t)tv.tv_sec*1000000 + tv.tv_usec;
+    }
+    if (clicon_hash_add(cdat, "xmldb-generation", &gen, sizeof(gen)) == NULL)
+	return 0;
+    return gen;
+}
+
+/*! Initialize generation of a database the first time it is accessed
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Database
+ * @param[in]  de   Database element (copy), modified if not initialized
+ * @retval     0    OK
+ * @retval    -1    Error
+ * Time of last modification is taken from the database file, if it exists
+ */
+static int
+xmldb_generation_init(clicon_handle h,
+		      const char   *db,
+		      db_elmnt     *de)
+{
+    int         retval = -1;
+    char       *filename = NULL;
+    struct stat sb;
+
+    if (de->de_gen0.dg_gen != 0){
+	retval = 0;
+	goto done;
+    }
+    if ((de->de_gen0.dg_gen = xmldb_generation_next(h)) == 0)
+	goto done;
+    if (xmldb_db2file(h, db, &filename) < 0)
+	goto done;
+    if (lstat(filename, &sb) == 0){
+	de->de_gen0.dg_modified.tv_sec = sb.st_mtime;
+	de->de_gen0.dg_modified.tv_usec = 0;
+    }
+    else
+	gettimeofday(&de->de_gen0.dg_modified, NULL);
+    de->de_gen = de->de_gen0;
+    retval = 0;
+ done:
+    if (filename)
+	free(filename);
+    return retval;
+}
+
+/*! Get subtree key of a top-level XML node on the form <module>:<name>
+ * @param[in]  h    Clicon handle
+ * @param[in]  x    Top-level XML node, eg child of <config>
+ * @param[out] cb   Key is appended to this buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ * Same as the first element of an api-path, eg example:x
+ */
+static int
+xmldb_subtree_key(clicon_handle h,
+		  cxobj        *x,
+		  cbuf         *cb)
+{
+    yang_stmt *ymod = NULL;
+
+    if (ys_module_by_xml(clicon_dbspec_yang(h), x, &ymod) < 0)
+	return -1;
+    if (ymod)
+	cprintf(cb, "%s:", yang_argument_get(ymod));
+    cprintf(cb, "%s", xml_name(x));
+    return 0;
+}
+
+/*! Send datastore change notification on the XMLDB_CHANGE_STREAM stream, if it exists
+ * @param[in]  h        Clicon handle
+ * @param[in]  db       Database
+ * @param[in]  gen      New generation of database
+ * @param[in]  subtrees Changed top-level subtrees as <subtree> elements, or NULL for all
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see clixon-lib.yang datastore-change notification
+ */
+static int
+xmldb_generation_notify(clicon_handle h,
+			const char   *db,
+			uint64_t      gen,
+			cbuf         *subtrees)
+{
+    if (stream_find(h, XMLDB_CHANGE_STREAM) == NULL)
+	return 0;
+    return stream_notify(h, XMLDB_CHANGE_STREAM,
+			 "<datastore-change xmlns=\"http://clicon.org/lib\"><datastore>%s</datastore><generation>%" PRIu64 "</generation>%s</datastore-change>",
+			 db, gen, subtrees?cbuf_get(subtrees):"");
+}
+
+/*! Bump generation of a database after a modification
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Database
+ * @param[in]  xt   Modification tree <config>..., or NULL if the whole database changed
+ * @retval     0    OK
+ * @retval    -1    Error
+ * All top-level subtrees of xt get a new generation, as well as the database itself.
+ * If xt is NULL, the generations of all subtrees are reset to the new generation.
+ * @see xmldb_generation
+ */
+int
+xmldb_generation_bump(clicon_handle h,
+		      const char   *db,
+		      cxobj        *xt)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    db_elmnt  de0 = {0,};
+    db_gen    dg;
+    cxobj    *x;
+    cbuf     *cb = NULL;
+    cbuf     *cbs = NULL; /* Changed subtrees for notification */
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de0 = *de;
+    if ((dg.dg_gen = xmldb_generation_next(h)) == 0)
+	goto done;
+    gettimeofday(&dg.dg_modified, NULL);
+    if (xt == NULL){
+	de0.de_gen0 = dg;
+	if (de0.de_subgen){
+	    clicon_hash_free(de0.de_subgen);
+	    de0.de_subgen = NULL;
+	}
+    }
+    else{
+	/* Other subtrees fall back to de_gen0 */
+	if (xmldb_generation_init(h, db, &de0) < 0)
+	    goto done;
+	if (de0.de_subgen == NULL &&
+	    (de0.de_subgen = clicon_hash_init()) == NULL)
+	    goto done;
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if ((cbs = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	x = NULL;
+	while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL){
+	    cbuf_reset(cb);
+	    if (xmldb_subtree_key(h, x, cb) < 0)
+		goto done;
+	    if (clicon_hash_add(de0.de_subgen, cbuf_get(cb), &dg, sizeof(dg)) == NULL)
+		goto done;
+	    cprintf(cbs, "<subtree>%s</subtree>", cbuf_get(cb));
+	}
+    }
+    de0.de_gen = dg;
+    if (clicon_db_elmnt_set(h, db, &de0) < 0)
+	goto done;
+    if (xmldb_generation_notify(h, db, dg.dg_gen, cbs) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (cbs)
+	cbuf_free(cbs);
+    return retval;
+}
+
+/*! Get generation and time of last modification of a database or a top-level subtree
+ * @param[in]  h        Clicon handle
+ * @param[in]  db       Database
+ * @param[in]  subtree  Top-level subtree as <module>:<name>, or NULL for whole database
+ * @param[out] gen      Generation
+ * @param[out] tv       Time of last modification (if not NULL)
+ * @retval     0        OK
+ * @retval    -1        Error
+ * Generations are unique among the databases and increase with every modification.
+ * They follow the content in xmldb_copy(), which means that two equal generations
+ * of the same (sub)tree imply equal content. Suitable as entity-tags.
+ * @code
+ *   uint64_t gen;
+ *   if (xmldb_generation(h, "running", "example:x", &gen, NULL) < 0)
+ *      err;
+ * @endcode
+ */
+int
+xmldb_generation(clicon_handle   h,
+		 const char     *db,
+		 const char     *subtree,
+		 uint64_t       *gen,
+		 struct timeval *tv)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    db_elmnt  de0 = {0,};
+    db_gen   *dg;
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de0 = *de;
+    if (de0.de_gen0.dg_gen == 0){
+	if (xmldb_generation_init(h, db, &de0) < 0)
+	    goto done;
+	if (clicon_db_elmnt_set(h, db, &de0) < 0)
+	    goto done;
+    }
+    dg = &de0.de_gen;
+    if (subtree != NULL){
+	if (de0.de_subgen == NULL ||
+	    (dg = clicon_hash_value(de0.de_subgen, subtree, NULL)) == NULL)
+	    dg = &de0.de_gen0;
+    }
+    *gen = dg->dg_gen;
+    if (tv)
+	*tv = dg->dg_modified;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add subtrees of one database whose generations differ in another database
+ * @param[in]  de1  Database element with subtree generations
+ * @param[in]  de2  Database element to compare with, same de_gen0 as de1
+ * @param[out] cb   Differing subtrees are appended as <subtree> elements
+ * @retval     0    OK
+ * @retval    -1    Error
+ * A subtree without generation has the generation of the whole database, de_gen0.
+ * Subtrees in both databases may be added twice.
+ */
+static int
+xmldb_generation_diff(db_elmnt *de1,
+		      db_elmnt *de2,
+		      cbuf     *cb)
+{
+    int      retval = -1;
+    char   **keys = NULL;
+    size_t   klen;
+    int      i;
+    db_gen  *dg1;
+    db_gen  *dg2;
+
+    if (de1->de_subgen == NULL){
+	retval = 0;
+	goto done;
+    }
+    if (clicon_hash_keys(de1->de_subgen, &keys, &klen) < 0)
+	goto done;
+    for (i = 0; i < klen; i++){
+	if ((dg1 = clicon_hash_value(de1->de_subgen, keys[i], NULL)) == NULL)
+	    continue;
+	if (de2->de_subgen == NULL ||
+	    (dg2 = clicon_hash_value(de2->de_subgen, keys[i], NULL)) == NULL)
+	    dg2 = &de2->de_gen0;
+	if (dg1->dg_gen != dg2->dg_gen)
+	    cprintf(cb, "<subtree>%s</subtree>", keys[i]);
+    }
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Copy generations of a database along with its content
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_generation_copy(clicon_handle h,
+		      const char   *from,
+		      const char   *to)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    db_elmnt  de1 = {0,};
+    db_elmnt  de2 = {0,};
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+    void     *p;
+    cbuf     *cbs = NULL; /* Changed subtrees for notification */
+
+    if ((de = clicon_db_elmnt_get(h, from)) != NULL)
+	de1 = *de;
+    if (de1.de_gen0.dg_gen == 0){
+	if (xmldb_generation_init(h, from, &de1) < 0)
+	    goto done;
+	if (clicon_db_elmnt_set(h, from, &de1) < 0)
+	    goto done;
+    }
+    if ((de = clicon_db_elmnt_get(h, to)) != NULL)
+	de2 = *de;
+    if (de2.de_gen.dg_gen == de1.de_gen.dg_gen){ /* Same content */
+	retval = 0;
+	goto done;
+    }
+    /* Changed subtrees for notification, all if whole database differs */
+    if (de2.de_gen0.dg_gen == de1.de_gen0.dg_gen){
+	if ((cbs = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (xmldb_generation_diff(&de1, &de2, cbs) < 0 ||
+	    xmldb_generation_diff(&de2, &de1, cbs) < 0)
+	    goto done;
+    }
+    if (de2.de_subgen){
+	clicon_hash_free(de2.de_subgen);
+	de2.de_subgen = NULL;
+    }
+    de2.de_gen = de1.de_gen;
+    de2.de_gen0 = de1.de_gen0;
+    if (de1.de_subgen){
+	if ((de2.de_subgen = clicon_hash_init()) == NULL)
+	    goto done;
+	if (clicon_hash_keys(de1.de_subgen, &keys, &klen) < 0)
+	    goto done;
+	for (i = 0; i < klen; i++)
+	    if ((p = clicon_hash_value(de1.de_subgen, keys[i], NULL)) != NULL &&
+		clicon_hash_add(de2.de_subgen, keys[i], p, sizeof(db_gen)) == NULL)
+		goto done;
+    }
+    if (clicon_db_elmnt_set(h, to, &de2) < 0)
+	goto done;
+    if (xmldb_generation_notify(h, to, de2.de_gen.dg_gen, cbs) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    if (cbs)
+	cbuf_free(cbs);
+    return retval;
+}
+
 /*! Connect to a datastore plugin, allocate resources to be used in API calls
  * @param[in]  h    Clicon handle
  * @retval     0    OK
@@ -169,6 +525,10 @@ xmldb_disconnect(clicon_handle h)
 		xml_free(de->de_xml);
 		de->de_xml = NULL;
 	    }
+	    if (de->de_subgen){
+		clicon_hash_free(de->de_subgen);
+		de->de_subgen = NULL;
+	    }
 	}
     retval = 0;
  done:
@@ -231,6 +591,8 @@ xmldb_copy(clicon_handle h,
 	 * de and de->de_xml */
 	if (de2)
 	    de0 = *de2;
+	if (x2 && xmldb_index(h, x2) < 0)
+	    goto done;
 	de0.de_xml = x2; /* The new tree */
 	clicon_db_elmnt_set(h, to, &de0);
     }
@@ -241,6 +603,8 @@ xmldb_copy(clicon_handle h,
 	goto done;
     if (clicon_file_copy(fromfile, tofile) < 0)
 	goto done;
+    if (xmldb_generation_copy(h, from, to) < 0)
+	goto done;
     retval = 0;
  done:
     if (fromfile)
@@ -401,6 +765,8 @@ xmldb_delete(clicon_handle h,
 	    clicon_err(OE_DB, errno, "truncate %s", filename);
 	    goto done;
 	}
+    if (xmldb_generation_bump(h, db, NULL) < 0)
+	goto done;
     retval = 0;
  done:
     if (filename)
@@ -438,6 +804,8 @@ xmldb_create(clicon_handle h,
 	clicon_err(OE_UNIX, errno, "open(%s)", filename);
 	goto done;
     }
+    if (xmldb_generation_bump(h, db, NULL) < 0)
+	goto done;
    retval = 0;
  done:
     if (filename)
@@ -464,3 +832,181 @@ xmldb_db_reset(clicon_handle h,
 	return -1;
     return 0;
 }
+
+/*! Get yang of a leaf with value index given by CLICON_XMLDB_VALUE_INDEX
+ * @param[in]  h      Clixon handle
+ * @param[in]  path   Absolute schema nodeid of leaf, eg /if:interfaces/if:interface/if:type
+ * @param[out] yleaf  Yang leaf, or NULL if not found or not indexable (warning logged)
+ * @retval     0      OK
+ * @retval    -1      Error
+ * The leaf should be a non-key leaf without default of a config list ordered-by system.
+ */
+static int
+xmldb_index_yang(clicon_handle h,
+		 char         *path,
+		 yang_stmt   **yleaf)
+{
+    yang_stmt *yspec;
+    yang_stmt *y = NULL;
+    yang_stmt *ylist;
+    int        ret;
+
+    *yleaf = NULL;
+    if ((yspec = clicon_dbspec_yang(h)) == NULL)
+	return 0;
+    if (yang_abs_schema_nodeid(yspec, NULL, path, Y_LEAF, &y) < 0)
+	return -1;
+    if (y == NULL){
+	clicon_log(LOG_WARNING, "CLICON_XMLDB_VALUE_INDEX: leaf %s not found", path);
+	return 0;
+    }
+    if ((ylist = yang_parent_get(y)) == NULL ||
+	yang_keyword_get(ylist) != Y_LIST ||
+	yang_config(ylist) == 0 ||
+	yang_find(ylist, Y_ORDERED_BY, "user") != NULL ||
+	yang_find(y, Y_DEFAULT, NULL) != NULL){
+	clicon_log(LOG_WARNING, "CLICON_XMLDB_VALUE_INDEX: %s is not a leaf without default of a config list ordered-by system", path);
+	return 0;
+    }
+    if ((ret = yang_key_match(ylist, yang_argument_get(y))) < 0)
+	return -1;
+    if (ret == 1){
+	clicon_log(LOG_WARNING, "CLICON_XMLDB_VALUE_INDEX: %s is a key", path);
+	return 0;
+    }
+    *yleaf = y;
+    return 0;
+}
+
+/* Value index given by CLICON_XMLDB_VALUE_INDEX, resolved to yang */
+struct xmldb_value_index{
+    yang_stmt *xvi_yleaf; /* Yang of leaf, NULL terminates vector */
+    char      *xvi_path;  /* Option value */
+};
+
+/*! Get value indexes given by CLICON_XMLDB_VALUE_INDEX resolved to yang leafs
+ *
+ * The paths are resolved once, and invalid paths logged once, the first time
+ * the value indexes are needed after the yang specs are loaded.
+ * @param[in]  h     Clixon handle
+ * @param[out] xviv  Vector of value indexes terminated by a NULL yang, or NULL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_value_indexes(clicon_handle              h,
+		    struct xmldb_value_index **xviv)
+{
+    int                       retval = -1;
+    clicon_hash_t            *cdat = clicon_data(h);
+    struct xmldb_value_index *vec = NULL;
+    int                       len = 0;
+    cxobj                    *x;
+    yang_stmt                *y;
+    void                     *p;
+
+    *xviv = NULL;
+    if ((p = clicon_hash_value(cdat, "xmldb-value-index", NULL)) != NULL){
+	*xviv = (struct xmldb_value_index *)p;
+	return 0;
+    }
+    if (clicon_conf_xml(h) == NULL || clicon_dbspec_yang(h) == NULL)
+	return 0;
+    if ((vec = malloc(sizeof(*vec))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    x = NULL;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(x), "CLICON_XMLDB_VALUE_INDEX") != 0)
+	    continue;
+	if (xmldb_index_yang(h, xml_body(x), &y) < 0)
+	    goto done;
+	if (y == NULL)
+	    continue;
+	if ((p = realloc(vec, (len+2)*sizeof(*vec))) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    goto done;
+	}
+	vec = p;
+	vec[len].xvi_yleaf = y;
+	vec[len].xvi_path = xml_body(x);
+	len++;
+    }
+    vec[len].xvi_yleaf = NULL;
+    vec[len].xvi_path = NULL;
+    if (clicon_hash_add(cdat, "xmldb-value-index", vec, (len+1)*sizeof(*vec)) == NULL)
+	goto done;
+    *xviv = clicon_hash_value(cdat, "xmldb-value-index", NULL);
+    retval = 0;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Enable indexes of a cached datastore tree given by options
+ * @param[in]  h    Clixon handle
+ * @param[in]  xt   Top of datastore tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see CLICON_XMLDB_INDEX and CLICON_XMLDB_VALUE_INDEX
+ */
+int
+xmldb_index(clicon_handle h,
+	    cxobj        *xt)
+{
+    struct xmldb_value_index *xvi;
+
+    if (clicon_option_bool(h, "CLICON_XMLDB_INDEX") &&
+	xml_index_enable(xt) < 0)
+	return -1;
+    if (xmldb_value_indexes(h, &xvi) < 0)
+	return -1;
+    for (; xvi && xvi->xvi_yleaf; xvi++)
+	if (xml_index_value_enable(xt, xvi->xvi_yleaf) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Get state of value indexes of cached datastores
+ * @param[in]  h    Clixon handle
+ * @param[out] cb   <datastore-index> element, or nothing if there are no value indexes
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon-lib.yang datastore-index
+ */
+int
+xmldb_index_state(clicon_handle h,
+		  cbuf         *cb)
+{
+    char                        *dbs[] = {"running", "candidate", "startup", NULL};
+    struct xml_value_index_stats vs;
+    db_elmnt                    *de;
+    struct xmldb_value_index    *xvi;
+    int                          i;
+    int                          n = 0;
+
+    if (xmldb_value_indexes(h, &xvi) < 0)
+	return -1;
+    for (; xvi && xvi->xvi_yleaf; xvi++){
+	for (i=0; dbs[i]; i++){
+	    if ((de = clicon_db_elmnt_get(h, dbs[i])) == NULL ||
+		de->de_xml == NULL ||
+		xml_index_value_stats(de->de_xml, xvi->xvi_yleaf, &vs) != 1)
+		continue;
+	    if (n++ == 0)
+		cprintf(cb, "<datastore-index xmlns=\"http://clicon.org/lib\">");
+	    cprintf(cb, "<value-index><datastore>%s</datastore><path>%s</path>",
+		    dbs[i], xvi->xvi_path);
+	    cprintf(cb, "<entries>%" PRIu64 "</entries><values>%" PRIu64 "</values>",
+		    vs.vs_entries, vs.vs_values);
+	    cprintf(cb, "<memory>%" PRIu64 "</memory><lookups>%" PRIu64 "</lookups><updates>%" PRIu64 "</updates>",
+		    vs.vs_memory, vs.vs_lookups, vs.vs_updates);
+	    cprintf(cb, "</value-index>");
+	}
+    }
+    if (n)
+	cprintf(cb, "</datastore-index>");
+    return 0;
+}
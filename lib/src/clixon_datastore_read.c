@@ -435,6 +435,8 @@ xmldb_get_nocache(clicon_handle       h,
     if (xvec != NULL)
 	for (i=0; i<xlen; i++){
 	    x = xvec[i];
+	    if (xml_flag(x, XML_FLAG_DEFAULT)) /* virtual default, see xml_default_child */
+		continue;
 	    xml_flag_set(x, XML_FLAG_MARK);
 	}
     /* Remove everything that is not marked */
@@ -444,10 +446,6 @@ xmldb_get_nocache(clicon_handle       h,
     /* reset flag */
     if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
 	goto done;
-
-    /* Add default values (if not set) */
-    if (xml_apply(xt, CX_ELMNT, xml_default, h) < 0)
-    	goto done;
 #if 0 /* debug */
     if (xml_apply0(xt, -1, xml_sort_verify, NULL) < 0)
 	clicon_log(LOG_NOTICE, "%s: sort verify failed #2", __FUNCTION__);
@@ -515,6 +513,10 @@ xmldb_get_cache(clicon_handle    h,
 	 * Argument against: we may want to have a semantically wrong file and wish
 	 * to edit?
 	 */
+	if (de != NULL)
+	    de0 = *de;
+	if (xmldb_index(h, x0t) < 0)
+	    goto done;
 	de0.de_xml = x0t;
 	clicon_db_elmnt_set(h, db, &de0);
     } /* x0t == NULL */
@@ -542,6 +544,8 @@ xmldb_get_cache(clicon_handle    h,
      */
     for (i=0; i<xlen; i++){
 	x0 = xvec[i];
+	if (xml_flag(x0, XML_FLAG_DEFAULT)) /* virtual default, see xml_default_child */
+	    continue;
 	xml_flag_set(x0, XML_FLAG_MARK);
 	xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
     }
@@ -551,11 +555,7 @@ xmldb_get_cache(clicon_handle    h,
 	goto done;
     if (xml_apply(x1t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
 	goto done;
-    /* x1t is wrong here should be <config><system>.. but is <system>.. */
-    /* XXX where should we apply default values once? */
-    if (xml_apply(x1t, CX_ELMNT, xml_default, h) < 0)
-	goto done;
-    
+    /* Default values are not added to the tree, see clicon_xml2cbuf_wdef */
     /* Copy the matching parts of the (relevant) XML tree.
      * If cache was empty, also update to datastore cache
      */
@@ -614,6 +614,10 @@ xmldb_get_zerocopy(clicon_handle    h,
 	 * Argument against: we may want to have a semantically wrong file and wish
 	 * to edit?
 	 */
+	if (de != NULL)
+	    de0 = *de;
+	if (xmldb_index(h, x0t) < 0)
+	    goto done;
 	de0.de_xml = x0t;
 	clicon_db_elmnt_set(h, db, &de0);
     } /* x0t == NULL */
@@ -627,12 +631,11 @@ xmldb_get_zerocopy(clicon_handle    h,
      */
     for (i=0; i<xlen; i++){
 	x0 = xvec[i];
+	if (xml_flag(x0, XML_FLAG_DEFAULT)) /* virtual default, see xml_default_child */
+	    continue;
 	xml_flag_set(x0, XML_FLAG_MARK);
 	xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
     }
-    /* Apply default values (removed in clear function) */
-    if (xml_apply(x0t, CX_ELMNT, xml_default, h) < 0)
-	goto done;
     if (debug>1)
     	clicon_xml2file(stderr, x0t, 0, 1);
     *xtop = x0t;
@@ -691,9 +694,11 @@ xmldb_get(clicon_handle    h,
  *   if (xmldb_get0(xh, "running", nsc, "/interface[name="eth"]", 0, &xt, NULL) < 0)
  *      err;
  *   ...
- *   xmldb_get0_clear(h, xt);   # Clear tree from default values and flags 
+ *   xmldb_get0_clear(h, xt);   # Clear tree from flags 
  *   xmldb_get0_free(h, &xt);   # Free tree
  * @endcode
+ * @note Default values are not added to the returned tree, they are virtual
+ *       in XPath and added when printing, see clicon_xml2cbuf_wdef
  * @see xml_nsctx_node  to get a XML namespace context from XML tree
  * @see xmldb_get for a copy version (old-style)
  */
@@ -711,15 +716,14 @@ xmldb_get0(clicon_handle    h,
     switch (clicon_datastore_cache(h)){
     case DATASTORE_NOCACHE:
 	/* Read from file into created/copy tree, prune non-matching xpath 
-	 * Add default values in copy
 	 * Copy deleted by xmldb_free
 	 */
 	retval = xmldb_get_nocache(h, db, nsc, xpath, xret, msd);
 	break;
     case DATASTORE_CACHE_ZEROCOPY:
 	/* Get cache (file if empty) mark xpath match in original tree 
-	 * add default values in original tree and return that.
-	 * Default values and markings removed in xmldb_clear
+	 * and return that.
+	 * Markings removed in xmldb_clear
 	 */
 	if (!copy){
 	    retval = xmldb_get_zerocopy(h, db, nsc, xpath, xret, msd);
@@ -728,7 +732,7 @@ xmldb_get0(clicon_handle    h,
 	/* fall through */
     case DATASTORE_CACHE:
 	/* Get cache (file if empty) mark xpath match and copy marked into copy 
-	 * Add default values in copy, return copy
+	 * return copy
 	 * Copy deleted by xmldb_free
 	 */
 	retval = xmldb_get_cache(h, db, nsc, xpath, xret, msd);
@@ -741,29 +745,22 @@ xmldb_get0(clicon_handle    h,
  *
  * @param[in]  h    Clicon handle
  * @param[in]  db   Name of datastore
- * "Clear" an xml tree means removing default values and resetting all flags.
+ * "Clear" an xml tree means resetting all flags.
  * @see xmldb_get0
  */
 int 
 xmldb_get0_clear(clicon_handle    h, 
 		 cxobj           *x)
 {
-    int        retval = -1;
-    
     if (clicon_datastore_cache(h) != DATASTORE_CACHE_ZEROCOPY)
 	goto ok;
     if (x == NULL)
 	goto ok;
-    /* clear XML tree of defaults */
-    if (xml_tree_prune_flagged(x, XML_FLAG_DEFAULT, 1) < 0)
-	goto done;
     /* clear mark and change */
     xml_apply0(x, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
 	       (void*)(0xff));
  ok:
-    retval = 0;
- done:
-    return retval;
+    return 0;
 }
 
 /*! Free xml tree obtained with xmldb_get0
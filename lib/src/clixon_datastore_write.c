@@ -203,6 +203,257 @@ check_identityref(cxobj     *x0,
     return retval;
 }
 
+/*! Check that element children of x are sorted and unique
+ * @param[in]  x   XML node
+ * @retval     1   Sorted and no two children are equal
+ * @retval     0   Not sorted or duplicates
+ */
+static int
+text_modify_unique(cxobj *x)
+{
+    cxobj *xc = NULL;
+    cxobj *xprev = NULL;
+
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+	if (xprev && xml_cmp(xprev, xc, 0) >= 0)
+	    return 0;
+	xprev = xc;
+    }
+    return 1;
+}
+
+/*! Check if the children of a modification tree can be moved into the base tree
+ *
+ * Moving is the same as adding each child of x1 one by one to a new base node if
+ * the subtree has no other attributes than namespace declarations, no prefixes,
+ * no ordered-by user lists, no identityref values with prefixes, and if children
+ * are sorted without duplicates. Unsorted children are sorted here.
+ * @param[in]  x1   XML node in modification tree, its children are checked
+ * @retval     1    Yes, children can be moved
+ * @retval     0    No, use text_modify on each child
+ * @retval    -1    Error
+ * @see text_modify_move
+ */
+static int
+text_modify_movable(cxobj *x1)
+{
+    cxobj     *x;
+    cxobj     *xa;
+    yang_stmt *y;
+    yang_stmt *yrestype;
+    char      *body;
+    int        ret;
+
+    if (text_modify_unique(x1) == 0){
+	xml_sort(x1, NULL);
+	if (text_modify_unique(x1) == 0)
+	    return 0;
+    }
+    x = NULL;
+    while ((x = xml_child_each(x1, x, CX_ELMNT)) != NULL) {
+	if ((y = xml_spec(x)) == NULL || xml_prefix(x) != NULL)
+	    return 0;
+	/* Only namespace declarations, no operation, insert, etc */
+	xa = NULL;
+	while ((xa = xml_child_each(x, xa, CX_ATTR)) != NULL)
+	    if (xml_prefix(xa) ? strcmp(xml_prefix(xa), "xmlns") != 0 :
+		strcmp(xml_name(xa), "xmlns") != 0)
+		return 0;
+	/* Cached namespace context may refer to bindings in x1 */
+	nscache_clear(x);
+	switch (yang_keyword_get(y)){
+	case Y_LEAF_LIST:
+	    if (yang_find(y, Y_ORDERED_BY, "user") != NULL)
+		return 0;
+	case Y_LEAF: /* fall thru */
+	    if (xml_child_nr_type(x, CX_ELMNT))
+		return 0;
+	    /* identityref prefix may need a new namespace binding */
+	    if ((body = xml_body(x)) != NULL && strchr(body, ':') != NULL){
+		if (yang_type_get(y, NULL, &yrestype,
+				  NULL, NULL, NULL, NULL, NULL) < 0)
+		    return -1;
+		if (strcmp(yang_argument_get(yrestype), "identityref") == 0)
+		    return 0;
+	    }
+	    break;
+	case Y_ANYXML: /* copied as a whole */
+	case Y_ANYDATA:
+	    break;
+	case Y_LIST:
+	    if (yang_find(y, Y_ORDERED_BY, "user") != NULL)
+		return 0;
+	default: /* fall thru */
+	    if ((ret = text_modify_movable(x)) < 1)
+		return ret;
+	    break;
+	}
+    }
+    return 1;
+}
+
+/*! Move element children of modification node x1 to new base node x0
+ * @param[in]  x0   New base node
+ * @param[in]  x1   Modification node, element children are removed
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see text_modify_movable  which must be called first
+ */
+static int
+text_modify_move(cxobj *x0,
+		 cxobj *x1)
+{
+    int     retval = -1;
+    cxobj **vec = NULL;
+    cxobj  *xc;
+    int     n;
+    int     i;
+
+    if ((n = xml_child_nr(x1)) == 0)
+	goto ok;
+    if ((vec = malloc(n*sizeof(cxobj *))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memcpy(vec, xml_childvec_get(x1), n*sizeof(cxobj *));
+    /* Remove from end, attributes are first so elements are not shifted */
+    for (i=n-1; i>=0; i--)
+	if (xml_type(vec[i]) == CX_ELMNT &&
+	    xml_child_rm(x1, i) < 0)
+	    goto done;
+    for (i=0; i<n; i++){
+	xc = vec[i];
+	if (xml_type(xc) != CX_ELMNT)
+	    continue;
+	if (xml_child_insert_pos(x0, xc, xml_child_nr(x0)) < 0)
+	    goto done;
+	xml_parent_set(xc, x0);
+    }
+    if (xml_sorted(x1)) /* x0 had no children, moved in order */
+	xml_sorted_set(x0, 1);
+    clicon_debug(1, "%s %s: %d nodes moved", __FUNCTION__, xml_name(x0), n);
+ ok:
+    retval = 0;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Match children of x1 with children of x0 by a merge-join of the sorted child vectors
+ *
+ * Instead of one binary search in x0 per child of x1 (match_base_child), walk
+ * both child vectors in lockstep. Only applicable if x1:s children are sorted,
+ * not ordered-by user, not in a choice and have all keys. Also only used if
+ * the number of x1 children is large in relation to x0:s (join is linear in both).
+ * @param[in]  x0     Base xml node
+ * @param[in]  y0     Yang spec of x0
+ * @param[in]  x1     XML node which modifies base
+ * @param[out] x0vec  Matching x0 children, one per x1 element child, NULL if no match
+ * @retval     1      Matched, x0vec is set
+ * @retval     0      Not applicable, x0vec is not set
+ * @see match_base_child
+ */
+static int
+text_modify_join(cxobj     *x0,
+		 yang_stmt *y0,
+		 cxobj     *x1,
+		 cxobj    **x0vec)
+{
+    cxobj     *x0c;
+    cxobj     *x1c;
+    cxobj     *xprev = NULL;
+    yang_stmt *yc;
+    cvec      *cvk;
+    cg_var    *cvi;
+    int        n0;
+    int        n1;
+    int        log2n = 0;
+    int        i;
+    int        j;
+    int        cmp = 1;
+
+    n0 = xml_child_nr(x0);
+    n1 = xml_child_nr_type(x1, CX_ELMNT);
+    for (i=n0+n1; i>1; i>>=1)
+	log2n++;
+    /* Search and insert per child is n1*log(n0+n1), join is n0+n1 */
+    if (n1 < 2 || n1*log2n < n0+n1)
+	return 0;
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+	if ((yc = yang_find_datanode(y0, xml_name(x1c))) == NULL ||
+	    yc != xml_spec(x1c))
+	    return 0; /* Error handled by match_base_child path */
+	if (yang_choice(yc) != NULL || yang_config(yc) == 0)
+	    return 0;
+	switch (yang_keyword_get(yc)){
+	case Y_LIST:
+	    if (yang_find(yc, Y_ORDERED_BY, "user") != NULL)
+		return 0;
+	    cvk = yang_cvec_get(yc);
+	    cvi = NULL;
+	    while ((cvi = cvec_each(cvk, cvi)) != NULL)
+		if (xml_find(x1c, cv_string_get(cvi)) == NULL)
+		    return 0;
+	    break;
+	case Y_LEAF_LIST:
+	    if (yang_find(yc, Y_ORDERED_BY, "user") != NULL ||
+		xml_body(x1c) == NULL)
+		return 0;
+	    break;
+	default:
+	    break;
+	}
+	if (xprev && xml_cmp(xprev, x1c, 0) > 0)
+	    return 0;
+	xprev = x1c;
+    }
+    j = 0;
+    i = 0;
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+	for (; j<n0; j++){
+	    x0c = xml_child_i(x0, j);
+	    if (xml_type(x0c) != CX_ELMNT)
+		continue;
+	    if ((cmp = xml_cmp(x0c, x1c, 0)) >= 0)
+		break;
+	}
+	x0vec[i++] = (j<n0 && cmp==0) ? xml_child_i(x0, j) : NULL;
+    }
+    return 1;
+}
+
+/*! Add a new child x0 to parent x0p
+ * @param[in]  x0p      Parent
+ * @param[in]  x0       New child without parent
+ * @param[in]  ins      Insert type, see xml_insert
+ * @param[in]  key_val  Key or value for ordered-by user, see xml_insert
+ * @param[in]  nsckey   Namespace context of key_val, see xml_insert
+ * @param[out] appended If set, append x0 last and increment, caller sorts
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xml_sort_tail
+ */
+static int
+text_modify_add(cxobj           *x0p,
+		cxobj           *x0,
+		enum insert_type ins,
+		char            *key_val,
+		cvec            *nsckey,
+		int             *appended)
+{
+    if (appended == NULL)
+	return xml_insert(x0p, x0, ins, key_val, nsckey);
+    if (xml_child_insert_pos(x0p, x0, xml_child_nr(x0p)) < 0)
+	return -1;
+    xml_parent_set(x0, x0p);
+    nscache_clear(x0);
+    (*appended)++;
+    return 0;
+}
+
 /*! Modify a base tree x0 with x1 with yang spec y according to operation op
  * @param[in]  th       Datastore text handle
  * @param[in]  x0       Base xml tree (can be NULL in add scenarios)
@@ -213,6 +464,9 @@ check_identityref(cxobj     *x0,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  move     If set, subtrees of x1 may be moved to x0 instead of copied
+ * @param[in,out] appended If set, new x0 is appended last to x0p and counted,
+ *                      caller sorts x0p, see xml_sort_tail
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval    -1        Error
  * @retval     0        Failed (cbret set)
@@ -234,6 +488,8 @@ text_modify(clicon_handle       h,
 	    char               *username,
 	    cxobj              *xnacm,
 	    int                 permit,
+	    int                 move,
+	    int                *appended,
 	    cbuf               *cbret)
 {
     int        retval = -1;
@@ -255,6 +511,8 @@ text_modify(clicon_handle       h,
     enum insert_type insert = INS_LAST;
     int        changed = 0; /* Only if x0p's children have changed-> sort necessary */
     cvec      *nscx1 = NULL;
+    int        join;
+    int        nappended = 0; /* Nr of x0 children appended by join */
     
     /* Check for operations embedded in tree according to netconf */
     if ((ret = attr_ns_value(x1,
@@ -380,7 +638,7 @@ text_modify(clicon_handle       h,
 		}
 	    }
 	    if (changed){ 
-		if (xml_insert(x0p, x0, insert, valstr, NULL) < 0) 
+		if (text_modify_add(x0p, x0, insert, valstr, NULL, appended) < 0) 
 		    goto done;
 	    }
 	    break;
@@ -494,6 +752,8 @@ text_modify(clicon_handle       h,
 		    goto done;
 		if (xml_copy(x1, x0) < 0)
 		    goto done;
+		if (appended)
+		    (*appended)++;
 		break;
 	    }
 	    if (x0==NULL){
@@ -519,6 +779,21 @@ text_modify(clicon_handle       h,
 		    goto done;
 		if (op==OP_NONE)
 		    xml_flag_set(x0, XML_FLAG_NONE); /* Mark for potential deletion */
+		/* Bulk load: move x1:s children to the new node instead of
+		 * adding them one by one. Then the passes below have nothing to do.
+		 * NACM create of the subtree is checked above.
+		 * Arena nodes are copied instead since moving them would keep
+		 * the arena in the datastore. The backend therefore copies the
+		 * config of an edit-config request to the heap, see
+		 * from_client_edit_config.
+		 */
+		if (move && op != OP_NONE && xml_arena_get(x1) == NULL &&
+		    xml_prefix(x1) == NULL && xml_prefix(x0) == NULL){
+		    if ((ret = text_modify_movable(x1)) < 0)
+			goto done;
+		    if (ret == 1 && text_modify_move(x0, x1) < 0)
+			goto done;
+		}
 	    }
 	    /* First pass: Loop through children of the x1 modification tree 
 	     * collect matching nodes from x0 in x0vec (no changes to x0 children)
@@ -527,9 +802,12 @@ text_modify(clicon_handle       h,
 		clicon_err(OE_UNIX, errno, "calloc");
 		goto done;
 	    }
+	    /* Large sorted modifications: match by merge-join instead */
+	    join = text_modify_join(x0, y0, x1, x0vec);
 	    x1c = NULL; 
 	    i = 0;
-	    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+	    while (!join &&
+		   (x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
 		x1cname = xml_name(x1c);
 		/* Get yang spec of the child by child matching */
 		if ((yc = yang_find_datanode(y0, x1cname)) == NULL){
@@ -563,19 +841,27 @@ text_modify(clicon_handle       h,
 	     */
 	    x1c = NULL;
 	    i = 0;
+	    ret = 1; /* ret from text_modify of children, unset if none */
 	    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
 		x1cname = xml_name(x1c);
 		x0c = x0vec[i++];
 		yc = yang_find_datanode(y0, x1cname);
 		if ((ret = text_modify(h, x0c, yc, x0, x1c, op,
-				       username, xnacm, permit, cbret)) < 0)
+				       username, xnacm, permit, move,
+				       join?&nappended:NULL, cbret)) < 0)
 		    goto done;
 		/* If xml return - ie netconf error xml tree, then stop and return OK */
 		if (ret == 0)
-		    goto fail;
+		    break;
 	    }
+	    /* Merge children appended by the second pass into sorted place,
+	     * also on failure since x0 remains in the datastore tree */
+	    if (nappended && xml_sort_tail(x0, nappended) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
 	    if (changed){
-		if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
+		if (text_modify_add(x0p, x0, insert, keystr, nscx1, appended) < 0)
 		    goto done;
 	    }
 	    break;
@@ -625,6 +911,7 @@ text_modify(clicon_handle       h,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  move     If set, subtrees of x1 may be moved to x0 instead of copied
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval    -1        Error
  * @retval     0        Failed (cbret set)
@@ -640,6 +927,7 @@ text_modify_top(clicon_handle       h,
 		char               *username,
 		cxobj              *xnacm,
 		int                 permit,
+		int                 move,
 		cbuf               *cbret)
 {
     int        retval = -1;
@@ -738,7 +1026,7 @@ text_modify_top(clicon_handle       h,
 	    x0c = NULL;
 	}
 	if ((ret = text_modify(h, x0c, yc, x0, x1c, op,
-			       username, xnacm, permit, cbret)) < 0)
+			       username, xnacm, permit, move, NULL, cbret)) < 0)
 	    goto done;
 	/* If xml return - ie netconf error xml tree, then stop and return OK */
 	if (ret == 0)
@@ -790,37 +1078,26 @@ xml_container_presence(cxobj  *x,
     return retval;
 }
 
-/*! Modify database given an xml tree and an operation
- *
+/*! Modify database given an xml tree and an operation, see xmldb_put
  * @param[in]  h      CLICON handle
  * @param[in]  db     running or candidate
  * @param[in]  op     Top-level operation, can be superceded by other op in tree
  * @param[in]  xt     xml-tree. Top-level symbol is dummy
  * @param[in]  username User name for nacm
+ * @param[in]  move   If set, subtrees of xt may be moved into the datastore
  * @param[out] cbret  Initialized cligen buffer. On exit contains XML if retval == 0
  * @retval     1      OK
  * @retval     0      Failed, cbret contains error xml message
  * @retval     -1     Error
- * The xml may contain the "operation" attribute which defines the operation.
- * @code
- *   cxobj     *xt;
- *   cxobj     *xret = NULL;
- *   if (xml_parse_string("<a>17</a>", yspec, &xt) < 0)
- *     err;
- *   if ((ret = xmldb_put(h, "running", OP_MERGE, xt, username, cbret)) < 0)
- *     err;
- *   if (ret==0)
- *     cbret contains netconf error message
- * @endcode
- * @note if xret is non-null, it may contain error message
  */
-int
-xmldb_put(clicon_handle       h,
-	  const char         *db, 
-	  enum operation_type op,
-	  cxobj              *x1,
-	  char               *username,
-	  cbuf               *cbret)
+static int
+xmldb_put1(clicon_handle       h,
+	   const char         *db, 
+	   enum operation_type op,
+	   cxobj              *x1,
+	   char               *username,
+	   int                 move,
+	   cbuf               *cbret)
 {
     int                 retval = -1;
     char               *dbfile = NULL;
@@ -839,6 +1116,7 @@ xmldb_put(clicon_handle       h,
     char               *format;
     cvec               *nsc = NULL; /* nacm namespace context */
     int                 firsttime = 0;
+    char               *opstr = NULL;
 
     if (cbret == NULL){
 	clicon_err(OE_XML, EINVAL, "cbret is NULL");
@@ -897,7 +1175,7 @@ xmldb_put(clicon_handle       h,
      * Modify base tree x with modification x1. This is where the
      * new tree is made.
      */
-    if ((ret = text_modify_top(h, x0, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
+    if ((ret = text_modify_top(h, x0, x1, yspec, op, username, xnacm, permit, move, cbret)) < 0)
 	goto done;
     /* If xml return - ie netconf error xml tree, then stop and return OK */
     if (ret == 0){
@@ -932,6 +1210,8 @@ xmldb_put(clicon_handle       h,
 	if (de != NULL)
 	    de0 = *de;
 	if (de0.de_xml == NULL){
+	    if (xmldb_index(h, x0) < 0)
+		goto done;
 	    de0.de_xml = x0;
 	    clicon_db_elmnt_set(h, db, &de0);
 	}
@@ -975,6 +1255,15 @@ xmldb_put(clicon_handle       h,
      */
     if (xmodst && xml_purge(xmodst) < 0)
 	goto done;
+    /* Bump generation of modified top-level subtrees, or of whole datastore
+     * if replaced or deleted at top-level (see text_modify_top) */
+    if (x1 && attr_ns_value(x1, "operation", NETCONF_BASE_NAMESPACE,
+			    cbret, &opstr) == 1 && opstr != NULL)
+	if (xml_operation(opstr, &op) < 0)
+	    goto done;
+    if (xmldb_generation_bump(h, db, 
+			      (x1 == NULL || op == OP_REPLACE || op == OP_DELETE || op == OP_REMOVE)?NULL:x1) < 0)
+	goto done;
     retval = 1;
  done:
     if (f != NULL)
@@ -992,3 +1281,69 @@ xmldb_put(clicon_handle       h,
     retval = 0;
     goto done;
 }
+
+/*! Modify database given an xml tree and an operation
+ *
+ * @param[in]  h      CLICON handle
+ * @param[in]  db     running or candidate
+ * @param[in]  op     Top-level operation, can be superceded by other op in tree
+ * @param[in]  xt     xml-tree. Top-level symbol is dummy
+ * @param[in]  username User name for nacm
+ * @param[out] cbret  Initialized cligen buffer. On exit contains XML if retval == 0
+ * @retval     1      OK
+ * @retval     0      Failed, cbret contains error xml message
+ * @retval     -1     Error
+ * The xml may contain the "operation" attribute which defines the operation.
+ * @code
+ *   cxobj     *xt;
+ *   cxobj     *xret = NULL;
+ *   if (xml_parse_string("<a>17</a>", yspec, &xt) < 0)
+ *     err;
+ *   if ((ret = xmldb_put(h, "running", OP_MERGE, xt, username, cbret)) < 0)
+ *     err;
+ *   if (ret==0)
+ *     cbret contains netconf error message
+ * @endcode
+ * @note if xret is non-null, it may contain error message
+ * @see xmldb_put_move  if xt is not used after the call
+ */
+int
+xmldb_put(clicon_handle       h,
+	  const char         *db, 
+	  enum operation_type op,
+	  cxobj              *xt,
+	  char               *username,
+	  cbuf               *cbret)
+{
+    return xmldb_put1(h, db, op, xt, username, 0, cbret);
+}
+
+/*! Modify database given an xml tree and an operation, consuming the xml tree
+ *
+ * Same as xmldb_put but subtrees of xt that are added as new nodes to the
+ * datastore may be moved from xt instead of copied node by node. This makes 
+ * bulk loads, eg a replace or an edit of an empty datastore, cost about the
+ * same as parsing xt.
+ * @param[in]  h      CLICON handle
+ * @param[in]  db     running or candidate
+ * @param[in]  op     Top-level operation, can be superceded by other op in tree
+ * @param[in]  xt     xml-tree. Top-level symbol is dummy. 
+ * @param[in]  username User name for nacm
+ * @param[out] cbret  Initialized cligen buffer. On exit contains XML if retval == 0
+ * @retval     1      OK
+ * @retval     0      Failed, cbret contains error xml message
+ * @retval     -1     Error
+ * @note xt may be partly emptied and should only be freed after the call.
+ *       It must not be a datastore tree, eg from xmldb_get0 with cache.
+ * @see xmldb_put
+ */
+int
+xmldb_put_move(clicon_handle       h,
+	       const char         *db, 
+	       enum operation_type op,
+	       cxobj              *xt,
+	       char               *username,
+	       cbuf               *cbret)
+{
+    return xmldb_put1(h, db, op, xt, username, 1, cbret);
+}
@@ -66,7 +66,7 @@
 struct event_data{
     struct event_data *e_next;     /* next in list */
     int (*e_fn)(int, void*);            /* function */
-    enum {EVENT_FD, EVENT_TIME} e_type;        /* type of event */
+    enum {EVENT_FD, EVENT_FD_WRITE, EVENT_TIME} e_type; /* type of event */
     int e_fd;                      /* File descriptor */
     struct timeval e_time;         /* Timeout */
     void *e_arg;                   /* function argument */
@@ -150,23 +150,45 @@ event_reg_fd(int   fd,
     return 0;
 }
 
-/*! Deregister a file descriptor callback
- * @param[in]  s   File descriptor
- * @param[in]  fn  Function to call when input available on fd
- * Note: deregister when exactly function and socket match, not argument
- * @see event_reg_fd
- * @see event_unreg_timeout
+/*! Register a callback function to be called when a file descriptor is writable
+ *
+ * Typically used to drain an output queue of a non-blocking socket. The 
+ * callback is called as long as it is registered and fd is writable, so it 
+ * should be deregistered when there is nothing more to write.
+ * @param[in]  fd  File descriptor
+ * @param[in]  fn  Function to call when fd is writable
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @see event_unreg_fd_write
  */
 int
-event_unreg_fd(int   s, 
-	       int (*fn)(int, void*))
+event_reg_fd_write(int   fd, 
+		   int (*fn)(int, void*), 
+		   void *arg, 
+		   char *str)
+{
+    struct event_data *e;
+
+    if (event_reg_fd(fd, fn, arg, str) < 0)
+	return -1;
+    e = ee; /* Just added first in list */
+    e->e_type = EVENT_FD_WRITE;
+    return 0;
+}
+
+/*! Deregister a file descriptor callback of a given type
+ */
+static int
+event_unreg_fd_type(int   s, 
+		    int (*fn)(int, void*),
+		    int   type)
 {
     struct event_data *e, **e_prev;
     int found = 0;
 
     e_prev = &ee;
     for (e = ee; e; e = e->e_next){
-	if (fn == e->e_fn && s == e->e_fd) {
+	if (fn == e->e_fn && s == e->e_fd && type == e->e_type) {
 	    found++;
 	    *e_prev = e->e_next;
 	    _ee_unreg++;
@@ -178,6 +200,32 @@ event_unreg_fd(int   s,
     return found?0:-1;
 }
 
+/*! Deregister a file descriptor callback
+ * @param[in]  s   File descriptor
+ * @param[in]  fn  Function to call when input available on fd
+ * Note: deregister when exactly function and socket match, not argument
+ * @see event_reg_fd
+ * @see event_unreg_timeout
+ */
+int
+event_unreg_fd(int   s, 
+	       int (*fn)(int, void*))
+{
+    return event_unreg_fd_type(s, fn, EVENT_FD);
+}
+
+/*! Deregister a file descriptor write callback
+ * @param[in]  s   File descriptor
+ * @param[in]  fn  Function to call when fd is writable
+ * @see event_reg_fd_write
+ */
+int
+event_unreg_fd_write(int   s, 
+		     int (*fn)(int, void*))
+{
+    return event_unreg_fd_type(s, fn, EVENT_FD_WRITE);
+}
+
 /*! Call a callback function at an absolute time
  * @param[in]  t   Absolute (not relative!) timestamp when callback is called
  * @param[in]  fn  Function to call at time t
@@ -297,23 +345,27 @@ event_loop(void)
     struct timeval     t0;
     struct timeval     tnull = {0,};
     fd_set             fdset;
+    fd_set             wfdset;
     int                retval = -1;
 
     while (!clicon_exit_get()){
 	FD_ZERO(&fdset);
+	FD_ZERO(&wfdset);
 	for (e=ee; e; e=e->e_next)
 	    if (e->e_type == EVENT_FD)
 		FD_SET(e->e_fd, &fdset);
+	    else if (e->e_type == EVENT_FD_WRITE)
+		FD_SET(e->e_fd, &wfdset);
 	if (ee_timers != NULL){
 	    gettimeofday(&t0, NULL);
 	    timersub(&ee_timers->e_time, &t0, &t); 
 	    if (t.tv_sec < 0)
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull); 
+		n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &tnull); 
 	    else
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &t); 
+		n = select(FD_SETSIZE, &fdset, &wfdset, NULL, &t); 
 	}
 	else
-	    n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL); 
+	    n = select(FD_SETSIZE, &fdset, &wfdset, NULL, NULL); 
 	if (clicon_exit_get())
 	    break;
 	if (n == -1) {
@@ -341,7 +393,8 @@ event_loop(void)
 	    if (clicon_exit_get())
 		break;
 	    e_next = e->e_next;
-	    if(e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)){
+	    if ((e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)) ||
+		(e->e_type == EVENT_FD_WRITE && FD_ISSET(e->e_fd, &wfdset))){
 		clicon_debug(2, "%s: FD_ISSET: %s", __FUNCTION__, e->e_string);
 		if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
 		    clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
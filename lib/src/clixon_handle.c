@@ -152,11 +152,15 @@ clicon_handle_exit(clicon_handle h)
     int                   retval = -1;
     struct clicon_handle *ch = handle(h);
     clicon_hash_t        *ha;
+    struct clicon_msg    *msg;
 
     if ((ha = clicon_options(h)) != NULL)
 	clicon_hash_free(ha);
-    if ((ha = clicon_data(h)) != NULL)
+    if ((ha = clicon_data(h)) != NULL){
+	if ((msg = clicon_rcvbuf_get(h, NULL)) != NULL)
+	    free(msg);
 	clicon_hash_free(ha);
+    }
 
     if ((ha = clicon_db_elmnt(h)) != NULL)
 	clicon_hash_free(ha);
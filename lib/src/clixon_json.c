@@ -604,6 +604,53 @@ xml2json_encode(cxobj     *xb,
     return retval;
 }
 
+/*! Print RFC 6243 default tag of a leaf as RFC 7952 metadata annotation
+ *
+ * In report-all-tagged mode leafs with default values have a default attribute,
+ * see clicon_xml2cbuf_wdef. In JSON it is printed as a member "@<leaf>" after
+ * the leaf, eg: "mtu":1500,"@mtu":{"ietf-netconf-with-defaults:default":true}
+ * @param[out]   cb        Cligen text buffer
+ * @param[in]    x         XML leaf
+ * @param[in]    level     Indentation level
+ * @param[in]    pretty    Pretty-print output
+ * @param[in]    modname0  Module name of parent
+ */
+static int
+xml2json_default_tag(cbuf  *cb,
+		     cxobj *x,
+		     int    level,
+		     int    pretty,
+		     char  *modname0)
+{
+    cxobj     *xa = NULL;
+    char      *ns = NULL;
+    yang_stmt *ys;
+    char      *modname = NULL;
+
+    while ((xa = xml_child_each(x, xa, CX_ATTR)) != NULL){
+	if (strcmp(xml_name(xa), "default") != 0 || xml_prefix(xa) == NULL)
+	    continue;
+	if (xml2ns(x, xml_prefix(xa), &ns) < 0)
+	    return -1;
+	if (ns && strcmp(ns, NETCONF_DEFAULT_NAMESPACE) == 0)
+	    break;
+    }
+    if (xa == NULL ||
+	(strcmp(xml_value(xa), "true") != 0 && strcmp(xml_value(xa), "1") != 0))
+	return 0;
+    if ((ys = xml_spec(x)) != NULL){
+	modname = yang_argument_get(ys_real_module(ys));
+	if (modname0 && strcmp(modname, modname0) == 0)
+	    modname = NULL;
+    }
+    cprintf(cb, ",%s%*s\"@", pretty?"\n":"", pretty?(level*JSON_INDENT):0, "");
+    if (modname)
+	cprintf(cb, "%s:", modname);
+    cprintf(cb, "%s\":%s{\"ietf-netconf-with-defaults:default\":%strue}",
+	    xml_name(x), pretty?" ":"", pretty?" ":"");
+    return 0;
+}
+
 /*! Do the actual work of translating XML to JSON 
  * @param[out]   cb        Cligen text buffer containing json on exit
  * @param[in]    x         XML tree structure containing XML to translate
@@ -773,6 +820,9 @@ xml2json1_cbuf(cbuf                   *cb,
 			   xc_arraytype,
 			   level+1, pretty, 0, modname0) < 0)
 	    goto done;
+	if (xc_arraytype == NO_ARRAY &&
+	    xml2json_default_tag(cb, xc, level+1, pretty, modname0) < 0)
+	    goto done;
 	if (commas > 0) {
 	    cprintf(cb, ",%s", pretty?"\n":"");
 	    --commas;
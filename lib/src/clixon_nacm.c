@@ -61,6 +61,7 @@
 #include "clixon_yang.h"
 #include "clixon_xml.h"
 #include "clixon_options.h"
+#include "clixon_xml_map.h"
 #include "clixon_data.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_xpath_ctx.h"
@@ -942,6 +943,9 @@ nacm_access_pre(clicon_handle  h,
     if (xml_rootchild_node(xnacm0, xnacm) < 0)
 	goto done;
     xnacm0 = NULL;
+    /* Datastore trees are without default values, add them to the private copy */
+    if (xml_apply0(xnacm, CX_ELMNT, xml_default, h) < 0)
+	goto done;
     /* Initial NACM steps and common to all NACM access validation. */
     if ((retval = nacm_access(h, mode, xnacm, username)) < 0)
 	goto done;
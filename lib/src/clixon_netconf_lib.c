@@ -1296,6 +1296,9 @@ netconf_module_load(clicon_handle h)
     /* Load yang spec */
     if (yang_spec_parse_module(h, "ietf-netconf", NULL, yspec)< 0)
 	goto done;
+    /* RFC 6243 with-defaults parameter of get and get-config */
+    if (yang_spec_parse_module(h, "ietf-netconf-with-defaults", NULL, yspec)< 0)
+	goto done;
     if (yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
 	goto done;
     /* YANG module revision change management */
@@ -1395,6 +1398,29 @@ netconf_content_int2str(netconf_content nr)
     return clicon_int2str(netconf_content_map, nr);
 }
 
+/* See RFC 6243 Sec 3
+ * @see netconf_withdefaults_str2int
+ */
+static const map_str2int netconf_withdefaults_map[] = {
+    {"report-all", WITHDEFAULTS_REPORT_ALL},
+    {"trim",       WITHDEFAULTS_TRIM},
+    {"explicit",   WITHDEFAULTS_EXPLICIT},
+    {"report-all-tagged", WITHDEFAULTS_REPORT_ALL_TAGGED},
+    {NULL,        -1}
+};
+
+const enum withdefaults_type
+netconf_withdefaults_str2int(char *str)
+{
+    return clicon_str2int(netconf_withdefaults_map, str);
+}
+
+const char *
+netconf_withdefaults_int2str(enum withdefaults_type nr)
+{
+    return clicon_int2str(netconf_withdefaults_map, nr);
+}
+
 /*! Create Netconf server hello. Single cap and defer individual to querying modules
 
  * @param[in]  h           Clicon handle
@@ -1466,6 +1492,7 @@ netconf_hello_server(clicon_handle h,
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:startup:1.0</capability>");
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:xpath:1.0</capability>");
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:notification:1.0</capability>");
+    cprintf(cb, "<capability>urn:ietf:params:netconf:capability:with-defaults:1.0?basic-mode=report-all&amp;also-supported=trim,explicit,report-all-tagged</capability>");
     cprintf(cb, "</capabilities>");
     if (session_id) 
 	cprintf(cb, "<session-id>%lu</session-id>", (long unsigned int)session_id);
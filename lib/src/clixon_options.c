@@ -143,7 +143,8 @@ static const map_str2int yang_regexp_map[] = {
  * @param[in] dbglevel Debug level
  * @retval    0        OK
  * @retval   -1        Error
- * @note CLICON_FEATURE and CLICON_YANG_DIR are treated specially since they are lists
+ * @note CLICON_FEATURE, CLICON_YANG_DIR and CLICON_XMLDB_VALUE_INDEX are treated
+ *       specially since they are lists
  */
 int
 clicon_option_dump(clicon_handle h, 
@@ -171,7 +172,7 @@ clicon_option_dump(clicon_handle h,
 	else
 	    clicon_debug(dbglevel, "%s = NULL", keys[i]);
     }
-    /* Next print CLICON_FEATURE and CLICON_YANG_DIR from config tree
+    /* Next print CLICON_FEATURE, CLICON_YANG_DIR and CLICON_XMLDB_VALUE_INDEX from config tree
      * Since they are lists they are placed in the config tree.
      */
     x = NULL;
@@ -182,7 +183,8 @@ clicon_option_dump(clicon_handle h,
     }
     x = NULL;
     while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
-	if (strcmp(xml_name(x), "CLICON_FEATURE") != 0)
+	if (strcmp(xml_name(x), "CLICON_FEATURE") != 0 &&
+	    strcmp(xml_name(x), "CLICON_XMLDB_VALUE_INDEX") != 0)
 	    continue;
 	clicon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
     }
@@ -281,6 +283,8 @@ parse_configfile(clicon_handle  h,
 	    continue;
 	if (strcmp(name,"CLICON_YANG_DIR")==0)
 	    continue;
+	if (strcmp(name,"CLICON_XMLDB_VALUE_INDEX")==0)
+	    continue;
 	/* Used as an arg to this fn */
 	if (strcmp(name,"CLICON_CONFIGFILE")==0)
 	    continue;
@@ -327,7 +331,8 @@ clicon_option_add(clicon_handle h,
     cxobj         *x;
 
     if (strcmp(name, "CLICON_FEATURE")==0 ||
-	strcmp(name, "CLICON_YANG_DIR")==0){
+	strcmp(name, "CLICON_YANG_DIR")==0 ||
+	strcmp(name, "CLICON_XMLDB_VALUE_INDEX")==0){
 	if ((x = clicon_conf_xml(h)) == NULL)
 	    goto done;
 	if (xml_parse_va(&x, NULL, "<%s>%s</%s>",
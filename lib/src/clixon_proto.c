@@ -53,6 +53,8 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <sys/stat.h>
 #include <netinet/in.h>
 #include <sys/un.h>
@@ -71,6 +73,7 @@
 #include "clixon_sig.h"
 #include "clixon_xml.h"
 #include "clixon_options.h"
+#include "clixon_data.h"
 #include "clixon_proto.h"
 
 static int _atomicio_sig = 0;
@@ -271,6 +274,51 @@ atomicio(ssize_t (*fn) (int, void *, size_t),
     return (pos);
 }
 
+/*! Ensure all of an io-vector is written, see atomicio
+ * @param[in]  fd      File descriptor, eg socket
+ * @param[in]  iov     IO-vector, modified by the call
+ * @param[in]  iovcnt  Number of elements in iov
+ * @retval     n       Number of bytes written
+ * @retval    -1       Error, errno set
+ */
+static ssize_t
+atomicio_writev(int           fd, 
+		struct iovec *iov,
+		int           iovcnt)
+{
+    ssize_t       res, pos = 0;
+    struct pollfd pfd;
+
+    while (iovcnt > 0){
+	if ((res = writev(fd, iov, iovcnt)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK){
+		/* Non-blocking socket is full: wait until it is writable */
+		pfd.fd = fd;
+		pfd.events = POLLOUT;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+		    return -1;
+		continue;
+	    }
+	    return -1;
+	}
+	pos += res;
+	/* Skip what was written */
+	while (iovcnt > 0 && res >= iov->iov_len){
+	    res -= iov->iov_len;
+	    iov++;
+	    iovcnt--;
+	}
+	if (iovcnt > 0){
+	    iov->iov_base = (char*)iov->iov_base + res;
+	    iov->iov_len -= res;
+	}
+    }
+    return pos;
+}
+
 /*! Print message on debug. Log if syslog, stderr if not
  * @param[in]  msg    CLICON msg
  */
@@ -344,6 +392,31 @@ int
 clicon_msg_rcv(int                s,
 	       struct clicon_msg **msg,
 	       int                *eof)
+{ 
+    size_t buflen = 0;
+
+    *msg = NULL;
+    return clicon_msg_rcv_buf(s, msg, &buflen, eof);
+}
+
+/*! Receive a CLICON message into a reusable buffer
+ *
+ * The buffer is only reallocated if the message does not fit. One null
+ * character is added after the message, so that a body ending with a null
+ * character can be parsed in place, see xml_parse_buffer.
+ * @param[in]     s      socket (unix or inet) to communicate with backend
+ * @param[in,out] msg    Buffer, or NULL. Free with free()
+ * @param[in,out] buflen Allocated length of buffer
+ * @param[out]    eof    Set if eof encountered
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @see clicon_msg_rcv
+ */
+int
+clicon_msg_rcv_buf(int                s,
+		   struct clicon_msg **msg,
+		   size_t             *buflen,
+		   int                *eof)
 { 
     int       retval = -1;
     struct clicon_msg hdr;
@@ -351,6 +424,7 @@ clicon_msg_rcv(int                s,
     uint32_t  len2;
     sigfn_t   oldhandler;
     uint32_t  mlen;
+    void     *p;
 
     *eof = 0;
     if (0)
@@ -372,19 +446,30 @@ clicon_msg_rcv(int                s,
     mlen = ntohl(hdr.op_len);
     clicon_debug(2, "%s: rcv msg len=%d",  
 		 __FUNCTION__, mlen);
-    if ((*msg = (struct clicon_msg *)malloc(mlen)) == NULL){
-	clicon_err(OE_CFG, errno, "malloc");
+    if (mlen < sizeof(hdr)){
+	clicon_err(OE_CFG, EINVAL, "message length too short (%u)", mlen);
 	goto done;
     }
-    memcpy(*msg, &hdr, hlen);
-    if ((len2 = atomicio(read, s, (*msg)->op_body, mlen - sizeof(hdr))) == 0){ 
- 	clicon_err(OE_CFG, errno, "read");
-	goto done;
+    if (*msg == NULL || *buflen < mlen + 1){
+	if ((p = realloc(*msg, mlen + 1)) == NULL){
+	    clicon_err(OE_CFG, errno, "realloc");
+	    goto done;
+	}
+	*msg = (struct clicon_msg *)p;
+	*buflen = mlen + 1;
     }
-    if (len2 != mlen - sizeof(hdr)){
-	clicon_err(OE_CFG, errno, "body too short");
-	goto done;
+    memcpy(*msg, &hdr, hlen);
+    if (mlen > sizeof(hdr)){
+	if ((len2 = atomicio(read, s, (*msg)->op_body, mlen - sizeof(hdr))) == 0){ 
+	    clicon_err(OE_CFG, errno, "read");
+	    goto done;
+	}
+	if (len2 != mlen - sizeof(hdr)){
+	    clicon_err(OE_CFG, errno, "body too short");
+	    goto done;
+	}
     }
+    ((char*)*msg)[mlen] = '\0';
     if (debug > 1)
 	msg_dump(*msg);
     retval = 0;
@@ -394,23 +479,67 @@ clicon_msg_rcv(int                s,
     return retval;
 }
 
+/*! Send a clicon_msg message and receive reply into the reusable buffer of handle
+ *
+ * @param[in]  h       Clicon handle
+ * @param[in]  s       Socket to communicate with backend
+ * @param[in]  msg     CLICON msg data structure. It has fixed header and variable body.
+ * @param[out] reply   Reply in receive buffer of h, valid until next rpc. Do not free
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see clicon_rpc
+ */
+static int
+clicon_rpc_buf(clicon_handle       h,
+	       int                 s, 
+	       struct clicon_msg  *msg, 
+	       struct clicon_msg **reply)
+{
+    int                retval = -1;
+    struct clicon_msg *buf;
+    size_t             buflen;
+    int                eof;
+    int                ret;
+
+    if (clicon_msg_send(s, msg) < 0)
+	goto done;
+    buf = clicon_rcvbuf_get(h, &buflen);
+    ret = clicon_msg_rcv_buf(s, &buf, &buflen, &eof);
+    /* Buffer may be reallocated also on error */
+    if (clicon_rcvbuf_set(h, buf, buflen) < 0)
+	goto done;
+    if (ret < 0)
+	goto done;
+    if (eof){
+	clicon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
+	close(s);
+	errno = ESHUTDOWN;
+	goto done;
+    }
+    *reply = buf;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Connect to server, send a clicon_msg message and wait for result using unix socket
  *
  * @param[in]  h       Clicon handle
  * @param[in]  msg     CLICON msg data structure. It has fixed header and variable body.
  * @param[in]  sockpath Unix domain file path
- * @param[out] retdata  Returned data as string netconf xml tree.
+ * @param[out] reply   Reply in reusable receive buffer of h, valid until next rpc.
+ *                     Do not free.
  * @param[out] sock0   Return socket in case of asynchronous notify
  * @retval     0       OK
  * @retval     -1      Error
  * @see clicon_rpc  But this is one-shot rpc: open, send, get reply and close.
  */
 int
-clicon_rpc_connect_unix(clicon_handle      h,
-			struct clicon_msg *msg, 
-			char              *sockpath,
-			char             **retdata,
-			int               *sock0)
+clicon_rpc_connect_unix(clicon_handle       h,
+			struct clicon_msg  *msg, 
+			char               *sockpath,
+			struct clicon_msg **reply,
+			int                *sock0)
 {
     int retval = -1;
     int s = -1;
@@ -428,7 +557,7 @@ clicon_rpc_connect_unix(clicon_handle      h,
     }
     if ((s = clicon_connect_unix(h, sockpath)) < 0)
 	goto done;
-    if (clicon_rpc(s, msg, retdata) < 0)
+    if (clicon_rpc_buf(h, s, msg, reply) < 0)
 	goto done;
     if (sock0 != NULL)
 	*sock0 = s;
@@ -445,19 +574,20 @@ clicon_rpc_connect_unix(clicon_handle      h,
  * @param[in]  msg     CLICON msg data structure. It has fixed header and variable body.
  * @param[in]  dst     IPv4 address
  * @param[in]  port    TCP port
- * @param[out] retdata  Returned data as string netconf xml tree.
+ * @param[out] reply   Reply in reusable receive buffer of h, valid until next rpc.
+ *                     Do not free.
  * @param[out] sock0   Return socket in case of asynchronous notify
  * @retval     0       OK
  * @retval     -1      Error
  * @see clicon_rpc  But this is one-shot rpc: open, send, get reply and close.
  */
 int
-clicon_rpc_connect_inet(clicon_handle      h,
-			struct clicon_msg *msg, 
-			char              *dst,
-			uint16_t           port,
-			char             **retdata,
-			int               *sock0)
+clicon_rpc_connect_inet(clicon_handle       h,
+			struct clicon_msg  *msg, 
+			char               *dst,
+			uint16_t            port,
+			struct clicon_msg **reply,
+			int                *sock0)
 {
     int                retval = -1;
     int                s = -1;
@@ -481,7 +611,7 @@ clicon_rpc_connect_inet(clicon_handle      h,
 	close(s);
 	goto done;
     }
-    if (clicon_rpc(s, msg, retdata) < 0)
+    if (clicon_rpc_buf(h, s, msg, reply) < 0)
 	goto done;
     if (sock0 != NULL)
 	*sock0 = s;
@@ -543,6 +673,7 @@ clicon_rpc(int                   s,
 
 /*! Send a clicon_msg message as reply to a clicon rpc request
  *
+ * Header and data are written with one writev, data is not copied.
  * @param[in]  s       Socket to communicate with client
  * @param[in]  data    Returned data as byte-string.
  * @param[in]  datalen Length of returned data XXX  may be unecessary if always string?
@@ -554,23 +685,24 @@ send_msg_reply(int      s,
 	       char    *data, 
 	       uint32_t datalen)
 {
-    int                retval = -1;
-    struct clicon_msg *reply = NULL;
-    uint32_t           len;
-
-    len = sizeof(*reply) + datalen;
-    if ((reply = (struct clicon_msg *)malloc(len)) == NULL)
-	goto done;
-    memset(reply, 0, len);
-    reply->op_len = htonl(len);
-    if (datalen > 0)
-      memcpy(reply->op_body, data, datalen);
-    if (clicon_msg_send(s, reply) < 0)
+    int               retval = -1;
+    struct clicon_msg hdr;
+    struct iovec      iov[2];
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.op_len = htonl(sizeof(hdr) + datalen);
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = data;
+    iov[1].iov_len = datalen;
+    clicon_debug(2, "%s: send msg len=%d", 
+		 __FUNCTION__, ntohl(hdr.op_len));
+    if (atomicio_writev(s, iov, datalen>0?2:1) < 0){
+	clicon_err(OE_CFG, errno, "writev");
 	goto done;
+    }
     retval = 0;
   done:
-    if (reply)
-	free(reply);
     return retval;
 }
 
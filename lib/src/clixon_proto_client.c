@@ -51,6 +51,7 @@
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/syslog.h>
+#include <arpa/inet.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -93,9 +94,10 @@ clicon_rpc_msg(clicon_handle      h,
     int                retval = -1;
     char              *sock;
     int                port;
-    char              *retdata = NULL;
+    struct clicon_msg *reply = NULL;
     cxobj             *xret = NULL;
     yang_stmt         *yspec;
+    size_t             len;
 
 #ifdef RPC_USERNAME_ASSERT
     assert(strstr(msg->op_body, "username")!=NULL); /* XXX */
@@ -108,7 +110,7 @@ clicon_rpc_msg(clicon_handle      h,
     /* What to do if inet socket? */
     switch (clicon_sock_family(h)){
     case AF_UNIX:
-	if (clicon_rpc_connect_unix(h, msg, sock, &retdata, sock0) < 0){
+	if (clicon_rpc_connect_unix(h, msg, sock, &reply, sock0) < 0){
 #if 0
 	    if (errno == ESHUTDOWN)
 		/* Maybe could reconnect on a higher layer, but lets fail
@@ -127,15 +129,23 @@ clicon_rpc_msg(clicon_handle      h,
 	    clicon_err(OE_FATAL, 0, "CLICON_SOCK_PORT not set");
 	    goto done;
 	}
-	if (clicon_rpc_connect_inet(h, msg, sock, port, &retdata, sock0) < 0)
+	if (clicon_rpc_connect_inet(h, msg, sock, port, &reply, sock0) < 0)
 	    goto done;
 	break;
     }
-    clicon_debug(1, "%s retdata:%s", __FUNCTION__, retdata);
-
-    if (retdata){
+    if (reply && (len = ntohl(reply->op_len) - sizeof(*reply)) > 0){
+	clicon_debug(1, "%s retdata:%s", __FUNCTION__, reply->op_body);
  	yspec = clicon_dbspec_yang(h);
-	if (xml_parse_string(retdata, yspec, &xret) < 0)
+	/* Reply is parsed into an arena, freed with xml_free of the reply */
+	if ((xret = xml_new_arena("top", NULL)) == NULL)
+	    goto done;
+	/* Parse in place in receive buffer if body is a null-terminated string,
+	 * clicon_msg_rcv_buf adds a second null character */
+	if (reply->op_body[len-1] == '\0'){
+	    if (xml_parse_buffer(reply->op_body, len+1, yspec, &xret) < 0)
+		goto done;
+	}
+	else if (xml_parse_string(reply->op_body, yspec, &xret) < 0)
 	    goto done;
     }
     if (xret0){
@@ -144,8 +154,6 @@ clicon_rpc_msg(clicon_handle      h,
     }
     retval = 0;
  done:
-    if (retdata)
-	free(retdata);
     if (xret)
 	xml_free(xret);
     return retval;
@@ -572,46 +580,19 @@ clicon_rpc_unlock(clicon_handle h,
     return retval;
 }
 
-/*! Get database configuration and state data
- * @param[in]  h         Clicon handle
- * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
- * @param[in]  namespace Namespace associated w xpath
- * @param[in]  nsc       Namespace context for filter
- * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
- * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
- * @param[out] xt        XML tree. Free with xml_free. 
- *                       Either <config> or <rpc-error>. 
- * @retval    0          OK
- * @retval   -1          Error, fatal or xml
- * @note if xpath is set but namespace is NULL, the default, netconf base 
- *       namespace will be used which is most probably wrong.
- * @code
- *  cxobj *xt = NULL;
- *  cvec *nsc = NULL;
- *
- *  if ((nsc = xml_nsctx_init(NULL, "urn:example:hello")) == NULL)
- *     err;
- *  if (clicon_rpc_get(h, "/hello/world", nsc, CONTENT_ALL, -1, &xt) < 0)
- *     err;
- *  if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
- *     clicon_rpc_generate_error(xerr, "clicon_rpc_get", NULL);
- *     err;
- *  }
- *  if (xt)
- *     xml_free(xt);
- *  if (nsc)
- *     xml_nsctx_free(nsc);
- * @endcode
- * @see clicon_rpc_get_config which is almost the same as with content=config, but you can also select dbname
- * @see clicon_rpc_generate_error
+/*! Send get request to backend, see clicon_rpc_get
+ * @param[in]  generation  Clixon extension: generation of subtree in reply, or NULL
+ * @see clicon_rpc_get
  */
-int
-clicon_rpc_get(clicon_handle   h, 
-	       char           *xpath,
-	       cvec           *nsc, /* namespace context for filter */
-	       netconf_content content,
-	       int32_t         depth,
-	       cxobj         **xt)
+static int
+clicon_rpc_get1(clicon_handle   h, 
+		char           *xpath,
+		cvec           *nsc,
+		netconf_content content,
+		int32_t         depth,
+		enum withdefaults_type wdef,
+		char           *generation,
+		cxobj         **xt)
 {
     int                retval = -1;
     struct clicon_msg *msg = NULL;
@@ -636,6 +617,9 @@ clicon_rpc_get(clicon_handle   h,
     /* Clixon extension, depth=<level> */
     if (depth != -1)
 	cprintf(cb, " depth=\"%d\"", depth);
+    /* Clixon extension, generation=<module>:<name> or / */
+    if (generation)
+	cprintf(cb, " generation=\"%s\"", generation);
     cprintf(cb, ">");
     if (xpath && strlen(xpath)) {
 	cprintf(cb, "<%s:filter %s:type=\"xpath\" %s:select=\"%s\"",
@@ -650,6 +634,10 @@ clicon_rpc_get(clicon_handle   h,
 	}
 	cprintf(cb, "/>");
     }
+    /* RFC 6243 with-defaults, report-all is default */
+    if (wdef != WITHDEFAULTS_REPORT_ALL)
+	cprintf(cb, "<with-defaults xmlns=\"%s\">%s</with-defaults>",
+		NETCONF_WITHDEFAULTS_NAMESPACE, netconf_withdefaults_int2str(wdef));
     cprintf(cb, "</get></rpc>");
     if ((msg = clicon_msg_encode(clicon_session_id_get(h),
 				 "%s", cbuf_get(cb))) == NULL)
@@ -679,6 +667,121 @@ clicon_rpc_get(clicon_handle   h,
 }
 
 
+/*! Get database configuration and state data
+ * @param[in]  h         Clicon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  namespace Namespace associated w xpath
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  wdef      RFC 6243 with-defaults mode
+ * @param[out] xt        XML tree. Free with xml_free. 
+ *                       Either <config> or <rpc-error>. 
+ * @retval    0          OK
+ * @retval   -1          Error, fatal or xml
+ * @note if xpath is set but namespace is NULL, the default, netconf base 
+ *       namespace will be used which is most probably wrong.
+ * @code
+ *  cxobj *xt = NULL;
+ *  cvec *nsc = NULL;
+ *
+ *  if ((nsc = xml_nsctx_init(NULL, "urn:example:hello")) == NULL)
+ *     err;
+ *  if (clicon_rpc_get(h, "/hello/world", nsc, CONTENT_ALL, -1, WITHDEFAULTS_REPORT_ALL, &xt) < 0)
+ *     err;
+ *  if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+ *     clicon_rpc_generate_error(xerr, "clicon_rpc_get", NULL);
+ *     err;
+ *  }
+ *  if (xt)
+ *     xml_free(xt);
+ *  if (nsc)
+ *     xml_nsctx_free(nsc);
+ * @endcode
+ * @see clicon_rpc_get_config which is almost the same as with content=config, but you can also select dbname
+ * @see clicon_rpc_generate_error
+ */
+int
+clicon_rpc_get(clicon_handle   h, 
+	       char           *xpath,
+	       cvec           *nsc, /* namespace context for filter */
+	       netconf_content content,
+	       int32_t         depth,
+	       enum withdefaults_type wdef,
+	       cxobj         **xt)
+{
+    return clicon_rpc_get1(h, xpath, nsc, content, depth, wdef, NULL, xt);
+}
+
+/*! Get running configuration and the generation of a top-level subtree in one request
+ * As clicon_rpc_get but the backend also returns the generation of the subtree
+ * and of the NACM rules, so that no separate generation request is necessary.
+ * The NACM generation is the modification time of the NACM file if NACM is external.
+ * @param[in]  h        CLICON handle
+ * @param[in]  xpath    XPath (or "")
+ * @param[in]  nsc      Namespace context for filter
+ * @param[in]  content  Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth    Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  wdef     RFC 6243 with-defaults mode
+ * @param[in]  subtree  Top-level subtree as <module>:<name>, or NULL for whole datastore
+ * @param[out] xt       XML tree. Free with xml_free. Either <data> or <rpc-error>. 
+ * @param[out] gen      Generation of subtree, 0 on error
+ * @param[out] ngen     Generation of NACM rules, 0 if NACM is disabled
+ * @param[out] modified Time of last modification of subtree or NACM rules
+ * @retval     0        OK
+ * @retval    -1        Error, fatal or xml
+ * @see clicon_rpc_generation  Only the generation
+ */
+int
+clicon_rpc_get_generation(clicon_handle   h, 
+			  char           *xpath,
+			  cvec           *nsc,
+			  netconf_content content,
+			  int32_t         depth,
+			  enum withdefaults_type wdef,
+			  char           *subtree,
+			  cxobj         **xt,
+			  uint64_t       *gen,
+			  uint64_t       *ngen,
+			  time_t         *modified)
+{
+    int    retval = -1;
+    cxobj *xa;
+    char  *str;
+
+    *gen = 0;
+    *ngen = 0;
+    *modified = 0;
+    if (clicon_rpc_get1(h, xpath, nsc, content, depth, wdef,
+			subtree?subtree:"/", xt) < 0)
+	goto done;
+    if (*xt == NULL || strcmp(xml_name(*xt), "data") != 0)
+	goto ok;
+    /* Remove the attributes from the data, they are not part of the config */
+    if ((xa = xml_find_type(*xt, NULL, "generation", CX_ATTR)) != NULL){
+	if ((str = xml_value(xa)) != NULL)
+	    *gen = strtoull(str, NULL, 10);
+	if (xml_purge(xa) < 0)
+	    goto done;
+    }
+    if ((xa = xml_find_type(*xt, NULL, "nacm-generation", CX_ATTR)) != NULL){
+	if ((str = xml_value(xa)) != NULL)
+	    *ngen = strtoull(str, NULL, 10);
+	if (xml_purge(xa) < 0)
+	    goto done;
+    }
+    if ((xa = xml_find_type(*xt, NULL, "modified", CX_ATTR)) != NULL){
+	if ((str = xml_value(xa)) != NULL)
+	    *modified = strtol(str, NULL, 10);
+	if (xml_purge(xa) < 0)
+	    goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Close a (user) session
  * @param[in] h        CLICON handle
  * @retval    0        OK
@@ -935,6 +1038,79 @@ clicon_rpc_debug(clicon_handle h,
     return retval;
 }
 
+/*! Get generation of a datastore, or of a top-level subtree of a datastore
+ * @param[in]  h        CLICON handle
+ * @param[in]  db       Name of database, eg "running"
+ * @param[in]  subtree  Top-level subtree as <module>:<name>, or NULL for whole datastore
+ * @param[out] gen      Generation, changes whenever the (sub)tree is modified
+ * @param[out] ngen     Generation of NACM rules, 0 if NACM is disabled (if not NULL)
+ * @param[out] modified Time of last modification of (sub)tree or NACM rules, 
+ *                      seconds since the Epoch (if not NULL)
+ * @retval     0        OK
+ * @retval    -1        Error and logged to syslog
+ * @see xmldb_generation  Backend implementation
+ * @see clicon_rpc_get_generation  Generation returned with the data
+ */
+int
+clicon_rpc_generation(clicon_handle h,
+		      char         *db,
+		      char         *subtree,
+		      uint64_t     *gen,
+		      uint64_t     *ngen,
+		      time_t       *modified)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xerr;
+    cxobj             *x;
+    char              *username;
+    char              *str;
+
+    username = clicon_username_get(h);
+    if ((msg = clicon_msg_encode(clicon_session_id_get(h),
+				 "<rpc username=\"%s\"><generation xmlns=\"http://clicon.org/lib\"><datastore>%s</datastore>%s%s%s</generation></rpc>",
+				 username?username:"",
+				 db,
+				 subtree?"<subtree>":"",
+				 subtree?subtree:"",
+				 subtree?"</subtree>":"")) == NULL)
+	goto done;
+    if (clicon_rpc_msg(h, msg, &xret, NULL) < 0)
+	goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	clicon_rpc_generate_error(xerr, "Generation", NULL);
+	goto done;
+    }
+    if ((x = xpath_first(xret, NULL, "//rpc-reply/generation")) == NULL ||
+	(str = xml_body(x)) == NULL){
+	clicon_err(OE_XML, 0, "rpc error"); /* XXX extract info from rpc-error */
+	goto done;
+    }
+    *gen = strtoull(str, NULL, 10);
+    if (ngen){
+	if ((x = xpath_first(xret, NULL, "//rpc-reply/nacm-generation")) != NULL &&
+	    (str = xml_body(x)) != NULL)
+	    *ngen = strtoull(str, NULL, 10);
+	else
+	    *ngen = 0;
+    }
+    if (modified){
+	if ((x = xpath_first(xret, NULL, "//rpc-reply/modified")) != NULL &&
+	    (str = xml_body(x)) != NULL)
+	    *modified = strtol(str, NULL, 10);
+	else
+	    *modified = 0;
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
 /*! Send a debug request to backend server
  * @param[in] h        CLICON handle
  * @param[in] level    Debug level
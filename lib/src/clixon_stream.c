@@ -36,6 +36,9 @@
  * 1) Base stream handling: stream_find/register/delete_all/get_xml
  * 2) Stream subscription handling (stream_ss_add/delete/timeout, stream_notify, etc
  * 3) Stream replay: stream_replay/_add
+ * Subscriptions with the same filter share a parsed filter (stream_filter), which
+ * is evaluated once per event. Notifications are serialized once per event and
+ * shared by reference count (stream_msg).
  * 4) nginx/nchan publish code (use --enable-publish config option)
  *
  *
@@ -58,11 +61,19 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
 #include <string.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <syslog.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -73,6 +84,7 @@
 #include "clixon_log.h"
 #include "clixon_event.h"
 #include "clixon_string.h"
+#include "clixon_file.h"
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
@@ -81,11 +93,341 @@
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_proto.h"
 #include "clixon_stream.h"
 
 /* Go through and timeout subscription timers [s] */
 #define STREAM_TIMER_TIMEOUT_S 5
 
+/* Size of a replay log segment */
+#define STREAM_SEGMENT_SIZE (256*1024)
+
+/* Max nr of events in replay time index of a stream, oldest are overwritten */
+#define STREAM_REPLAY_MAX (256*1024)
+
+/* Max total size of replay log segments of a stream, oldest are dropped.
+ * These limits apply also if retention is 0 (unlimited) */
+#define STREAM_REPLAY_SIZE_MAX (64*1024*1024)
+
+/* Suffix of replay log segment files, see CLICON_STREAM_REPLAY_DIR */
+#define STREAM_SEGMENT_SUFFIX "replay"
+
+/* Event in a replay log segment. A zero length marks the end of a segment. */
+struct stream_record{
+    uint64_t rec_sec;   /* Timestamp seconds */
+    uint32_t rec_usec;  /* Timestamp microseconds */
+    uint32_t rec_len;   /* Length of XML string including null character */
+    char     rec_xml[0];
+};
+/* Size of a record with XML of length len, padded to 8 bytes */
+#define STREAM_RECORD_SIZE(len) ((sizeof(struct stream_record)+(len)+7) & ~((size_t)7))
+
+/* Event being notified by stream_notify1 and its serialized message, if any */
+static cxobj             *_stream_xev = NULL;
+static struct stream_msg *_stream_msg = NULL;
+
+/*! Get i:th oldest entry of replay time index of a stream */
+static struct stream_replay *
+stream_replay_ith(event_stream_t *es,
+		  size_t          i)
+{
+    return &es->es_replay[(es->es_replay_head + i) % es->es_replay_max];
+}
+
+/*! Binary search in replay time index for first entry not older than tv
+ * @param[in]  es   Event stream
+ * @param[in]  tv   Timestamp
+ * @retval     i    Index of first entry with timestamp >= tv, or es_replay_nr
+ */
+static size_t
+stream_replay_seek(event_stream_t *es,
+		   struct timeval *tv)
+{
+    size_t lo = 0;
+    size_t hi = es->es_replay_nr;
+    size_t mid;
+
+    while (lo < hi){
+	mid = (lo + hi)/2;
+	if (timercmp(&stream_replay_ith(es, mid)->r_tv, tv, <))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+/*! Append entry to replay time index, grow ring buffer if full
+ * The ring buffer grows to at most STREAM_REPLAY_MAX entries, thereafter the
+ * oldest entry is overwritten.
+ * @param[in]  es   Event stream
+ * @param[in]  tv   Timestamp of event
+ * @param[in]  xml  Serialized event in segment
+ * @param[in]  sg   Segment
+ */
+static int
+stream_replay_push(event_stream_t        *es,
+		   struct timeval        *tv,
+		   char                  *xml,
+		   struct stream_segment *sg)
+{
+    struct stream_replay *vec;
+    struct stream_replay *r;
+    size_t                max;
+    size_t                i;
+
+    if (es->es_replay_nr == STREAM_REPLAY_MAX){
+	es->es_replay_head = (es->es_replay_head + 1) % es->es_replay_max;
+	es->es_replay_nr--;
+    }
+    else if (es->es_replay_nr == es->es_replay_max){
+	max = es->es_replay_max ? 2*es->es_replay_max : 64;
+	if (max > STREAM_REPLAY_MAX)
+	    max = STREAM_REPLAY_MAX;
+	if ((vec = malloc(max*sizeof(*vec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    return -1;
+	}
+	for (i=0; i<es->es_replay_nr; i++)
+	    vec[i] = *stream_replay_ith(es, i);
+	if (es->es_replay)
+	    free(es->es_replay);
+	es->es_replay = vec;
+	es->es_replay_head = 0;
+	es->es_replay_max = max;
+    }
+    r = stream_replay_ith(es, es->es_replay_nr);
+    r->r_tv = *tv;
+    r->r_xml = xml;
+    r->r_seg = sg;
+    es->es_replay_nr++;
+    return 0;
+}
+
+/*! Create a new replay log segment last in stream, in memory or as file
+ * @param[in]  es    Event stream
+ * @param[in]  size  Size of segment
+ * @param[out] sgp   New segment
+ */
+static int
+stream_segment_new(event_stream_t         *es,
+		   size_t                  size,
+		   struct stream_segment **sgp)
+{
+    int                    retval = -1;
+    struct stream_segment *sg = NULL;
+    cbuf                  *cb = NULL;
+
+    if ((sg = malloc(sizeof(*sg))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(sg, 0, sizeof(*sg));
+    sg->sg_fd = -1;
+    sg->sg_size = size;
+    if (es->es_replay_dir){
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	cprintf(cb, "%s/%s-%010d.%s", es->es_replay_dir, es->es_name,
+		++es->es_segment_nr, STREAM_SEGMENT_SUFFIX);
+	if ((sg->sg_file = strdup(cbuf_get(cb))) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	if ((sg->sg_fd = open(sg->sg_file, O_RDWR|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR)) < 0){
+	    clicon_err(OE_UNIX, errno, "open(%s)", sg->sg_file);
+	    goto done;
+	}
+	if (ftruncate(sg->sg_fd, size) < 0){
+	    clicon_err(OE_UNIX, errno, "ftruncate(%s)", sg->sg_file);
+	    goto done;
+	}
+	if ((sg->sg_buf = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED,
+			       sg->sg_fd, 0)) == MAP_FAILED){
+	    sg->sg_buf = NULL;
+	    clicon_err(OE_UNIX, errno, "mmap(%s)", sg->sg_file);
+	    goto done;
+	}
+    }
+    else{
+	if ((sg->sg_buf = calloc(1, size)) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+    }
+    ADDQ(sg, es->es_segments);
+    es->es_segment_size += sg->sg_size;
+    *sgp = sg;
+    sg = NULL;
+    retval = 0;
+ done:
+    if (sg){
+	if (sg->sg_fd != -1){
+	    close(sg->sg_fd);
+	    unlink(sg->sg_file);
+	}
+	if (sg->sg_file)
+	    free(sg->sg_file);
+	free(sg);
+    }
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Remove oldest replay log segment of stream and its entries in the time index
+ * @param[in]  es     Event stream
+ * @param[in]  unlnk  If set, remove segment file (if any)
+ */
+static int
+stream_segment_drop(event_stream_t *es,
+		    int             unlnk)
+{
+    struct stream_segment *sg;
+
+    if ((sg = es->es_segments) == NULL)
+	return 0;
+    while (es->es_replay_nr && stream_replay_ith(es, 0)->r_seg == sg){
+	es->es_replay_head = (es->es_replay_head + 1) % es->es_replay_max;
+	es->es_replay_nr--;
+    }
+    DELQ(sg, es->es_segments, struct stream_segment *);
+    es->es_segment_size -= sg->sg_size;
+    if (sg->sg_fd != -1){
+	if (sg->sg_buf)
+	    munmap(sg->sg_buf, sg->sg_size);
+	close(sg->sg_fd);
+	if (unlnk)
+	    unlink(sg->sg_file);
+    }
+    else if (sg->sg_buf)
+	free(sg->sg_buf);
+    if (sg->sg_file)
+	free(sg->sg_file);
+    free(sg);
+    return 0;
+}
+
+/*! Load replay log segment files of a stream, eg after restart
+ * Segment files are named <stream>-<nr>.replay in es_replay_dir. Events are 
+ * read until the first incomplete record, and appended to the last segment.
+ * @param[in]  es    Event stream
+ */
+static int
+stream_segment_load(event_stream_t *es)
+{
+    int                    retval = -1;
+    struct dirent         *dp = NULL;
+    int                    ndp;
+    int                    i;
+    size_t                 plen;
+    cbuf                  *cb = NULL;
+    struct stream_segment *sg = NULL;
+    struct stream_record  *rec;
+    struct stat            st;
+    struct timeval         tv;
+    long                   nr;
+    char                  *end;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((ndp = clicon_file_dirent(es->es_replay_dir, &dp, 
+				  "\\." STREAM_SEGMENT_SUFFIX "$", S_IFREG)) < 0)
+	goto done;
+    plen = strlen(es->es_name);
+    for (i = 0; i < ndp; i++){ /* Sorted on name, ie sequence nr */
+	/* Exactly <stream>-<nr>.replay, not eg segments of stream <stream>-1 */
+	if (strncmp(dp[i].d_name, es->es_name, plen) != 0 ||
+	    dp[i].d_name[plen] != '-' ||
+	    !isdigit(dp[i].d_name[plen+1]))
+	    continue;
+	errno = 0;
+	nr = strtol(dp[i].d_name + plen + 1, &end, 10);
+	if (errno != 0 || nr > INT_MAX ||
+	    strcmp(end, "." STREAM_SEGMENT_SUFFIX) != 0)
+	    continue;
+	cbuf_reset(cb);
+	cprintf(cb, "%s/%s", es->es_replay_dir, dp[i].d_name);
+	if ((sg = malloc(sizeof(*sg))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memset(sg, 0, sizeof(*sg));
+	sg->sg_fd = -1;
+	if ((sg->sg_file = strdup(cbuf_get(cb))) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	if ((sg->sg_fd = open(sg->sg_file, O_RDWR)) < 0){
+	    clicon_err(OE_UNIX, errno, "open(%s)", sg->sg_file);
+	    goto done;
+	}
+	if (fstat(sg->sg_fd, &st) < 0){
+	    clicon_err(OE_UNIX, errno, "fstat(%s)", sg->sg_file);
+	    goto done;
+	}
+	if ((sg->sg_size = st.st_size) < sizeof(*rec)){
+	    clicon_log(LOG_WARNING, "%s: replay segment %s too short, removed", 
+		       __FUNCTION__, sg->sg_file);
+	    close(sg->sg_fd);
+	    unlink(sg->sg_file);
+	    free(sg->sg_file);
+	    free(sg);
+	    sg = NULL;
+	    continue;
+	}
+	if ((sg->sg_buf = mmap(NULL, sg->sg_size, PROT_READ|PROT_WRITE, MAP_SHARED,
+			       sg->sg_fd, 0)) == MAP_FAILED){
+	    sg->sg_buf = NULL;
+	    clicon_err(OE_UNIX, errno, "mmap(%s)", sg->sg_file);
+	    goto done;
+	}
+	ADDQ(sg, es->es_segments);
+	es->es_segment_size += sg->sg_size;
+	if (nr > es->es_segment_nr)
+	    es->es_segment_nr = nr;
+	while (es->es_segment_size > STREAM_REPLAY_SIZE_MAX && es->es_segments != sg)
+	    stream_segment_drop(es, 1);
+	/* Index records until end marker or incomplete record */
+	while (sg->sg_len + sizeof(*rec) <= sg->sg_size){
+	    rec = (struct stream_record *)(sg->sg_buf + sg->sg_len);
+	    if (rec->rec_len == 0 ||
+		sg->sg_len + STREAM_RECORD_SIZE(rec->rec_len) + sizeof(*rec) > sg->sg_size ||
+		rec->rec_xml[rec->rec_len-1] != '\0')
+		break;
+	    tv.tv_sec = rec->rec_sec;
+	    tv.tv_usec = rec->rec_usec;
+	    if (stream_replay_push(es, &tv, rec->rec_xml, sg) < 0)
+		goto done;
+	    sg->sg_last = tv;
+	    sg->sg_len += STREAM_RECORD_SIZE(rec->rec_len);
+	}
+	/* Clear what follows, eg an incomplete record */
+	memset(sg->sg_buf + sg->sg_len, 0, sg->sg_size - sg->sg_len);
+	sg = NULL;
+    }
+    clicon_debug(1, "%s %s: %zu events in replay log", __FUNCTION__, 
+		 es->es_name, es->es_replay_nr);
+    retval = 0;
+ done:
+    if (sg){
+	if (sg->sg_fd != -1)
+	    close(sg->sg_fd);
+	if (sg->sg_file)
+	    free(sg->sg_file);
+	free(sg);
+    }
+    if (dp)
+	free(dp);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Find an event notification stream given name
  * @param[in]  h    Clicon handle
  * @param[in]  name Name of stream
@@ -125,6 +467,7 @@ stream_add(clicon_handle   h,
 {
     int             retval = -1;
     event_stream_t *es;
+    char           *dir;
 
     if ((es = stream_find(h, name)) != NULL)
 	goto ok;
@@ -144,6 +487,15 @@ stream_add(clicon_handle   h,
     es->es_replay_enabled = replay_enabled;
     if (retention)
 	es->es_retention = *retention;
+    if (replay_enabled &&
+	(dir = clicon_option_str(h, "CLICON_STREAM_REPLAY_DIR")) != NULL){
+	if ((es->es_replay_dir = strdup(dir)) == NULL){
+	    clicon_err(OE_XML, errno, "strdup");
+	    goto done;
+	}
+	if (stream_segment_load(es) < 0)
+	    goto done;
+    }
     clicon_stream_append(h, es);
  ok:
     retval = 0;
@@ -151,6 +503,96 @@ stream_add(clicon_handle   h,
     return retval;
 }
 
+/*! Get a parsed subscription filter of a stream, shared by subscriptions
+ * @param[in]  es     Event stream
+ * @param[in]  xpath  Filter selector as xpath
+ * @retval     sf     Filter, release with stream_filter_put
+ * @retval     NULL   Error, eg xpath parse error
+ */
+static struct stream_filter *
+stream_filter_get(event_stream_t *es,
+		  char           *xpath)
+{
+    struct stream_filter *sf;
+
+    if ((sf = es->es_filters) != NULL)
+	do {
+	    if (strcmp(sf->sf_xpath, xpath) == 0){
+		sf->sf_refcnt++;
+		return sf;
+	    }
+	    sf = NEXTQ(struct stream_filter *, sf);
+	} while (sf && sf != es->es_filters);
+    if ((sf = malloc(sizeof(*sf))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(sf, 0, sizeof(*sf));
+    if ((sf->sf_xpath = strdup(xpath)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (xpath_parse(xpath, &sf->sf_xptree) < 0)
+	goto done;
+    sf->sf_refcnt = 1;
+    ADDQ(sf, es->es_filters);
+    return sf;
+ done:
+    if (sf){
+	if (sf->sf_xpath)
+	    free(sf->sf_xpath);
+	free(sf);
+    }
+    return NULL;
+}
+
+/*! Release a subscription filter, free it when not used by any subscription
+ * @param[in]  es     Event stream
+ * @param[in]  sf     Filter
+ */
+static int
+stream_filter_put(event_stream_t       *es,
+		  struct stream_filter *sf)
+{
+    if (--sf->sf_refcnt > 0)
+	return 0;
+    DELQ(sf, es->es_filters, struct stream_filter *);
+    if (sf->sf_xptree)
+	xpath_tree_free(sf->sf_xptree);
+    if (sf->sf_xpath)
+	free(sf->sf_xpath);
+    free(sf);
+    return 0;
+}
+
+/*! Check if event matches a subscription filter, evaluated once per event
+ * @param[in]  es     Event stream, es_gen identifies the event
+ * @param[in]  sf     Filter or NULL (match all)
+ * @param[in]  xevent Event as XML
+ * @retval     1      Match
+ * @retval     0      No match, or xpath evaluation error
+ */
+static int
+stream_filter_match(event_stream_t       *es,
+		    struct stream_filter *sf,
+		    cxobj                *xevent)
+{
+    xp_ctx *xr = NULL;
+
+    if (sf == NULL)
+	return 1;
+    if (sf->sf_gen != es->es_gen){
+	sf->sf_gen = es->es_gen;
+	sf->sf_match = 0;
+	if (xpath_vec_ctx_tree(xevent, NULL, sf->sf_xptree, 0, &xr) == 0 &&
+	    xr && xr->xc_type == XT_NODESET && xr->xc_size)
+	    sf->sf_match = 1;
+	if (xr)
+	    ctx_free(xr);
+    }
+    return sf->sf_match;
+}
+
 /*! Delete complete notification event stream list (not just single stream)
  * @param[in] h     Clicon handle
  * @param[in] force Force deletion of 
@@ -159,8 +601,8 @@ int
 stream_delete_all(clicon_handle h,
 		  int           force)
 {
-    struct stream_replay *r;
     struct stream_subscription *ss;
+    struct stream_filter *sf;
     event_stream_t       *es;
     event_stream_t       *head = clicon_stream(h);
     
@@ -173,12 +615,16 @@ stream_delete_all(clicon_handle h,
 	    free(es->es_description);
 	while ((ss = es->es_subscription) != NULL)
 	    stream_ss_rm(h, es, ss, force); /* XXX in some cases leaks memory due to DONT clause in stream_ss_rm() */
-	while ((r = es->es_replay) != NULL){
-	    DELQ(r, es->es_replay, struct stream_replay *);
-	    if (r->r_xml)
-		xml_free(r->r_xml);
-	    free(r);
+	while ((sf = es->es_filters) != NULL){
+	    sf->sf_refcnt = 1;
+	    stream_filter_put(es, sf);
 	}
+	while (es->es_segments != NULL)
+	    stream_segment_drop(es, 0); /* Keep files for restart */
+	if (es->es_replay)
+	    free(es->es_replay);
+	if (es->es_replay_dir)
+	    free(es->es_replay_dir);
 	free(es);
     }
     return 0;
@@ -244,8 +690,7 @@ stream_timer_setup(int   fd,
     event_stream_t              *es;
     struct stream_subscription  *ss;
     struct stream_subscription  *ss1;
-    struct stream_replay        *r;
-    struct stream_replay        *r1;
+    struct stream_segment       *sg;
     
     clicon_debug(2, "%s", __FUNCTION__);
     /* Go thru callbacks and see if any have timed out, if so remove them 
@@ -272,22 +717,13 @@ stream_timer_setup(int   fd,
 		    else
 			ss = NEXTQ(struct stream_subscription *, ss);
 		} while (ss && ss != es->es_subscription);
-  /* 2) Go throughreplay buffer and remove entries with passed retention time */
-	    if (timerisset(&es->es_retention) &&
-		(r = es->es_replay) != NULL){
+  /* 2) Go through replay log and remove segments whose last entry has passed
+   * retention time */
+	    if (timerisset(&es->es_retention)){
 		timersub(&now, &es->es_retention, &tret);
-		do {
-		    if (timercmp(&r->r_tv, &tret, <)){
-			r1 = NEXTQ(struct stream_replay *, r);
-			DELQ(r, es->es_replay, struct stream_replay *);
-			if (r->r_xml)
-			    xml_free(r->r_xml);
-			free(r);
-			r = r1;
-		    }
-		    else
-			r = NEXTQ(struct stream_replay *, r);
-		} while (r && r!=es->es_replay);
+		while ((sg = es->es_segments) != NULL &&
+		       timercmp(&sg->sg_last, &tret, <))
+		    stream_segment_drop(es, 1);
 	    }
 	    es = NEXTQ(struct event_stream *, es);
 	} while (es && es != clicon_stream(h));
@@ -360,13 +796,21 @@ stream_ss_add(clicon_handle     h,
 	clicon_err(OE_CFG, errno, "strdup");
 	goto done;
     }
+    if (xpath && strlen(xpath) &&
+	(ss->ss_filter = stream_filter_get(es, xpath)) == NULL)
+	goto done;
     ss->ss_fn     = fn;
     ss->ss_arg    = arg;
     ADDQ(ss, es->es_subscription);
     return ss;
   done:
-    if (ss)
+    if (ss){
+	if (ss->ss_stream)
+	    free(ss->ss_stream);
+	if (ss->ss_xpath)
+	    free(ss->ss_xpath);
 	free(ss);
+    }
     return NULL;
 }
 
@@ -386,6 +830,10 @@ stream_ss_rm(clicon_handle                h,
 {
     clicon_debug(1, "%s", __FUNCTION__);
     DELQ(ss, es->es_subscription, struct stream_subscription *);
+    if (ss->ss_filter){
+	stream_filter_put(es, ss->ss_filter);
+	ss->ss_filter = NULL;
+    }
     /* Remove from upper layers - close socket etc. */
     (*ss->ss_fn)(h, 1, NULL, ss->ss_arg);
     if (force){
@@ -479,6 +927,76 @@ stream_ss_delete(clicon_handle     h,
     return retval;
 }
 
+/*! Get notification event serialized as a framed internal message
+ *
+ * During notification of an event (in subscription callbacks), the event is
+ * serialized only once and the message is shared by all subscribers.
+ * @param[in]  xevent Event as XML
+ * @retval     sm     Message, release with stream_msg_unref
+ * @retval     NULL   Error
+ * @see send_msg_notify_xml
+ */
+struct stream_msg *
+stream_msg_get(cxobj *xevent)
+{
+    struct stream_msg *sm = NULL;
+    struct clicon_msg *msg;
+    cbuf              *cb = NULL;
+    size_t             len;
+
+    if (xevent == _stream_xev && _stream_msg != NULL){
+	_stream_msg->sm_refcnt++;
+	return _stream_msg;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf(cb, xevent, 0, 0, -1) < 0)
+	goto done;
+    len = sizeof(*msg) + cbuf_len(cb) + 1;
+    if ((sm = malloc(sizeof(*sm))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(sm, 0, sizeof(*sm));
+    if ((sm->sm_data = malloc(len)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	free(sm);
+	sm = NULL;
+	goto done;
+    }
+    msg = (struct clicon_msg *)sm->sm_data;
+    memset(msg, 0, sizeof(*msg));
+    msg->op_len = htonl(len);
+    memcpy(msg->op_body, cbuf_get(cb), cbuf_len(cb)+1);
+    sm->sm_len = len;
+    sm->sm_refcnt = 1;
+    if (xevent == _stream_xev){ /* Keep for other subscribers of this event */
+	_stream_msg = sm;
+	sm->sm_refcnt++;
+    }
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return sm;
+}
+
+/*! Release a shared notification message, free it when not referenced
+ * @param[in]  sm     Message
+ * @see stream_msg_get
+ */
+int
+stream_msg_unref(struct stream_msg *sm)
+{
+    if (--sm->sm_refcnt > 0)
+	return 0;
+    if (sm->sm_data)
+	free(sm->sm_data);
+    free(sm);
+    return 0;
+}
+
 /*! Stream notify event and distribute to all registered callbacks
  * @param[in]  h       Clicon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
@@ -497,8 +1015,15 @@ stream_notify1(clicon_handle   h,
 {
     int                         retval = -1;
     struct stream_subscription *ss;
+    cxobj                      *xev0;
+    struct stream_msg          *sm0;
     
     clicon_debug(2, "%s", __FUNCTION__);
+    es->es_gen++; /* New event: filters are evaluated again */
+    xev0 = _stream_xev; /* In case of recursive notify */
+    sm0 = _stream_msg;
+    _stream_xev = xevent;
+    _stream_msg = NULL;
     /* Go thru all subscriptions and find matches */
     if ((ss = es->es_subscription) != NULL)
 	do {
@@ -512,9 +1037,7 @@ stream_notify1(clicon_handle   h,
 		ss = ss1;
 	    }
 	    else{  /* xpath match */
-		if (ss->ss_xpath == NULL ||
-		    strlen(ss->ss_xpath)==0 ||
-		    xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL)
+		if (stream_filter_match(es, ss->ss_filter, xevent))
 		    if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
 			goto done;
 		ss = NEXTQ(struct stream_subscription *, ss);
@@ -522,6 +1045,10 @@ stream_notify1(clicon_handle   h,
 	} while (es->es_subscription && ss != es->es_subscription);
     retval = 0;
   done:
+    if (_stream_msg)
+	stream_msg_unref(_stream_msg);
+    _stream_xev = xev0;
+    _stream_msg = sm0;
     return retval;
 }
 
@@ -591,7 +1118,6 @@ stream_notify(clicon_handle h,
     if (es->es_replay_enabled){
 	if (stream_replay_add(es, &tv, xev) < 0)
 	    goto done;
-	xev = NULL; /* xml stored in replay_add and should not be freed */
     }
  ok:
     retval = 0;
@@ -658,7 +1184,6 @@ stream_notify_xml(clicon_handle h,
     if (es->es_replay_enabled){
 	if (stream_replay_add(es, &tv, xev) < 0)
 	    goto done;
-	xev = NULL; /* xml stored in replay_add and should not be freed */
     }
  ok:
     retval = 0;
@@ -705,61 +1230,91 @@ stream_replay_notify(clicon_handle               h,
 {
     int                   retval = -1;
     struct stream_replay *r;
+    size_t                i;
+    cxobj                *xt = NULL;
+    cxobj                *xev;
+    yang_stmt            *yspec;
 
     /* If <startTime> is not present, this is not a replay */
     if (!timerisset(&ss->ss_starttime))
 	goto ok;
     if (!es->es_replay_enabled)
 	goto ok;
-    /* Get replay linked list */
-    if ((r = es->es_replay) == NULL)
-	goto ok;
-    /* First loop to skip until start */
-    do {
-	if (timercmp(&r->r_tv, &ss->ss_starttime, >=))
-	    break;
-	r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
-    if (r == NULL)
-	goto ok; /* No samples to replay */
-    /* Then notify until stop */
-    do {
+    yspec = clicon_dbspec_yang(h);
+    /* Binary search for first event at or after start, then notify until stop */
+    for (i = stream_replay_seek(es, &ss->ss_starttime); i < es->es_replay_nr; i++){
+	r = stream_replay_ith(es, i);
 	if (timerisset(&ss->ss_stoptime) &&
 	    timercmp(&r->r_tv, &ss->ss_stoptime, >))
 	    break;
-	if ((*ss->ss_fn)(h, 0, r->r_xml, ss->ss_arg) < 0)
+	if (xml_parse_string(r->r_xml, yspec, &xt) < 0)
 	    goto done;
-	r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
+	if ((xev = xml_child_i(xt, 0)) != NULL)
+	    if ((*ss->ss_fn)(h, 0, xev, ss->ss_arg) < 0)
+		goto done;
+	xml_free(xt);
+	xt = NULL;
+    }
  ok:
     retval = 0;
  done:
+    if (xt)
+	xml_free(xt);
     return retval;
 }
 
 /*! Add replay sample to stream with timestamp
+ * The event is serialized into the last segment of the replay log, a new 
+ * segment is created if it is full, and an entry is added to the time index.
  * @param[in] es   Stream
- * @param[in] tv   Timestamp
- * @param[in] xv   XML
+ * @param[in] tv   Timestamp, assumed not older than previous sample
+ * @param[in] xv   XML, not consumed
  */
 int
 stream_replay_add(event_stream_t *es,
 		  struct timeval *tv,
 		  cxobj          *xv)
 {
-    int                   retval = -1;
-    struct stream_replay *new;
+    int                    retval = -1;
+    cbuf                  *cb = NULL;
+    struct stream_segment *sg;
+    struct stream_record  *rec;
+    size_t                 len;
+    size_t                 reclen;
+    size_t                 size;
 
-    if ((new = malloc(sizeof *new)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
 	goto done;
     }
-    memset(new, 0, (sizeof *new));
-    new->r_tv = *tv;
-    new->r_xml = xv;
-    ADDQ(new, es->es_replay);
+    if (clicon_xml2cbuf(cb, xv, 0, 0, -1) < 0)
+	goto done;
+    len = cbuf_len(cb) + 1;
+    /* Room for record and end-of-segment marker */
+    reclen = STREAM_RECORD_SIZE(len);
+    sg = PREVQ(struct stream_segment *, es->es_segments); /* last */
+    if (sg == NULL || sg->sg_len + reclen + sizeof(*rec) > sg->sg_size){
+	size = reclen + sizeof(*rec) > STREAM_SEGMENT_SIZE ?
+	    reclen + sizeof(*rec) : STREAM_SEGMENT_SIZE;
+	while (es->es_segments != NULL &&
+	       es->es_segment_size + size > STREAM_REPLAY_SIZE_MAX)
+	    stream_segment_drop(es, 1);
+	if (stream_segment_new(es, size, &sg) < 0)
+	    goto done;
+    }
+    rec = (struct stream_record *)(sg->sg_buf + sg->sg_len);
+    memcpy(rec->rec_xml, cbuf_get(cb), len);
+    rec->rec_sec = tv->tv_sec;
+    rec->rec_usec = tv->tv_usec;
+    rec->rec_len = len; /* Written last, see stream_segment_load */
+    sg->sg_len += reclen;
+    sg->sg_last = *tv;
+    if (stream_replay_push(es, tv, rec->rec_xml, sg) < 0)
+	goto done;
     retval = 0;
  done:
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
@@ -884,73 +1439,278 @@ curl_get_cb(void *ptr,
     return len;
 }
 
-/*! Send a curl POST request
- * @retval  -1   fatal error
- * @retval   0   expect set but did not expected return or other non-fatal error
- * @retval   1   ok
- * Note: curl_easy_perform blocks
- * Note: New handle is created every time, the handle can be re-used for better TCP performance
- * @see same function (url_post) in grideye_curl.c
+/* Max bytes of events waiting to be published per stream, more are dropped */
+#define STREAM_PUB_QUEUE_MAX (1024*1024)
+
+/* Nr of times a failed post is retried before its events are dropped */
+#define STREAM_PUB_RETRY_MAX 3
+
+/* Time between retries of a failed post [s] */
+#define STREAM_PUB_RETRY_S 1
+
+/* Event waiting to be published. The serialized event is shared with other
+ * subscribers, see stream_msg_get
+ */
+struct stream_pub_event{
+    qelem_t            pe_q;     /* queue header */
+    struct stream_msg *pe_msg;   /* Serialized event */
+};
+
+/* Publish state of a stream. Events are queued per stream and posted in order,
+ * one event per post since the pub/sub server publishes each post as one
+ * message. Posts are made with a curl multi handle driven by the clixon event
+ * loop, so the backend never blocks on the pub/sub server, and connections to
+ * the server are reused by the multi handle.
+ */
+struct stream_pub{
+    qelem_t        sp_q;         /* queue header */
+    clicon_handle  sp_h;
+    char          *sp_stream;    /* Name of stream */
+    struct stream_pub_event *sp_events; /* Events waiting, first is posted or retried */
+    size_t         sp_len;       /* Nr of bytes of events in sp_events */
+    CURL          *sp_curl;      /* Ongoing post, or NULL */
+    int            sp_retrying;  /* Post of first event waits for retry timer */
+    int            sp_retries;   /* Nr of retries of first event */
+    struct curlbuf sp_reply;     /* Reply of ongoing post */
+    uint64_t       sp_stat_posted;  /* Nr of events posted */
+    uint64_t       sp_stat_dropped; /* Nr of events dropped (queue full or failed) */
+    uint64_t       sp_stat_retries; /* Nr of retried posts */
+};
+
+static struct stream_pub *_stream_pubs = NULL; /* Publish state of all streams */
+static CURLM             *_stream_curlm = NULL; /* Curl multi handle */
+
+static int stream_pub_post(struct stream_pub *sp);
+static int stream_pub_retry_cb(int s, void *arg);
+
+/*! Remove first event of publish queue of a stream
+ * @param[in]  sp  Stream publish state
  */
 static int
-url_post(char *url, 
-	 char *postfields, 
-	 char **getdata)
+stream_pub_event_pop(struct stream_pub *sp)
 {
-    int            retval = -1;
-    CURL          *curl = NULL;
-    char          *err = NULL;
-    struct curlbuf cb = {0, };
-    CURLcode       errcode;
-
-    /* Try it with  curl -X PUT -d '*/
-    clicon_debug(1, "%s:  curl -X POST -d '%s' %s",
-	__FUNCTION__, postfields, url);
-    /* Set up curl for doing the communication with the controller */
-    if ((curl = curl_easy_init()) == NULL) {
-	clicon_debug(1, "curl_easy_init");
+    struct stream_pub_event *pe;
+
+    if ((pe = sp->sp_events) == NULL)
+	return 0;
+    DELQ(pe, sp->sp_events, struct stream_pub_event *);
+    sp->sp_len -= pe->pe_msg->sm_len;
+    stream_msg_unref(pe->pe_msg);
+    free(pe);
+    sp->sp_retries = 0;
+    return 0;
+}
+
+/*! Let curl act on its sockets and timers, and handle finished posts
+ * @param[in]  s      Socket or CURL_SOCKET_TIMEOUT
+ * @param[in]  flags  CURL_CSELECT_IN / CURL_CSELECT_OUT
+ */
+static int
+stream_curl_action(curl_socket_t s,
+		   int           flags)
+{
+    int                retval = -1;
+    int                running;
+    CURLMsg           *m;
+    int                n;
+    struct stream_pub *sp;
+    long               code = 0;
+    struct timeval     t;
+
+    if (curl_multi_socket_action(_stream_curlm, s, flags, &running) != CURLM_OK){
+	clicon_err(OE_PLUGIN, 0, "curl_multi_socket_action");
+	goto done;
+    }
+    while ((m = curl_multi_info_read(_stream_curlm, &n)) != NULL){
+	if (m->msg != CURLMSG_DONE)
+	    continue;
+	curl_easy_getinfo(m->easy_handle, CURLINFO_PRIVATE, (char**)&sp);
+	curl_easy_getinfo(m->easy_handle, CURLINFO_RESPONSE_CODE, &code);
+	curl_multi_remove_handle(_stream_curlm, m->easy_handle);
+	curl_easy_cleanup(m->easy_handle);
+	sp->sp_curl = NULL;
+	if (sp->sp_reply.b_buf){
+	    clicon_debug(1, "%s: %s", __FUNCTION__, sp->sp_reply.b_buf);
+	    free(sp->sp_reply.b_buf);
+	    sp->sp_reply.b_buf = NULL;
+	    sp->sp_reply.b_len = 0;
+	}
+	if (m->data.result == CURLE_OK && code < 300){
+	    sp->sp_stat_posted++;
+	    stream_pub_event_pop(sp);
+	    if (stream_pub_post(sp) < 0) /* Next event, if any */
+		goto done;
+	}
+	else if (sp->sp_retries++ < STREAM_PUB_RETRY_MAX){
+	    clicon_debug(1, "%s %s: post failed: %s (%ld), retry", __FUNCTION__,
+			 sp->sp_stream, curl_easy_strerror(m->data.result), code);
+	    sp->sp_stat_retries++;
+	    gettimeofday(&t, NULL);
+	    t.tv_sec += STREAM_PUB_RETRY_S;
+	    if (event_reg_timeout(t, stream_pub_retry_cb, sp, "stream publish retry") < 0)
+		goto done;
+	    sp->sp_retrying = 1;
+	}
+	else{
+	    clicon_log(LOG_WARNING, "%s %s: post failed: %s (%ld), event dropped",
+		       __FUNCTION__, sp->sp_stream, 
+		       curl_easy_strerror(m->data.result), code);
+	    sp->sp_stat_dropped++;
+	    stream_pub_event_pop(sp);
+	    if (stream_pub_post(sp) < 0)
+		goto done;
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Curl socket is readable */
+static int
+stream_curl_read_cb(int   s,
+		    void *arg)
+{
+    return stream_curl_action(s, CURL_CSELECT_IN);
+}
+
+/*! Curl socket is writable */
+static int
+stream_curl_write_cb(int   s,
+		     void *arg)
+{
+    return stream_curl_action(s, CURL_CSELECT_OUT);
+}
+
+/*! Curl timeout has expired */
+static int
+stream_curl_timeout_cb(int   s,
+		       void *arg)
+{
+    return stream_curl_action(CURL_SOCKET_TIMEOUT, 0);
+}
+
+/*! Curl tells which events it wants on a socket: register them in event loop
+ * @see CURLMOPT_SOCKETFUNCTION
+ */
+static int
+stream_curl_socket_cb(CURL         *easy,
+		      curl_socket_t s,
+		      int           what,
+		      void         *userp,
+		      void         *socketp)
+{
+    event_unreg_fd(s, stream_curl_read_cb);
+    event_unreg_fd_write(s, stream_curl_write_cb);
+    if (what == CURL_POLL_IN || what == CURL_POLL_INOUT)
+	if (event_reg_fd(s, stream_curl_read_cb, NULL, "stream publish") < 0)
+	    return -1;
+    if (what == CURL_POLL_OUT || what == CURL_POLL_INOUT)
+	if (event_reg_fd_write(s, stream_curl_write_cb, NULL, "stream publish") < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Curl sets its timer: register it in event loop
+ * @see CURLMOPT_TIMERFUNCTION
+ */
+static int
+stream_curl_timer_cb(CURLM *multi,
+		     long   timeout_ms,
+		     void  *userp)
+{
+    struct timeval t;
+
+    event_unreg_timeout(stream_curl_timeout_cb, NULL);
+    if (timeout_ms < 0) /* Delete timer */
+	return 0;
+    gettimeofday(&t, NULL);
+    t.tv_sec += timeout_ms/1000;
+    t.tv_usec += (timeout_ms%1000)*1000;
+    if (t.tv_usec >= 1000000){
+	t.tv_sec++;
+	t.tv_usec -= 1000000;
+    }
+    if (event_reg_timeout(t, stream_curl_timeout_cb, NULL, "stream publish timer") < 0)
+	return -1;
+    return 0;
+}
+
+/*! Post first waiting event of a stream, unless a post is ongoing or waits for retry
+ * @param[in]  sp  Stream publish state
+ */
+static int
+stream_pub_post(struct stream_pub *sp)
+{
+    int                retval = -1;
+    cbuf              *u = NULL; /* stream pub (push) url */
+    char              *pub_prefix;
+    struct stream_msg *sm;
+    CURL              *curl = NULL;
+
+    if (sp->sp_curl != NULL || sp->sp_retrying || sp->sp_events == NULL)
+	goto ok;
+    sm = sp->sp_events->pe_msg;
+    if ((pub_prefix = clicon_option_str(sp->sp_h, "CLICON_STREAM_PUB")) == NULL){
+	clicon_err(OE_CFG, ENOENT, "CLICON_STREAM_PUB not defined");
 	goto done;
     }
-    if ((err = malloc(CURL_ERROR_SIZE)) == NULL) {
-	clicon_debug(1, "%s: malloc", __FUNCTION__);
+    if ((u = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
     }
-    curl_easy_setopt(curl, CURLOPT_URL, url);
+    cprintf(u, "%s/%s", pub_prefix, sp->sp_stream);
+    clicon_debug(1, "%s: curl -X POST %s", __FUNCTION__, cbuf_get(u));
+    if ((curl = curl_easy_init()) == NULL) {
+	clicon_err(OE_PLUGIN, 0, "curl_easy_init");
+	goto done;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, cbuf_get(u));
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_get_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &cb);
-    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, err);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sp->sp_reply);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, sp);
     curl_easy_setopt(curl, CURLOPT_POST, 1);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postfields);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, strlen(postfields));
-
+    /* Event is referenced by the queue until the post is done */
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, sm->sm_data + sizeof(struct clicon_msg));
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, sm->sm_len - sizeof(struct clicon_msg) - 1);
     if (debug)
 	curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);   
-    if ((errcode = curl_easy_perform(curl)) != CURLE_OK){
-	clicon_debug(1, "%s: curl: %s(%d)", __FUNCTION__, err, errcode);
-	retval = 0;
-	goto done; 
-    }
-    if (getdata && cb.b_buf){
-	*getdata = cb.b_buf;
-	cb.b_buf = NULL;
+    if (curl_multi_add_handle(_stream_curlm, curl) != CURLM_OK){
+	clicon_err(OE_PLUGIN, 0, "curl_multi_add_handle");
+	goto done;
     }
-    retval = 1;
-  done:
-    if (err)
-	free(err);
-    if (cb.b_buf)
-	free(cb.b_buf);
+    sp->sp_curl = curl;
+    curl = NULL;
+ ok:
+    retval = 0;
+ done:
     if (curl)
-	curl_easy_cleanup(curl);   /* cleanup */ 
+	curl_easy_cleanup(curl);
+    if (u)
+	cbuf_free(u);
     return retval;
 }
 
+/*! Timeout callback for retrying a failed post
+ * @param[in]  s    Ignore
+ * @param[in]  arg  Stream publish state
+ */
+static int
+stream_pub_retry_cb(int   s,
+		    void *arg)
+{
+    struct stream_pub *sp = (struct stream_pub *)arg;
+
+    sp->sp_retrying = 0;
+    return stream_pub_post(sp);
+}
+
 /*! Stream callback for example stream notification 
- * Push via curl_post to publish stream event
+ * Append event to publish queue of stream and post it asynchronously
  * @param[in]  h     Clicon handle
  * @param[in]  op    Operation: 0 OK, 1 Close
  * @param[in]  event Event as XML
- * @param[in]  arg   Extra argument provided in stream_ss_add
+ * @param[in]  arg   Stream publish state
  * @see stream_ss_add
  */
 static int 
@@ -959,65 +1719,96 @@ stream_publish_cb(clicon_handle h,
 		  cxobj        *event,
 		  void         *arg)
 {
-    int   retval = -1;
-    cbuf *u = NULL; /* stream pub (push) url */
-    cbuf *d = NULL; /* (XML) data to push */
-    char *pub_prefix;
-    char *result = NULL;
-    char *stream = (char*)arg;
+    int                      retval = -1;
+    struct stream_pub       *sp = (struct stream_pub *)arg;
+    struct stream_msg       *sm = NULL;
+    struct stream_pub_event *pe;
 
     clicon_debug(1, "%s", __FUNCTION__); 
     if (op != 0)
 	goto ok;
-    /* Create pub url */
-    if ((u = cbuf_new()) == NULL){
-	clicon_err(OE_XML, errno, "cbuf_new");
-	goto done;
-    }
-    if ((pub_prefix = clicon_option_str(h, "CLICON_STREAM_PUB")) == NULL){
-	clicon_err(OE_CFG, ENOENT, "CLICON_STREAM_PUB not defined");
+    /* Serialized event is shared with other subscribers */
+    if ((sm = stream_msg_get(event)) == NULL)
 	goto done;
+    if (sp->sp_len + sm->sm_len > STREAM_PUB_QUEUE_MAX){
+	if (sp->sp_stat_dropped++ == 0)
+	    clicon_log(LOG_WARNING, "%s %s: publish queue full, dropping events",
+		       __FUNCTION__, sp->sp_stream);
+	goto ok;
     }
-    cprintf(u, "%s/%s", pub_prefix, stream);
-    /* Create XML data as string */
-    if ((d = cbuf_new()) == NULL){
-	clicon_err(OE_XML, errno, "cbuf_new");
+    if ((pe = malloc(sizeof(*pe))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
 	goto done;
     }
-    if (clicon_xml2cbuf(d, event, 0, 0, -1) < 0)
-	goto done;
-    if (url_post(cbuf_get(u),     /* url+stream */
-		 cbuf_get(d),     /* postfields */
-		 &result) < 0)    /* result as xml */
+    memset(pe, 0, sizeof(*pe));
+    pe->pe_msg = sm;
+    sp->sp_len += sm->sm_len;
+    sm = NULL;
+    ADDQ(pe, sp->sp_events);
+    /* Not while a post is ongoing or waits for retry, see stream_pub_retry_cb */
+    if (stream_pub_post(sp) < 0)
 	goto done;
-    if (result)
-	clicon_debug(1, "%s: %s", __FUNCTION__, result);
  ok:
     retval = 0;
  done:
-    if (u)
-	cbuf_free(u);
-    if (d)
-	cbuf_free(d);
-    if (result)
-	free(result);
+    if (sm)
+	stream_msg_unref(sm);
     return retval;
 }
+
+/*! Free publish state of a stream */
+static int
+stream_pub_free(struct stream_pub *sp)
+{
+    if (sp->sp_curl){
+	curl_multi_remove_handle(_stream_curlm, sp->sp_curl);
+	curl_easy_cleanup(sp->sp_curl);
+    }
+    event_unreg_timeout(stream_pub_retry_cb, sp);
+    clicon_debug(1, "%s %s: posted:%" PRIu64 " dropped:%" PRIu64 " retries:%" PRIu64,
+		 __FUNCTION__, sp->sp_stream,
+		 sp->sp_stat_posted, sp->sp_stat_dropped, sp->sp_stat_retries);
+    if (sp->sp_reply.b_buf)
+	free(sp->sp_reply.b_buf);
+    while (sp->sp_events)
+	stream_pub_event_pop(sp);
+    if (sp->sp_stream)
+	free(sp->sp_stream);
+    free(sp);
+    return 0;
+}
 #endif /* CLIXON_PUBLISH_STREAMS */
 
 /*! Publish all streams on a pubsub channel, eg using SSE
+ * Events are queued per stream and posted asynchronously, one event per request
+ * in order, see stream_pub_post
  */
 int
 stream_publish(clicon_handle h,
 	       char         *stream)
 {
 #ifdef CLIXON_PUBLISH_STREAMS
-    int retval = -1;
+    int                retval = -1;
+    struct stream_pub *sp = NULL;
 
-    if (stream_ss_add(h, stream, NULL, NULL, NULL, stream_publish_cb, (void*)stream) < 0)
+    if ((sp = malloc(sizeof(*sp))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(sp, 0, sizeof(*sp));
+    sp->sp_h = h;
+    if ((sp->sp_stream = strdup(stream)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
 	goto done;
+    }
+    if (stream_ss_add(h, stream, NULL, NULL, NULL, stream_publish_cb, (void*)sp) == NULL)
+	goto done;
+    ADDQ(sp, _stream_pubs);
+    sp = NULL;
     retval = 0;
  done:
+    if (sp)
+	stream_pub_free(sp);
     return retval;
 #else
    clicon_log(LOG_WARNING, "%s called but CLIXON_PUBLISH_STREAMS not enabled (enable with configure --enable-publish)", __FUNCTION__);
@@ -1036,6 +1827,12 @@ stream_publish_init()
 	clicon_err(OE_PLUGIN, errno, "curl_global_init");
 	goto done;
     }    
+    if ((_stream_curlm = curl_multi_init()) == NULL){
+	clicon_err(OE_PLUGIN, errno, "curl_multi_init");
+	goto done;
+    }    
+    curl_multi_setopt(_stream_curlm, CURLMOPT_SOCKETFUNCTION, stream_curl_socket_cb);
+    curl_multi_setopt(_stream_curlm, CURLMOPT_TIMERFUNCTION, stream_curl_timer_cb);
     retval = 0;
  done:
     return retval;
@@ -1048,6 +1845,17 @@ int
 stream_publish_exit()
 {
 #ifdef CLIXON_PUBLISH_STREAMS
+    struct stream_pub *sp;
+
+    while ((sp = _stream_pubs) != NULL){
+	DELQ(sp, _stream_pubs, struct stream_pub *);
+	stream_pub_free(sp);
+    }
+    if (_stream_curlm){
+	curl_multi_cleanup(_stream_curlm);
+	_stream_curlm = NULL;
+	event_unreg_timeout(stream_curl_timeout_cb, NULL);
+    }
     curl_global_cleanup();
 #endif 
     return 0;
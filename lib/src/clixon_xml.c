@@ -42,6 +42,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
@@ -54,6 +55,7 @@
 
 /* clixon */
 #include "clixon_err.h"
+#include "clixon_arena.h"
 #include "clixon_string.h"
 #include "clixon_queue.h"
 #include "clixon_hash.h"
@@ -66,6 +68,7 @@
 #include "clixon_xml_sort.h"
 #include "clixon_xml_parse.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_xml_index.h"
 
 /*
  * Constants
@@ -78,13 +81,51 @@
 #define XML_TOP_SYMBOL "top" 
 /* How many XML children to start with if any (and then add exponentialy) */
 #define XML_CHILDVEC_MAX_DEFAULT 4
-/* Initial length of x_value malloced string */
-#define XML_VALUE_MAX_DEFAULT 32
+/* Values shorter than this are stored inline in the node */
+#define XML_VALUE_INLINE 16
+/* Initial number of buckets of the table of interned names */
+#define XML_INTERN_SIZE_DEFAULT 256
+/* Private flag: arena node holds a reference of its arena, see xml_arena_ref */
+#define XML_FLAG_ARENA 0x8000
+/* Private flag: value is stored inline, see xml_value_set */
+#define XML_FLAG_VINLINE 0x10000
+/* Private flag: children are sorted as by xml_sort, see xml_sorted */
+#define XML_FLAG_SORTED 0x20000
+/* Private flag: node is in a tree with indexes, see xml_indexed */
+#define XML_FLAG_INDEXED 0x40000
+
+/* Arena of a node, or NULL if it is allocated from the heap */
+#define XML_ARENA(x) ((x)->x_ext ? (x)->x_ext->xe_arena : NULL)
 
 /*
  * Types
  */
 
+/*! Value of attribute and body nodes, short values are stored inline
+ * @see XML_FLAG_VINLINE
+ */
+union xml_value{
+    struct {
+	char         *xv_ptr;       /* Allocated value */
+	int           xv_len;       /* Length of value */
+	int           xv_max;       /* Length of allocated value */
+    } xv_alloc;
+    char          xv_inline[XML_VALUE_INLINE]; /* Short null-terminated value */
+};
+
+/*! Rarely used fields of an xml node, allocated on demand
+ * Allocated together with the node for arena nodes
+ */
+struct xml_ext{
+    clixon_arena     *xe_arena;     /* Arena of node and its strings, or NULL
+				       if allocated from the heap */
+    struct xml      **xe_defaults;  /* Cached virtual default leafs, not 
+				       children, see xml_default_child */
+    int               xe_defaults_len;/* Number of virtual default leafs */
+    struct xml_index *xe_index;     /* Element-name index of tree, only on top
+				       node, see clixon_xml_index.c */
+};
+
 /*! xml tree node, with name, type, parent, children, etc 
  * Note that this is a private type not visible from externally, use
  * access functions.
@@ -117,25 +158,50 @@
  * - Local name: In either case the "local name" is N (also "prefix")
  * It is this combination of the universally managed URI namespace with the 
  * vocabulary's local names that is effective in avoiding name clashes.
+ * The node is kept small since large trees have millions of nodes:
+ * - Names and prefixes are interned, ie shared by all nodes, see xml_intern
+ * - Short values are stored inline, see union xml_value
+ * - A single child is stored inline, see x_child
+ * - Rarely used fields are in an extension block, see struct xml_ext
  */
 struct xml{
-    char             *x_name;       /* name of node */
-    char             *x_prefix;     /* namespace localname N, called prefix */
+    char             *x_name;       /* name of node, interned */
+    char             *x_prefix;     /* namespace localname N, called prefix,
+				       interned */
     struct xml       *x_up;         /* parent node in hierarchy if any */
     struct xml      **x_childvec;   /* vector of children nodes */
     int               x_childvec_len;/* Number of children */
     int               x_childvec_max;/* Length of allocated vector */
     enum cxobj_type   x_type;       /* type of node: element, attribute, body */
-    cbuf             *x_value_cb;   /* attribute and body nodes have values */
     int               x_flags;      /* Flags according to XML_FLAG_* */
+    union xml_value   x_value;      /* attribute and body nodes have values */
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, by 
 				       reference, dont free */
     cg_var           *x_cv;         /* Cached value as cligen variable 
                                        (eg xml_cmp) */
+    cg_var          **x_keys;       /* Cached key values of list entry, 
+				       borrowed from key bodies (xml_cmp) */
     cvec             *x_ns_cache;   /* Cached vector of namespaces */
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for sorting: 
 				       see xml_enumerate and xml_cmp */
+    struct xml_ext   *x_ext;        /* Rarely used fields, or NULL */
+    struct xml       *x_child;      /* Child vector of length one, a node with
+				       one child has x_childvec == &x_child */
+};
+
+/*! Interned name or prefix, shared by all heap nodes with the same name */
+struct xml_intern{
+    struct xml_intern *xs_next;     /* Next string in hash bucket */
+    uint32_t           xs_hash;     /* Hash value of string */
+    int                xs_refcnt;   /* Number of nodes using the string */
+    char               xs_str[];    /* Null-terminated string */
+};
+
+/*! Heap child of an arena node, freed with the arena, see xml_arena_child */
+struct xml_arena_child{
+    struct xml *xac_parent;
+    struct xml *xac_child;
 };
 
 /*
@@ -151,6 +217,324 @@ static const map_str2int xsmap[] = {
     {NULL,           -1}
 };
 
+/* Hash table of interned names and prefixes, see xml_intern */
+static struct xml_intern **_xml_intern_vec = NULL;
+static uint32_t            _xml_intern_size = 0; /* Number of buckets */
+static uint32_t            _xml_intern_nr = 0;   /* Number of strings */
+
+/*! Hash function of interned strings (FNV-1a)
+ * @param[in]  str  String
+ * @retval     h    Hash value
+ */
+static uint32_t
+xml_intern_hash(const char *str)
+{
+    uint32_t h = 2166136261u;
+
+    while (*str){
+	h ^= (unsigned char)*str++;
+	h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Resize hash table of interned strings
+ * @param[in]  size  New number of buckets, a power of two
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_intern_resize(uint32_t size)
+{
+    struct xml_intern **vec;
+    struct xml_intern  *xs;
+    uint32_t            i;
+
+    if ((vec = calloc(size, sizeof(*vec))) == NULL){
+	clicon_err(OE_XML, errno, "calloc");
+	return -1;
+    }
+    for (i=0; i<_xml_intern_size; i++)
+	while ((xs = _xml_intern_vec[i]) != NULL){
+	    _xml_intern_vec[i] = xs->xs_next;
+	    xs->xs_next = vec[xs->xs_hash & (size-1)];
+	    vec[xs->xs_hash & (size-1)] = xs;
+	}
+    if (_xml_intern_vec)
+	free(_xml_intern_vec);
+    _xml_intern_vec = vec;
+    _xml_intern_size = size;
+    return 0;
+}
+
+/*! Intern a name or prefix
+ * Nodes with the same name share one copy, which is freed when no node
+ * uses it. Interned strings must not be modified.
+ * @param[in]  str  String
+ * @retval     s    Interned string, release with xml_intern_release
+ * @retval     NULL Error
+ */
+static char *
+xml_intern(char *str)
+{
+    struct xml_intern *xs;
+    uint32_t           h;
+    size_t             len;
+
+    h = xml_intern_hash(str);
+    if (_xml_intern_size)
+	for (xs = _xml_intern_vec[h & (_xml_intern_size-1)]; xs; xs = xs->xs_next)
+	    if (xs->xs_hash == h && strcmp(xs->xs_str, str) == 0){
+		xs->xs_refcnt++;
+		return xs->xs_str;
+	    }
+    if (_xml_intern_nr >= _xml_intern_size &&
+	xml_intern_resize(_xml_intern_size?2*_xml_intern_size:XML_INTERN_SIZE_DEFAULT) < 0)
+	return NULL;
+    len = strlen(str);
+    if ((xs = malloc(sizeof(*xs) + len + 1)) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return NULL;
+    }
+    memcpy(xs->xs_str, str, len+1);
+    xs->xs_hash = h;
+    xs->xs_refcnt = 1;
+    xs->xs_next = _xml_intern_vec[h & (_xml_intern_size-1)];
+    _xml_intern_vec[h & (_xml_intern_size-1)] = xs;
+    _xml_intern_nr++;
+    return xs->xs_str;
+}
+
+/*! Release an interned string, free it if no node uses it
+ * @param[in]  str  String returned by xml_intern
+ */
+static void
+xml_intern_release(char *str)
+{
+    struct xml_intern  *xs;
+    struct xml_intern **xsp;
+
+    xs = (struct xml_intern *)(str - offsetof(struct xml_intern, xs_str));
+    if (--xs->xs_refcnt > 0)
+	return;
+    for (xsp = &_xml_intern_vec[xs->xs_hash & (_xml_intern_size-1)];
+	 *xsp;
+	 xsp = &(*xsp)->xs_next)
+	if (*xsp == xs){
+	    *xsp = xs->xs_next;
+	    break;
+	}
+    _xml_intern_nr--;
+    free(xs);
+}
+
+/*! Invalidate cached list key values of a node and of its parent
+ * Called when the children of x change: x is either a list entry (key leaf
+ * added or removed) or a key leaf (its body added or removed).
+ * @param[in]  x   XML node
+ * @see xml_keys
+ */
+static void
+xml_keys_reset(cxobj *x)
+{
+    if (x->x_keys){
+	free(x->x_keys);
+	x->x_keys = NULL;
+    }
+    if ((x = x->x_up) != NULL && x->x_keys){
+	free(x->x_keys);
+	x->x_keys = NULL;
+    }
+}
+
+/*! Allocate memory for a node, from its arena if it has one
+ * @param[in]  x    XML node
+ * @param[in]  len  Number of bytes
+ * @retval     p    Memory, free with free() unless x is an arena node
+ * @retval     NULL Error
+ */
+static void *
+xml_alloc(cxobj *x,
+	  size_t len)
+{
+    void *p;
+
+    if (XML_ARENA(x))
+	return clixon_arena_alloc(XML_ARENA(x), len);
+    if ((p = malloc(len)) == NULL)
+	clicon_err(OE_XML, errno, "malloc");
+    return p;
+}
+
+/*! Copy a name or prefix for a node, to its arena if it has one
+ * Names of heap nodes are interned
+ * @param[in]  x    XML node
+ * @param[in]  str  String
+ * @retval     s    Copy, free with xml_strfree
+ * @retval     NULL Error
+ */
+static char *
+xml_strdup(cxobj *x,
+	   char  *str)
+{
+    if (XML_ARENA(x))
+	return clixon_arena_strdup(XML_ARENA(x), str);
+    return xml_intern(str);
+}
+
+/*! Free a name or prefix of a node
+ * @param[in]  x    XML node
+ * @param[in]  str  String returned by xml_strdup
+ */
+static void
+xml_strfree(cxobj *x,
+	    char  *str)
+{
+    if (XML_ARENA(x) == NULL)
+	xml_intern_release(str);
+}
+
+/*! Grow a vector of a node, in its arena if it has one
+ * @param[in]  x     XML node
+ * @param[in]  p     Vector or NULL
+ * @param[in]  len0  Current size of p in bytes
+ * @param[in]  len   New size in bytes
+ * @retval     p     New vector, old p is freed or left in the arena
+ * @retval     NULL  Error, p is unchanged
+ */
+static void *
+xml_realloc(cxobj *x,
+	    void  *p,
+	    size_t len0,
+	    size_t len)
+{
+    void *p1;
+
+    if (XML_ARENA(x))
+	return clixon_arena_grow(XML_ARENA(x), p, len0, len);
+    if ((p1 = realloc(p, len)) == NULL)
+	clicon_err(OE_XML, errno, "realloc");
+    return p1;
+}
+
+/*! Free heap memory of an arena node when its arena is freed
+ * Caches are allocated from the heap also for arena nodes
+ * @param[in]  arg  XML node
+ * @see xml_arena_attach
+ */
+static void
+xml_arena_cleanup(void *arg)
+{
+    cxobj          *x = (cxobj *)arg;
+    struct xml_ext *xe = x->x_ext; /* Arena nodes have an extension */
+    int             i;
+
+    if (x->x_cv){
+	cv_free(x->x_cv);
+	x->x_cv = NULL;
+    }
+    if (x->x_keys){
+	free(x->x_keys);
+	x->x_keys = NULL;
+    }
+    if (x->x_ns_cache){
+	xml_nsctx_free(x->x_ns_cache);
+	x->x_ns_cache = NULL;
+    }
+    for (i=0; i<xe->xe_defaults_len; i++)
+	xml_free(xe->xe_defaults[i]);
+    if (xe->xe_defaults){
+	free(xe->xe_defaults);
+	xe->xe_defaults = NULL;
+    }
+    xe->xe_defaults_len = 0;
+    if (xe->xe_index){
+	xml_index_free(xe->xe_index);
+	xe->xe_index = NULL;
+    }
+}
+
+/*! Prepare an arena node for heap memory attached to it
+ * Call before setting a cache of x. Registers xml_arena_cleanup unless a cache
+ * is already set, in which case it has already been registered.
+ * @param[in]  x   XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+xml_arena_attach(cxobj *x)
+{
+    if (XML_ARENA(x) == NULL ||
+	x->x_cv || x->x_keys || x->x_ns_cache ||
+	x->x_ext->xe_defaults || x->x_ext->xe_index)
+	return 0;
+    return clixon_arena_cleanup(XML_ARENA(x), xml_arena_cleanup, x);
+}
+
+/*! Free a heap child of an arena node when the arena is freed
+ * The child is freed only if it is still a child of the node
+ * @param[in]  arg  struct xml_arena_child
+ * @see xml_parent_set
+ */
+static void
+xml_arena_child(void *arg)
+{
+    struct xml_arena_child *xac = (struct xml_arena_child *)arg;
+    cxobj                  *xp = xac->xac_parent;
+    int                     i;
+
+    for (i=0; i<xp->x_childvec_len; i++)
+	if (xp->x_childvec[i] == xac->xac_child){
+	    xp->x_childvec[i] = NULL;
+	    xml_free(xac->xac_child);
+	    break;
+	}
+}
+
+/*! Keep arena reference of a node consistent with its parent
+ * A node allocated from an arena holds a reference of the arena if it is a
+ * top node, or if no ancestor is in the same arena. The arena is then freed
+ * when the last such node is freed.
+ * @param[in]  x       XML node
+ * @param[in]  parent  New parent of x, or NULL
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xml_arena_ref(cxobj *x,
+	      cxobj *parent)
+{
+    cxobj                  *xp;
+    struct xml_arena_child *xac;
+    int                     ref;
+
+    if (XML_ARENA(x) == NULL){
+	/* Heap child of arena node, freed with the arena */
+	if (parent && XML_ARENA(parent)){
+	    if ((xac = clixon_arena_alloc(XML_ARENA(parent), sizeof(*xac))) == NULL)
+		return -1;
+	    xac->xac_parent = parent;
+	    xac->xac_child = x;
+	    if (clixon_arena_cleanup(XML_ARENA(parent), xml_arena_child, xac) < 0)
+		return -1;
+	}
+	return 0;
+    }
+    for (xp = parent; xp; xp = xp->x_up)
+	if (XML_ARENA(xp) == XML_ARENA(x))
+	    break;
+    ref = (xp == NULL);
+    if (ref && (x->x_flags & XML_FLAG_ARENA) == 0){
+	clixon_arena_ref(XML_ARENA(x));
+	x->x_flags |= XML_FLAG_ARENA;
+    }
+    else if (!ref && (x->x_flags & XML_FLAG_ARENA)){
+	x->x_flags &= ~XML_FLAG_ARENA;
+	clixon_arena_unref(XML_ARENA(x));
+    }
+    return 0;
+}
+
 /*! Translate from xml type in enum form to string keyword
  * @param[in] type  Xml type
  * @retval    str   String keyword
@@ -184,17 +568,35 @@ int
 xml_name_set(cxobj *xn, 
 	     char  *name)
 {
-    if (xn->x_name){
-	free(xn->x_name);
-	xn->x_name = NULL;
+    int   retval = -1;
+    char *old = xn->x_name;
+    int   relink = 0;
+
+    /* Element-name index is keyed by name, see xml_index_link */
+    if (old && xn->x_up){
+	if (xml_index_unlink(xn) < 0)
+	    goto done;
+	relink++;
     }
+    /* Copy before releasing old, name may be the old name */
     if (name){
-	if ((xn->x_name = strdup(name)) == NULL){
-	    clicon_err(OE_XML, errno, "strdup");
-	    return -1;
+	if ((xn->x_name = xml_strdup(xn, name)) == NULL){
+	    xn->x_name = old;
+	    goto done;
 	}
     }
-    return 0;
+    else
+	xn->x_name = NULL;
+    if (old){
+	xml_strfree(xn, old);
+	if (xn->x_up) /* May rename a key leaf */
+	    xml_keys_reset(xn->x_up);
+    }
+    retval = 0;
+ done:
+    if (relink && xml_index_link(xn) < 0)
+	retval = -1;
+    return retval;
 }
 
 /*! Get prefix of xnode
@@ -217,16 +619,18 @@ int
 xml_prefix_set(cxobj *xn, 
 	       char  *localname)
 {
-    if (xn->x_prefix){
-	free(xn->x_prefix);
-	xn->x_prefix = NULL;
-    }
+    char *old = xn->x_prefix;
+
     if (localname){
-	if ((xn->x_prefix = strdup(localname)) == NULL){
-	    clicon_err(OE_XML, errno, "strdup");
+	if ((xn->x_prefix = xml_strdup(xn, localname)) == NULL){
+	    xn->x_prefix = old;
 	    return -1;
 	}
     }
+    else
+	xn->x_prefix = NULL;
+    if (old)
+	xml_strfree(xn, old);
     return 0;
 }
 
@@ -291,6 +695,8 @@ nscache_set(cxobj *x,
     int     retval = -1;
 
     if (x->x_ns_cache == NULL){
+	if (xml_arena_attach(x) < 0)
+	    goto done;
 	if ((x->x_ns_cache = xml_nsctx_init(prefix, namespace)) == NULL)
 	    goto done;
     }
@@ -318,9 +724,11 @@ nscache_replace(cxobj *x,
 	xml_nsctx_free(x->x_ns_cache);
 	x->x_ns_cache = NULL;
     }
+    if (nsc && xml_arena_attach(x) < 0)
+	goto done;
     x->x_ns_cache = nsc;
     retval = 0;
-    // done:
+ done:
     return retval;
 }
 
@@ -570,12 +978,22 @@ xml_parent(cxobj *xn)
  * @param[in]  xn      xml node
  * @param[in]  parent  pointer to new parent xml node
  * @retval     0       OK
+ * @retval    -1       Error
+ * Indexes of the old and new tree are updated, see xml_index_link
+ * Arena references are updated, see xml_arena_ref
  */
 int
 xml_parent_set(cxobj *xn, 
 	       cxobj *parent)
 {
+    if (xn->x_up && xml_index_unlink(xn) < 0)
+	return -1;
     xn->x_up = parent;
+    if ((XML_ARENA(xn) || (parent && XML_ARENA(parent))) &&
+	xml_arena_ref(xn, parent) < 0)
+	return -1;
+    if (parent && xml_index_link(xn) < 0)
+	return -1;
     return 0;
 }
 
@@ -598,7 +1016,7 @@ int
 xml_flag_set(cxobj   *xn, 
 	     uint16_t flag)
 {
-    xn->x_flags |= flag;
+    xn->x_flags |= flag & ~XML_FLAG_ARENA;
     return 0;
 }
 
@@ -610,7 +1028,69 @@ int
 xml_flag_reset(cxobj   *xn, 
 	       uint16_t flag)
 {
-    xn->x_flags &= ~flag;
+    xn->x_flags &= ~(flag & ~XML_FLAG_ARENA);
+    return 0;
+}
+
+/*! Check if the children of an XML node are known to be sorted as by xml_sort
+ *
+ * Set by xml_sort and by sorted insertion, and cleared when children are
+ * appended, inserted at a position or replaced.
+ * @param[in]  xn    XML node
+ * @retval     1     Children are sorted
+ * @retval     0     Children may not be sorted
+ */
+int
+xml_sorted(cxobj *xn)
+{
+    return (xn->x_flags & XML_FLAG_SORTED) != 0;
+}
+
+/*! Mark that the children of an XML node are, or may not be, sorted
+ * @param[in]  xn      XML node
+ * @param[in]  sorted  1: children are sorted as by xml_sort, 0: unknown
+ * @see xml_sorted
+ */
+int
+xml_sorted_set(cxobj *xn,
+	       int    sorted)
+{
+    if (sorted)
+	xn->x_flags |= XML_FLAG_SORTED;
+    else
+	xn->x_flags &= ~XML_FLAG_SORTED;
+    return 0;
+}
+
+/*! Check if an XML element is in a tree with indexes
+ *
+ * Set on all elements of a tree when an index is enabled, and on elements
+ * added to the tree thereafter. Lets modifications of trees without
+ * indexes skip looking for an index at the top of the tree.
+ * @param[in]  xn    XML node
+ * @retval     1     Node is in an indexed tree
+ * @retval     0     Node is not in an indexed tree
+ * @see xml_index_link
+ */
+int
+xml_indexed(cxobj *xn)
+{
+    return (xn->x_flags & XML_FLAG_INDEXED) != 0;
+}
+
+/*! Mark that an XML element is, or is not, in a tree with indexes
+ * @param[in]  xn       XML node
+ * @param[in]  indexed  1: node is in an indexed tree, 0: not
+ * @see xml_indexed
+ */
+int
+xml_indexed_set(cxobj *xn,
+		int    indexed)
+{
+    if (indexed)
+	xn->x_flags |= XML_FLAG_INDEXED;
+    else
+	xn->x_flags &= ~XML_FLAG_INDEXED;
     return 0;
 }
 
@@ -621,7 +1101,48 @@ xml_flag_reset(cxobj   *xn,
 char*
 xml_value(cxobj *xn)
 {
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    if (xn->x_flags & XML_FLAG_VINLINE)
+	return xn->x_value.xv_inline;
+    return xn->x_value.xv_alloc.xv_ptr;
+}
+
+/*! Make room for an allocated value of a given length in an xml node
+ * The value is copied from inline storage if needed
+ * @param[in]  xn    xml node
+ * @param[in]  len   Length of value, excluding null-termination
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_value_reserve(cxobj *xn,
+		  int    len)
+{
+    int   max;
+    int   len0;
+    char *v;
+
+    if (xn->x_flags & XML_FLAG_VINLINE){
+	len0 = strlen(xn->x_value.xv_inline);
+	if ((v = xml_alloc(xn, len+1)) == NULL)
+	    return -1;
+	memcpy(v, xn->x_value.xv_inline, len0+1);
+	xn->x_flags &= ~XML_FLAG_VINLINE;
+	xn->x_value.xv_alloc.xv_ptr = v;
+	xn->x_value.xv_alloc.xv_len = len0;
+	xn->x_value.xv_alloc.xv_max = len+1;
+	return 0;
+    }
+    if (len < xn->x_value.xv_alloc.xv_max)
+	return 0;
+    max = xn->x_value.xv_alloc.xv_max ? 2*xn->x_value.xv_alloc.xv_max : len+1;
+    if (max <= len)
+	max = len+1;
+    if ((v = xml_realloc(xn, xn->x_value.xv_alloc.xv_ptr,
+			 xn->x_value.xv_alloc.xv_max, max)) == NULL)
+	return -1;
+    xn->x_value.xv_alloc.xv_ptr = v;
+    xn->x_value.xv_alloc.xv_max = max;
+    return 0;
 }
 
 /*! Set value of xml node, value is copied
@@ -634,17 +1155,30 @@ int
 xml_value_set(cxobj *xn, 
 	      char  *val)
 {
-    int retval = -1;
-    
-    if (xn->x_value_cb == NULL){
-	if ((xn->x_value_cb = cbuf_new()) == NULL){
-	    clicon_err(OE_XML, errno, "cbuf_new");
+    int   retval = -1;
+    int   len;
+    char *old = NULL;
+
+    if (val == NULL)
+	val = "";
+    len = strlen(val);
+    if (len < XML_VALUE_INLINE){
+	/* val may point into the old value, free it after copy */
+	if ((xn->x_flags & XML_FLAG_VINLINE) == 0 && XML_ARENA(xn) == NULL)
+	    old = xn->x_value.xv_alloc.xv_ptr;
+	memmove(xn->x_value.xv_inline, val, len+1);
+	xn->x_flags |= XML_FLAG_VINLINE;
+	if (old)
+	    free(old);
+    }
+    else {
+	if (xml_value_reserve(xn, len) < 0)
 	    goto done;
-	}
+	memmove(xn->x_value.xv_alloc.xv_ptr, val, len+1);
+	xn->x_value.xv_alloc.xv_len = len;
     }
-    else
-	cbuf_reset(xn->x_value_cb);
-    cprintf(xn->x_value_cb, "%s", val);
+    if (xn->x_up && xml_index_link(xn) < 0)
+	goto done;
     retval = 0;
  done:
     return retval;
@@ -660,18 +1194,32 @@ int
 xml_value_append(cxobj *xn, 
 		 char  *val)
 {
-    int retval = -1;
-    
-    if (xn->x_value_cb == NULL){
-	if ((xn->x_value_cb = cbuf_new()) == NULL){
-	    clicon_err(OE_XML, errno, "cbuf_new");
+    int   retval = -1;
+    int   len;
+    int   len0;
+    char *v;
+
+    if ((v = xml_value(xn)) == NULL)
+	return xml_value_set(xn, val);
+    if (val == NULL)
+	val = "";
+    len = strlen(val);
+    if (xn->x_flags & XML_FLAG_VINLINE){
+	len0 = strlen(v);
+	if (len0 + len < XML_VALUE_INLINE)
+	    memmove(v + len0, val, len+1);
+	else if (xml_value_reserve(xn, len0 + len) < 0)
 	    goto done;
-	}
     }
-    if (cprintf(xn->x_value_cb, "%s", val) < 0){
-	clicon_err(OE_XML, errno, "cprintf");
-	goto done;
+    if ((xn->x_flags & XML_FLAG_VINLINE) == 0){
+	len0 = xn->x_value.xv_alloc.xv_len;
+	if (xml_value_reserve(xn, len0 + len) < 0)
+	    goto done;
+	memcpy(xn->x_value.xv_alloc.xv_ptr + len0, val, len+1);
+	xn->x_value.xv_alloc.xv_len += len;
     }
+    if (xn->x_up && xml_index_link(xn) < 0)
+	goto done;
     retval = 0;
  done:
     return retval;
@@ -804,8 +1352,12 @@ xml_child_i_set(cxobj *xt,
 		int    i, 
 		cxobj *xc)
 {
-    if (i < xt->x_childvec_len)
+    if (i < xt->x_childvec_len){
 	xt->x_childvec[i] = xc;
+	xt->x_flags &= ~XML_FLAG_SORTED;
+	xml_keys_reset(xt);
+	xml_index_modified(xt);
+    }
     return 0;
 }
 
@@ -874,6 +1426,41 @@ xml_child_each(cxobj           *xparent,
     return xn;
 }
 
+/*! Extend child vector of a node with one, the new entry is not set
+ * @param[in]  x   XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+xml_childvec_grow(cxobj *x)
+{
+    int     max = x->x_childvec_max;
+    cxobj **vec;
+
+    if (x->x_childvec_len + 1 > max){
+	if (max == 0){ /* First child is stored inline */
+	    x->x_childvec = &x->x_child;
+	    x->x_childvec_max = 1;
+	}
+	else {
+	    max = max>1?2*max:XML_CHILDVEC_MAX_DEFAULT;
+	    if (x->x_childvec == &x->x_child){
+		if ((vec = xml_alloc(x, max*sizeof(cxobj*))) == NULL)
+		    return -1;
+		vec[0] = x->x_child;
+	    }
+	    else if ((vec = xml_realloc(x, x->x_childvec,
+					x->x_childvec_max*sizeof(cxobj*),
+					max*sizeof(cxobj*))) == NULL)
+		return -1;
+	    x->x_childvec = vec;
+	    x->x_childvec_max = max;
+	}
+    }
+    x->x_childvec_len++;
+    return 0;
+}
+
 /*! Extend child vector with one and insert xml node there
  * @note does not do anything with child, you may need to set its parent, etc
  */
@@ -881,15 +1468,11 @@ static int
 xml_child_append(cxobj *x, 
 		 cxobj *xc)
 {
-    x->x_childvec_len++;
-    if (x->x_childvec_len > x->x_childvec_max)
-	x->x_childvec_max = x->x_childvec_max?2*x->x_childvec_max:XML_CHILDVEC_MAX_DEFAULT;
-    x->x_childvec = realloc(x->x_childvec, x->x_childvec_max*sizeof(cxobj*));
-    if (x->x_childvec == NULL){
-	clicon_err(OE_XML, errno, "realloc");
+    if (xml_childvec_grow(x) < 0)
 	return -1;
-    }
     x->x_childvec[x->x_childvec_len-1] = xc;
+    x->x_flags &= ~XML_FLAG_SORTED;
+    xml_keys_reset(x);
     return 0;
 }
 
@@ -905,17 +1488,13 @@ xml_child_insert_pos(cxobj *xp,
 {
     size_t size;
    
-    xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max)
-	xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:XML_CHILDVEC_MAX_DEFAULT;
-    xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-    if (xp->x_childvec == NULL){
-	clicon_err(OE_XML, errno, "realloc");
+    if (xml_childvec_grow(xp) < 0)
 	return -1;
-    }
     size = (xml_child_nr(xp) - i - 1)*sizeof(cxobj *);
     memmove(&xp->x_childvec[i+1], &xp->x_childvec[i], size);
     xp->x_childvec[i] = xc;
+    xp->x_flags &= ~XML_FLAG_SORTED;
+    xml_keys_reset(xp);
     return 0;
 }
 
@@ -932,12 +1511,16 @@ xml_childvec_set(cxobj *x,
 {
     x->x_childvec_len = len;
     x->x_childvec_max = len;
-    if (x->x_childvec)
+    x->x_flags &= ~XML_FLAG_SORTED;
+    xml_keys_reset(x);
+    xml_index_modified(x);
+    if (x->x_childvec && x->x_childvec != &x->x_child && XML_ARENA(x) == NULL)
 	free(x->x_childvec);
-    if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
-	clicon_err(OE_XML, errno, "calloc");
+    if (len <= 1)
+	x->x_childvec = &x->x_child;
+    else if ((x->x_childvec = xml_alloc(x, len*sizeof(cxobj*))) == NULL)
 	return -1;
-    }
+    memset(x->x_childvec, 0, len*sizeof(cxobj*));
     return 0;
 }
 
@@ -949,6 +1532,42 @@ xml_childvec_get(cxobj *x)
     return x->x_childvec;
 }
 
+/*! Allocate a node and its extension from an arena
+ * @param[in]  xa   Arena
+ * @retval     x    XML node, with no name
+ * @retval     NULL Error
+ */
+static cxobj *
+xml_new_arena_node(clixon_arena *xa)
+{
+    cxobj *x;
+
+    if ((x = clixon_arena_alloc(xa, sizeof(cxobj) + sizeof(struct xml_ext))) == NULL)
+	return NULL;
+    memset(x, 0, sizeof(cxobj) + sizeof(struct xml_ext));
+    x->x_ext = (struct xml_ext *)(x + 1);
+    x->x_ext->xe_arena = xa;
+    return x;
+}
+
+/*! Get extension of a node, allocate it if needed
+ * @param[in]  x    XML node
+ * @retval     xe   Extension
+ * @retval     NULL Error
+ */
+static struct xml_ext *
+xml_ext(cxobj *x)
+{
+    if (x->x_ext == NULL){
+	if ((x->x_ext = malloc(sizeof(struct xml_ext))) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return NULL;
+	}
+	memset(x->x_ext, 0, sizeof(struct xml_ext));
+    }
+    return x->x_ext;
+}
+
 /*! Create new xml node given a name and parent. Free with xml_free().
  *
  * @param[in]  name      Name of XML node
@@ -976,11 +1595,17 @@ xml_new(char      *name,
 {
     cxobj *x;
     
-    if ((x = malloc(sizeof(cxobj))) == NULL){
-	clicon_err(OE_XML, errno, "malloc");
-	return NULL;
+    if (xp && XML_ARENA(xp)){
+	if ((x = xml_new_arena_node(XML_ARENA(xp))) == NULL)
+	    return NULL;
+    }
+    else{
+	if ((x = malloc(sizeof(cxobj))) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return NULL;
+	}
+	memset(x, 0, sizeof(cxobj));
     }
-    memset(x, 0, sizeof(cxobj));
     if ((xml_name_set(x, name)) < 0)
 	return NULL;
     if (xp){
@@ -993,6 +1618,68 @@ xml_new(char      *name,
     return x;
 }
 
+/*! Create new top xml node allocated from a new arena. Free with xml_free().
+ *
+ * Nodes created under an arena node with xml_new (eg by the XML parser) are
+ * allocated from the same arena, as are their names, values and child vectors.
+ * Freeing a single node of the tree does not free any memory: the arena is
+ * freed when the top node and all nodes removed from the tree are freed.
+ * Use for trees that are parsed, read and discarded, eg requests and replies.
+ * @param[in]  name      Name of XML node
+ * @param[in]  spec      Yang statement of this XML or NULL.
+ * @retval     xml       Created xml object if successful. Free with xml_free()
+ * @retval     NULL      Error and clicon_err() called
+ * @code
+ *   cxobj *xt;
+ *   if ((xt = xml_new_arena("top", NULL)) == NULL)
+ *     err;
+ *   if (xml_parse_string(str, yspec, &xt) < 0)
+ *     err;
+ *   ...
+ *   xml_free(xt);
+ * @endcode
+ * @note Nodes of the tree should not be moved into a long-lived tree, such as
+ *       a datastore cache, since that keeps the whole arena allocated. Copy
+ *       them with xml_copy or xml_dup instead.
+ * @note A heap node inserted in the tree is freed with the arena. An arena
+ *       node inserted under such a heap node is not protected from the arena
+ *       being freed if the heap node is removed from the tree.
+ * @see xml_new
+ */
+cxobj *
+xml_new_arena(char      *name, 
+	      yang_stmt *spec)
+{
+    clixon_arena *xa;
+    cxobj        *x;
+
+    if ((xa = clixon_arena_new()) == NULL)
+	return NULL;
+    if ((x = xml_new_arena_node(xa)) == NULL){
+	clixon_arena_free(xa);
+	return NULL;
+    }
+    x->x_flags = XML_FLAG_ARENA; /* Holds the initial reference */
+    if ((xml_name_set(x, name)) < 0){
+	clixon_arena_free(xa);
+	return NULL;
+    }
+    x->x_spec = spec; /* Can be NULL */
+    return x;
+}
+
+/*! Return arena of xml node
+ * @param[in]  x    XML node
+ * @retval     xa   Arena the node is allocated from
+ * @retval     NULL Node is allocated from the heap
+ * @see xml_new_arena
+ */
+clixon_arena *
+xml_arena_get(cxobj *x)
+{
+    return XML_ARENA(x);
+}
+
 /*! Return yang spec of node. 
  * Not necessarily set. Either has not been set yet (by xml_spec_set( or anyxml.
  */
@@ -1006,7 +1693,14 @@ int
 xml_spec_set(cxobj     *x, 
 	     yang_stmt *spec)
 {
+    if (x->x_spec == spec)
+	return 0;
+    if (x->x_up && xml_index_unlink(x) < 0)
+	return -1;
     x->x_spec = spec;
+    xml_keys_reset(x);
+    if (x->x_up && xml_index_link(x) < 0)
+	return -1;
     return 0;
 }
 
@@ -1022,6 +1716,36 @@ xml_cv(cxobj *x)
     return x->x_cv;
 }
 
+/*! Return element-name index of xml tree, only set on top node
+ * @param[in]  x   XML node
+ * @see xml_index_enable
+ */
+struct xml_index *
+xml_index_get(cxobj *x)
+{
+    return x->x_ext ? x->x_ext->xe_index : NULL;
+}
+
+/*! Set element-name index of xml tree
+ * @param[in]  x   XML node
+ * @param[in]  xi  Index, or NULL
+ */
+int
+xml_index_set(cxobj            *x,
+	      struct xml_index *xi)
+{
+    struct xml_ext *xe;
+
+    if (xi == NULL && x->x_ext == NULL)
+	return 0;
+    if ((xe = xml_ext(x)) == NULL)
+	return -1;
+    if (xi && xml_arena_attach(x) < 0)
+	return -1;
+    xe->xe_index = xi;
+    return 0;
+}
+
 /*! Return (cached) cligen variable value of xml node
  * @param[in]  x   XML node (body and leaf/leaf-list)
  * @param[in]  cv  CLIgen variable containing value of x body
@@ -1032,12 +1756,55 @@ int
 xml_cv_set(cxobj  *x, 
 	   cg_var *cv)
 {
-    if (x->x_cv)
+    if (x->x_cv){
 	cv_free(x->x_cv);
+	/* The old value may be referenced from a list entry key cache */
+	if (x->x_up)
+	    xml_keys_reset(x->x_up);
+	x->x_cv = NULL;
+    }
+    if (cv && xml_arena_attach(x) < 0)
+	return -1;
     x->x_cv = cv;
     return 0;
 }
 
+/*! Return cached key values of a list entry
+ * @param[in]  x    XML list entry
+ * @retval     keys Vector of key values in yang key order, or NULL if not set
+ * The vector has the same length as the key names of the list (yang_cvec_get)
+ * and a NULL entry for a missing key. The values are borrowed from the x_cv
+ * cache of the key bodies, and the vector is invalidated when the children
+ * of the list entry or of its key leafs change.
+ * @see xml_keys_set
+ * @see xml_cmp
+ */
+cg_var **
+xml_keys(cxobj *x)
+{
+    return x->x_keys;
+}
+
+/*! Set cached key values of a list entry
+ * @param[in]  x     XML list entry
+ * @param[in]  keys  Malloced vector of key values, consumed by the xml node
+ * @retval     0     OK
+ * @see xml_keys
+ */
+int
+xml_keys_set(cxobj   *x, 
+	     cg_var **keys)
+{
+    if (x->x_keys){
+	free(x->x_keys);
+	x->x_keys = NULL;
+    }
+    if (keys && xml_arena_attach(x) < 0)
+	return -1;
+    x->x_keys = keys;
+    return 0;
+}
+
 /*! Find an XML node matching name among a parent's children.
  *
  * Get first XML node directly under x_up in the xml hierarchy with
@@ -1194,11 +1961,15 @@ xml_purge(cxobj *xc)
 	    if (xml_child_i(xp, i) == xc)
 		break;
 	/* Remove xc from parent */
-	if (i < xml_child_nr(xp))
+	if (i < xml_child_nr(xp)){
 	    if (xml_child_rm(xp, i) < 0)
 		goto done;
+	}
+	else if (xml_flag(xc, XML_FLAG_DEFAULT))
+	    goto ok; /* Virtual default leaf owned by xp, see xml_default_child */
     }
     xml_free(xc);	    
+ ok:
     retval = 0;
  done:
     return retval; 
@@ -1228,6 +1999,7 @@ xml_child_rm(cxobj *xp,
     xp->x_childvec[i] = NULL;
     xml_parent_set(xc, NULL);
     xp->x_childvec_len--;
+    xml_keys_reset(xp);
     /* shift up, note same index i used but ok since we break */
     for (; i<xp->x_childvec_len; i++)
 	xp->x_childvec[i] = xp->x_childvec[i+1];
@@ -1588,6 +2360,146 @@ xml_find_body_obj(cxobj *xt,
     return x;
 }
 
+/*! Check if yang node is a data node whose children may have default values
+ * @see xml_default
+ */
+static int
+xml_default_parent(yang_stmt *ys)
+{
+    enum rfc_6020 keyw;
+
+    if (ys == NULL)
+	return 0;
+    keyw = yang_keyword_get(ys);
+    return keyw == Y_CONTAINER || keyw == Y_LIST || keyw == Y_INPUT;
+}
+
+/*! Check if yang node is a config leaf with a default value
+ * State data is returned as is by plugins and does not get default values
+ */
+static int
+xml_default_yleaf(yang_stmt *y)
+{
+    cg_var    *cv;
+    yang_stmt *yp;
+
+    if (yang_keyword_get(y) != Y_LEAF)
+	return 0;
+    if ((cv = yang_cv_get(y)) == NULL)
+	return 0;
+    if (cv_flag(cv, V_UNSET))
+	return 0;
+    for (yp = y; yp && yang_keyword_get(yp) != Y_MODULE; yp = yang_parent_get(yp))
+	if (!yang_config(yp))
+	    return 0;
+    return 1;
+}
+
+/*! Find yang leaf with default value of an absent child of an xml node
+ * @param[in]  xp    XML parent node
+ * @param[in]  name  Name of child
+ * @retval     y     Yang leaf with default value, and xp has no child with name
+ * @retval     NULL  No such leaf, or xp has child with name
+ * @see xml_default  which adds the same leafs to the tree
+ */
+yang_stmt *
+xml_default_leaf(cxobj *xp,
+		 char  *name)
+{
+    yang_stmt *ys;
+    yang_stmt *y;
+
+    if (!xml_default_parent(ys = xml_spec(xp)))
+	return NULL;
+    if ((y = yang_find(ys, Y_LEAF, name)) == NULL ||
+	yang_parent_get(y) != ys ||
+	!xml_default_yleaf(y))
+	return NULL;
+    if (xml_find_type(xp, NULL, name, CX_ELMNT) != NULL)
+	return NULL;
+    return y;
+}
+
+/*! Get virtual default leaf of xml node
+ *
+ * The leaf is not inserted in the tree: it is not visible as a child of xp, but
+ * its parent is xp. It is created on first access and cached in xp until xp
+ * is freed. Used in XPath evaluation so that default values need not be added
+ * to the tree.
+ * @param[in]  xp    XML parent node
+ * @param[in]  y     Yang leaf with default, @see xml_default_leaf
+ * @param[out] xcp   Virtual leaf, do not free or insert in a tree
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xml_default_child(cxobj     *xp,
+		  yang_stmt *y,
+		  cxobj    **xcp)
+{
+    int    retval = -1;
+    int    i;
+    cxobj *xc = NULL;
+    cxobj *xb;
+    cxobj **vec;
+    char  *namespace;
+    char  *prefix = NULL;
+    char  *str = NULL;
+    int    ret;
+    struct xml_ext *xe;
+
+    if ((xe = xp->x_ext) != NULL)
+	for (i=0; i<xe->xe_defaults_len; i++)
+	    if (xml_spec(xe->xe_defaults[i]) == y){
+		*xcp = xe->xe_defaults[i];
+		goto ok;
+	    }
+    if ((xc = xml_new(yang_argument_get(y), NULL, y)) == NULL)
+	goto done;
+    xml_flag_set(xc, XML_FLAG_DEFAULT);
+    if ((namespace = yang_find_mynamespace(y)) != NULL){
+	if ((ret = xml2prefix(xp, namespace, &prefix)) < 0)
+	    goto done;
+	if (ret == 0){
+	    if (xmlns_set(xc, NULL, namespace) < 0)
+		goto done;
+	}
+	else if (prefix && xml_prefix_set(xc, prefix) < 0)
+	    goto done;
+    }
+    if ((xb = xml_new("body", xc, NULL)) == NULL)
+	goto done;
+    xml_type_set(xb, CX_BODY);
+    if ((str = cv2str_dup(yang_cv_get(y))) == NULL){
+	clicon_err(OE_UNIX, errno, "cv2str_dup");
+	goto done;
+    }
+    if (xml_value_set(xb, str) < 0)
+	goto done;
+    if ((xe = xml_ext(xp)) == NULL)
+	goto done;
+    if (xe->xe_defaults == NULL && xml_arena_attach(xp) < 0)
+	goto done;
+    if ((vec = realloc(xe->xe_defaults, (xe->xe_defaults_len+1)*sizeof(cxobj*))) == NULL){
+	clicon_err(OE_XML, errno, "realloc");
+	goto done;
+    }
+    xe->xe_defaults = vec;
+    xe->xe_defaults[xe->xe_defaults_len++] = xc;
+    /* Set parent last and without xml_parent_set, a virtual leaf is not indexed */
+    xc->x_up = xp;
+    *xcp = xc;
+    xc = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (str)
+	free(str);
+    if (xc)
+	xml_free(xc);
+    return retval;
+}
+
 /*! Free an xl sub-tree recursively, but do not remove it from parent
  * @param[in]  x  the xml tree to be freed.
  * @see xml_purge where x is also removed from parent
@@ -1597,29 +2509,118 @@ xml_free(cxobj *x)
 {
     int i;
     cxobj *xc;
+    struct xml_ext *xe;
 
+    if (XML_ARENA(x)){
+	/* Freed with the arena when there are no more references */
+	if (x->x_flags & XML_FLAG_ARENA){
+	    x->x_flags &= ~XML_FLAG_ARENA;
+	    clixon_arena_unref(XML_ARENA(x));
+	}
+	return 0;
+    }
     if (x->x_name)
-	free(x->x_name);
-    if (x->x_value_cb)
-	cbuf_free(x->x_value_cb);  
+	xml_intern_release(x->x_name);
+    if ((x->x_flags & XML_FLAG_VINLINE) == 0 && x->x_value.xv_alloc.xv_ptr)
+	free(x->x_value.xv_alloc.xv_ptr);
     if (x->x_prefix)
-	free(x->x_prefix);
+	xml_intern_release(x->x_prefix);
     for (i=0; i<x->x_childvec_len; i++){
 	if ((xc = x->x_childvec[i]) != NULL){
 	    xml_free(xc);
 	    x->x_childvec[i] = NULL;
 	}
     }
-    if (x->x_childvec)
+    if (x->x_childvec && x->x_childvec != &x->x_child)
 	free(x->x_childvec);
     if (x->x_cv)
 	cv_free(x->x_cv);
+    if (x->x_keys)
+	free(x->x_keys);
     if (x->x_ns_cache)
 	xml_nsctx_free(x->x_ns_cache);
+    if ((xe = x->x_ext) != NULL){
+	for (i=0; i<xe->xe_defaults_len; i++)
+	    xml_free(xe->xe_defaults[i]);
+	if (xe->xe_defaults)
+	    free(xe->xe_defaults);
+	if (xe->xe_index)
+	    xml_index_free(xe->xe_index);
+	free(xe);
+    }
     free(x);
     return 0;
 }
 
+/*! Add memory usage of an xml sub-tree, see xml_stats
+ */
+static int
+xml_stats_one(cxobj    *x,
+	      uint64_t *nrp,
+	      size_t   *szp)
+{
+    int i;
+
+    (*nrp)++;
+    *szp += sizeof(struct xml);
+    if (x->x_ext)
+	*szp += sizeof(struct xml_ext);
+    if (x->x_childvec && x->x_childvec != &x->x_child)
+	*szp += x->x_childvec_max*sizeof(cxobj*);
+    if ((x->x_flags & XML_FLAG_VINLINE) == 0 && x->x_value.xv_alloc.xv_ptr)
+	*szp += x->x_value.xv_alloc.xv_max;
+    for (i=0; i<x->x_childvec_len; i++)
+	if (x->x_childvec[i] != NULL)
+	    xml_stats_one(x->x_childvec[i], nrp, szp);
+    return 0;
+}
+
+/*! Get number of nodes and memory usage of an xml tree
+ * Memory of nodes, child vectors and values is counted. Names and prefixes
+ * are interned and shared by all trees, see xml_stats_global. Caches, such as
+ * cligen values and namespace contexts, are not included.
+ * @param[in]   xt    XML tree
+ * @param[out]  nrp   Number of nodes, including attributes and bodies
+ * @param[out]  szp   Bytes allocated by the nodes
+ * @retval      0     OK
+ * @code
+ *   uint64_t nr;
+ *   size_t   sz;
+ *   xml_stats(xt, &nr, &sz);
+ *   printf("%zu bytes per node\n", nr?sz/nr:0);
+ * @endcode
+ */
+int
+xml_stats(cxobj    *xt,
+	  uint64_t *nrp,
+	  size_t   *szp)
+{
+    *nrp = 0;
+    *szp = 0;
+    return xml_stats_one(xt, nrp, szp);
+}
+
+/*! Get number and memory usage of interned names and prefixes of all trees
+ * @param[out]  nrp   Number of distinct names and prefixes
+ * @param[out]  szp   Bytes allocated by the names, prefixes and hash table
+ * @retval      0     OK
+ * @see xml_stats
+ */
+int
+xml_stats_global(uint64_t *nrp,
+		 size_t   *szp)
+{
+    struct xml_intern *xs;
+    uint32_t           i;
+
+    *nrp = _xml_intern_nr;
+    *szp = _xml_intern_size*sizeof(struct xml_intern *);
+    for (i=0; i<_xml_intern_size; i++)
+	for (xs = _xml_intern_vec[i]; xs; xs = xs->xs_next)
+	    *szp += sizeof(*xs) + strlen(xs->xs_str) + 1;
+    return 0;
+}
+
 /*------------------------------------------------------------------------
  * XML printing functions. Output a parse tree to file, string cligen buf
  *------------------------------------------------------------------------*/
@@ -1746,6 +2747,109 @@ xml_print(FILE  *f,
     return clicon_xml2file(f, xn, 0, 1);
 }
 
+/*! Get next yang leaf with default value that is absent in xml node
+ * @param[in]  x     XML node
+ * @param[in]  ys    Yang spec of x
+ * @param[in]  yprev Previous leaf, or NULL to start from first
+ * @retval     y     Yang leaf
+ * @retval     NULL  No more leafs
+ */
+static yang_stmt *
+xml_default_next(cxobj     *x,
+		 yang_stmt *ys,
+		 yang_stmt *yprev)
+{
+    yang_stmt *y = yprev;
+
+    while ((y = yn_each(ys, y)) != NULL){
+	if (!xml_default_yleaf(y))
+	    continue;
+	if (xml_find_type(x, NULL, yang_argument_get(y), CX_ELMNT) == NULL)
+	    break;
+    }
+    return y;
+}
+
+/*! Check if xml node is a leaf set to its yang default value
+ * Used when printing in with-defaults trim mode
+ */
+static int
+xml_default_trim(cxobj *x)
+{
+    yang_stmt *y;
+    char      *body;
+    char      *str;
+    int        equal;
+
+    if ((y = xml_spec(x)) == NULL || !xml_default_yleaf(y))
+	return 0;
+    if (!xml_default_parent(yang_parent_get(y)))
+	return 0;
+    if ((body = xml_body(x)) == NULL)
+	return 0;
+    if ((str = cv2str_dup(yang_cv_get(y))) == NULL)
+	return 0;
+    equal = strcmp(body, str) == 0;
+    free(str);
+    return equal;
+}
+
+/*! Print an absent leaf with default value, without adding it to the tree
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     xp          Parent of leaf
+ * @param[in]     y           Yang leaf with default value
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     tagged      Add RFC 6243 default attribute (report-all-tagged)
+ */
+static int
+xml2cbuf_default(cbuf      *cb,
+		 cxobj     *xp,
+		 yang_stmt *y,
+		 int        level,
+		 int        prettyprint,
+		 int        tagged)
+{
+    int    retval = -1;
+    char  *namespace;
+    char  *prefix = NULL;
+    char  *str = NULL;
+    char  *encstr = NULL;
+    int    ret = 1;
+
+    if ((namespace = yang_find_mynamespace(y)) != NULL)
+	if ((ret = xml2prefix(xp, namespace, &prefix)) < 0)
+	    goto done;
+    cprintf(cb, "%*s<", prettyprint?(level*XML_INDENT):0, "");
+    if (prefix)
+	cprintf(cb, "%s:", prefix);
+    cprintf(cb, "%s", yang_argument_get(y));
+    if (ret == 0)
+	cprintf(cb, " xmlns=\"%s\"", namespace);
+    if (tagged)
+	cprintf(cb, " xmlns:%s=\"%s\" %s:default=\"true\"",
+		NETCONF_DEFAULT_PREFIX, NETCONF_DEFAULT_NAMESPACE, NETCONF_DEFAULT_PREFIX);
+    if ((str = cv2str_dup(yang_cv_get(y))) == NULL){
+	clicon_err(OE_UNIX, errno, "cv2str_dup");
+	goto done;
+    }
+    if (xml_chardata_encode(&encstr, "%s", str) < 0)
+	goto done;
+    cprintf(cb, ">%s</", encstr);
+    if (prefix)
+	cprintf(cb, "%s:", prefix);
+    cprintf(cb, "%s>", yang_argument_get(y));
+    if (prettyprint)
+	cprintf(cb, "\n");
+    retval = 0;
+ done:
+    if (str)
+	free(str);
+    if (encstr)
+	free(encstr);
+    return retval;
+}
+
 /*! Print an XML tree structure to a cligen buffer and encode chars "<>&"
  *
  * @param[in,out] cb          Cligen buffer to write to
@@ -1763,6 +2867,7 @@ xml_print(FILE  *f,
  * cbuf_free(cb);
  * @endcode
  * @see  clicon_xml2file
+ * @see  clicon_xml2cbuf_wdef  Print with default values
  */
 int
 clicon_xml2cbuf(cbuf   *cb, 
@@ -1771,14 +2876,43 @@ clicon_xml2cbuf(cbuf   *cb,
 		int     prettyprint,
 		int32_t depth)
 {
-    int    retval = -1;
-    cxobj *xc;
-    char  *name;
-    int    hasbody;
-    int    haselement;
-    char  *namespace;
-    char  *encstr = NULL; /* xml encoded string */
-    char  *val;
+    return clicon_xml2cbuf_wdef(cb, x, level, prettyprint, depth, WITHDEFAULTS_EXPLICIT);
+}
+
+/*! Print an XML tree structure to a cligen buffer with RFC6243 with-defaults mode
+ *
+ * Default values are not stored in the tree. In report-all mode absent leafs with
+ * yang default values are printed in yang order among the other children, in
+ * trim mode leafs set to their default value are not printed. In
+ * report-all-tagged mode absent leafs and leafs set to their default value are
+ * printed with the default attribute of RFC 6243 Sec 6.
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     xn          Clicon xml tree
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]     wdef        With-defaults mode
+ * @see  clicon_xml2cbuf  Print tree as is, ie explicit mode
+ */
+int
+clicon_xml2cbuf_wdef(cbuf                  *cb, 
+		     cxobj                 *x, 
+		     int                    level,
+		     int                    prettyprint,
+		     int32_t                depth,
+		     enum withdefaults_type wdef)
+{
+    int        retval = -1;
+    cxobj     *xc;
+    char      *name;
+    int        hasbody;
+    int        haselement;
+    char      *namespace;
+    char      *encstr = NULL; /* xml encoded string */
+    char      *val;
+    yang_stmt *ys = NULL;
+    yang_stmt *yd = NULL;     /* Next absent leaf with default */
+    int        tagged;
     
     if (depth == 0)
 	goto ok;
@@ -1805,23 +2939,34 @@ clicon_xml2cbuf(cbuf   *cb,
 	cprintf(cb, "%s", name);
 	hasbody = 0;
 	haselement = 0;
+	tagged = wdef == WITHDEFAULTS_REPORT_ALL_TAGGED;
+	if ((wdef == WITHDEFAULTS_REPORT_ALL || tagged) && depth != 1 &&
+	    xml_default_parent(xml_spec(x))){
+	    ys = xml_spec(x);
+	    if ((yd = xml_default_next(x, ys, yd)) != NULL)
+		haselement = 1;
+	}
 	xc = NULL;
 	/* print attributes only */
 	while ((xc = xml_child_each(x, xc, -1)) != NULL) 
 	    switch (xc->x_type){
 	    case CX_ATTR:
-		if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, -1) < 0)
+		if (clicon_xml2cbuf_wdef(cb, xc, level+1, prettyprint, -1, wdef) < 0)
 		    goto done;
 		break;
 	    case CX_BODY:
 		hasbody=1;
 		break;
 	    case CX_ELMNT:
-		haselement=1;
+		if (wdef != WITHDEFAULTS_TRIM || !xml_default_trim(xc))
+		    haselement=1;
 		break;
 	    default:
 		break;
 	    }
+	if (tagged && xml_default_trim(x))
+	    cprintf(cb, " xmlns:%s=\"%s\" %s:default=\"true\"",
+		    NETCONF_DEFAULT_PREFIX, NETCONF_DEFAULT_NAMESPACE, NETCONF_DEFAULT_PREFIX);
 	/* Check for special case <a/> instead of <a></a> */
 	if (hasbody==0 && haselement==0) 
 	    cprintf(cb, "/>");
@@ -1830,10 +2975,26 @@ clicon_xml2cbuf(cbuf   *cb,
 	    if (prettyprint && hasbody == 0)
 		cprintf(cb, "\n");
 	    xc = NULL;
-	    while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-		if (xml_type(xc) != CX_ATTR)
-		    if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, depth-1) < 0)
-			goto done;
+	    while ((xc = xml_child_each(x, xc, -1)) != NULL){
+		if (xml_type(xc) == CX_ATTR)
+		    continue;
+		if (xml_type(xc) == CX_ELMNT){
+		    if (wdef == WITHDEFAULTS_TRIM && xml_default_trim(xc))
+			continue;
+		    /* Absent defaults before xc in yang order */
+		    while (yd && xml_spec(xc) &&
+			   yang_order(yd) < yang_order(xml_spec(xc))){
+			if (xml2cbuf_default(cb, x, yd, level+1, prettyprint, tagged) < 0)
+			    goto done;
+			yd = xml_default_next(x, ys, yd);
+		    }
+		}
+		if (clicon_xml2cbuf_wdef(cb, xc, level+1, prettyprint, depth-1, wdef) < 0)
+		    goto done;
+	    }
+	    for (; yd; yd = xml_default_next(x, ys, yd))
+		if (xml2cbuf_default(cb, x, yd, level+1, prettyprint, tagged) < 0)
+		    goto done;
 	    if (prettyprint && hasbody == 0)
 		cprintf(cb, "%*s", level*XML_INDENT, "");
 	    cprintf(cb, "</");
@@ -1854,6 +3015,7 @@ clicon_xml2cbuf(cbuf   *cb,
 	free(encstr);
     return retval;
 }
+
 /*! Print actual xml tree datastructures (not xml), mainly for debugging
  * @param[in,out] cb          Cligen buffer to write to
  * @param[in]     xn          Clicon xml tree
@@ -1899,9 +3061,11 @@ xmltree2cbuf(cbuf  *cb,
 /*! Common internal xml parsing function string to parse-tree
  *
  * Given a string containing XML, parse into existing XML tree and return
- * @param[in]     str   Pointer to string containing XML definition. 
- * @param[in]     yspec Yang specification or NULL
- * @param[in,out] xtop  Top of XML parse tree. Assume created. Holds new tree.
+ * @param[in]     str    Pointer to string containing XML definition. 
+ * @param[in]     buflen If 0, str is copied. Otherwise str is parsed in place,
+ *                       see xml_parse_buffer
+ * @param[in]     yspec  Yang specification or NULL
+ * @param[in,out] xtop   Top of XML parse tree. Assume created. Holds new tree.
  * @see xml_parse_file
  * @see xml_parse_string
  * @see xml_parse_va
@@ -1909,6 +3073,7 @@ xmltree2cbuf(cbuf  *cb,
  */
 static int 
 _xml_parse(const char  *str, 
+	   size_t       buflen,
 	   yang_stmt   *yspec,
 	   cxobj       *xt)
 {
@@ -1922,7 +3087,11 @@ _xml_parse(const char  *str,
 	clicon_err(OE_XML, errno, "Unexpected NULL XML");
 	return -1;	
     }
-    if ((ya.ya_parse_string = strdup(str)) == NULL){
+    if (buflen){
+	ya.ya_parse_string = (char*)str;
+	ya.ya_parse_buflen = buflen;
+    }
+    else if ((ya.ya_parse_string = strdup(str)) == NULL){
 	clicon_err(OE_XML, errno, "strdup");
 	return -1;
     }
@@ -1951,7 +3120,7 @@ _xml_parse(const char  *str,
     retval = 0;
   done:
     clixon_xml_parsel_exit(&ya);
-    if (ya.ya_parse_string != NULL)
+    if (ya.ya_parse_string != NULL && ya.ya_parse_buflen == 0)
 	free(ya.ya_parse_string);
     return retval; 
 }
@@ -2030,7 +3199,7 @@ xml_parse_file(int        fd,
 	    if (*xt == NULL)
 		if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, NULL)) == NULL)
 		    goto done;
-	    if (_xml_parse(ptr, yspec, *xt) < 0)
+	    if (_xml_parse(ptr, 0, yspec, *xt) < 0)
 		goto done;
 	    break;
 	}
@@ -2084,7 +3253,35 @@ xml_parse_string(const char *str,
     if (*xtop == NULL)
 	if ((*xtop = xml_new(XML_TOP_SYMBOL, NULL, NULL)) == NULL)
 	    return -1;
-    return _xml_parse(str, yspec, *xtop);
+    return _xml_parse(str, 0, yspec, *xtop);
+}
+
+/*! Parse XML in a writable buffer in place into a parse-tree, without copying it
+ *
+ * The buffer is used by the XML scanner and its contents is undefined after
+ * the call.
+ * @param[in]     buf    Buffer containing XML, must end with two null characters
+ * @param[in]     buflen Length of buffer including the two null characters
+ * @param[in]     yspec  Yang specification, or NULL
+ * @param[in,out] xtop   Pointer to XML parse tree. If empty will be created.
+ * @retval        0      OK
+ * @retval       -1      Error with clicon_err called. Includes parse error
+ * @see xml_parse_string which copies the string
+ */
+int 
+xml_parse_buffer(char       *buf, 
+		 size_t      buflen,
+		 yang_stmt  *yspec,
+		 cxobj     **xtop)
+{
+    if (buflen < 2){
+	clicon_err(OE_XML, EINVAL, "Parse buffer too short");
+	return -1;
+    }
+    if (*xtop == NULL)
+	if ((*xtop = xml_new(XML_TOP_SYMBOL, NULL, NULL)) == NULL)
+	    return -1;
+    return _xml_parse(buf, buflen, yspec, *xtop);
 }
 
 /*! Read XML from var-arg list and parse it into xml tree
@@ -2188,9 +3385,11 @@ xml_copy(cxobj *x0,
     int    retval = -1;
     cxobj *x;
     cxobj *xcopy;
+    int    empty;
 
     if (xml_copy_one(x0, x1) <0)
 	goto done;
+    empty = (xml_child_nr(x1) == 0);
     x = NULL;
     while ((x = xml_child_each(x0, x, -1)) != NULL) {
 	if ((xcopy = xml_new(xml_name(x), x1, xml_spec(x))) == NULL)
@@ -2198,6 +3397,9 @@ xml_copy(cxobj *x0,
 	if (xml_copy(x, xcopy) < 0) /* recursion */
 	    goto done;
     }
+    /* Children are copied in order */
+    if (empty && xml_sorted(x0))
+	xml_sorted_set(x1, 1);
     retval = 0;
   done:
     return retval;
@@ -0,0 +1,1095 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2020 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+ * Indexes of XML trees, see CLICON_XMLDB_INDEX and CLICON_XMLDB_VALUE_INDEX
+ *
+ * Indexes are enabled on the top of a tree, eg a cached datastore.
+ * 1. Element-name index
+ * Maps element names to all element nodes with that name in a tree.
+ * Built on first lookup, thereafter maintained incrementally when nodes are
+ * added to or removed from the tree, see xml_index_link() and xml_index_unlink().
+ * The nodes of a name are put in document order on lookup, only if nodes of
+ * the name were added or removed, or children were reordered, since the last
+ * lookup.
+ * Used by XPath descendant steps, eg //interface, instead of visiting every node
+ * of the tree.
+ * 2. Value indexes
+ * A value index of a (non-key) leaf of a list maps values of the leaf to the
+ * leaf nodes with that value. It is maintained incrementally when nodes are
+ * added to or removed from the tree, or when their values or yang specs
+ * change, see xml_index_link() and xml_index_unlink().
+ * Values and leaf node positions are kept in open-addressing hash tables with
+ * linear probing, so that adding and removing a leaf node is constant time
+ * independent of the number of indexed nodes.
+ * All elements of an indexed tree are marked, see xml_indexed(), so that
+ * modifications of trees without indexes do not look for an index.
+ * Used by XPath equality predicates on the leaf, eg interface[type='x'], instead
+ * of a scan of all list entries.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
+
+/*
+ * Types
+ */
+/* Nodes of one element name */
+struct xml_index_entry{
+    cxobj  **xe_vec;
+    size_t   xe_len;
+    size_t   xe_max;
+    uint64_t xe_order; /* xe_vec is in document order if equal to xi_order */
+};
+
+/* Leaf nodes of one value, in no particular order */
+struct xml_value_bucket{
+    char    *xb_value; /* Value, hash key */
+    uint32_t xb_hash;  /* Hash of value */
+    cxobj  **xb_vec;
+    size_t   xb_len;
+    size_t   xb_max;
+};
+
+/* Position of an indexed node in its bucket (value index) or entry
+ * (element-name index), slot of position table */
+struct xml_index_pos{
+    cxobj  *xp_node;   /* Node, hash key, NULL if free slot */
+    void   *xp_set;    /* struct xml_value_bucket or struct xml_index_entry */
+    size_t  xp_i;
+};
+
+/* Value index of a leaf of a list
+ * Both tables have a power of two number of slots and are at most 3/4 full
+ */
+struct xml_value_index{
+    yang_stmt     *xv_yleaf;   /* Yang of indexed leaf */
+    struct xml_value_bucket **xv_values; /* Table of buckets, key is value */
+    size_t         xv_vmax;    /* Number of slots of xv_values */
+    struct xml_index_pos *xv_pos; /* Table of positions, key is leaf node */
+    size_t         xv_pmax;    /* Number of slots of xv_pos */
+    uint64_t       xv_entries; /* Number of indexed leaf nodes */
+    uint64_t       xv_nvalues; /* Number of distinct values */
+    uint64_t       xv_lookups;
+    uint64_t       xv_updates;
+};
+
+struct xml_index{
+    int            xi_names; /* Element-name index enabled */
+    int            xi_built; /* Element-name index is built, otherwise built on first lookup */
+    clicon_hash_t *xi_hash;  /* Element name -> struct xml_index_entry */
+    struct xml_index_pos *xi_pos; /* Table of positions, key is element node */
+    size_t         xi_pmax;  /* Number of slots of xi_pos */
+    uint64_t       xi_entries; /* Number of indexed element nodes */
+    uint64_t       xi_order; /* Incremented when children are reordered */
+    struct xml_value_index *xi_values; /* Vector of value indexes */
+    int            xi_nvalues;
+};
+
+/*! Get index of tree, create if not exists
+ * @param[in]  xt   Top of XML tree
+ * @retval     xi   Index
+ * @retval     NULL Error
+ */
+static struct xml_index *
+xml_index_new(cxobj *xt)
+{
+    struct xml_index *xi;
+
+    if ((xi = xml_index_get(xt)) != NULL)
+	return xi;
+    if ((xi = malloc(sizeof(*xi))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return NULL;
+    }
+    memset(xi, 0, sizeof(*xi));
+    xi->xi_order = 1;
+    xml_index_set(xt, xi);
+    return xi;
+}
+
+/*! Get index of the tree of a node
+ * @param[in]  x    XML node
+ * @retval     xi   Index of top of tree
+ * @retval     NULL No index
+ */
+static struct xml_index *
+xml_index_top(cxobj *x)
+{
+    while (xml_parent(x) != NULL)
+	x = xml_parent(x);
+    return xml_index_get(x);
+}
+
+/*! Get index of the tree of a node, if its parent is in an indexed tree
+ * @param[in]  x    XML node with a parent
+ * @retval     xi   Index of top of tree
+ * @retval     NULL No index, without looking for the top of the tree if the
+ *                  parent is not marked as indexed
+ * @see xml_indexed
+ */
+static struct xml_index *
+xml_index_parent(cxobj *x)
+{
+    cxobj *xp;
+
+    if ((xp = xml_parent(x)) == NULL || !xml_indexed(xp))
+	return NULL;
+    return xml_index_top(xp);
+}
+
+/*! Hash of a node pointer, mixes all bits since pointers are aligned
+ */
+static size_t
+xml_index_pos_hash(cxobj *x)
+{
+    uint64_t h = (uint64_t)(uintptr_t)x;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+/*! Find position of an indexed node
+ * @param[in]  vec   Table of positions
+ * @param[in]  max   Number of slots of table, power of two
+ * @param[in]  x     Node
+ * @retval     xp    Position, valid until the next change of the table
+ * @retval     NULL  Not indexed
+ */
+static struct xml_index_pos *
+xml_index_pos_find(struct xml_index_pos *vec,
+		   size_t                max,
+		   cxobj                *x)
+{
+    size_t mask = max-1;
+    size_t i;
+
+    if (vec == NULL)
+	return NULL;
+    for (i = xml_index_pos_hash(x) & mask; vec[i].xp_node != NULL; i = (i+1) & mask)
+	if (vec[i].xp_node == x)
+	    return &vec[i];
+    return NULL;
+}
+
+/*! Add position of a node, double the table if it would be more than 3/4 full
+ * @param[in,out] vecp  Table of positions
+ * @param[in,out] maxp  Number of slots of table
+ * @param[in]     len   Number of positions in table
+ * @param[in]     x     Node, not in table
+ * @param[in]     set   Bucket or entry of node
+ * @param[in]     i     Position of node in bucket or entry
+ */
+static int
+xml_index_pos_add(struct xml_index_pos **vecp,
+		  size_t                *maxp,
+		  uint64_t               len,
+		  cxobj                 *x,
+		  void                  *set,
+		  size_t                 i)
+{
+    struct xml_index_pos *vec;
+    size_t                max;
+    size_t                j;
+    size_t                k;
+
+    if (4*(len+1) > 3*(*maxp)){
+	max = *maxp ? 2*(*maxp) : 16;
+	if ((vec = calloc(max, sizeof(*vec))) == NULL){
+	    clicon_err(OE_XML, errno, "calloc");
+	    return -1;
+	}
+	for (j=0; j<*maxp; j++)
+	    if ((*vecp)[j].xp_node != NULL){
+		for (k = xml_index_pos_hash((*vecp)[j].xp_node) & (max-1);
+		     vec[k].xp_node != NULL;
+		     k = (k+1) & (max-1));
+		vec[k] = (*vecp)[j];
+	    }
+	if (*vecp)
+	    free(*vecp);
+	*vecp = vec;
+	*maxp = max;
+    }
+    vec = *vecp;
+    for (j = xml_index_pos_hash(x) & (*maxp-1);
+	 vec[j].xp_node != NULL;
+	 j = (j+1) & (*maxp-1));
+    vec[j].xp_node = x;
+    vec[j].xp_set = set;
+    vec[j].xp_i = i;
+    return 0;
+}
+
+/*! Remove a position from its slot, and shift back following positions of the probe sequence
+ */
+static void
+xml_index_pos_del(struct xml_index_pos *vec,
+		  size_t                max,
+		  struct xml_index_pos *xp)
+{
+    size_t mask = max-1;
+    size_t i = xp - vec;
+    size_t j;
+    size_t k;
+
+    vec[i].xp_node = NULL;
+    for (j = (i+1) & mask; vec[j].xp_node != NULL; j = (j+1) & mask){
+	k = xml_index_pos_hash(vec[j].xp_node) & mask; /* Home slot */
+	if (((j-k) & mask) >= ((j-i) & mask)){
+	    vec[i] = vec[j];
+	    vec[j].xp_node = NULL;
+	    i = j;
+	}
+    }
+}
+
+/*! Add an element node to the element-name index
+ * @param[in]  xi   Index
+ * @param[in]  x    Element node, not in index
+ */
+static int
+xml_index_name_link(struct xml_index *xi,
+		    cxobj            *x)
+{
+    struct xml_index_entry *xe;
+    struct xml_index_entry  xe0 = {0,};
+    cxobj                 **vec;
+    char                   *name;
+
+    if ((name = xml_name(x)) == NULL)
+	return 0;
+    if ((xe = clicon_hash_value(xi->xi_hash, name, NULL)) == NULL){
+	xe0.xe_order = xi->xi_order;
+	if (clicon_hash_add(xi->xi_hash, name, &xe0, sizeof(xe0)) == NULL)
+	    return -1;
+	if ((xe = clicon_hash_value(xi->xi_hash, name, NULL)) == NULL)
+	    return -1;
+    }
+    if (xe->xe_len == xe->xe_max){
+	xe->xe_max = xe->xe_max?2*xe->xe_max:4;
+	if ((vec = realloc(xe->xe_vec, xe->xe_max*sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    return -1;
+	}
+	xe->xe_vec = vec;
+    }
+    if (xml_index_pos_add(&xi->xi_pos, &xi->xi_pmax, xi->xi_entries,
+			  x, xe, xe->xe_len) < 0)
+	return -1;
+    /* Nodes are added in document order when the index is built */
+    if (xi->xi_built && xe->xe_len)
+	xe->xe_order = 0;
+    xe->xe_vec[xe->xe_len++] = x;
+    xi->xi_entries++;
+    return 0;
+}
+
+/*! Remove an element node from the element-name index, no-op if not indexed
+ * @param[in]  xi   Index
+ * @param[in]  x    Element node
+ */
+static int
+xml_index_name_unlink(struct xml_index *xi,
+		      cxobj            *x)
+{
+    struct xml_index_pos   *xp;
+    struct xml_index_pos   *xp1;
+    struct xml_index_entry *xe;
+    cxobj                  *x1;
+
+    if ((xp = xml_index_pos_find(xi->xi_pos, xi->xi_pmax, x)) == NULL)
+	return 0;
+    xe = xp->xp_set;
+    /* Move last node of entry to the position of x */
+    if (xp->xp_i != xe->xe_len-1){
+	x1 = xe->xe_vec[xe->xe_len-1];
+	xe->xe_vec[xp->xp_i] = x1;
+	if ((xp1 = xml_index_pos_find(xi->xi_pos, xi->xi_pmax, x1)) != NULL)
+	    xp1->xp_i = xp->xp_i;
+	xe->xe_order = 0;
+    }
+    xe->xe_len--;
+    xml_index_pos_del(xi->xi_pos, xi->xi_pmax, xp);
+    xi->xi_entries--;
+    return 0;
+}
+
+/*! Mark, and add or remove element nodes of, a subtree in an indexed tree
+ * @param[in]  xi    Index
+ * @param[in]  x     Top of subtree
+ * @param[in]  link  1: add, 0: remove
+ * @see xml_indexed
+ */
+static int
+xml_index_subtree(struct xml_index *xi,
+		  cxobj            *x,
+		  int               link)
+{
+    cxobj *xc = NULL;
+
+    xml_indexed_set(x, link);
+    if (xi->xi_built &&
+	(link?xml_index_name_link(xi, x):xml_index_name_unlink(xi, x)) < 0)
+	return -1;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	if (xml_index_subtree(xi, xc, link) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Enable element-name index of an XML tree
+ *
+ * The index is built on first lookup.
+ * @param[in]  xt   Top of XML tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_index_link  Index is maintained when the tree is modified
+ */
+int
+xml_index_enable(cxobj *xt)
+{
+    struct xml_index *xi;
+
+    if ((xi = xml_index_new(xt)) == NULL)
+	return -1;
+    if (!xml_indexed(xt) && xml_index_subtree(xi, xt, 1) < 0)
+	return -1;
+    xi->xi_names = 1;
+    return 0;
+}
+
+/*! Remove all entries of the element-name index, but keep it enabled
+ */
+static int
+xml_index_clear(struct xml_index *xi)
+{
+    char                  **keys = NULL;
+    size_t                  nkeys = 0;
+    struct xml_index_entry *xe;
+    int                     i;
+
+    if (xi->xi_hash){
+	if (clicon_hash_keys(xi->xi_hash, &keys, &nkeys) < 0)
+	    return -1;
+	for (i=0; i<nkeys; i++)
+	    if ((xe = clicon_hash_value(xi->xi_hash, keys[i], NULL)) != NULL &&
+		xe->xe_vec)
+		free(xe->xe_vec);
+	if (keys)
+	    free(keys);
+	clicon_hash_free(xi->xi_hash);
+	xi->xi_hash = NULL;
+    }
+    if (xi->xi_pos){
+	free(xi->xi_pos);
+	xi->xi_pos = NULL;
+    }
+    xi->xi_pmax = 0;
+    xi->xi_entries = 0;
+    xi->xi_built = 0;
+    return 0;
+}
+
+/*! Free all entries of a value index
+ */
+static int
+xml_value_index_clear(struct xml_value_index *xv)
+{
+    struct xml_value_bucket *xb;
+    size_t                   i;
+
+    if (xv->xv_values){
+	for (i=0; i<xv->xv_vmax; i++)
+	    if ((xb = xv->xv_values[i]) != NULL){
+		if (xb->xb_vec)
+		    free(xb->xb_vec);
+		free(xb->xb_value);
+		free(xb);
+	    }
+	free(xv->xv_values);
+	xv->xv_values = NULL;
+    }
+    xv->xv_vmax = 0;
+    if (xv->xv_pos){
+	free(xv->xv_pos);
+	xv->xv_pos = NULL;
+    }
+    xv->xv_pmax = 0;
+    xv->xv_entries = 0;
+    xv->xv_nvalues = 0;
+    return 0;
+}
+
+/*! Reset element-name index of an XML tree
+ *
+ * The index is rebuilt on next lookup. No-op if index is not enabled.
+ * Value indexes are not affected.
+ * @param[in]  xt   Top of XML tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_index_reset(cxobj *xt)
+{
+    struct xml_index *xi;
+
+    if ((xi = xml_index_get(xt)) == NULL)
+	return 0;
+    return xml_index_clear(xi);
+}
+
+/*! Free all indexes of a tree, called when the tree is freed
+ * @param[in]  xi   Index
+ * @see xml_free
+ */
+int
+xml_index_free(struct xml_index *xi)
+{
+    int i;
+
+    xml_index_clear(xi);
+    for (i=0; i<xi->xi_nvalues; i++)
+	xml_value_index_clear(&xi->xi_values[i]);
+    if (xi->xi_values)
+	free(xi->xi_values);
+    free(xi);
+    return 0;
+}
+
+/*! Notify the element-name index that the children of a node are reordered
+ *
+ * Called by the XML tree primitives when children are replaced or sorted.
+ * Nodes added to or removed from the tree are handled by xml_index_link and
+ * xml_index_unlink. Document order of the index is restored on next lookup.
+ * @param[in]  x    XML node whose children are reordered
+ */
+int
+xml_index_modified(cxobj *x)
+{
+    struct xml_index *xi;
+
+    if (!xml_indexed(x) || (xi = xml_index_top(x)) == NULL)
+	return 0;
+    xi->xi_order++;
+    return 0;
+}
+
+/*! Add element nodes of a tree to the index in document order
+ * @param[in]  xi   Index
+ * @param[in]  xn   XML node whose descendants are added
+ */
+static int
+xml_index_build(struct xml_index *xi,
+		cxobj            *xn)
+{
+    cxobj *x = NULL;
+
+    while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
+	if (xml_index_name_link(xi, x) < 0)
+	    return -1;
+	if (xml_index_build(xi, x) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! qsort compare of nodes in document order
+ * Children of the ancestors of the nodes are enumerated, see xml_index_order
+ */
+static int
+xml_index_order_cmp(const void *arg1,
+		    const void *arg2)
+{
+    cxobj *x1 = *(cxobj**)arg1;
+    cxobj *x2 = *(cxobj**)arg2;
+    cxobj *xp;
+    int    d1 = 0;
+    int    d2 = 0;
+
+    for (xp = xml_parent(x1); xp != NULL; xp = xml_parent(xp))
+	d1++;
+    for (xp = xml_parent(x2); xp != NULL; xp = xml_parent(xp))
+	d2++;
+    /* An ancestor is before its descendants */
+    for (; d1 > d2; d1--)
+	if ((x1 = xml_parent(x1)) == x2)
+	    return 1;
+    for (; d2 > d1; d2--)
+	if ((x2 = xml_parent(x2)) == x1)
+	    return -1;
+    while (xml_parent(x1) != xml_parent(x2)){
+	x1 = xml_parent(x1);
+	x2 = xml_parent(x2);
+    }
+    return xml_enumerate_get(x1) - xml_enumerate_get(x2);
+}
+
+/*! Put the nodes of an entry in document order, if not already
+ * @param[in]  xi   Index
+ * @param[in]  xe   Entry
+ */
+static int
+xml_index_order(struct xml_index       *xi,
+		struct xml_index_entry *xe)
+{
+    struct xml_index_pos *xp;
+    cxobj                *x;
+    cxobj                *xpar;
+    size_t                i;
+
+    if (xe->xe_order == xi->xi_order)
+	return 0;
+    /* Enumerate children of ancestors, unless the enumeration is up to date */
+    for (i=0; i<xe->xe_len; i++)
+	for (x = xe->xe_vec[i]; (xpar = xml_parent(x)) != NULL; x = xpar)
+	    if (xml_child_i(xpar, xml_enumerate_get(x)) != x)
+		xml_enumerate_children(xpar);
+    qsort(xe->xe_vec, xe->xe_len, sizeof(cxobj *), xml_index_order_cmp);
+    for (i=0; i<xe->xe_len; i++)
+	if ((xp = xml_index_pos_find(xi->xi_pos, xi->xi_pmax, xe->xe_vec[i])) != NULL)
+	    xp->xp_i = i;
+    xe->xe_order = xi->xi_order;
+    return 0;
+}
+
+/*! Get all descendant elements of a node with a given name using the index
+ *
+ * The tree of xn is the tree where the index is enabled, see xml_index_enable.
+ * Candidates of the name are checked for ancestry so that only descendants of xn
+ * are returned. The result is in document order, ie the same as a
+ * recursive search.
+ * @param[in]  xn     XML node
+ * @param[in]  name   Element name
+ * @param[out] vec    Vector of nodes, free with free(). Can be NULL if none found
+ * @param[out] veclen Length of vector
+ * @retval     1      OK, vec contains descendants
+ * @retval     0      No index of this tree, make a recursive search instead
+ * @retval    -1      Error
+ */
+int
+xml_index_descendants(cxobj    *xn,
+		      char     *name,
+		      cxobj  ***vec,
+		      size_t   *veclen)
+{
+    int                     retval = -1;
+    cxobj                  *xt;
+    cxobj                  *xp;
+    struct xml_index       *xi;
+    struct xml_index_entry *xe;
+    int                     i;
+
+    /* Find top of tree */
+    for (xt = xn; xml_parent(xt) != NULL; xt = xml_parent(xt));
+    if ((xi = xml_index_get(xt)) == NULL || !xi->xi_names)
+	goto noindex;
+    if (!xi->xi_built){
+	if ((xi->xi_hash = clicon_hash_init()) == NULL)
+	    goto done;
+	if (xml_index_build(xi, xt) < 0){
+	    xml_index_clear(xi);
+	    goto done;
+	}
+	xi->xi_built = 1;
+	clicon_debug(1, "%s index built", __FUNCTION__);
+    }
+    if ((xe = clicon_hash_value(xi->xi_hash, name, NULL)) != NULL){
+	if (xml_index_order(xi, xe) < 0)
+	    goto done;
+	for (i=0; i<xe->xe_len; i++){
+	    if (xn != xt){ /* Check that xn is ancestor */
+		for (xp = xml_parent(xe->xe_vec[i]); xp != NULL; xp = xml_parent(xp))
+		    if (xp == xn)
+			break;
+		if (xp == NULL)
+		    continue;
+	    }
+	    if (cxvec_append(xe->xe_vec[i], vec, veclen) < 0)
+		goto done;
+	}
+    }
+    retval = 1;
+ done:
+    return retval;
+ noindex:
+    retval = 0;
+    goto done;
+}
+
+/*! Hash of a value, FNV-1a
+ */
+static uint32_t
+xml_value_hash(const char *str)
+{
+    uint32_t h = 2166136261U;
+
+    while (*str){
+	h ^= (uint8_t)*str++;
+	h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Find bucket of a value in a value index
+ * @param[in]  xv    Value index
+ * @param[in]  value Value
+ * @param[in]  hash  Hash of value, see xml_value_hash
+ * @param[out] slot  Slot of bucket, or free slot for a new bucket (if not NULL)
+ * @retval     xb    Bucket
+ * @retval     NULL  Not found
+ */
+static struct xml_value_bucket *
+xml_value_bucket_find(struct xml_value_index *xv,
+		      const char             *value,
+		      uint32_t                hash,
+		      size_t                 *slot)
+{
+    struct xml_value_bucket *xb;
+    size_t                   mask = xv->xv_vmax-1;
+    size_t                   i;
+
+    if (xv->xv_values == NULL)
+	return NULL;
+    for (i = hash & mask; (xb = xv->xv_values[i]) != NULL; i = (i+1) & mask)
+	if (xb->xb_hash == hash && strcmp(xb->xb_value, value) == 0)
+	    break;
+    if (slot)
+	*slot = i;
+    return xb;
+}
+
+/*! Make room for one more bucket, double the table if it would be more than 3/4 full
+ */
+static int
+xml_value_bucket_grow(struct xml_value_index *xv)
+{
+    struct xml_value_bucket **vec;
+    size_t                    max;
+    size_t                    i;
+    size_t                    j;
+
+    if (4*(xv->xv_nvalues+1) <= 3*xv->xv_vmax)
+	return 0;
+    max = xv->xv_vmax ? 2*xv->xv_vmax : 16;
+    if ((vec = calloc(max, sizeof(*vec))) == NULL){
+	clicon_err(OE_XML, errno, "calloc");
+	return -1;
+    }
+    for (i=0; i<xv->xv_vmax; i++)
+	if (xv->xv_values[i] != NULL){
+	    for (j = xv->xv_values[i]->xb_hash & (max-1); vec[j] != NULL; j = (j+1) & (max-1));
+	    vec[j] = xv->xv_values[i];
+	}
+    if (xv->xv_values)
+	free(xv->xv_values);
+    xv->xv_values = vec;
+    xv->xv_vmax = max;
+    return 0;
+}
+
+/*! Remove a bucket from its slot, and shift back following buckets of the probe sequence
+ */
+static void
+xml_value_bucket_del(struct xml_value_index *xv,
+		     size_t                  i)
+{
+    size_t mask = xv->xv_vmax-1;
+    size_t j;
+    size_t k;
+
+    xv->xv_values[i] = NULL;
+    for (j = (i+1) & mask; xv->xv_values[j] != NULL; j = (j+1) & mask){
+	k = xv->xv_values[j]->xb_hash & mask; /* Home slot */
+	if (((j-k) & mask) >= ((j-i) & mask)){
+	    xv->xv_values[i] = xv->xv_values[j];
+	    xv->xv_values[j] = NULL;
+	    i = j;
+	}
+    }
+}
+
+/*! Remove a leaf node from a value index, no-op if not indexed
+ * @param[in]  xv   Value index
+ * @param[in]  x    Leaf node
+ */
+static int
+xml_value_unlink(struct xml_value_index *xv,
+		 cxobj                  *x)
+{
+    struct xml_index_pos    *xp;
+    struct xml_index_pos    *xp1;
+    struct xml_value_bucket *xb;
+    cxobj                   *x1;
+    size_t                   slot;
+
+    if ((xp = xml_index_pos_find(xv->xv_pos, xv->xv_pmax, x)) == NULL)
+	return 0;
+    xb = xp->xp_set;
+    /* Move last node of bucket to the position of x */
+    if (xp->xp_i != xb->xb_len-1){
+	x1 = xb->xb_vec[xb->xb_len-1];
+	xb->xb_vec[xp->xp_i] = x1;
+	if ((xp1 = xml_index_pos_find(xv->xv_pos, xv->xv_pmax, x1)) != NULL)
+	    xp1->xp_i = xp->xp_i;
+    }
+    xb->xb_len--;
+    xml_index_pos_del(xv->xv_pos, xv->xv_pmax, xp);
+    xv->xv_entries--;
+    xv->xv_updates++;
+    if (xb->xb_len == 0){
+	if (xml_value_bucket_find(xv, xb->xb_value, xb->xb_hash, &slot) == xb)
+	    xml_value_bucket_del(xv, slot);
+	if (xb->xb_vec)
+	    free(xb->xb_vec);
+	free(xb->xb_value);
+	free(xb);
+	xv->xv_nvalues--;
+    }
+    return 0;
+}
+
+/*! Add a leaf node with its current value to a value index
+ * @param[in]  xv   Value index
+ * @param[in]  x    Leaf node, with yang spec of index and a list entry as parent
+ */
+static int
+xml_value_link(struct xml_value_index *xv,
+	       cxobj                  *x)
+{
+    struct xml_value_bucket *xb;
+    cxobj                  **vec;
+    char                    *body;
+    uint32_t                 hash;
+    size_t                   slot;
+
+    if (xml_value_unlink(xv, x) < 0)
+	return -1;
+    if (xml_parent(x) == NULL || (body = xml_body(x)) == NULL)
+	return 0;
+    hash = xml_value_hash(body);
+    if ((xb = xml_value_bucket_find(xv, body, hash, NULL)) == NULL){
+	if (xml_value_bucket_grow(xv) < 0)
+	    return -1;
+	(void)xml_value_bucket_find(xv, body, hash, &slot);
+	if ((xb = malloc(sizeof(*xb))) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return -1;
+	}
+	memset(xb, 0, sizeof(*xb));
+	if ((xb->xb_value = strdup(body)) == NULL){
+	    clicon_err(OE_XML, errno, "strdup");
+	    free(xb);
+	    return -1;
+	}
+	xb->xb_hash = hash;
+	xv->xv_values[slot] = xb;
+	xv->xv_nvalues++;
+    }
+    if (xb->xb_len == xb->xb_max){
+	xb->xb_max = xb->xb_max?2*xb->xb_max:4;
+	if ((vec = realloc(xb->xb_vec, xb->xb_max*sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    return -1;
+	}
+	xb->xb_vec = vec;
+    }
+    if (xml_index_pos_add(&xv->xv_pos, &xv->xv_pmax, xv->xv_entries,
+			  x, xb, xb->xb_len) < 0)
+	return -1;
+    xb->xb_vec[xb->xb_len++] = x;
+    xv->xv_entries++;
+    xv->xv_updates++;
+    return 0;
+}
+
+/*! Add or remove leaf nodes of a subtree to or from value indexes
+ * @param[in]  xi    Index
+ * @param[in]  xv0   Only this value index, or NULL for all value indexes
+ * @param[in]  x     Top of subtree
+ * @param[in]  link  1: add (or update), 0: remove
+ */
+static int
+xml_value_subtree(struct xml_index       *xi,
+		  struct xml_value_index *xv0,
+		  cxobj                  *x,
+		  int                     link)
+{
+    struct xml_value_index *xv;
+    yang_stmt              *y;
+    cxobj                  *xc;
+    int                     i;
+
+    if ((y = xml_spec(x)) != NULL){
+	for (i=0; i<xi->xi_nvalues; i++){
+	    xv = &xi->xi_values[i];
+	    if ((xv0 != NULL && xv != xv0) || xv->xv_yleaf != y)
+		continue;
+	    if ((link?xml_value_link(xv, x):xml_value_unlink(xv, x)) < 0)
+		return -1;
+	}
+	if (yang_keyword_get(y) == Y_LEAF || yang_keyword_get(y) == Y_LEAF_LIST)
+	    return 0;
+    }
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	if (xml_value_subtree(xi, xv0, xc, link) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Enable value index of a leaf of a list in an XML tree
+ *
+ * The leaf nodes already in the tree are indexed, thereafter the index is
+ * maintained when the tree is modified.
+ * @param[in]  xt     Top of XML tree
+ * @param[in]  yleaf  Yang of leaf, the parent of the leaf should be a list
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xml_index_value_enable(cxobj     *xt,
+		       yang_stmt *yleaf)
+{
+    struct xml_index       *xi;
+    struct xml_value_index *xv;
+    int                     i;
+
+    if ((xi = xml_index_new(xt)) == NULL)
+	return -1;
+    if (!xml_indexed(xt) && xml_index_subtree(xi, xt, 1) < 0)
+	return -1;
+    for (i=0; i<xi->xi_nvalues; i++)
+	if (xi->xi_values[i].xv_yleaf == yleaf)
+	    return 0;
+    if ((xv = realloc(xi->xi_values, (xi->xi_nvalues+1)*sizeof(*xv))) == NULL){
+	clicon_err(OE_XML, errno, "realloc");
+	return -1;
+    }
+    xi->xi_values = xv;
+    xv = &xi->xi_values[xi->xi_nvalues++];
+    memset(xv, 0, sizeof(*xv));
+    xv->xv_yleaf = yleaf;
+    return xml_value_subtree(xi, xv, xt, 1);
+}
+
+/*! Add nodes to indexes when they are added to a tree or changed
+ *
+ * Called by XML tree primitives when a node gets a new parent, a new yang spec
+ * or name, or if it is a body, a new value.
+ * No-op unless the parent is in an indexed tree, see xml_indexed.
+ * @param[in]  x    XML node
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_index_unlink
+ */
+int
+xml_index_link(cxobj *x)
+{
+    struct xml_index *xi;
+    cxobj            *xp;
+    yang_stmt        *y;
+
+    if ((xi = xml_index_parent(x)) == NULL)
+	return 0;
+    switch (xml_type(x)){
+    case CX_BODY: /* Value of leaf changed */
+	xp = xml_parent(x);
+	if (xi->xi_nvalues &&
+	    (y = xml_spec(xp)) != NULL && yang_keyword_get(y) == Y_LEAF)
+	    return xml_value_subtree(xi, NULL, xp, 1);
+	break;
+    case CX_ELMNT:
+	if (!xml_indexed(x) && xml_index_subtree(xi, x, 1) < 0)
+	    return -1;
+	if (xi->xi_nvalues)
+	    return xml_value_subtree(xi, NULL, x, 1);
+	break;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Remove nodes from indexes before they are removed from a tree or changed
+ *
+ * @param[in]  x    XML node
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_index_link
+ */
+int
+xml_index_unlink(cxobj *x)
+{
+    struct xml_index *xi;
+    cxobj            *xp;
+    yang_stmt        *y;
+
+    if ((xi = xml_index_parent(x)) == NULL)
+	return 0;
+    switch (xml_type(x)){
+    case CX_BODY: /* Leaf loses its value */
+	xp = xml_parent(x);
+	if (xi->xi_nvalues &&
+	    (y = xml_spec(xp)) != NULL && yang_keyword_get(y) == Y_LEAF)
+	    return xml_value_subtree(xi, NULL, xp, 0);
+	break;
+    case CX_ELMNT:
+	if (xi->xi_nvalues && xml_value_subtree(xi, NULL, x, 0) < 0)
+	    return -1;
+	if (xml_indexed(x))
+	    return xml_index_subtree(xi, x, 0);
+	break;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! qsort compare of list entries in the order of xml_sort
+ */
+static int
+xml_value_cmp(const void *arg1,
+	      const void *arg2)
+{
+    return xml_cmp(*(cxobj**)arg1, *(cxobj**)arg2, 0);
+}
+
+/*! Get list entries with a given value of an indexed leaf
+ *
+ * @param[in]  xv     XML node, parent of list entries
+ * @param[in]  yleaf  Yang of leaf
+ * @param[in]  value  Value (string) of leaf
+ * @param[out] vec    Matching list entries, children of xv (appended)
+ * @param[out] veclen Length of vec
+ * @retval     1      OK, matching entries in vec sorted as in xml_sort
+ * @retval     0      No value index of leaf in this tree
+ * @retval    -1      Error
+ */
+int
+xml_index_value_lookup(cxobj      *xv,
+		       yang_stmt  *yleaf,
+		       char       *value,
+		       cxobj    ***vec,
+		       size_t     *veclen)
+{
+    struct xml_index        *xi;
+    struct xml_value_index  *xvi = NULL;
+    struct xml_value_bucket *xb;
+    cxobj                   *xe;
+    size_t                   len0 = *veclen;
+    int                      i;
+
+    if (!xml_indexed(xv) || (xi = xml_index_top(xv)) == NULL)
+	return 0;
+    for (i=0; i<xi->xi_nvalues; i++)
+	if (xi->xi_values[i].xv_yleaf == yleaf){
+	    xvi = &xi->xi_values[i];
+	    break;
+	}
+    if (xvi == NULL)
+	return 0;
+    xvi->xv_lookups++;
+    if ((xb = xml_value_bucket_find(xvi, value, xml_value_hash(value), NULL)) == NULL)
+	return 1;
+    for (i=0; i<xb->xb_len; i++)
+	if ((xe = xml_parent(xb->xb_vec[i])) != NULL &&
+	    xml_parent(xe) == xv)
+	    if (cxvec_append(xe, vec, veclen) < 0)
+		return -1;
+    if (*veclen - len0 > 1)
+	qsort(*vec + len0, *veclen - len0, sizeof(cxobj *), xml_value_cmp);
+    return 1;
+}
+
+/*! Get statistics of the value index of a leaf
+ * @param[in]  xt     Top of XML tree
+ * @param[in]  yleaf  Yang of leaf
+ * @param[out] vs     Statistics, memory is an estimate of index data only
+ * @retval     1      OK
+ * @retval     0      No value index of leaf in this tree
+ */
+int
+xml_index_value_stats(cxobj                        *xt,
+		      yang_stmt                    *yleaf,
+		      struct xml_value_index_stats *vs)
+{
+    struct xml_index        *xi;
+    struct xml_value_index  *xv = NULL;
+    struct xml_value_bucket *xb;
+    size_t                   i;
+
+    if ((xi = xml_index_get(xt)) == NULL)
+	return 0;
+    for (i=0; i<xi->xi_nvalues; i++)
+	if (xi->xi_values[i].xv_yleaf == yleaf){
+	    xv = &xi->xi_values[i];
+	    break;
+	}
+    if (xv == NULL)
+	return 0;
+    memset(vs, 0, sizeof(*vs));
+    vs->vs_entries = xv->xv_entries;
+    vs->vs_values = xv->xv_nvalues;
+    vs->vs_lookups = xv->xv_lookups;
+    vs->vs_updates = xv->xv_updates;
+    /* Both tables, and each bucket with value and vector */
+    vs->vs_memory = xv->xv_pmax*sizeof(struct xml_index_pos) +
+	xv->xv_vmax*sizeof(struct xml_value_bucket *);
+    for (i=0; i<xv->xv_vmax; i++)
+	if ((xb = xv->xv_values[i]) != NULL)
+	    vs->vs_memory += sizeof(*xb) + strlen(xb->xb_value)+1 +
+		xb->xb_max*sizeof(cxobj *);
+    return 1;
+}
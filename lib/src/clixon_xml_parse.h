@@ -45,6 +45,7 @@
 struct xml_parse_yacc_arg{
     char       *ya_parse_string; /* original (copy of) parse string */
     int         ya_linenum;      /* Number of \n in parsed buffer */
+    size_t      ya_parse_buflen; /* If set, parse string in place, see xml_parse_buffer */
     void       *ya_lexbuf;       /* internal parse buffer from lex */
 
     cxobj      *ya_xelement;     /* xml active element */
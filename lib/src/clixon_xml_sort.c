@@ -66,6 +66,7 @@
 #include "clixon_xml_map.h"
 #include "clixon_yang_type.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
 
 /*! Get xml body value as cligen variable
  * @param[in]  x   XML node (body and leaf/leaf-list)
@@ -82,11 +83,9 @@ xml_cv_cache(cxobj   *x,
     int          retval = -1;
     cg_var      *cv = NULL;
     yang_stmt   *y;
-    yang_stmt   *yrestype;
     enum cv_type cvtype;
     int          ret;
     char        *reason=NULL;
-    int          options = 0;
     uint8_t      fraction = 0;
     char        *body;
 		 
@@ -96,12 +95,12 @@ xml_cv_cache(cxobj   *x,
 	goto ok;
     if ((y = xml_spec(x)) == NULL)
 	goto ok;
-    if (yang_type_get(y, NULL, &yrestype, &options, NULL, NULL, NULL, &fraction) < 0)
+    /* Resolved leaf type, no typedef lookups */
+    if (yang_leaftype_cv(y, &cvtype, &fraction) < 0)
 	goto done;
-    yang2cv_type(yang_argument_get(yrestype), &cvtype);
     if (cvtype==CGV_ERR){
-	clicon_err(OE_YANG, errno, "yang->cligen type %s mapping failed",
-		   yang_argument_get(yrestype));
+	clicon_err(OE_YANG, errno, "yang->cligen type mapping failed for %s",
+		   yang_argument_get(y));
 	goto done;
     }
     if ((cv = cv_new(cvtype)) == NULL){
@@ -133,6 +132,56 @@ xml_cv_cache(cxobj   *x,
     return retval;
 }
 
+/*! Return (cached) key values of an XML list entry
+ * The first call looks up the key leafs and their values, which are then
+ * kept in the list entry so that subsequent comparisons do not need to
+ * search the children.
+ * @param[in]  x      XML list entry
+ * @param[in]  cvk    Key names of the list, see yang_cvec_get()
+ * @param[out] keysp  Vector of key values in cvk order, NULL entry if missing
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xml_keys
+ */
+static int
+xml_keys_cache(cxobj    *x,
+	       cvec     *cvk,
+	       cg_var ***keysp)
+{
+    int      retval = -1;
+    cg_var **keys = NULL;
+    cg_var  *cvi;
+    cxobj   *xb;
+    int      i;
+
+    if ((keys = xml_keys(x)) != NULL)
+	goto ok;
+    if ((keys = calloc(cvec_len(cvk)+1, sizeof(cg_var *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    i = 0;
+    cvi = NULL;
+    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+	/* operational data may have NULL keys */
+	if ((xb = xml_find(x, cv_string_get(cvi))) != NULL &&
+	    xml_body(xb) != NULL)
+	    if (xml_cv_cache(xb, &keys[i]) < 0)
+		goto done;
+	i++;
+    }
+    if (xml_keys_set(x, keys) < 0)
+	goto done;
+ ok:
+    *keysp = keys;
+    keys = NULL;
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
 /*! Given a child name and an XML object, return yang stmt of child
  * If no xml parent, find root yang stmt matching name
  * @param[in]  x        Child
@@ -228,17 +277,16 @@ xml_cmp(cxobj *x1,
     int         yi1 = 0;
     int         yi2 = 0;
     cvec       *cvk = NULL; /* vector of index keys */
-    cg_var     *cvi;
     int         equal = 0;
     char       *b1;
     char       *b2;
-    char       *keyname;
     cg_var     *cv1; 
     cg_var     *cv2;
+    cg_var    **keys1;
+    cg_var    **keys2;
     int         nr1 = 0;
     int         nr2 = 0;
-    cxobj      *x1b;
-    cxobj      *x2b;
+    int         i;
 
     if (x1==NULL || x2==NULL)
 	goto done; /* shouldnt happen */
@@ -302,26 +350,19 @@ xml_cmp(cxobj *x1,
 	break;
     case Y_LIST: /* Match with key values 
 		  * Use Y_LIST cache (see struct yang_stmt)
+		  * and key value cache of each list entry (see xml_keys)
 		  */
 	cvk = yang_cvec_get(y1); /* Use Y_LIST cache, see ys_populate_list() */
-	cvi = NULL;
-	while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-	    keyname = cv_string_get(cvi); /* operational data may have NULL keys*/
-	    if ((x1b = xml_find(x1, keyname)) == NULL ||
-		xml_body(x1b) == NULL)
-		equal = -1;
-	    else if ((x2b = xml_find(x2, keyname)) == NULL ||
-		     xml_body(x2b) == NULL)
-		equal = 1;
-	    else{
-		if (xml_cv_cache(x1b, &cv1) < 0) /* error case */
-		    goto done;
-		if (xml_cv_cache(x2b, &cv2) < 0) /* error case */
-		    goto done;
-		assert(cv1 && cv2);
-		if ((equal = cv_cmp(cv1, cv2)) != 0)
-		    goto done;
-	    }
+	if (xml_keys_cache(x1, cvk, &keys1) < 0) /* error case */
+	    goto done;
+	if (xml_keys_cache(x2, cvk, &keys2) < 0) /* error case */
+	    goto done;
+	for (i=0; i<cvec_len(cvk); i++){
+	    /* operational data may have NULL keys, skip them */
+	    if ((cv1 = keys1[i]) == NULL || (cv2 = keys2[i]) == NULL)
+		continue;
+	    if ((equal = cv_cmp(cv1, cv2)) != 0)
+		goto done;
 	}
 	equal = 0;
 	break;
@@ -363,9 +404,73 @@ xml_sort(cxobj *x,
 	return 1;
     xml_enumerate_children(x);
     qsort(xml_childvec_get(x), xml_child_nr(x), sizeof(cxobj *), xml_cmp_qsort);
+    xml_sorted_set(x, 1);
+    xml_index_modified(x);
     return 0;
 }
 
+/*! Sort children of an XML node where the last n children have been appended
+ * The children before the tail and the n children of the tail are each assumed
+ * to be sorted. They are merged in one linear pass instead of inserting each
+ * appended child with xml_insert.
+ * @param[in] x    XML node
+ * @param[in] n    Number of appended children at the end of x:s children
+ * @retval    0    OK
+ * @retval   -1    Error
+ * @see xml_sort   for sorting unsorted children
+ * @see xml_insert for inserting a single child
+ */
+int
+xml_sort_tail(cxobj *x,
+	      int    n)
+{
+    int     retval = -1;
+    cxobj **vec;
+    cxobj **tail = NULL;
+    int     len;
+    int     low;
+    int     i;
+    int     j;
+    int     k;
+
+    len = xml_child_nr(x);
+    if (n < 0 || n > len){
+	clicon_err(OE_XML, EINVAL, "Tail %d out of range %d", n, len);
+	goto done;
+    }
+    vec = xml_childvec_get(x);
+    /* Attributes are placed first and not part of the merge */
+    for (low=0; low<len-n; low++)
+	if (xml_type(vec[low]) != CX_ATTR)
+	    break;
+    /* Already in order */
+    if (n == 0 || low == len-n || xml_cmp(vec[len-n-1], vec[len-n], 0) <= 0)
+	goto ok;
+    if ((tail = malloc(n*sizeof(cxobj *))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memcpy(tail, &vec[len-n], n*sizeof(cxobj *));
+    /* Merge backwards so that no unmerged child is overwritten */
+    i = len-n-1;
+    j = n-1;
+    k = len-1;
+    while (j >= 0){
+	if (i >= low && xml_cmp(vec[i], tail[j], 0) > 0)
+	    vec[k--] = vec[i--];
+	else
+	    vec[k--] = tail[j--];
+    }
+    xml_index_modified(x);
+ ok:
+    xml_sorted_set(x, 1);
+    retval = 0;
+ done:
+    if (tail)
+	free(tail);
+    return retval;
+}
+
 /*! Special case search for ordered-by user where linear sort is used
  * @param[in]  xp    Parent XML node (go through its childre)
  * @param[in]  x1    XML node to match
@@ -706,6 +811,7 @@ xml_insert(cxobj           *xp,
     int        userorder= 0;
     int        yi; /* Global yang-stmt order */
     int        i;
+    int        sorted;
 
     /* Ensure the intermediate state that xp is parent of x but has not yet been
      * added as a child
@@ -734,8 +840,11 @@ xml_insert(cxobj           *xp,
 			 userorder, ins, key_val, nsc_key,
 			 low, upper)) < 0)
 	goto done;
+    sorted = xml_sorted(xp);
     if (xml_child_insert_pos(xp, xi, i) < 0)
 	goto done;
+    if (sorted) /* Inserted in order */
+	xml_sorted_set(xp, 1);
     xml_parent_set(xi, xp);
     /* clear namespace context cache of child */
     nscache_clear(xi);
@@ -902,6 +1011,9 @@ xml_binsearch(cxobj     *xp,
 		cv_name_get(cvi));
     }
     cprintf(cb, "</%s>", name);
+    /* The search object is temporary, allocate it from an arena */
+    if ((xc = xml_new_arena("top", NULL)) == NULL)
+	goto done;
     if (xml_parse_string(cbuf_get(cb), yc, &xc) < 0)
 	goto done;
     if (xml_rootchild(xc, 0, &xc) < 0)
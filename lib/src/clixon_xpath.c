@@ -75,6 +75,7 @@
 
 /* clicon */
 #include "clixon_err.h"
+#include "clixon_arena.h"
 #include "clixon_log.h"
 #include "clixon_string.h"
 #include "clixon_queue.h"
@@ -85,6 +86,7 @@
 #include "clixon_xml_nsctx.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_optimize.h"
 #include "clixon_xpath_parse.h"
 #include "clixon_xpath_eval.h"
 
@@ -462,6 +464,8 @@ xpath_tree_free(xpath_tree *xs)
 	xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
 	xpath_tree_free(xs->xs_c1);
+    if (xs->xs_lookup)
+	xpath_lookup_free(xs->xs_lookup);
     free(xs);
     return 0;
 }
@@ -512,6 +516,10 @@ xpath_parse(char        *xpath,
     }
     xpath_parse_exit(&xy);
     xpath_scan_exit(&xy);
+#ifdef XPATH_LIST_OPTIMIZE
+    if (xpath_optimize(xy.xy_top) < 0)
+	goto done;
+#endif
     *xptree = xy.xy_top;
     retval = 0;
  done:
@@ -547,25 +555,60 @@ xpath_vec_ctx(cxobj    *xcur,
 {
     int         retval = -1;
     xpath_tree *xptree = NULL;
-    xp_ctx      xc = {0,};
     
     if (xpath_parse(xpath, &xptree) < 0)
 	goto done;
+    if (xpath_vec_ctx_tree(xcur, nsc, xptree, localonly, xrp) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (xptree)
+	xpath_tree_free(xptree);
+    return retval;
+}
+
+/*! Given XML tree and a parsed xpath, eval it and return xpath context
+ * Same as xpath_vec_ctx but with an xpath parsed once with xpath_parse, for 
+ * xpaths evaluated many times.
+ * @param[in]  xcur   XML-tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xptree Parsed XPATH, see xpath_parse
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp    Return XPATH context
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xpath_vec_ctx
+ */
+int
+xpath_vec_ctx_tree(cxobj      *xcur, 
+		   cvec       *nsc,
+		   xpath_tree *xptree,
+		   int         localonly,
+		   xp_ctx    **xrp)
+{
+    int         retval = -1;
+    xp_ctx      xc = {0,};
+    xp_ctx     *xr = NULL;
+    clixon_arena *xa = NULL;
+    
+    /* All intermediate contexts are allocated from an arena freed at once */
+    if ((xa = clixon_arena_new()) == NULL)
+	goto done;
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
     xc.xc_initial = xcur;
-    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+    xc.xc_arena = xa;
+    if (ctx_nodeset_append(&xc, xcur) < 0)
 	goto done;
-    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+    if (xp_eval(&xc, xptree, nsc, localonly, &xr) < 0)
+	goto done;
+    /* Copy result out of arena */
+    if ((*xrp = ctx_copy(xr, NULL)) == NULL)
 	goto done;
-    if (xc.xc_nodeset){
-	free(xc.xc_nodeset);
-	xc.xc_nodeset = NULL;
-    }
     retval = 0;
  done:
-    if (xptree)
-	xpath_tree_free(xptree);
+    if (xa)
+	clixon_arena_free(xa);
     return retval;
 }
 
@@ -50,6 +50,7 @@
 
 /* clicon */
 #include "clixon_err.h"
+#include "clixon_arena.h"
 #include "clixon_log.h"
 #include "clixon_string.h"
 #include "clixon_queue.h"
@@ -72,10 +73,49 @@ const map_str2int ctxmap[] = {
     {NULL,        -1}
 };
 
-/*! Free xpath context */
+/*! Allocate memory from an arena, or from the heap if no arena */
+static void *
+ctx_alloc(clixon_arena *xa,
+	  size_t        len)
+{
+    void *p;
+    
+    if (xa)
+	return clixon_arena_alloc(xa, len);
+    if ((p = malloc(len)) == NULL)
+	clicon_err(OE_UNIX, errno, "malloc");
+    return p;
+}
+
+/*! Create new xpath context in the same arena as an existing context
+ * @param[in]  xc0   Existing context, arena and initial node are inherited
+ * @param[in]  type  Type of new context
+ * @retval     xc    New context, free with ctx_free
+ * @retval     NULL  Error
+ */
+xp_ctx *
+ctx_new(xp_ctx         *xc0,
+	enum xp_objtype type)
+{
+    xp_ctx *xc;
+
+    if ((xc = ctx_alloc(xc0->xc_arena, sizeof(*xc))) == NULL)
+	return NULL;
+    memset(xc, 0, sizeof(*xc));
+    xc->xc_type = type;
+    xc->xc_initial = xc0->xc_initial;
+    xc->xc_arena = xc0->xc_arena;
+    return xc;
+}
+
+/*! Free xpath context 
+ * Contexts allocated from an arena are freed with the arena
+ */
 int
 ctx_free(xp_ctx *xc)
 {
+    if (xc->xc_arena)
+	return 0;
     if (xc->xc_nodeset)
 	free(xc->xc_nodeset);
     if (xc->xc_string)
@@ -84,32 +124,103 @@ ctx_free(xp_ctx *xc)
     return 0;
 }
 
-/*! Duplicate xpath context */
+/*! Copy xpath context to an arena or to the heap
+ * @param[in]  xc0  Context
+ * @param[in]  xa   Arena to copy to, or NULL for heap
+ * @retval     xc   New context, free with ctx_free
+ * @retval     NULL Error
+ * Use with a NULL arena to return a result that outlives the evaluation arena
+ */
 xp_ctx *
-ctx_dup(xp_ctx *xc0)
+ctx_copy(xp_ctx       *xc0,
+	 clixon_arena *xa)
 {
-    static xp_ctx *xc = NULL;
+    xp_ctx *xc = NULL;
     
-    if ((xc = malloc(sizeof(*xc))) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
-	goto done;
-    }
-    memset(xc, 0, sizeof(*xc));
+    if ((xc = ctx_alloc(xa, sizeof(*xc))) == NULL)
+	goto err;
     *xc = *xc0;
+    xc->xc_arena = xa;
+    xc->xc_nodeset = NULL;
+    xc->xc_max = 0;
+    xc->xc_string = NULL;
     if (xc0->xc_size){
-	if ((xc->xc_nodeset = calloc(xc0->xc_size, sizeof(cxobj*))) == NULL){
-	    clicon_err(OE_UNIX, errno, "calloc");
-	    goto done;
-	}
-	memcpy(xc->xc_nodeset, xc0->xc_nodeset, xc->xc_size*sizeof(cxobj*));
+	if ((xc->xc_nodeset = ctx_alloc(xa, xc0->xc_size*sizeof(cxobj*))) == NULL)
+	    goto err;
+	memcpy(xc->xc_nodeset, xc0->xc_nodeset, xc0->xc_size*sizeof(cxobj*));
+	xc->xc_max = xc0->xc_size;
     }
-    if (xc0->xc_string)
-	if ((xc->xc_string = strdup(xc0->xc_string)) == NULL){
-	    clicon_err(OE_UNIX, errno, "strdup");
-	    goto done;
-	}
- done:
+    if (xc0->xc_string && ctx_string_set(xc, xc0->xc_string) < 0)
+	goto err;
     return xc;
+ err:
+    if (xc)
+	ctx_free(xc);
+    return NULL;
+}
+
+/*! Duplicate xpath context in the same arena */
+xp_ctx *
+ctx_dup(xp_ctx *xc0)
+{
+    return ctx_copy(xc0, xc0->xc_arena);
+}
+
+/*! Append a node to the nodeset of an xpath context
+ * The nodeset is grown in powers of two, from the arena if any.
+ * @param[in]  xc  XPATH context
+ * @param[in]  x   XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+ctx_nodeset_append(xp_ctx *xc,
+		   cxobj  *x)
+{
+    size_t  max;
+    cxobj **vec;
+
+    if (xc->xc_size >= xc->xc_max){
+	max = xc->xc_max ? xc->xc_max : 4;
+	while (max <= xc->xc_size)
+	    max *= 2;
+	if (xc->xc_arena){
+	    if ((vec = clixon_arena_grow(xc->xc_arena, xc->xc_nodeset,
+				     xc->xc_size*sizeof(cxobj*),
+				     max*sizeof(cxobj*))) == NULL)
+		return -1;
+	}
+	else if ((vec = realloc(xc->xc_nodeset, max*sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	xc->xc_nodeset = vec;
+	xc->xc_max = max;
+    }
+    xc->xc_nodeset[xc->xc_size++] = x;
+    return 0;
+}
+
+/*! Set string of an xpath context to a copy of a string
+ * @param[in]  xc   XPATH context
+ * @param[in]  str  String, copied to the arena if any
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+ctx_string_set(xp_ctx *xc,
+	       char   *str)
+{
+    size_t len = strlen(str) + 1;
+    char  *s;
+
+    if ((s = ctx_alloc(xc->xc_arena, len)) == NULL)
+	return -1;
+    memcpy(s, str, len);
+    if (xc->xc_arena == NULL && xc->xc_string)
+	free(xc->xc_string);
+    xc->xc_string = s;
+    return 0;
 }
 
 /*! Print XPATH context to CLIgen buf
@@ -280,14 +391,14 @@ int
 ctx2number(xp_ctx *xc,
 	   double *n0)
 {
-    int     retval = -1;
     char   *str = NULL;
     double  n;
     
     switch (xc->xc_type){
     case XT_NODESET:
-	if (ctx2string(xc, &str) < 0)
-	    goto done;
+	/* String value of first node, see ctx2string */
+	if (xc->xc_size == 0 || (str = xml_body(xc->xc_nodeset[0])) == NULL)
+	    str = "";
 	if (sscanf(str, "%lf",&n) != 1)
 	    n = NAN;
 	break;
@@ -303,24 +414,37 @@ ctx2number(xp_ctx *xc,
 	break;
     }
     *n0 = n;
-    retval = 0;
- done:
-    if (str)
-	free(str);
-    return retval;
+    return 0;
 }
 
 /*! Replace a nodeset of a XPATH context with a new nodeset 
+ * @param[in]  xc      XPATH context
+ * @param[in]  vec     Malloced vector, consumed by this function
+ * @param[in]  veclen  Length of vector
+ * If the context is in an arena, the vector is copied to the arena and freed
  */
 int
 ctx_nodeset_replace(xp_ctx   *xc,
 		    cxobj   **vec,
 		    size_t    veclen)
 {
-    if (xc->xc_nodeset)
-	free(xc->xc_nodeset);
-    xc->xc_nodeset = vec;
+    if (xc->xc_arena){
+	xc->xc_nodeset = NULL;
+	if (veclen &&
+	    (xc->xc_nodeset = clixon_arena_alloc(xc->xc_arena, veclen*sizeof(cxobj*))) == NULL)
+	    return -1;
+	if (veclen)
+	    memcpy(xc->xc_nodeset, vec, veclen*sizeof(cxobj*));
+	if (vec)
+	    free(vec);
+    }
+    else{
+	if (xc->xc_nodeset)
+	    free(xc->xc_nodeset);
+	xc->xc_nodeset = vec;
+    }
     xc->xc_size = veclen;
+    xc->xc_max = veclen;
     return 0;
 }
 
@@ -74,6 +74,7 @@
 
 /* clicon */
 #include "clixon_err.h"
+#include "clixon_arena.h"
 #include "clixon_log.h"
 #include "clixon_string.h"
 #include "clixon_queue.h"
@@ -82,6 +83,7 @@
 #include "clixon_yang.h"
 #include "clixon_xml.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
@@ -278,6 +280,81 @@ nodetest_recursive(cxobj      *xn,
     return retval;
 }
 
+/*! Append all descendant elements of a node matching a nodetest to a nodeset
+ * Same as nodetest_recursive but append to the nodeset of an xpath context
+ * @param[in]  xn        XML node
+ * @param[in]  nodetest  XPATH stack
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  xr        XPATH context whose nodeset is appended to
+ */
+static int
+nodetest_recursive_ctx(cxobj      *xn, 
+		       xpath_tree *nodetest,
+		       cvec       *nsc,
+		       int         localonly,
+		       xp_ctx     *xr)
+{
+    cxobj  *xsub; 
+
+    xsub = NULL;
+    while ((xsub = xml_child_each(xn, xsub, CX_ELMNT)) != NULL) {
+	if (nodetest_eval(xsub, nodetest, nsc, localonly) == 1)
+	    if (ctx_nodeset_append(xr, xsub) < 0)
+		return -1;
+	if (nodetest_recursive_ctx(xsub, nodetest, nsc, localonly, xr) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Get all descendant elements of a node matching a nodetest
+ *
+ * Use the element-name index of the tree if enabled and the nodetest is a name,
+ * otherwise make a recursive search.
+ * @param[in]  xn        XML node
+ * @param[in]  nodetest  XPATH stack
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  xr        XPATH context whose nodeset is appended to
+ * @see xml_index_descendants
+ */
+static int
+nodetest_descendants(cxobj      *xn, 
+		     xpath_tree *nodetest,
+		     cvec       *nsc,
+		     int         localonly,
+		     xp_ctx     *xr)
+{
+    int     retval = -1;
+    cxobj **xvec = NULL;
+    size_t  xlen = 0;
+    int     ret;
+    int     i;
+
+    if (nodetest->xs_type == XP_NODE &&
+	nodetest->xs_s1 != NULL &&
+	strcmp(nodetest->xs_s1, "*") != 0){
+	if ((ret = xml_index_descendants(xn, nodetest->xs_s1, &xvec, &xlen)) < 0)
+	    goto done;
+	if (ret == 1){
+	    for (i=0; i<xlen; i++)
+		if (nodetest_eval(xvec[i], nodetest, nsc, localonly) == 1)
+		    if (ctx_nodeset_append(xr, xvec[i]) < 0)
+			goto done;
+	    retval = 0;
+	    goto done;
+	}
+    }
+    if (nodetest_recursive_ctx(xn, nodetest, nsc, localonly, xr) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (xvec)
+	free(xvec);
+    return retval;
+}
+
 /*! Evaluate xpath step rule of an XML tree
  *
  * @param[in]  xc0  Incoming context
@@ -304,13 +381,15 @@ xp_eval_step(xp_ctx     *xc0,
     cxobj      *x;
     cxobj      *xv;
     cxobj      *xp;
-    cxobj     **vec = NULL;
-    size_t      veclen = 0;
     xpath_tree *nodetest = xs->xs_c0;
     xp_ctx     *xc = NULL;
     int         ret;
+    cxobj     **xvec = NULL; /* Candidates of indexed lookup */
+    size_t      xveclen = 0;
+    int         j;
+    yang_stmt  *ydef;
     
-    /* Create new xc */
+    /* Create new xc, axes that select new nodes rebuild its nodeset from xc0 */
     if ((xc = ctx_dup(xc0)) == NULL)
 	goto done;
     switch (xs->xs_int){
@@ -321,10 +400,11 @@ xp_eval_step(xp_ctx     *xc0,
     case A_ATTRIBUTE: /* principal node type is attribute */
 	break;
     case A_CHILD:
+	xc->xc_size = 0;
 	if (xc->xc_descendant){
-	    for (i=0; i<xc->xc_size; i++){
-		xv = xc->xc_nodeset[i];
-		if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+	    for (i=0; i<xc0->xc_size; i++){
+		xv = xc0->xc_nodeset[i];
+		if (nodetest_descendants(xv, nodetest, nsc, localonly, xc) < 0)
 		    goto done;
 	    }
 	    xc->xc_descendant = 0;
@@ -333,43 +413,54 @@ xp_eval_step(xp_ctx     *xc0,
 	    if (nodetest->xs_type==XP_NODE_FN &&
 		nodetest->xs_s0 &&
 		strcmp(nodetest->xs_s0,"current")==0){
-		if (cxvec_append(xc->xc_initial, &vec, &veclen) < 0)
+		if (ctx_nodeset_append(xc, xc->xc_initial) < 0)
 		    goto done;
 	    }
-	    else for (i=0; i<xc->xc_size; i++){ 
-		    xv = xc->xc_nodeset[i];
+	    else for (i=0; i<xc0->xc_size; i++){ 
+		    xv = xc0->xc_nodeset[i];
 		    x = NULL; 
-		    if ((ret = xpath_optimize_check(xs, xv, &x)) < 0)
+		    xveclen = 0;
+		    if ((ret = xpath_optimize_check(xs, xc, xv, nsc, localonly, &xvec, &xveclen)) < 0)
 			goto done;
-		    switch (ret){
-		    case 1: /* optimized */
-		    	if (x) /* keep only x */
-			    if (cxvec_append(x, &vec, &veclen) < 0)
-				goto done;
-			break;
-		    case 0: /* regular code */
-			if (ret == 0){ /* No optimization made */
-			    while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
-				/* xs->xs_c0 is nodetest */
-				if (nodetest == NULL || nodetest_eval(x, nodetest, nsc, localonly) == 1){
-				    if (cxvec_append(x, &vec, &veclen) < 0)
-					goto done;
-				}
+		    if (ret == 1){ /* optimized: check nodetest of candidates */
+			for (j=0; j<xveclen; j++){
+			    x = xvec[j];
+			    if (nodetest == NULL || nodetest_eval(x, nodetest, nsc, localonly) == 1){
+				if (ctx_nodeset_append(xc, x) < 0)
+				    goto done;
+			    }
+			}
+		    }
+		    else{ /* No optimization made */
+			while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+			    /* xs->xs_c0 is nodetest */
+			    if (nodetest == NULL || nodetest_eval(x, nodetest, nsc, localonly) == 1){
+				if (ctx_nodeset_append(xc, x) < 0)
+				    goto done;
 			    }
 			}
-		    } /* switch */
+			/* Absent leaf with default value: use virtual leaf */
+			if (nodetest && nodetest->xs_type == XP_NODE &&
+			    nodetest->xs_s1 && strcmp(nodetest->xs_s1, "*") != 0 &&
+			    (ydef = xml_default_leaf(xv, nodetest->xs_s1)) != NULL){
+			    if (xml_default_child(xv, ydef, &x) < 0)
+				goto done;
+			    if (nodetest_eval(x, nodetest, nsc, localonly) == 1)
+				if (ctx_nodeset_append(xc, x) < 0)
+				    goto done;
+			}
+		    }
 		}
 	}
-	ctx_nodeset_replace(xc, vec, veclen);
 	break;
     case A_DESCENDANT:
     case A_DESCENDANT_OR_SELF:
-	for (i=0; i<xc->xc_size; i++){
-	    xv = xc->xc_nodeset[i];
-	    if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+	xc->xc_size = 0;
+	for (i=0; i<xc0->xc_size; i++){
+	    xv = xc0->xc_nodeset[i];
+	    if (nodetest_descendants(xv, xs->xs_c0, nsc, localonly, xc) < 0)
 		goto done;
 	}
-	ctx_nodeset_replace(xc, vec, veclen);
 	break;
     case A_FOLLOWING:
 	break;
@@ -378,20 +469,13 @@ xp_eval_step(xp_ctx     *xc0,
     case A_NAMESPACE: /* principal node type is namespace */
 	break;
     case A_PARENT:
-	veclen = xc->xc_size;
-	vec = xc->xc_nodeset;
 	xc->xc_size = 0;
-	xc->xc_nodeset = NULL;
-	for (i=0; i<veclen; i++){
-	    x = vec[i];
+	for (i=0; i<xc0->xc_size; i++){
+	    x = xc0->xc_nodeset[i];
 	    if ((xp = xml_parent(x)) != NULL)
-		if (cxvec_append(xp, &xc->xc_nodeset, &xc->xc_size) < 0)
+		if (ctx_nodeset_append(xc, xp) < 0)
 		    goto done;
 	}
-	if (vec){
-	    free(vec);
-	    vec = NULL;
-	}
 	break;
     case A_PRECEDING:
 	break;
@@ -415,6 +499,8 @@ xp_eval_step(xp_ctx     *xc0,
     assert(*xrp);
     retval = 0;
  done:
+    if (xvec)
+	free(xvec);
     if (xc)
 	ctx_free(xc);
     return retval;
@@ -458,6 +544,8 @@ xp_eval_predicate(xp_ctx     *xc,
     int      i;
     cxobj   *x;
     xp_ctx  *xcc;
+    int      match;
+    clixon_arena_pos xm = {0,};
     
     if (xs->xs_c0 == NULL){ /* empty */
 	if ((xr0 = ctx_dup(xc)) == NULL)
@@ -470,49 +558,40 @@ xp_eval_predicate(xp_ctx     *xc,
     if (xs->xs_c1){
 	/* Loop over each node in the nodeset */
 	assert (xr0->xc_type == XT_NODESET);
-	if ((xr1 = malloc(sizeof(*xr1))) == NULL){
-	    clicon_err(OE_UNIX, errno, "malloc");
+	if ((xr1 = ctx_new(xc, XT_NODESET)) == NULL)
 	    goto done;
-	}
-	memset(xr1, 0, sizeof(*xr1));
-	xr1->xc_type = XT_NODESET;
 	xr1->xc_node = xc->xc_node;
-	xr1->xc_initial = xc->xc_initial;
 	for (i=0; i<xr0->xc_size; i++){
 	    x = xr0->xc_nodeset[i];
+	    /* Everything allocated when evaluating the predicate for this node
+	     * is released from the arena before the next node */
+	    clixon_arena_mark(xc->xc_arena, &xm);
 	    /* Create new context */
-	    if ((xcc = malloc(sizeof(*xcc))) == NULL){
-		clicon_err(OE_XML, errno, "malloc");
+	    if ((xcc = ctx_new(xc, XT_NODESET)) == NULL)
 		goto done;
-	    }
-	    memset(xcc, 0, sizeof(*xcc));
-	    xcc->xc_type = XT_NODESET;
-	    xcc->xc_initial = xc->xc_initial;
 	    xcc->xc_node = x;
 	    /* For each node in the node-set to be filtered, the PredicateExpr is
 	     * evaluated with that node as the context node */
-	    if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
+	    if (ctx_nodeset_append(xcc, x) < 0)
 		goto done;
 	    if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
 		goto done;
 	    if (xcc)
 		ctx_free(xcc);
-	    if (xrc->xc_type == XT_NUMBER){
+	    if (xrc->xc_type == XT_NUMBER)
 		/* If the result is a number, the result will be converted to true
 		   if the number is equal to the context position */
-		if ((int)xrc->xc_number == i)
-		    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
-			goto done;		    
-	    }
-	    else {
+		match = ((int)xrc->xc_number == i);
+	    else 
 		/* if PredicateExpr evaluates to true for that node, the node is 
 		   included in the new node-set */
-		if (ctx2boolean(xrc))
-		    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
-			goto done;		    
-	    }
+		match = ctx2boolean(xrc);
 	    if (xrc)
 		ctx_free(xrc);
+	    clixon_arena_release(xc->xc_arena, &xm);
+	    if (match)
+		if (ctx_nodeset_append(xr1, x) < 0)
+		    goto done;
 	}
 
     }
@@ -555,13 +634,8 @@ xp_logop(xp_ctx    *xc1,
     int     b1;
     int     b2;
     
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new(xc1, XT_BOOL)) == NULL)
 	goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
-    xr->xc_initial = xc1->xc_initial;
-    xr->xc_type = XT_BOOL;
     if ((b1 = ctx2boolean(xc1)) < 0)
 	goto done;
     if ((b2 = ctx2boolean(xc2)) < 0)
@@ -605,13 +679,8 @@ xp_numop(xp_ctx    *xc1,
     double  n1;
     double  n2;
     
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new(xc1, XT_NUMBER)) == NULL)
 	goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
-    xr->xc_initial = xc1->xc_initial;
-    xr->xc_type = XT_NUMBER;
     if (ctx2number(xc1, &n1) < 0)
 	goto done;
     if (ctx2number(xc2, &n2) < 0)
@@ -685,13 +754,8 @@ xp_relop(xp_ctx    *xc1,
     int     reverse = 0;
     double  n1, n2;
     
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new(xc1, XT_BOOL)) == NULL)
 	goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
-    xr->xc_initial = xc1->xc_initial;
-    xr->xc_type = XT_BOOL;
     if (xc1->xc_type == xc2->xc_type){ /* cases (2-3) above */
 	switch (xc1->xc_type){
 	case XT_NODESET:
@@ -885,19 +949,13 @@ xp_union(xp_ctx    *xc1,
 		   __FUNCTION__, clicon_int2str(xpopmap,op));
 	goto done;
     }
-    if ((xr = malloc(sizeof(*xr))) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if ((xr = ctx_new(xc1, XT_NODESET)) == NULL)
 	goto done;
-    }
-    memset(xr, 0, sizeof(*xr));
-    xr->xc_initial = xc1->xc_initial;
-    xr->xc_type = XT_NODESET;
-
     for (i=0; i<xc1->xc_size; i++)
-	if (cxvec_append(xc1->xc_nodeset[i], &xr->xc_nodeset, &xr->xc_size) < 0)
+	if (ctx_nodeset_append(xr, xc1->xc_nodeset[i]) < 0)
 	    goto done;
     for (i=0; i<xc2->xc_size; i++){
-	if (cxvec_append(xc2->xc_nodeset[i], &xr->xc_nodeset, &xr->xc_size) < 0)
+	if (ctx_nodeset_append(xr, xc2->xc_nodeset[i]) < 0)
 	    goto done;
     }
     *xrp = xr;
@@ -994,16 +1052,11 @@ xp_eval(xp_ctx     *xc,
 	use_xr0++;
 	/* Special case, no c0 or c1, single "/" */
 	if (xs->xs_c0 == NULL){
-	    if ((xr0 = malloc(sizeof(*xr0))) == NULL){
-		clicon_err(OE_UNIX, errno, "malloc");
+	    if ((xr0 = ctx_new(xc, XT_NODESET)) == NULL)
 		goto done;
-	    }
-	    memset(xr0, 0, sizeof(*xr0));
-	    xr0->xc_initial = xc->xc_initial;
-	    xr0->xc_type = XT_NODESET;
 	    x = NULL;
 	    while ((x = xml_child_each(xc->xc_node, x, CX_ELMNT)) != NULL) {
-		if (cxvec_append(x, &xr0->xc_nodeset, &xr0->xc_size) < 0)
+		if (ctx_nodeset_append(xr0, x) < 0)
 		    goto done;
 	    }
 	}
@@ -1020,24 +1073,15 @@ xp_eval(xp_ctx     *xc,
     case XP_PRI0:
 	break;
     case XP_PRIME_NR: /* primaryexpr -> [<number>] */
-	if ((xr0 = malloc(sizeof(*xr0))) == NULL){
-	    clicon_err(OE_UNIX, errno, "malloc");
+	if ((xr0 = ctx_new(xc, XT_NUMBER)) == NULL)
 	    goto done;
-	}
-	memset(xr0, 0, sizeof(*xr0));
-	xr0->xc_initial = xc->xc_initial;
-	xr0->xc_type = XT_NUMBER;
 	xr0->xc_number = xs->xs_double;
 	break;
     case XP_PRIME_STR:
-	if ((xr0 = malloc(sizeof(*xr0))) == NULL){
-	    clicon_err(OE_UNIX, errno, "malloc");
+	if ((xr0 = ctx_new(xc, XT_STRING)) == NULL)
+	    goto done;
+	if (xs->xs_s0 && ctx_string_set(xr0, xs->xs_s0) < 0)
 	    goto done;
-	}
-	memset(xr0, 0, sizeof(*xr0));
-	xr0->xc_initial = xc->xc_initial;
-	xr0->xc_type = XT_STRING;
-	xr0->xc_string = xs->xs_s0?strdup(xs->xs_s0):NULL;
 	break;
     case XP_PRIME_FN:
 	break;
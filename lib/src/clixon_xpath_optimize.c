@@ -33,6 +33,25 @@
 
  * Clixon XML XPATH 1.0 according to https://www.w3.org/TR/xpath-10
  * See XPATH_LIST_OPTIMIZE
+ *
+ * Indexed lookup of list and leaf-list steps.
+ * When an xpath is parsed, xpath_optimize() marks child steps whose leading 
+ * predicates are (conjunctions of) equalities of the form <name>=<value>, 
+ * where <name> is a child node or '.' and <value> is a literal, an absolute
+ * path or a current() relative path, eg:
+ *    y[k='3']    y[k1='a'][k2=3]    y[k1='a' and k2='b']    ll[.='x']
+ *    /ex:y[ex:k=current()/../ref]
+ * When evaluated, xpath_optimize_check() checks the yang of the step: if it
+ * is a list whose first keys (or a leaf-list whose value) are given, and it is
+ * sorted by system, the matching entries are found by binary search instead
+ * of a scan of all children. 
+ * The entries found are a superset of the result: the predicates are always 
+ * evaluated on them afterwards. Therefore non-key equalities, other 
+ * predicates following the equalities, etc, give the same result as the
+ * unoptimized evaluation. If any condition is not met, the step is evaluated
+ * as usual.
+ * If no leading keys are given, an equality on a non-key leaf with a value
+ * index, see CLICON_XMLDB_VALUE_INDEX, is looked up in the index instead.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -62,23 +81,52 @@
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
+#include "clixon_yang_type.h"
 #include "clixon_xml.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_xpath_optimize.h"
-
+#include "clixon_xpath_eval.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
-static xpath_tree *_xmtop = NULL; /* pattern match tree top */
-static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
+/*
+ * Types
+ */
+/* Value of an equality predicate */
+enum xpath_lookup_type{
+    XL_STRING, /* String literal */
+    XL_NUMBER, /* Number literal */
+    XL_PATH,   /* Absolute or current() relative path */
+};
+
+/* Equality predicate <name>=<value> of a step */
+struct xpath_lookup_eq{
+    char                  *xe_name; /* Child name, or NULL for '.' */
+    enum xpath_lookup_type xe_type;
+    char                  *xe_str;  /* String or number literal, NULL is '' */
+    xpath_tree            *xe_path; /* Location path if XL_PATH */
+};
+
+/* Indexed lookup of a step, see xpath_optimize() 
+ * Strings and paths point into the xpath tree of the step.
+ */
+struct xpath_lookup{
+    int                     xl_len;
+    struct xpath_lookup_eq *xl_vec;
+};
+
+/*
+ * Variables
+ */
 static int _optimize_enable = 1;
 static int _optimize_hits = 0;
 #endif /* XPATH_LIST_OPTIMIZE */
 
-
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset number of optimized lookups
+ * @param[out] hits  Number of steps evaluated with indexed lookup since last call
+ */
 int
 xpath_list_optimize_stats(int *hits)
 {
@@ -89,6 +137,9 @@ xpath_list_optimize_stats(int *hits)
     return 0;
 }
 
+/*! Enable or disable indexed lookup when evaluating xpaths (enabled by default)
+ * @param[in] enable  0: disable, 1: enable
+ */
 int
 xpath_list_optimize_set(int enable)
 {
@@ -101,240 +152,728 @@ xpath_list_optimize_set(int enable)
 void
 xpath_optimize_exit(void)
 {
-#ifdef XPATH_LIST_OPTIMIZE
-    if (_xmtop)
-	xpath_tree_free(_xmtop);
-#endif
 }
 
 #ifdef XPATH_LIST_OPTIMIZE
-/*! Initialize xpath module
- * XXX move to clixon_xpath.c 
- * @see loop_preds
+/*! Get operand of a relational expression if it is a single path or primary
+ * @param[in]  xt   XPath tree of type XP_ADD (addexpr)
+ * @retval     xo   XPath tree of type XP_LOCPATH or a primary expression
+ * @retval     NULL Not a single operand
  */
-int
-xpath_optimize_init(xpath_tree **xm,
-		    xpath_tree **xe)
+static xpath_tree *
+optimize_operand(xpath_tree *xt)
+{
+    if (xt == NULL || xt->xs_type != XP_ADD || xt->xs_c1)
+	return NULL;
+    if ((xt = xt->xs_c0) == NULL || xt->xs_type != XP_UNION || xt->xs_c1)
+	return NULL;
+    if ((xt = xt->xs_c0) == NULL || xt->xs_type != XP_PATHEXPR)
+	return NULL;
+    return xt->xs_c0;
+}
+
+/*! Check if a step has no predicates
+ */
+static int
+optimize_nopred(xpath_tree *xs)
+{
+    xpath_tree *xp = xs->xs_c1;
+
+    return xp == NULL || (xp->xs_type == XP_PRED && xp->xs_c0 == NULL && xp->xs_c1 == NULL);
+}
+
+/*! Check if operand is a child node or '.', ie the name side of an equality
+ * @param[in]  xo    Operand, see optimize_operand()
+ * @param[out] name  Child name, or NULL if '.'
+ * @retval     1     Yes
+ * @retval     0     No
+ */
+static int
+optimize_name(xpath_tree *xo,
+	      char      **name)
 {
-    int         retval = -1;
     xpath_tree *xs;
-    
-    if (_xm == NULL){
-	/* Initialize xpath-tree */
-	if (xpath_parse("_x[_y='_z']", &_xmtop) < 0) 
-	    goto done;
-	/* Go down two steps */
-	if ((_xm = xpath_tree_traverse(_xmtop, 0, 0, -1)) == NULL)
-	    goto done;
-	/* get nodetest tree (_x) */
-	if ((xs = xpath_tree_traverse(_xm, 0, -1)) == NULL)
-	    goto done;
-	xs->xs_match++;
-	/* get predicates [_y=_z][z=2] */
-	if ((xs = xpath_tree_traverse(_xm, 1, -1)) == NULL)
-	    goto done;
-	xs->xs_match++;
-	/* get expression [_y=_z] */
-	if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
-	    goto done;
-	/* get keyname (_y) */
-	if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
+    xpath_tree *xn;
+
+    if (xo->xs_type != XP_LOCPATH ||
+	(xs = xo->xs_c0) == NULL ||
+	xs->xs_type != XP_RELLOCPATH || xs->xs_c1)
+	return 0;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_STEP || !optimize_nopred(xs))
+	return 0;
+    xn = xs->xs_c0;
+    if (xs->xs_int == A_SELF && xn == NULL){
+	*name = NULL;
+	return 1;
+    }
+    if (xs->xs_int == A_CHILD && xn && xn->xs_type == XP_NODE &&
+	xn->xs_s1 && strcmp(xn->xs_s1, "*") != 0){
+	*name = xn->xs_s1;
+	return 1;
+    }
+    return 0;
+}
+
+/*! Check if operand is a value independent of the context node
+ * @param[in]  xo    Operand, see optimize_operand()
+ * @param[out] xe    Value is set in equality predicate 
+ * @retval     1     Yes
+ * @retval     0     No
+ */
+static int
+optimize_value(xpath_tree             *xo,
+	       struct xpath_lookup_eq *xe)
+{
+    xpath_tree *xs;
+
+    switch (xo->xs_type){
+    case XP_PRIME_STR:
+	xe->xe_type = XL_STRING;
+	xe->xe_str = xo->xs_s0;
+	return 1;
+    case XP_PRIME_NR:
+	xe->xe_type = XL_NUMBER;
+	xe->xe_str = xo->xs_strnr;
+	return 1;
+    case XP_LOCPATH:
+	if ((xs = xo->xs_c0) == NULL)
+	    return 0;
+	if (xs->xs_type == XP_RELLOCPATH){
+	    /* First step must be current() */
+	    while (xs && xs->xs_type == XP_RELLOCPATH)
+		xs = xs->xs_c0;
+	    if (xs == NULL || xs->xs_type != XP_STEP ||
+		xs->xs_c0 == NULL || xs->xs_c0->xs_type != XP_NODE_FN ||
+		xs->xs_c0->xs_s0 == NULL || strcmp(xs->xs_c0->xs_s0, "current") != 0)
+		return 0;
+	}
+	else if (xs->xs_type != XP_ABSPATH)
+	    return 0;
+	xe->xe_type = XL_PATH;
+	xe->xe_path = xo;
+	return 1;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Add an equality predicate to lookup of a step
+ * @param[in]  xl    Lookup
+ * @param[in]  xe    Equality predicate
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+optimize_add(struct xpath_lookup    *xl,
+	     struct xpath_lookup_eq *xe)
+{
+    if ((xl->xl_vec = realloc(xl->xl_vec, (xl->xl_len+1)*sizeof(*xe))) == NULL){
+	clicon_err(OE_XML, errno, "realloc");
+	return -1;
+    }
+    xl->xl_vec[xl->xl_len++] = *xe;
+    return 0;
+}
+
+/*! Collect equalities of a predicate expression
+ * @param[in]  xt    XPath tree of predicate expression (or sub-expression)
+ * @param[in]  xl    Lookup
+ * @retval     1     Expression is boolean, later predicates may also be used
+ * @retval     0     Expression may be positional, stop
+ * @retval    -1     Error
+ * Only equalities that are conjuncts of the expression are collected, others
+ * are ignored.
+ */
+static int
+optimize_expr(xpath_tree          *xt,
+	      struct xpath_lookup *xl)
+{
+    struct xpath_lookup_eq xe = {0,};
+    xpath_tree            *xo0;
+    xpath_tree            *xo1;
+
+    switch (xt->xs_type){
+    case XP_EXP:
+	if (xt->xs_c1) /* or */
+	    return 0;
+	return optimize_expr(xt->xs_c0, xl);
+    case XP_AND:
+	if (xt->xs_c1 == NULL)
+	    return optimize_expr(xt->xs_c0, xl);
+	if (xt->xs_int != XO_AND)
+	    return 0;
+	if (optimize_expr(xt->xs_c0, xl) < 0)
+	    return -1;
+	if (optimize_expr(xt->xs_c1, xl) < 0)
+	    return -1;
+	return 1;
+    case XP_RELEX:
+	if (xt->xs_c1 == NULL)
+	    return 0; /* eg [1] */
+	if (xt->xs_int != XO_EQ ||
+	    xt->xs_c0->xs_type != XP_RELEX || xt->xs_c0->xs_c1)
+	    return 1;
+	if ((xo0 = optimize_operand(xt->xs_c0->xs_c0)) == NULL ||
+	    (xo1 = optimize_operand(xt->xs_c1)) == NULL)
+	    return 1;
+	if (optimize_name(xo0, &xe.xe_name) && optimize_value(xo1, &xe)){
+	    if (optimize_add(xl, &xe) < 0)
+		return -1;
+	}
+	else if (optimize_name(xo1, &xe.xe_name) && optimize_value(xo0, &xe)){
+	    if (optimize_add(xl, &xe) < 0)
+		return -1;
+	}
+	return 1;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Collect equalities of the leading predicates of a step
+ * @param[in]  xp    XPath tree of type XP_PRED
+ * @param[in]  xl    Lookup
+ * @retval     1     All predicates are boolean
+ * @retval     0     Stopped at a predicate that may be positional
+ * @retval    -1     Error
+ */
+static int
+optimize_preds(xpath_tree          *xp,
+	       struct xpath_lookup *xl)
+{
+    int ret;
+
+    if (xp == NULL || xp->xs_type != XP_PRED)
+	return 1;
+    if ((ret = optimize_preds(xp->xs_c0, xl)) <= 0)
+	return ret;
+    if (xp->xs_c1 == NULL)
+	return 1;
+    return optimize_expr(xp->xs_c1, xl);
+}
+
+/*! Free indexed lookup of a step
+ * @param[in]  xl   Lookup
+ */
+int
+xpath_lookup_free(struct xpath_lookup *xl)
+{
+    if (xl->xl_vec)
+	free(xl->xl_vec);
+    free(xl);
+    return 0;
+}
+
+/*! Mark steps of an xpath tree that can be evaluated with indexed lookup
+ * @param[in]  xs   XPath tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xpath_optimize_check  where the lookup is made
+ */
+int
+xpath_optimize(xpath_tree *xs)
+{
+    int                  retval = -1;
+    struct xpath_lookup *xl = NULL;
+    xpath_tree          *xn;
+
+    if (xs->xs_type == XP_STEP &&
+	xs->xs_int == A_CHILD &&
+	xs->xs_lookup == NULL &&
+	(xn = xs->xs_c0) != NULL &&
+	xn->xs_type == XP_NODE &&
+	xn->xs_s1 && strcmp(xn->xs_s1, "*") != 0 &&
+	!optimize_nopred(xs)){
+	if ((xl = malloc(sizeof(*xl))) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
 	    goto done;
-	xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
-	/* get keyval (_z) */
-	if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, -1)) == NULL)
+	}
+	memset(xl, 0, sizeof(*xl));
+	if (optimize_preds(xs->xs_c1, xl) < 0)
 	    goto done;
-	xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
+	if (xl->xl_len){
+	    xs->xs_lookup = xl;
+	    xl = NULL;
+	}
     }
-    *xm = _xm;
-    *xe = _xe;
+    if (xs->xs_c0 && xpath_optimize(xs->xs_c0) < 0)
+	goto done;
+    if (xs->xs_c1 && xpath_optimize(xs->xs_c1) < 0)
+	goto done;
     retval = 0;
  done:
+    if (xl)
+	xpath_lookup_free(xl);
     return retval;
 }
 
+/*! Find yang data node child of a given name, if unique
+ * @param[in]  yp   Yang parent
+ * @param[in]  name Child name
+ * @retval     yc   Yang child
+ * @retval     NULL Not found, or same name in several modules (augment)
+ */
+static yang_stmt *
+optimize_child(yang_stmt *yp,
+	       char      *name)
+{
+    yang_stmt *yc = NULL;
+    yang_stmt *ys = NULL;
+
+    while ((ys = yn_each(yp, ys)) != NULL)
+	if (yang_datanode(ys) &&
+	    strcmp(yang_argument_get(ys), name) == 0){
+	    if (yc != NULL)
+		return NULL;
+	    yc = ys;
+	}
+    return yc;
+}
 
-/*! Recursive function to loop over all EXPR and pattern match them
- *
- * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
- * @param[out] cvk   Vector of <keyname>:<keyval> pairs
- * @retval    -1     Error
- * @retval     0     No match
- * @retval     1     Match
- * @see xpath_optimize_init
+/*! Find yang child of a given name that can be searched in sorted order
+ * @param[in]  yp   Yang of parent XML node
+ * @param[in]  name Child name
+ * @retval     yc   List or leaf-list ordered-by system, config data
+ * @retval     NULL Not found or not searchable
+ */
+static yang_stmt *
+optimize_yang(yang_stmt *yp,
+	      char      *name)
+{
+    yang_stmt *yc;
+    yang_stmt *y;
+
+    /* Children are sorted only if parent and its ancestors are config, see xml_sort */
+    for (y = yp; y && yang_keyword_get(y) != Y_MODULE && yang_keyword_get(y) != Y_SUBMODULE;
+	 y = yang_parent_get(y))
+	if (yang_config(y) == 0)
+	    return NULL;
+    if ((yc = optimize_child(yp, name)) == NULL ||
+	(yang_keyword_get(yc) != Y_LIST && yang_keyword_get(yc) != Y_LEAF_LIST))
+	return NULL;
+    if (yang_config(yc) == 0 || yang_find(yc, Y_ORDERED_BY, "user") != NULL)
+	return NULL;
+    return yc;
+}
+
+/*! Get value of an equality predicate
+ * @param[in]  xe      Equality predicate
+ * @param[in]  xc      XPath context of the step
+ * @param[in]  xv      Context node
+ * @param[in]  nsc     XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] str     Value, points into xpath or xml tree
+ * @param[out] number  Value is a number
+ * @retval     1       OK
+ * @retval     0       No value: path is empty, no node can match
+ * @retval     2       Cannot use value, do not optimize
+ * @retval    -1       Error
  */
 static int
-loop_preds(xpath_tree *xt,
-	   xpath_tree *xepat,
-	   cvec       *cvk)
+optimize_value_get(struct xpath_lookup_eq *xe,
+		   xp_ctx                 *xc,
+		   cxobj                  *xv,
+		   cvec                   *nsc,
+		   int                     localonly,
+		   char                  **str,
+		   int                    *number)
 {
-    int          retval = -1;
-    int          ret;
-    xpath_tree  *xe;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    cg_var      *cvi;
-	
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-	if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
+    int     retval = -1;
+    xp_ctx  xc0 = {0,};
+    xp_ctx *xr = NULL;
+
+    switch (xe->xe_type){
+    case XL_STRING:
+	*str = xe->xe_str?xe->xe_str:"";
+	*number = 0;
+	break;
+    case XL_NUMBER:
+	*str = xe->xe_str;
+	*number = 1;
+	break;
+    case XL_PATH:
+	xc0.xc_type = XT_NODESET;
+	xc0.xc_node = xv;
+	xc0.xc_initial = xc->xc_initial;
+	xc0.xc_arena = xc->xc_arena;
+	if (ctx_nodeset_append(&xc0, xv) < 0)
 	    goto done;
-	if (ret == 0)
-	    goto ok;
-    }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-	if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
+	if (xp_eval(&xc0, xe->xe_path, nsc, localonly, &xr) < 0)
 	    goto done;
-	if (ret == 0)
-	    goto ok;
-	if (veclen != 2)
-	    goto ok;
-	if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
-	    clicon_err(OE_XML, errno, "cvec_add");	
+	if (xr->xc_type != XT_NODESET || xr->xc_size > 1){
+	    retval = 2;
 	    goto done;
 	}
-	cv_name_set(cvi, vec[0]->xs_s1);
-	if (vec[1]->xs_type == XP_PRIME_NR)
-	    cv_string_set(cvi, vec[1]->xs_strnr);
-	else
-	    cv_string_set(cvi, vec[1]->xs_s0);
+	if (xr->xc_size == 0){
+	    retval = 0;
+	    goto done;
+	}
+	if ((*str = xml_body(xr->xc_nodeset[0])) == NULL){
+	    retval = 2;
+	    goto done;
+	}
+	*number = 0;
+	break;
     }
     retval = 1;
  done:
-    if (vec)
-	free(vec);
+    if (xc0.xc_arena == NULL && xc0.xc_nodeset)
+	free(xc0.xc_nodeset);
+    if (xr)
+	ctx_free(xr);
     return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
 }
 
-/*! Pattern matching to find fastpath
- *
- * @param[in]  xt     XPath tree
- * @param[in]  xv     XML base node
- * @param[out] xp     XML found node (retval == 1)
- * @param[out] key
- * @param[out] keyval
- * @retval    -1      Error
- * @retval     0      No match - use non-optimized lookup
- * @retval     1      Match
- *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+/*! Parse a value according to the type of a leaf or leaf-list
+ * @param[in]  y       Yang of leaf or leaf-list
+ * @param[in]  str     Value
+ * @param[in]  number  Value is an xpath number, then the type must be numeric
+ * @param[out] cvp     Typed value, free with cv_free
+ * @retval     1       OK
+ * @retval     0       Value cannot be compared by type, do not optimize
+ * @retval    -1       Error
  */
 static int
-xpath_list_optimize_fn(xpath_tree *xt,
-		       cxobj      *xv,
-		       cxobj     **xp)
+optimize_cv(yang_stmt *y,
+	    char      *str,
+	    int        number,
+	    cg_var   **cvp)
 {
     int          retval = -1;
-    xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
-    char        *name;
-    yang_stmt   *yp;
-    yang_stmt   *yc;
-    cvec        *cvv = NULL;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    xpath_tree  *xtp;
+    enum cv_type cvtype;
+    uint8_t      fraction = 0;
+    cg_var      *cv = NULL;
+    char        *reason = NULL;
     int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
-    cg_var      *cvi;
-    int          i;
-    
-    /* revert to non-optimized if no yang */
-    if ((yp = xml_spec(xv)) == NULL)
-	goto ok;
-    /* or if not config data (state data should not be ordered) */
-    if (yang_config(yp) == 0)
-	goto ok;
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
-    /* Here is where pattern is checked for equality and where variable binding is made (if
-     * equal) */
-    if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
+
+    if (yang_leaftype_cv(y, &cvtype, &fraction) < 0)
 	goto done;
-    if (ret == 0)
-	goto ok; /* no match */
-    if (veclen != 2)
-	goto ok;
-    name = vec[0]->xs_s1;
-    /* Extract variables XXX strdups */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET
-	if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-	    goto ok; 
-    /* Validate keys */
-    if ((cvv = yang_cvec_get(yc)) == NULL)
-	goto ok;
-    xtp = vec[1];
-    if ((cvk = cvec_new(0)) == NULL){
-	clicon_err(OE_YANG, errno, "cvec_new");	
+    switch (cvtype){
+    case CGV_ERR:
+	retval = 0;
 	goto done;
+    case CGV_INT8: case CGV_INT16: case CGV_INT32: case CGV_INT64:
+    case CGV_UINT8: case CGV_UINT16: case CGV_UINT32: case CGV_UINT64:
+    case CGV_DEC64:
+	break;
+    default:
+	if (number){ /* Number comparison of non-numeric type */
+	    retval = 0;
+	    goto done;
+	}
+	break;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    if ((cv = cv_new(cvtype)) == NULL){
+	clicon_err(OE_YANG, errno, "cv_new");
+	goto done;
+    }
+    if (cvtype == CGV_DEC64)
+	cv_dec64_n_set(cv, fraction);
+    if ((ret = cv_parse1(str, cv, &reason)) < 0){
+	clicon_err(OE_YANG, errno, "cv_parse1");
 	goto done;
-    if (ret == 0)
-	goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
-	goto ok;
-    i = 0;
-    cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-	if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i)))){
-	    fprintf(stderr, "%s key name mismatch %s vs %s\n",
-		    __FUNCTION__, cv_name_get(cvi), cv_string_get(cvec_i(cvv,i)));
-	    goto ok;
-	}
-	i++;
     }
-    if (xml_binsearch(xv, yc, cvk, xp) < 0)
+    if (ret == 0){ /* Not a value of the type: compare as strings */
+	retval = 0;
 	goto done;
-    retval = 1; /* match */
+    }
+    *cvp = cv;
+    cv = NULL;
+    retval = 1;
  done:
-    if (vec)
-	free(vec);
-    if (cvk)
-	cvec_free(cvk);
+    if (reason)
+	free(reason);
+    if (cv)
+	cv_free(cv);
     return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
+}
+
+/*! Add a leaf with a typed value to a search object
+ * @param[in]  xp   Parent
+ * @param[in]  y    Yang of leaf 
+ * @param[in]  str  Value
+ * @param[in]  cv   Typed value, consumed
+ */
+static cxobj *
+optimize_leaf(cxobj     *xp,
+	      char      *name,
+	      yang_stmt *y,
+	      char      *str,
+	      cg_var    *cv)
+{
+    cxobj *x = xp;
+    cxobj *xb;
+
+    if (name && (x = xml_new(name, xp, y)) == NULL)
+	goto err;
+    if ((xb = xml_new("body", x, NULL)) == NULL)
+	goto err;
+    xml_type_set(xb, CX_BODY);
+    if (xml_value_set(xb, str) < 0)
+	goto err;
+    xml_cv_set(x, cv);
+    return x;
+ err:
+    cv_free(cv);
+    return NULL;
+}
+
+/*! Compare search object with a child, in the order of xml_sort
+ * @retval  <0 / 0 / >0  xs is before / equal to / after xc
+ * @retval  INT_MIN      Child has no yang, children may not be sorted
+ */
+static int
+optimize_cmp(cxobj *xs,
+	     int    yangi,
+	     cxobj *xc)
+{
+    yang_stmt *y;
+    int        cmp;
+
+    if ((y = xml_spec(xc)) == NULL)
+	return INT_MIN;
+    if ((cmp = yangi - yang_order(y)) != 0)
+	return cmp;
+    return xml_cmp(xs, xc, 0);
+}
+
+/*! Find all children equal to a search object by binary search
+ * @param[in]  xv      Parent XML node
+ * @param[in]  xs      Search object, list entry with a prefix of its keys or leaf-list
+ * @param[in]  yc      Yang of search object
+ * @param[out] vec     Vector of matching children (appended)
+ * @param[out] veclen  Length of vec
+ * @retval     1       OK
+ * @retval     0       Children not sorted, do not optimize
+ * @retval    -1       Error
+ * Since list entries are sorted by their keys in yang order, entries matching
+ * the first keys are consecutive. Only made if the children of xv are known to
+ * be sorted, see xml_sorted.
+ */
+static int
+optimize_search(cxobj     *xv,
+		cxobj     *xs,
+		yang_stmt *yc,
+		cxobj   ***vec,
+		size_t    *veclen)
+{
+    int    low;
+    int    upper;
+    int    mid;
+    int    yangi;
+    int    cmp;
+    cxobj *xc;
+    size_t len0 = *veclen;
+
+    if (!xml_sorted(xv))
+	return 0;
+    upper = xml_child_nr(xv);
+    /* Skip attributes, they are first */
+    for (low=0; low<upper; low++)
+	if ((xc = xml_child_i(xv, low)) == NULL || xml_type(xc) != CX_ATTR)
+	    break;
+    yangi = yang_order(yc);
+    /* Find first child not before xs */
+    while (low < upper){
+	mid = (low + upper) / 2;
+	if ((cmp = optimize_cmp(xs, yangi, xml_child_i(xv, mid))) == INT_MIN)
+	    return 0;
+	if (cmp > 0)
+	    low = mid + 1;
+	else
+	    upper = mid;
+    }
+    for (; low < xml_child_nr(xv); low++){
+	xc = xml_child_i(xv, low);
+	if ((cmp = optimize_cmp(xs, yangi, xc)) == INT_MIN){
+	    *veclen = len0;
+	    return 0;
+	}
+	if (cmp != 0)
+	    break;
+	if (cxvec_append(xc, vec, veclen) < 0)
+	    return -1;
+    }
+    return 1;
+}
+
+/*! Find list entries by a value index of a non-key leaf
+ * @param[in]  xl      Lookup of step
+ * @param[in]  yc      Yang of list
+ * @param[in]  xc      XPath context of the step
+ * @param[in]  xv      Context node, parent of list entries
+ * @param[in]  nsc     XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] vec     Vector of matching list entries (appended)
+ * @param[out] veclen  Length of vec
+ * @retval     1       OK, entries found by index
+ * @retval     0       No equality on an indexed leaf, do not optimize
+ * @retval    -1       Error
+ * Values are compared as strings, as xpath does for a node and a string.
+ * @see xml_index_value_lookup
+ */
+static int
+optimize_value_index(struct xpath_lookup *xl,
+		     yang_stmt           *yc,
+		     xp_ctx              *xc,
+		     cxobj               *xv,
+		     cvec                *nsc,
+		     int                  localonly,
+		     cxobj             ***vec,
+		     size_t              *veclen)
+{
+    struct xpath_lookup_eq *xe;
+    yang_stmt              *yk;
+    char                   *str;
+    int                     number;
+    int                     i;
+    int                     ret;
+
+    for (i=0; i<xl->xl_len; i++){
+	xe = &xl->xl_vec[i];
+	if (xe->xe_name == NULL || xe->xe_type == XL_NUMBER)
+	    continue;
+	if ((yk = optimize_child(yc, xe->xe_name)) == NULL ||
+	    yang_keyword_get(yk) != Y_LEAF)
+	    continue;
+	if ((ret = optimize_value_get(xe, xc, xv, nsc, localonly, &str, &number)) < 0)
+	    return -1;
+	if (ret != 1)
+	    continue;
+	if ((ret = xml_index_value_lookup(xv, yk, str, vec, veclen)) != 0)
+	    return ret;
+    }
+    return 0;
 }
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/*! Identify XPATH special cases and if match, use binary search.
+/*! Evaluate a child step with indexed lookup if possible
  *
+ * @param[in]  xs      XPath tree of type XP_STEP
+ * @param[in]  xc      XPath context of the step
+ * @param[in]  xv      Context node, search among its children
+ * @param[in]  nsc     XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] vec     Candidate children (appended), the nodetest and predicates
+ *                     of the step should still be evaluated on them
+ * @param[out] veclen  Length of vec
  * @retval -1  Error
  * @retval  0  Dont optimize: not special case, do normal processing
- * @retval  1  Optimization made, special case, use x (found if != NULL)
+ * @retval  1  Optimization made, candidates in vec
+ * @see xpath_optimize  where steps are marked
  */
 int
 xpath_optimize_check(xpath_tree *xs,
+		     xp_ctx     *xc,
 		     cxobj      *xv,
-    		     cxobj     **xp)
-
+		     cvec       *nsc,
+		     int         localonly,
+		     cxobj    ***vec,
+		     size_t     *veclen)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    int    ret;
-    
-    if (!_optimize_enable)
+    int                     retval = -1;
+    struct xpath_lookup    *xl;
+    struct xpath_lookup_eq *xe = NULL;
+    yang_stmt              *yp;
+    yang_stmt              *yc;
+    yang_stmt              *yk;
+    cvec                   *cvk;
+    cg_var                 *cvi;
+    cg_var                 *cv = NULL;
+    cxobj                  *xsearch = NULL;
+    char                   *keyname;
+    char                   *str;
+    int                     number;
+    int                     i;
+    int                     n;
+    int                     ret;
+
+    if (!_optimize_enable || (xl = xs->xs_lookup) == NULL)
 	return 0; /* use regular code */
-    if ((ret = xpath_list_optimize_fn(xs, xv, xp)) < 0)
-	return -1;
-    if (ret == 1){
-	_optimize_hits++;
-	return 1; /* Optimized */
+    if ((yp = xml_spec(xv)) == NULL ||
+	(yc = optimize_yang(yp, xs->xs_c0->xs_s1)) == NULL)
+	return 0;
+    if ((xsearch = xml_new(yang_argument_get(yc), NULL, yc)) == NULL)
+	goto done;
+    n = 0; /* Number of leading keys given, or leaf-list value */
+    if (yang_keyword_get(yc) == Y_LIST){
+	cvk = yang_cvec_get(yc); /* Use Y_LIST cache, see ys_populate_list() */
+	cvi = NULL;
+	while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+	    keyname = cv_string_get(cvi);
+	    for (i=0; i<xl->xl_len; i++){
+		xe = &xl->xl_vec[i];
+		if (xe->xe_name && strcmp(xe->xe_name, keyname) == 0)
+		    break;
+	    }
+	    if (i == xl->xl_len)
+		break;
+	    if ((yk = optimize_child(yc, keyname)) == NULL ||
+		yang_keyword_get(yk) != Y_LEAF)
+		break;
+	    if ((ret = optimize_value_get(xe, xc, xv, nsc, localonly, &str, &number)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto empty;
+	    if (ret == 2)
+		break;
+	    if ((ret = optimize_cv(yk, str, number, &cv)) < 0)
+		goto done;
+	    if (ret == 0)
+		break;
+	    if (optimize_leaf(xsearch, keyname, yk, str, cv) == NULL)
+		goto done;
+	    n++;
+	}
     }
-    else
-	return 0; /* use regular code */
+    else { /* Y_LEAF_LIST */
+	for (i=0; i<xl->xl_len; i++)
+	    if (xl->xl_vec[i].xe_name == NULL)
+		break;
+	if (i < xl->xl_len){
+	    xe = &xl->xl_vec[i];
+	    if ((ret = optimize_value_get(xe, xc, xv, nsc, localonly, &str, &number)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto empty;
+	    if (ret == 1){
+		if ((ret = optimize_cv(yc, str, number, &cv)) < 0)
+		    goto done;
+		if (ret == 1){
+		    if (optimize_leaf(xsearch, NULL, yc, str, cv) == NULL)
+			goto done;
+		    n++;
+		}
+	    }
+	}
+    }
+    if (n == 0){ /* No leading keys, try value index of other leafs */
+	if (yang_keyword_get(yc) != Y_LIST)
+	    goto ok;
+	if ((ret = optimize_value_index(xl, yc, xc, xv, nsc, localonly, vec, veclen)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto ok;
+	goto empty;
+    }
+    if ((ret = optimize_search(xv, xsearch, yc, vec, veclen)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+ empty:
+    _optimize_hits++;
+    retval = 1;
+ done:
+    if (xsearch)
+	xml_free(xsearch);
+    return retval;
+ ok: /* no match, not special case */
+    retval = 0;
+    goto done;
 #else
     return 0; /* use regular code */
 #endif
 }
-
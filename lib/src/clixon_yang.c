@@ -42,11 +42,13 @@
  *                                     v                       v   v
  * yang_spec_parse_file-> yang_parse_post->yang_parse_recurse->yang_parse_module
  *                    \   /                                         v
- * yang_spec_load_dir ------------------------------------> yang_parse_filename
- *                                                                 v  
- *                                                          yang_parse_file
- *                                                                 v  
- *                                                          yang_parse_str
+ * yang_spec_load_dir ------------------------------> yang_parse_filename_cache
+ *                                                           v            v
+ *                                            yang_cache_read  yang_parse_filename
+ *                                                                        v  
+ *                                                                 yang_parse_file
+ *                                                                        v  
+ *                                                                 yang_parse_str
  */
 
 #ifdef HAVE_CONFIG_H
@@ -70,6 +72,7 @@
 #include <libgen.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/time.h>
 #include <netinet/in.h>
 #include <libgen.h>
 
@@ -94,10 +97,15 @@
 #include "clixon_yang_cardinality.h"
 #include "clixon_yang_internal.h" /* internal */
 #include "clixon_yang_type.h"
+#include "clixon_yang_cache.h"
 
 /* Size of json read buffer when reading from file*/
 #define BUFLEN 1024
 
+/* Build child lookup index only for yang statements with at least this many
+ * (data/schema) children, linear search is faster for fewer */
+#define YANG_INDEX_MIN 8
+
 /*
  * Local variables
  */
@@ -286,6 +294,74 @@ ys_new(enum rfc_6020 keyw)
     return ys;
 }
 
+/*! Free child lookup index of a yang statement */
+static int
+ys_index_free(yang_stmt *ys)
+{
+    yang_index *yx;
+
+    if ((yx = ys->ys_index) != NULL){
+	if (yx->yx_stmt)
+	    free(yx->yx_stmt);
+	if (yx->yx_data)
+	    free(yx->yx_data);
+	if (yx->yx_schema)
+	    free(yx->yx_schema);
+	free(yx);
+	ys->ys_index = NULL;
+    }
+    return 0;
+}
+
+/*! Invalidate lookup indexes and orders after children of yp are changed
+ * Data and schema node indexes look through choice and case, so also 
+ * invalidate ancestors up to the first non choice/case node.
+ * Orders are reset for nodes whose order may have changed: after a prune all 
+ * siblings, after an append only if a choice/case grows. Top-level orders of 
+ * later modules are also reset since they depend on number of children in 
+ * preceding modules.
+ * @param[in]  yp     Yang statement whose children were inserted or pruned
+ * @param[in]  prune  If set, a child was removed, else a child was appended
+ */
+static int
+ys_index_invalidate(yang_stmt *yp,
+		    int        prune)
+{
+    int        i;
+    int        j;
+    yang_stmt *yspec;
+    yang_stmt *ym;
+    
+    while (yp != NULL){
+	ys_index_free(yp);
+	if (yp->ys_keyword != Y_CHOICE && yp->ys_keyword != Y_CASE)
+	    break;
+	prune++; /* choice/case changed, reset orders in real parent */
+	yp = yp->ys_parent;
+    }
+    if (yp == NULL)
+	goto done;
+    if (prune)
+	for (i=0; i<yp->ys_len; i++)
+	    if (yp->ys_stmt[i])
+		yp->ys_stmt[i]->ys_order = 0;
+    if ((yp->ys_keyword == Y_MODULE || yp->ys_keyword == Y_SUBMODULE) &&
+	(yspec = yp->ys_parent) != NULL){
+	for (i=0; i<yspec->ys_len; i++)
+	    if (yspec->ys_stmt[i] == yp)
+		break;
+	for (i++; i<yspec->ys_len; i++){
+	    if ((ym = yspec->ys_stmt[i]) == NULL)
+		continue;
+	    for (j=0; j<ym->ys_len; j++)
+		if (ym->ys_stmt[j])
+		    ym->ys_stmt[j]->ys_order = 0;
+	}
+    }
+ done:
+    return 0;
+}
+
 /*! Free a single yang statement */
 static int 
 ys_free1(yang_stmt *ys)
@@ -298,6 +374,9 @@ ys_free1(yang_stmt *ys)
 	cvec_free(ys->ys_cvec);
     if (ys->ys_typecache)
 	yang_type_cache_free(ys->ys_typecache);
+    if (ys->ys_leaftype)
+	yang_leaftype_free(ys->ys_leaftype);
+    ys_index_free(ys);
     free(ys);
     return 0;
 }
@@ -325,6 +404,7 @@ ys_prune(yang_stmt *yp,
 	    &yp->ys_stmt[i+1],
 	    size);
     yp->ys_stmt[yp->ys_len--] = NULL;
+    ys_index_invalidate(yp, 1);
  done:
     return yc;
 }
@@ -364,6 +444,7 @@ yspec_free(yang_stmt *yspec)
     }
     if (yspec->ys_stmt)
 	free(yspec->ys_stmt);
+    ys_index_free(yspec);
     free(yspec);
     return 0;
 }
@@ -427,6 +508,11 @@ ys_cp(yang_stmt *ynew,
 	if (yang_type_cache_cp(&ynew->ys_typecache, yold->ys_typecache) < 0)
 	    goto done;
     }
+    /* Resolved leaf type points into old tree, re-resolve on demand */
+    ynew->ys_leaftype = NULL;
+    /* Order and index depend on position in tree */
+    ynew->ys_order = 0;
+    ynew->ys_index = NULL;
     for (i=0; i<ynew->ys_len; i++){
 	yco = yold->ys_stmt[i];
 	if ((ycn = ys_dup(yco)) == NULL)
@@ -483,6 +569,7 @@ yn_insert(yang_stmt *ys_parent,
 	return -1;
     ys_parent->ys_stmt[pos] = ys_child;
     ys_child->ys_parent = ys_parent;
+    ys_index_invalidate(ys_parent, 0);
     return 0;
 }
 
@@ -522,6 +609,248 @@ yn_each(yang_stmt *yparent,
     return yc;
 }
 
+/* Yang statement and its position, used when sorting indexes */
+struct ys_pos{
+    yang_stmt *yp_ys;
+    int        yp_pos;
+};
+
+/*! Compare argument strings, NULL is smallest */
+static int
+ys_argcmp(char *a1,
+	  char *a2)
+{
+    if (a1 == NULL)
+	return a2 == NULL ? 0 : -1;
+    if (a2 == NULL)
+	return 1;
+    return strcmp(a1, a2);
+}
+
+/*! qsort compare of index entries on keyword, argument and position */
+static int
+ys_pos_cmp_keyword(const void *arg1,
+		   const void *arg2)
+{
+    const struct ys_pos *p1 = arg1;
+    const struct ys_pos *p2 = arg2;
+    int                  eq;
+
+    if ((eq = p1->yp_ys->ys_keyword - p2->yp_ys->ys_keyword) != 0)
+	return eq;
+    if ((eq = ys_argcmp(p1->yp_ys->ys_argument, p2->yp_ys->ys_argument)) != 0)
+	return eq;
+    return p1->yp_pos - p2->yp_pos;
+}
+
+/*! qsort compare of index entries on argument and position */
+static int
+ys_pos_cmp_argument(const void *arg1,
+		    const void *arg2)
+{
+    const struct ys_pos *p1 = arg1;
+    const struct ys_pos *p2 = arg2;
+    int                  eq;
+
+    if ((eq = ys_argcmp(p1->yp_ys->ys_argument, p2->yp_ys->ys_argument)) != 0)
+	return eq;
+    return p1->yp_pos - p2->yp_pos;
+}
+
+/*! Collect data or schema nodes of yn in the order they are found by 
+ * yang_find_datanode / yang_find_schemanode, ie also via choice and case
+ * @param[in]     yn      Yang node
+ * @param[in]     schema  If set collect schema nodes, else data nodes
+ * @param[in,out] vec     Vector of yang statements and positions
+ * @param[in,out] len     Length of vec
+ * @retval        0       OK
+ * @retval       -1       Error
+ */
+static int
+ys_index_collect(yang_stmt      *yn,
+		 int             schema,
+		 struct ys_pos **vec,
+		 int            *len)
+{
+    int        retval = -1;
+    yang_stmt *ys;
+    yang_stmt *yc;
+    int        i;
+    int        j;
+
+    for (i=0; i<yn->ys_len; i++){
+	ys = yn->ys_stmt[i];
+	if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
+	    for (j=0; j<ys->ys_len; j++){
+		yc = ys->ys_stmt[j];
+		if (yc->ys_keyword == Y_CASE){
+		    if (ys_index_collect(yc, schema, vec, len) < 0)
+			goto done;
+		    continue;
+		}
+		if (schema ? !yang_schemanode(yc) : !yang_datanode(yc))
+		    continue;
+		if ((*vec = realloc(*vec, (*len+1)*sizeof(**vec))) == NULL){
+		    clicon_err(OE_YANG, errno, "realloc");
+		    goto done;
+		}
+		(*vec)[*len].yp_ys = yc;
+		(*vec)[*len].yp_pos = *len;
+		(*len)++;
+	    }
+	}
+	else if (schema ? yang_schemanode(ys) : yang_datanode(ys)){
+	    if ((*vec = realloc(*vec, (*len+1)*sizeof(**vec))) == NULL){
+		clicon_err(OE_YANG, errno, "realloc");
+		goto done;
+	    }
+	    (*vec)[*len].yp_ys = ys;
+	    (*vec)[*len].yp_pos = *len;
+	    (*len)++;
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Sort collected yang statements and store them as an index vector
+ * @param[in]  vec    Vector of yang statements and positions (sorted here)
+ * @param[in]  len    Length of vec
+ * @param[in]  cmp    qsort compare function
+ * @param[out] yvec   Sorted vector of yang statements (malloced)
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+ys_index_sort(struct ys_pos *vec,
+	      int            len,
+	      int          (*cmp)(const void *, const void *),
+	      yang_stmt   ***yvec)
+{
+    int i;
+
+    qsort(vec, len, sizeof(*vec), cmp);
+    if ((*yvec = calloc(len, sizeof(yang_stmt *))) == NULL){
+	clicon_err(OE_YANG, errno, "calloc");
+	return -1;
+    }
+    for (i=0; i<len; i++)
+	(*yvec)[i] = vec[i].yp_ys;
+    return 0;
+}
+
+/*! Build child lookup index of a yang statement
+ * Only statements with at least YANG_INDEX_MIN children get an index
+ * @param[in]  ys   Yang statement
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+ys_index_build(yang_stmt *ys)
+{
+    int            retval = -1;
+    yang_index    *yx = NULL;
+    struct ys_pos *vec = NULL;
+    int            len = 0;
+    int            i;
+
+    ys_index_free(ys);
+    if (ys->ys_len < YANG_INDEX_MIN)
+	goto ok;
+    if ((yx = malloc(sizeof(*yx))) == NULL){
+	clicon_err(OE_YANG, errno, "malloc");
+	goto done;
+    }
+    memset(yx, 0, sizeof(*yx));
+    /* All children on keyword and argument */
+    if ((vec = calloc(ys->ys_len, sizeof(*vec))) == NULL){
+	clicon_err(OE_YANG, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<ys->ys_len; i++){
+	vec[i].yp_ys = ys->ys_stmt[i];
+	vec[i].yp_pos = i;
+    }
+    if (ys_index_sort(vec, ys->ys_len, ys_pos_cmp_keyword, &yx->yx_stmt) < 0)
+	goto done;
+    yx->yx_nstmt = ys->ys_len;
+    free(vec);
+    vec = NULL;
+    /* Data nodes */
+    if (ys_index_collect(ys, 0, &vec, &len) < 0)
+	goto done;
+    if (len >= YANG_INDEX_MIN){
+	if (ys_index_sort(vec, len, ys_pos_cmp_argument, &yx->yx_data) < 0)
+	    goto done;
+	yx->yx_ndata = len;
+    }
+    if (vec){
+	free(vec);
+	vec = NULL;
+    }
+    len = 0;
+    /* Schema nodes */
+    if (ys_index_collect(ys, 1, &vec, &len) < 0)
+	goto done;
+    if (len >= YANG_INDEX_MIN){
+	if (ys_index_sort(vec, len, ys_pos_cmp_argument, &yx->yx_schema) < 0)
+	    goto done;
+	yx->yx_nschema = len;
+    }
+    ys->ys_index = yx;
+    yx = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (vec)
+	free(vec);
+    if (yx){
+	ys->ys_index = yx;
+	ys_index_free(ys);
+    }
+    return retval;
+}
+
+/*! Binary search for first yang statement in sorted index vector
+ * @param[in]  vec      Index vector sorted on (keyword,) argument and position
+ * @param[in]  len      Length of vec
+ * @param[in]  keyword  Keyword to match, or 0 if vec is sorted on argument only
+ * @param[in]  argument Argument to match
+ * @retval     ys       First matching yang statement in yang order
+ * @retval     NULL     Not found
+ */
+static yang_stmt *
+ys_index_search(yang_stmt **vec,
+		int         len,
+		int         keyword,
+		const char *argument)
+{
+    int        low = 0;
+    int        upper = len;
+    int        mid;
+    int        eq;
+    yang_stmt *ys;
+
+    while (low < upper){ /* Find leftmost match */
+	mid = (low + upper) / 2;
+	ys = vec[mid];
+	if ((eq = keyword ? (int)ys->ys_keyword - keyword : 0) == 0)
+	    eq = ys->ys_argument ? strcmp(ys->ys_argument, argument) : -1;
+	if (eq < 0)
+	    low = mid + 1;
+	else
+	    upper = mid;
+    }
+    if (low < len){
+	ys = vec[low];
+	if ((keyword == 0 || (int)ys->ys_keyword == keyword) &&
+	    ys->ys_argument && strcmp(ys->ys_argument, argument) == 0)
+	    return ys;
+    }
+    return NULL;
+}
+
 /*! Find first child yang_stmt with matching keyword and argument
  *
  * @param[in]  yn         Yang node, current context node.
@@ -545,13 +874,18 @@ yang_find(yang_stmt  *yn,
     yang_stmt *yspec;
     yang_stmt *ym;
 
-    for (i=0; i<yn->ys_len; i++){
-	ys = yn->ys_stmt[i];
-	if (keyword == 0 || ys->ys_keyword == keyword){
-	    if (argument == NULL ||
-		(ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)){
-		yret = ys;
-		break;
+    if (yn->ys_index && keyword != 0 && argument != NULL)
+	yret = ys_index_search(yn->ys_index->yx_stmt, yn->ys_index->yx_nstmt,
+			       keyword, argument);
+    else {
+	for (i=0; i<yn->ys_len; i++){
+	    ys = yn->ys_stmt[i];
+	    if (keyword == 0 || ys->ys_keyword == keyword){
+		if (argument == NULL ||
+		    (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)){
+		    yret = ys;
+		    break;
+		}
 	    }
 	}
     }
@@ -625,34 +959,41 @@ yang_find_datanode(yang_stmt *yn,
     char      *name;
     int        i, j;
 
-    for (i=0; i<yn->ys_len; i++){
-	ys = yn->ys_stmt[i];
-	if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
-	    for (j=0; j<ys->ys_len; j++){
-		yc = ys->ys_stmt[j];
-		if (yc->ys_keyword == Y_CASE) /* Look for its children */
-		    ysmatch = yang_find_datanode(yc, argument);
-		else
-		    if (yang_datanode(yc)){
-			if (argument == NULL)
-			    ysmatch = yc;
-			else
-			    if (yc->ys_argument && strcmp(argument, yc->ys_argument) == 0)
+    if (argument != NULL && yn->ys_index && yn->ys_index->yx_data != NULL){
+	if ((ysmatch = ys_index_search(yn->ys_index->yx_data, yn->ys_index->yx_ndata,
+				       0, argument)) != NULL)
+	    goto match;
+    }
+    else {
+	for (i=0; i<yn->ys_len; i++){
+	    ys = yn->ys_stmt[i];
+	    if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
+		for (j=0; j<ys->ys_len; j++){
+		    yc = ys->ys_stmt[j];
+		    if (yc->ys_keyword == Y_CASE) /* Look for its children */
+			ysmatch = yang_find_datanode(yc, argument);
+		    else
+			if (yang_datanode(yc)){
+			    if (argument == NULL)
 				ysmatch = yc;
-		    }
-		if (ysmatch)
-		    goto match;
-	    }
-	} /* Y_CHOICE */
-	else{
-	    if (yang_datanode(ys)){
-		if (argument == NULL)
-		    ysmatch = ys;
-		else
-		    if (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)
+			    else
+				if (yc->ys_argument && strcmp(argument, yc->ys_argument) == 0)
+				    ysmatch = yc;
+			}
+		    if (ysmatch)
+			goto match;
+		}
+	    } /* Y_CHOICE */
+	    else{
+		if (yang_datanode(ys)){
+		    if (argument == NULL)
 			ysmatch = ys;
-		if (ysmatch)
-		    goto match;
+		    else
+			if (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)
+			    ysmatch = ys;
+		    if (ysmatch)
+			goto match;
+		}
 	    }
 	}
     }
@@ -693,35 +1034,42 @@ yang_find_schemanode(yang_stmt *yn,
     char      *name;
     int        i, j;
 
-    for (i=0; i<yn->ys_len; i++){
-	ys = yn->ys_stmt[i];
-	if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
-	    for (j=0; j<ys->ys_len; j++){
-		yc = ys->ys_stmt[j];
-		if (yc->ys_keyword == Y_CASE) /* Look for its children */
-		    ysmatch = yang_find_schemanode(yc, argument);
-		else
-		    if (yang_schemanode(yc)){
-			if (argument == NULL)
-			    ysmatch = yc;
-			else
-			    if (yc->ys_argument && strcmp(argument, yc->ys_argument) == 0)
+    if (argument != NULL && yn->ys_index && yn->ys_index->yx_schema != NULL){
+	if ((ysmatch = ys_index_search(yn->ys_index->yx_schema, yn->ys_index->yx_nschema,
+				       0, argument)) != NULL)
+	    goto match;
+    }
+    else {
+	for (i=0; i<yn->ys_len; i++){
+	    ys = yn->ys_stmt[i];
+	    if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
+		for (j=0; j<ys->ys_len; j++){
+		    yc = ys->ys_stmt[j];
+		    if (yc->ys_keyword == Y_CASE) /* Look for its children */
+			ysmatch = yang_find_schemanode(yc, argument);
+		    else
+			if (yang_schemanode(yc)){
+			    if (argument == NULL)
 				ysmatch = yc;
-		    }
-		if (ysmatch)
-		    goto match;
-	    }
-	} /* Y_CHOICE */
-	else
-	    if (yang_schemanode(ys)){
-		if (argument == NULL)
-		    ysmatch = ys;
-		else
-		    if (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)
+			    else
+				if (yc->ys_argument && strcmp(argument, yc->ys_argument) == 0)
+				    ysmatch = yc;
+			}
+		    if (ysmatch)
+			goto match;
+		}
+	    } /* Y_CHOICE */
+	    else
+		if (yang_schemanode(ys)){
+		    if (argument == NULL)
 			ysmatch = ys;
-		if (ysmatch)
-		    goto match;
-	    }
+		    else
+			if (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)
+			    ysmatch = ys;
+		    if (ysmatch)
+			goto match;
+		}
+	}
     }
     /* Special case: if not match and yang node is module or submodule, extend
      * search to include submodules */
@@ -960,15 +1308,14 @@ order1(yang_stmt *yp,
     return 0;
 }
 
-/*! Return order of yang statement y in parents child vector
+/*! Compute order of yang statement y in parents child vector
  * @param[in]  y      Find position of this data-node
- * @param[out] index  Index of y in yp:s list of children
  * @retval   >=0      Order of child with specified argument
  * @retval    -1      Not found
- * @note special handling if y is child of (sub)module
+ * @see yang_order  which caches the order
  */
-int
-yang_order(yang_stmt *y)
+static int
+yang_order_compute(yang_stmt *y)
 {
     yang_stmt  *yp;
     yang_stmt  *ypp;
@@ -1007,6 +1354,97 @@ yang_order(yang_stmt *y)
     return -1;
 }
 
+/*! Return order of yang statement y in parents child vector
+ * The order is assigned to all data nodes in yang_parse_post, otherwise it 
+ * is computed and cached on first call.
+ * @param[in]  y      Find position of this data-node
+ * @retval   >=0      Order of child with specified argument
+ * @retval    -1      Not found
+ * @note special handling if y is child of (sub)module
+ */
+int
+yang_order(yang_stmt *y)
+{
+    int order;
+
+    if (y == NULL)
+	return -1;
+    if (y->ys_order)
+	return y->ys_order - 1;
+    if ((order = yang_order_compute(y)) >= 0)
+	y->ys_order = order + 1;
+    return order;
+}
+
+/*! Assign yang order to data node children of a choice
+ * Same order as computed by order1_choice
+ * @param[in]     yp     Choice node
+ * @param[in]     tot    Offset for top-level nodes, see yang_order
+ * @param[in,out] index  Running index in the parent
+ */
+static int
+ys_order_choice_set(yang_stmt *yp,
+		    int        tot,
+		    int       *index)
+{
+    yang_stmt  *ys;
+    yang_stmt  *yc;
+    int         i;
+    int         j;
+    int         shortcut=0;
+    int         max=0;
+
+    for (i=0; i<yp->ys_len; i++){ /* Loop through choice */
+	ys = yp->ys_stmt[i];
+	if (ys->ys_keyword == Y_CASE){ /* Loop through case */
+	    for (j=0; j<ys->ys_len; j++){
+		yc = ys->ys_stmt[j];
+		if (yang_datanode(yc))
+		    yc->ys_order = tot + *index + j + 1;
+	    }
+	    if (j>max)
+		max = j;
+	}
+	else {
+	    shortcut = 1;   /* Shortcut, no case */
+	    if (yang_datanode(ys))
+		ys->ys_order = tot + *index + 1;
+	}
+    }
+    if (shortcut)
+	(*index)++;
+    else
+	*index += max;
+    return 0;
+}
+
+/*! Assign yang order to all data node children of a yang node
+ * Same order as computed by order1
+ * @param[in]  yp     Parent, not choice or case
+ * @param[in]  tot    Offset for top-level nodes, see yang_order
+ */
+static int
+ys_order_set(yang_stmt *yp,
+	     int        tot)
+{
+    yang_stmt  *ys;
+    int         i;
+    int         index = 0;
+    
+    for (i=0; i<yp->ys_len; i++){
+	ys = yp->ys_stmt[i];
+	if (ys->ys_keyword == Y_CHOICE)
+	    ys_order_choice_set(ys, tot, &index);
+	else {
+	    if (!yang_datanode(ys))
+		continue;
+	    ys->ys_order = tot + index + 1;
+	    index++; 
+	}
+    }
+    return 0;
+}
+
 /*! Reset flag in complete tree, arg contains flag */
 static int
 ys_flag_reset(yang_stmt *ys, 
@@ -1378,27 +1816,23 @@ ys_populate_leaf(clicon_handle h,
     int             cvret;
     int             ret;
     char           *reason = NULL;
-    yang_stmt      *yrestype;  /* resolved type */
-    char           *restype;  /* resolved type */
-    char           *origtype=NULL;   /* original type */
-    uint8_t         fraction_digits;
-    int             options = 0x0;
+    yang_leaftype  *lt;
 
     yparent = ys->ys_parent;     /* Find parent: list/container */
-    /* 1. Find type specification and set cv type accordingly */
-    if (yang_type_get(ys, &origtype, &yrestype, &options, NULL, NULL, NULL, &fraction_digits)
- < 0)
-	goto done;
-    restype = yrestype?yrestype->ys_argument:NULL;
-    if (clicon_type2cv(origtype, restype, ys, &cvtype) < 0) /* This handles non-resolved also */
+    /* 1. Find type specification and set cv type accordingly 
+     * Resolve the type once and keep it in the leaf, also compile patterns.
+     * This handles non-resolved also */
+    if (yang_leaftype_set(h, ys) < 0)
 	goto done;
+    lt = ys->ys_leaftype;
+    cvtype = lt->lt_cvtype;
     /* 2. Create the CV using cvtype and name it */
     if ((cv = cv_new(cvtype)) == NULL){
 	clicon_err(OE_YANG, errno, "cv_new"); 
 	goto done;
     }
-    if (options & YANG_OPTIONS_FRACTION_DIGITS && cvtype == CGV_DEC64) /* XXX: Seems misplaced? / too specific */
-	cv_dec64_n_set(cv, fraction_digits);
+    if (lt->lt_options & YANG_OPTIONS_FRACTION_DIGITS && cvtype == CGV_DEC64) /* XXX: Seems misplaced? / too specific */
+	cv_dec64_n_set(cv, lt->lt_fraction);
 
     if (cv_name_set(cv, ys->ys_argument) == NULL){
 	clicon_err(OE_YANG, errno, "cv_new_set"); 
@@ -1430,8 +1864,6 @@ ys_populate_leaf(clicon_handle h,
     ys->ys_cv = cv;
     retval = 0;
   done:
-    if (origtype)
-	free(origtype);
     if (cv && retval < 0)
 	cv_free(cv);
     return retval;
@@ -2400,7 +2832,6 @@ yang_parse_file(int         fd,
 {
     char         *buf = NULL;
     int           i;
-    int           c;
     int           len;
     yang_stmt    *ymod = NULL;
     int           ret;
@@ -2412,14 +2843,8 @@ yang_parse_file(int         fd,
     }
     memset(buf, 0, len);
     i = 0; /* position in buf */
-    while (1){ /* read the whole file */
-	if ((ret = read(fd, &c, 1)) < 0){
-	    clicon_err(OE_XML, errno, "read");
-	    break;
-	}
-	if (ret == 0)
-	    break; /* eof */
-	if (len==i){
+    while (1){ /* read the whole file, in chunks */
+	if (len-i <= 1){ /* keep space for terminating null */
 	    if ((buf = realloc(buf, 2*len)) == NULL){
 		clicon_err(OE_XML, errno, "realloc");
 		goto done;
@@ -2427,8 +2852,14 @@ yang_parse_file(int         fd,
 	    memset(buf+len, 0, len);
 	    len *= 2;
 	}
-	buf[i++] = (char)(c&0xff);
-    } /* read a line */
+	if ((ret = read(fd, buf+i, len-i-1)) < 0){
+	    clicon_err(OE_XML, errno, "read");
+	    break;
+	}
+	if (ret == 0)
+	    break; /* eof */
+	i += ret;
+    }
     if ((ymod = yang_parse_str(buf, name, ysp)) < 0)
 	goto done;
   done:
@@ -2582,6 +3013,42 @@ yang_parse_filename(const char *filename,
     return ymod; /* top-level (sub)module */
 }
 
+/*! Parse a yang file, or read its parse-tree from the binary yang cache
+ *
+ * If CLICON_YANG_CACHE_DIR is set, a valid cache file of filename is read
+ * instead of parsing the file. Otherwise the file is parsed and a new cache
+ * file is written. Failure to write the cache file is not fatal.
+ * @param[in] h        CLICON handle
+ * @param[in] filename Name of file
+ * @param[in] ysp      Yang specification
+ * @retval    ymod     Top-level yang (sub)module
+ * @retval    NULL     Error encountered
+ * @see yang_parse_filename
+ */
+static yang_stmt *
+yang_parse_filename_cache(clicon_handle h,
+			  const char   *filename, 
+			  yang_stmt    *ysp)
+{
+    yang_stmt *ymod = NULL;
+    char      *dir;
+    int        ret;
+
+    if ((dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL)
+	return yang_parse_filename(filename, ysp);
+    if ((ret = yang_cache_read(dir, filename, ysp, &ymod)) < 0)
+	return NULL;
+    if (ret == 1)
+	return ymod;
+    if ((ymod = yang_parse_filename(filename, ysp)) == NULL)
+	return NULL;
+    if (yang_cache_write(dir, filename, ymod) < 0){
+	clicon_log(LOG_WARNING, "Yang cache not written: %s", clicon_err_reason);
+	clicon_err_reset();
+    }
+    return ymod; /* top-level (sub)module */
+}
+
 /*! Given a (sub)module, parse all (sub)modules in turn recursively
  *
  * Find a yang module file, and then recursively parse all its imported modules.
@@ -2620,7 +3087,7 @@ yang_parse_module(clicon_handle h,
 	goto done;
     }
     filename = cbuf_get(fbuf);
-    if ((ymod = yang_parse_filename(filename, ysp)) == NULL)
+    if ((ymod = yang_parse_filename_cache(h, filename, ysp)) == NULL)
 	goto done;
     if ((yrev = yang_find(ymod, Y_REVISION, NULL)) != NULL)
 	revm = cv_uint32_get(yrev->ys_cv);
@@ -2846,6 +3313,54 @@ yang_features(clicon_handle h,
     return retval;
 }
 
+/*! Build lookup index and assign yang order of children of a yang statement
+ * @param[in]  ys   Yang statement
+ * @param[in]  arg  Not used
+ */
+static int
+ys_populate_index(yang_stmt *ys,
+		  void      *arg)
+{
+    if (ys_index_build(ys) < 0)
+	return -1;
+    /* Children of choice/case are ordered by the (real) parent */
+    if (ys->ys_keyword != Y_CHOICE && ys->ys_keyword != Y_CASE)
+	ys_order_set(ys, 0);
+    return 0;
+}
+
+/*! Build lookup indexes and assign yang order in a complete yang spec
+ * All modules are (re-)indexed since new modules may be loaded in between 
+ * and augment or remove nodes of existing modules.
+ * @param[in] yspec  Yang specification. 
+ * @retval    0      OK
+ * @retval   -1      Error
+ */
+static int
+yang_spec_index(yang_stmt *yspec)
+{
+    int        retval = -1;
+    int        i;
+    int        tot = 0;
+    yang_stmt *ym;
+
+    if (ys_index_build(yspec) < 0)
+	goto done;
+    for (i=0; i<yspec->ys_len; i++){
+	ym = yspec->ys_stmt[i];
+	if (ys_index_build(ym) < 0)
+	    goto done;
+	/* Top-level order is global among modules, see yang_order */
+	ys_order_set(ym, tot);
+	tot += ym->ys_len;
+	if (yang_apply(ym, -1, ys_populate_index, NULL) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Parse top yang module including all its sub-modules. Expand and populate yang tree
  *
  * Perform secondary actions after yang parsing. These actions cannot be made at
@@ -2859,6 +3374,8 @@ yang_features(clicon_handle h,
  * - Augments
  * - Defaults
  * 
+ * The time of the steps after parsing is logged on debug, these are not 
+ * covered by the yang cache, see clixon_yang_cache.c
  * @param[in] h      CLICON handle
  * @param[in] yspec  Yang specification. 
  * @param[in] modnr  Perform checks after this number, prior are already complete
@@ -2870,8 +3387,10 @@ yang_parse_post(clicon_handle h,
 		yang_stmt    *yspec,
 		int           modnr)
 {
-    int retval = -1;
-    int i;
+    int            retval = -1;
+    int            i;
+    struct timeval t0;
+    struct timeval t1;
     
     /* 1: Parse from text to yang parse-tree. 
      * Iterate through modules and detect module/submodules to parse
@@ -2879,6 +3398,7 @@ yang_parse_post(clicon_handle h,
     for (i=modnr; i<yspec->ys_len; i++)
 	if (yang_parse_recurse(h, yspec->ys_stmt[i], yspec) < 0)
 	    goto done;
+    gettimeofday(&t0, NULL);
 
     /* 2. Check cardinality maybe this should be done after grouping/augment */
     for (i=modnr; i<yspec->ys_len; i++) 
@@ -2930,6 +3450,15 @@ yang_parse_post(clicon_handle h,
     for (i=modnr; i<yspec->ys_len; i++)
 	if (yang_apply(yspec->ys_stmt[i], -1, ys_schemanode_check, NULL) < 0)
 	    goto done;
+
+    /* 9: Assign yang order and build child lookup indexes, now that the tree
+     * is complete. Used by sorting and searching, eg yang_order/yang_find */
+    if (yang_spec_index(yspec) < 0)
+	goto done;
+    gettimeofday(&t1, NULL);
+    timersub(&t1, &t0, &t1);
+    clicon_debug(1, "%s %d modules post-processing: %ld.%06ld s", __FUNCTION__,
+		 yspec->ys_len - modnr, (long)t1.tv_sec, (long)t1.tv_usec);
     retval = 0;
  done:
     return retval;
@@ -3013,7 +3542,7 @@ yang_spec_parse_file(clicon_handle h,
 	*index(base, '@') = '\0';
     if (yang_find(yspec, Y_MODULE, base) != NULL)
 	goto ok;
-    if (yang_parse_filename(filename, yspec) == NULL)
+    if (yang_parse_filename_cache(h, filename, yspec) == NULL)
 	goto done;
     if (yang_parse_post(h, yspec, modnr) < 0)
 	goto done;
@@ -3108,7 +3637,7 @@ yang_spec_load_dir(clicon_handle h,
 	}
 	/* Create full filename */
 	snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
-	if ((ym = yang_parse_filename(filename, yspec)) == NULL)
+	if ((ym = yang_parse_filename_cache(h, filename, yspec)) == NULL)
 	    goto done;
 	revm = 0;
 	if ((yrev = yang_find(ym, Y_REVISION, NULL)) != NULL)
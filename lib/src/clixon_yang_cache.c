@@ -0,0 +1,522 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary cache of parsed yang files
+ *
+ * Parsing large yang models (eg IETF and openconfig) with flex/bison is a
+ * significant part of the startup time of every clixon daemon. If the
+ * CLICON_YANG_CACHE_DIR option is set, the parse-tree of each yang file is
+ * saved in that directory in a binary form, and read back (using mmap)
+ * instead of parsing the yang file the next time it is loaded.
+ *
+ * Only the parse-tree is cached, ie what yang_parse_file() produces: the
+ * keyword and argument of each statement (and the extra argument of unknown
+ * statements). All later steps in yang_parse_post(), (features, type
+ * resolution, grouping expansion, augment, etc) are made on the loaded
+ * tree as before, therefore the cache does not depend on any options.
+ *
+ * A cache file is invalid and replaced if the size or the content hash of the
+ * yang file differs from what was recorded, or if it was written by another
+ * clixon version or cache format.
+ *
+ * Cache file layout (host byte order, a cache is not portable between hosts):
+ *   header: struct yang_cache_hdr
+ *   string: filename of yang file
+ *   stmt*:  statements in pre-order: keyword, number of children, argument
+ *           and extra argument (strings)
+ * A string is a uint32 length including the terminating null (0 means NULL)
+ * followed by the characters including the null.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <syslog.h>
+#include <libgen.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include "clixon_log.h"
+#include "clixon_err.h"
+#include "clixon_string.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_yang_internal.h" /* internal */
+#include "clixon_yang_cache.h"
+
+/*
+ * Constants
+ */
+#define YANG_CACHE_MAGIC   "CLXYANG"
+#define YANG_CACHE_VERSION 1
+
+/*
+ * Types
+ */
+/* Header of a binary yang cache file */
+struct yang_cache_hdr{
+    char     yh_magic[8];   /* YANG_CACHE_MAGIC */
+    uint32_t yh_version;    /* YANG_CACHE_VERSION, cache format */
+    uint32_t yh_nstmt;      /* Number of statements in file */
+    uint64_t yh_size;       /* Size of yang file */
+    uint64_t yh_hash;       /* FNV-1a hash of content of yang file */
+    char     yh_clixon[32]; /* CLIXON_VERSION_STRING of writer */
+};
+
+/* Read state of a mapped cache file */
+struct yang_cache_rd{
+    char    *rd_buf;        /* Mapped cache file */
+    size_t   rd_len;        /* Length of mapped file */
+    size_t   rd_pos;        /* Read position */
+    uint32_t rd_nstmt;      /* Statements left according to header */
+};
+
+/*! Read a yang file and compute its size and FNV-1a hash
+ * @param[in]  filename  Yang file
+ * @param[out] sizep     Size of file
+ * @param[out] hashp     Hash of content
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+yang_cache_hash(const char *filename,
+		uint64_t   *sizep,
+		uint64_t   *hashp)
+{
+    int      retval = -1;
+    int      fd = -1;
+    char     buf[BUFSIZ];
+    ssize_t  len;
+    ssize_t  i;
+    uint64_t hash = 14695981039346656037ULL; /* FNV offset basis */
+    uint64_t size = 0;
+
+    if ((fd = open(filename, O_RDONLY)) < 0){
+	clicon_err(OE_YANG, errno, "open(%s)", filename);
+	goto done;
+    }
+    while ((len = read(fd, buf, sizeof(buf))) != 0){
+	if (len < 0){
+	    clicon_err(OE_YANG, errno, "read(%s)", filename);
+	    goto done;
+	}
+	for (i=0; i<len; i++){
+	    hash ^= (uint8_t)buf[i];
+	    hash *= 1099511628211ULL; /* FNV prime */
+	}
+	size += len;
+    }
+    *sizep = size;
+    *hashp = hash;
+    retval = 0;
+ done:
+    if (fd != -1)
+	close(fd);
+    return retval;
+}
+
+/*! Get name of cache file of a yang file
+ * The FNV-1a hash of the full path of the yang file is part of the name, so that
+ * yang files with the same name in different directories have different caches.
+ * @param[in]  dir       Cache directory
+ * @param[in]  filename  Yang file
+ * @param[out] cb        Cache file name: <dir>/<basename of yang file>.<path hash>.yb
+ */
+static int
+yang_cache_filename(const char *dir,
+		    const char *filename,
+		    cbuf       *cb)
+{
+    int         retval = -1;
+    char       *f = NULL;
+    char       *path = NULL;
+    const char *p;
+    uint64_t    hash = 14695981039346656037ULL; /* FNV offset basis */
+
+    if ((f = strdup(filename)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    /* Fall back to the given name if the file cannot be resolved */
+    path = realpath(filename, NULL);
+    for (p = path?path:filename; *p; p++){
+	hash ^= (uint8_t)*p;
+	hash *= 1099511628211ULL; /* FNV prime */
+    }
+    cprintf(cb, "%s/%s.%016" PRIx64 ".%s", dir, basename(f), hash, YANG_CACHE_SUFFIX);
+    retval = 0;
+ done:
+    if (path)
+	free(path);
+    if (f)
+	free(f);
+    return retval;
+}
+
+/*! Write a string to cache file
+ */
+static int
+yang_cache_write_str(FILE *f,
+		     char *str)
+{
+    uint32_t len;
+
+    len = str?strlen(str)+1:0;
+    if (fwrite(&len, sizeof(len), 1, f) != 1)
+	return -1;
+    if (len && fwrite(str, len, 1, f) != 1)
+	return -1;
+    return 0;
+}
+
+/*! Write a yang statement and its children recursively to cache file
+ * @param[in]  f      Open cache file
+ * @param[in]  ys     Yang statement
+ * @param[out] nstmt  Incremented with number of written statements
+ */
+static int
+yang_cache_write_stmt(FILE      *f,
+		      yang_stmt *ys,
+		      uint32_t  *nstmt)
+{
+    uint32_t   u32;
+    char      *extra = NULL;
+    int        i;
+
+    u32 = ys->ys_keyword;
+    if (fwrite(&u32, sizeof(u32), 1, f) != 1)
+	return -1;
+    u32 = ys->ys_len;
+    if (fwrite(&u32, sizeof(u32), 1, f) != 1)
+	return -1;
+    if (yang_cache_write_str(f, ys->ys_argument) < 0)
+	return -1;
+    /* The extra argument of unknown statements is saved in ys_cv, see
+     * ys_parse_sub */
+    if (ys->ys_keyword == Y_UNKNOWN && ys->ys_cv)
+	extra = cv_string_get(ys->ys_cv);
+    if (yang_cache_write_str(f, extra) < 0)
+	return -1;
+    (*nstmt)++;
+    for (i=0; i<ys->ys_len; i++)
+	if (yang_cache_write_stmt(f, ys->ys_stmt[i], nstmt) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Write a binary cache file of a parsed yang (sub)module
+ *
+ * Must be called directly after parsing, before yang_parse_post() has
+ * modified the parse-tree.
+ * The file is written to a temporary file which is then renamed, so that
+ * concurrent readers never see a partial file.
+ * @param[in]  dir       Cache directory
+ * @param[in]  filename  Yang file that ymod was parsed from
+ * @param[in]  ymod      Parsed yang module or submodule
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see yang_cache_read
+ */
+int
+yang_cache_write(const char *dir,
+		 const char *filename,
+		 yang_stmt  *ymod)
+{
+    int                   retval = -1;
+    cbuf                 *cbf = NULL;
+    cbuf                 *cbt = NULL;
+    FILE                 *f = NULL;
+    struct yang_cache_hdr hdr = {{0},};
+
+    if ((cbf = cbuf_new()) == NULL || (cbt = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (yang_cache_filename(dir, filename, cbf) < 0)
+	goto done;
+    cprintf(cbt, "%s.%u", cbuf_get(cbf), getpid());
+    memcpy(hdr.yh_magic, YANG_CACHE_MAGIC, sizeof(hdr.yh_magic));
+    hdr.yh_version = YANG_CACHE_VERSION;
+    strncpy(hdr.yh_clixon, CLIXON_VERSION_STRING, sizeof(hdr.yh_clixon)-1);
+    if (yang_cache_hash(filename, &hdr.yh_size, &hdr.yh_hash) < 0)
+	goto done;
+    if ((f = fopen(cbuf_get(cbt), "w")) == NULL){
+	clicon_err(OE_YANG, errno, "fopen(%s)", cbuf_get(cbt));
+	goto done;
+    }
+    /* Header is written twice, the second time with number of statements */
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1 ||
+	yang_cache_write_str(f, (char*)filename) < 0 ||
+	yang_cache_write_stmt(f, ymod, &hdr.yh_nstmt) < 0 ||
+	fseek(f, 0, SEEK_SET) < 0 ||
+	fwrite(&hdr, sizeof(hdr), 1, f) != 1){
+	clicon_err(OE_YANG, errno, "write(%s)", cbuf_get(cbt));
+	goto done;
+    }
+    if (fclose(f) != 0){
+	f = NULL;
+	clicon_err(OE_YANG, errno, "fclose(%s)", cbuf_get(cbt));
+	goto done;
+    }
+    f = NULL;
+    if (rename(cbuf_get(cbt), cbuf_get(cbf)) < 0){
+	clicon_err(OE_YANG, errno, "rename(%s)", cbuf_get(cbf));
+	goto done;
+    }
+    clicon_debug(1, "%s %s: %u statements", __FUNCTION__,
+		 cbuf_get(cbf), hdr.yh_nstmt);
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (retval < 0 && cbt)
+	unlink(cbuf_get(cbt));
+    if (cbf)
+	cbuf_free(cbf);
+    if (cbt)
+	cbuf_free(cbt);
+    return retval;
+}
+
+/*! Read a uint32 from a mapped cache file
+ * @retval  0  OK
+ * @retval -1  Truncated file
+ */
+static int
+yang_cache_read_u32(struct yang_cache_rd *rd,
+		    uint32_t             *u32p)
+{
+    if (rd->rd_pos + sizeof(uint32_t) > rd->rd_len)
+	return -1;
+    memcpy(u32p, rd->rd_buf + rd->rd_pos, sizeof(uint32_t));
+    rd->rd_pos += sizeof(uint32_t);
+    return 0;
+}
+
+/*! Read a string from a mapped cache file, the string is not copied
+ * @param[out] strp  Pointer into mapped file, or NULL
+ * @retval  0  OK
+ * @retval -1  Truncated or corrupt file
+ */
+static int
+yang_cache_read_str(struct yang_cache_rd *rd,
+		    char                **strp)
+{
+    uint32_t len;
+
+    if (yang_cache_read_u32(rd, &len) < 0)
+	return -1;
+    if (len == 0){
+	*strp = NULL;
+	return 0;
+    }
+    if (rd->rd_pos + len > rd->rd_len || rd->rd_buf[rd->rd_pos+len-1] != '\0')
+	return -1;
+    *strp = rd->rd_buf + rd->rd_pos;
+    rd->rd_pos += len;
+    return 0;
+}
+
+/*! Read a yang statement and its children recursively from cache file
+ *
+ * Statements are created and inserted in the same way as the yang parser
+ * does, see ysp_add() in clixon_yang_parse.y
+ * @param[in]  rd    Read state
+ * @param[in]  yp    Parent yang statement
+ * @param[out] ysp   Created statement (if retval = 1)
+ * @retval     1     OK
+ * @retval     0     Corrupt cache file
+ * @retval    -1     Error
+ */
+static int
+yang_cache_read_stmt(struct yang_cache_rd *rd,
+		     yang_stmt            *yp,
+		     yang_stmt           **ysp)
+{
+    int        retval = -1;
+    uint32_t   keyword;
+    uint32_t   nchild;
+    uint32_t   i;
+    char      *arg;
+    char      *extra;
+    yang_stmt *ys = NULL;
+    yang_stmt *yc;
+    int        ret;
+
+    if (rd->rd_nstmt == 0 ||
+	yang_cache_read_u32(rd, &keyword) < 0 ||
+	yang_cache_read_u32(rd, &nchild) < 0 ||
+	yang_cache_read_str(rd, &arg) < 0 ||
+	yang_cache_read_str(rd, &extra) < 0)
+	goto corrupt;
+    if (keyword < Y_ACTION || keyword >= Y_SPEC || nchild >= rd->rd_nstmt)
+	goto corrupt;
+    rd->rd_nstmt--;
+    if ((ys = ys_new(keyword)) == NULL)
+	goto done;
+    if (arg && (ys->ys_argument = strdup(arg)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (yn_insert(yp, ys) < 0)
+	goto done;
+    *ysp = yc = ys;
+    ys = NULL; /* part of tree */
+    if (extra && (extra = strdup(extra)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (ys_parse_sub(yc, extra) < 0) /* consumes extra */
+	goto done;
+    for (i=0; i<nchild; i++)
+	if ((ret = yang_cache_read_stmt(rd, *ysp, &yc)) < 1){
+	    retval = ret;
+	    goto done;
+	}
+    retval = 1;
+ done:
+    if (ys)
+	ys_free(ys);
+    return retval;
+ corrupt:
+    retval = 0;
+    goto done;
+}
+
+/*! Read a parsed yang (sub)module from a binary cache file
+ *
+ * The result is the same as if the yang file had been parsed with
+ * yang_parse_filename(): the (sub)module is added last to yspec.
+ * @param[in]  dir       Cache directory
+ * @param[in]  filename  Yang file
+ * @param[in]  yspec     Yang specification, the module is added to it
+ * @param[out] ymodp     Top-level yang (sub)module (if retval = 1)
+ * @retval     1         OK, module read from cache
+ * @retval     0         No valid cache file, parse filename instead
+ * @retval    -1         Error
+ * @see yang_cache_write
+ */
+int
+yang_cache_read(const char *dir,
+		const char *filename,
+		yang_stmt  *yspec,
+		yang_stmt **ymodp)
+{
+    int                    retval = -1;
+    cbuf                  *cbf = NULL;
+    int                    fd = -1;
+    struct stat            st;
+    struct yang_cache_rd   rd = {0,};
+    struct yang_cache_hdr *hdr;
+    uint64_t               size;
+    uint64_t               hash;
+    char                  *fname;
+    yang_stmt             *ymod = NULL;
+    int                    ret;
+
+    if ((cbf = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (yang_cache_filename(dir, filename, cbf) < 0)
+	goto done;
+    if ((fd = open(cbuf_get(cbf), O_RDONLY)) < 0)
+	goto miss;
+    if (fstat(fd, &st) < 0 || st.st_size < sizeof(*hdr))
+	goto miss;
+    rd.rd_len = st.st_size;
+    if ((rd.rd_buf = mmap(NULL, rd.rd_len, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+	rd.rd_buf = NULL;
+	goto miss;
+    }
+    /* Check header and that the yang file has not changed */
+    hdr = (struct yang_cache_hdr *)rd.rd_buf;
+    if (strncmp(hdr->yh_magic, YANG_CACHE_MAGIC, sizeof(hdr->yh_magic)) != 0 ||
+	hdr->yh_version != YANG_CACHE_VERSION ||
+	strncmp(hdr->yh_clixon, CLIXON_VERSION_STRING, sizeof(hdr->yh_clixon)-1) != 0)
+	goto miss;
+    rd.rd_pos = sizeof(*hdr);
+    rd.rd_nstmt = hdr->yh_nstmt;
+    if (yang_cache_read_str(&rd, &fname) < 0 ||
+	fname == NULL || strcmp(fname, filename) != 0)
+	goto miss;
+    if (yang_cache_hash(filename, &size, &hash) < 0)
+	goto done;
+    if (size != hdr->yh_size || hash != hdr->yh_hash)
+	goto miss;
+    if ((ret = yang_cache_read_stmt(&rd, yspec, &ymod)) < 0)
+	goto done;
+    if (ret == 0 || rd.rd_nstmt != 0){
+	clicon_log(LOG_WARNING, "%s: corrupt yang cache file, ignored",
+		   cbuf_get(cbf));
+	goto miss;
+    }
+    clicon_debug(1, "%s %s", __FUNCTION__, cbuf_get(cbf));
+    *ymodp = ymod;
+    ymod = NULL;
+    retval = 1;
+ done:
+    /* Remove partially read module from spec */
+    if (ymod && yspec->ys_len && yspec->ys_stmt[yspec->ys_len-1] == ymod){
+	ys_prune(yspec, yspec->ys_len-1);
+	ys_free(ymod);
+    }
+    if (rd.rd_buf)
+	munmap(rd.rd_buf, rd.rd_len);
+    if (fd != -1)
+	close(fd);
+    if (cbf)
+	cbuf_free(cbf);
+    return retval;
+ miss:
+    clicon_debug(1, "%s %s: no valid cache file", __FUNCTION__, filename);
+    retval = 0;
+    goto done;
+}
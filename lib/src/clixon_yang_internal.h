@@ -49,8 +49,24 @@
 
 #define YANG_FLAG_MARK 0x01  /* Marker for dynamic algorithms, eg expand */
 
+/*! Resolved member type of a union, see yc_members in yang_type_cache
+ * Nested unions are flattened, so a member is never itself a union.
+ */
+struct yang_union_member{
+    yang_stmt   *um_ytype;    /* Member type statement */
+    yang_stmt   *um_restype;  /* Resolved built-in type, NULL if unresolved */
+    enum cv_type um_cvtype;   /* Cligen type of um_restype (if resolved) */
+    int          um_options;  /* See YANG_OPTIONS_* */
+    cvec        *um_cvv;      /* Range and length restriction (direct ptr) */
+    cvec        *um_regexps;  /* List of _compiled_ regexp, or NULL */
+    uint8_t      um_fraction; /* Fraction digits for decimal64 */
+    uint32_t     um_hits;     /* Number of values validated by this member */
+};
+typedef struct yang_union_member yang_union_member;
+
 /*! Yang type cache. Yang type statements can cache all typedef info here
- * @note unions not cached
+ * @note unions are cached lazily (yc_members) on first validation since 
+ *       compiled regexps are needed, and they are not copied (see yc_regexps)
 */
 struct yang_type_cache{
     int        yc_options;  /* See YANG_OPTIONS_* that determines pattern/
@@ -64,9 +80,47 @@ struct yang_type_cache{
     uint8_t    yc_fraction; /* Fraction digits for decimal64 (if 
                                YANG_OPTIONS_FRACTION_DIGITS */
     yang_stmt *yc_resolved; /* Resolved type object, can be NULL - note direct ptr */
+    int        yc_nmembers; /* Length of yc_members (if resolved union) */
+    yang_union_member *yc_members; /* Flattened union members in yang order */
+    int       *yc_order;    /* Order to try members in, most frequent first */
 };
 typedef struct yang_type_cache yang_type_cache;
 
+/*! Resolved type of a leaf or leaf-list
+ * Set once in ys_populate_leaf after grouping expansion and augments, so that
+ * parsing and validating values does not resolve types.
+ * Range/length is a direct pointer and compiled regexps are kept in the type
+ * cache of lt_ytype.
+ */
+struct yang_leaftype{
+    yang_stmt   *lt_ytype;    /* Type statement of the leaf */
+    yang_stmt   *lt_restype;  /* Resolved built-in type, NULL if unresolved */
+    char        *lt_origtype; /* Original type without prefix (malloced) */
+    enum cv_type lt_cvtype;   /* Cligen type of the resolved type */
+    int          lt_options;  /* See YANG_OPTIONS_* */
+    cvec        *lt_cvv;      /* Range and length restriction (direct ptr) */
+    uint8_t      lt_fraction; /* Fraction digits for decimal64 */
+};
+typedef struct yang_leaftype yang_leaftype;
+
+/*! Child lookup index of a yang statement
+ * Vectors are sorted on (keyword, argument) or argument, and ties are broken 
+ * by yang order so that a lookup returns the same (first) match as a linear
+ * search.
+ * Only built for statements with many children, and rebuilt after each 
+ * yang_parse_post. Removed if children are inserted or pruned.
+ * @see yang_find, yang_find_datanode, yang_find_schemanode
+ */
+struct yang_index{
+    int                yx_nstmt;   /* Length of yx_stmt */
+    struct yang_stmt **yx_stmt;    /* All children on (keyword, argument) */
+    int                yx_ndata;   /* Length of yx_data */
+    struct yang_stmt **yx_data;    /* Data nodes, also via choice/case */
+    int                yx_nschema; /* Length of yx_schema */
+    struct yang_stmt **yx_schema;  /* Schema nodes, also via choice/case */
+};
+typedef struct yang_index yang_index;
+
 /*! yang statement 
  */
 struct yang_stmt{
@@ -95,7 +149,11 @@ struct yang_stmt{
 					Y_TYPE & identity: store all derived 
 					   types as <module>:<id> list
 				     */
-    yang_type_cache   *ys_typecache; /* If ys_keyword==Y_TYPE, cache all typedef data except unions */
+    yang_type_cache   *ys_typecache; /* If ys_keyword==Y_TYPE, cache all typedef data */
+    yang_leaftype     *ys_leaftype;  /* If leaf or leaf-list, resolved type */
+    int                ys_order;     /* Yang order + 1 of data node, see 
+					yang_order(). 0 if not computed */
+    yang_index        *ys_index;     /* Child lookup index, or NULL */
     int               _ys_vector_i;   /* internal use: yn_each */
 };
 
@@ -59,6 +59,9 @@
  * 3) We know I think when cache is set and when it is not set in the calls
  *    to yang_type_resolve. maybe we should make code easier by a separate
  *    yang_type_resolve_cache() call?
+ * 4) Unions are resolved once into a flat member vector in the type cache of
+ *    the union type statement (yang_type_union_cache_set), also lazily in 
+ *    ys_cv_validate for the same reason as 2). 
  */
 
 #ifdef HAVE_CONFIG_H
@@ -301,37 +304,74 @@ yang_type_cache_cp(yang_type_cache **ycnew,
     return retval;
 }
 
-int
-yang_type_cache_free(yang_type_cache *ycache)
+/*! Free a vector of compiled regexps
+ * @param[in] rxmode  Regexp engine, need to store mode since clicon_handle 
+ *                    is not available
+ * @param[in] regexps Vector of compiled regexps
+ */
+static int
+yang_type_regexps_free(int   rxmode,
+		       cvec *regexps)
 {
     cg_var *cv;
     void   *p;
-    
+
+    cv = NULL;
+    while ((cv = cvec_each(regexps, cv)) != NULL){
+	switch (rxmode){
+	case REGEXP_POSIX:
+	    cligen_regex_posix_free(cv_void_get(cv));
+	    break;
+	case REGEXP_LIBXML2:
+	    cligen_regex_libxml2_free(cv_void_get(cv));
+	    break;
+	default:
+	    break;
+	}
+	if ((p = cv_void_get(cv)) != NULL){
+	    free(p);
+	    cv_void_set(cv, NULL);
+	}
+    }
+    cvec_free(regexps);
+    return 0;
+}
+
+/*! Free resolved union members of a yang type cache
+ */
+static int
+yang_type_cache_members_free(yang_type_cache *ycache)
+{
+    int                i;
+    yang_union_member *um;
+
+    if (ycache->yc_members){
+	for (i=0; i<ycache->yc_nmembers; i++){
+	    um = &ycache->yc_members[i];
+	    if (um->um_regexps)
+		yang_type_regexps_free(ycache->yc_rxmode, um->um_regexps);
+	}
+	free(ycache->yc_members);
+	ycache->yc_members = NULL;
+    }
+    if (ycache->yc_order){
+	free(ycache->yc_order);
+	ycache->yc_order = NULL;
+    }
+    ycache->yc_nmembers = 0;
+    return 0;
+}
+
+int
+yang_type_cache_free(yang_type_cache *ycache)
+{
     if (ycache->yc_cvv)
 	cvec_free(ycache->yc_cvv);
     if (ycache->yc_patterns)
 	cvec_free(ycache->yc_patterns);
-    if (ycache->yc_regexps){
-	cv = NULL;
-	while ((cv = cvec_each(ycache->yc_regexps, cv)) != NULL){
-	    /* need to store mode since clicon_handle is not available */
-	    switch (ycache->yc_rxmode){
-	    case REGEXP_POSIX:
-		cligen_regex_posix_free(cv_void_get(cv));
-		break;
-	    case REGEXP_LIBXML2:
-		cligen_regex_libxml2_free(cv_void_get(cv));
-		break;
-	    default:
-		break;
-	    }
-	    if ((p = cv_void_get(cv)) != NULL){
-		free(p);
-		cv_void_set(cv, NULL);
-	    }
-	}
-	cvec_free(ycache->yc_regexps);
-    }
+    if (ycache->yc_regexps)
+	yang_type_regexps_free(ycache->yc_rxmode, ycache->yc_regexps);
+    yang_type_cache_members_free(ycache);
     free(ycache);
     return 0;
 }
@@ -386,6 +426,45 @@ compile_pattern2regexp(clicon_handle h,
     return retval;
 }
 
+/*! Get compiled regexps of a type statement, compile and cache them if needed
+ * @param[in]  h       Clicon handle. If NULL, regexps are not compiled
+ * @param[in]  ytype   Type statement
+ * @param[out] regexps Compiled regexps (direct pointer into type cache) or NULL
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+yang_type_cache_regexps(clicon_handle h,
+			yang_stmt    *ytype,
+			cvec        **regexps)
+{
+    int              retval = -1;
+    yang_type_cache *ycache;
+    cvec            *rxs = NULL;
+
+    *regexps = NULL;
+    if ((ycache = ytype->ys_typecache) == NULL)
+	goto ok;
+    if (ycache->yc_regexps == NULL && h != NULL &&
+	ycache->yc_patterns && cvec_len(ycache->yc_patterns) != 0){
+	if ((rxs = cvec_new(0)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_new");
+	    goto done;
+	}
+	if (compile_pattern2regexp(h, ycache->yc_patterns, rxs) < 1)
+	    goto done;
+	if (yang_type_cache_regexp_set(ytype, clicon_yang_regexp(h), rxs) < 0)
+	    goto done;
+    }
+    *regexps = ycache->yc_regexps;
+ ok:
+    retval = 0;
+ done:
+    if (rxs)
+	cvec_free(rxs);
+    return retval;
+}
+
 /*! Resolve types: populate type caches 
  * @param[in]  ys  This is a type statement
  * @param[in]  arg Not used
@@ -434,6 +513,94 @@ ys_resolve_type(yang_stmt    *ys,
     return retval;
 }
 
+/*! Resolve type of a leaf or leaf-list once and store it in the yang statement
+ * @param[in]  h   Clicon handle. If NULL, regexps are compiled on first validate
+ * @param[in]  ys  Leaf or leaf-list
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see ys_populate_leaf  Where this is called after grouping expansion/augment
+ */
+int
+yang_leaftype_set(clicon_handle h,
+		  yang_stmt    *ys)
+{
+    int            retval = -1;
+    yang_leaftype *lt = NULL;
+    yang_stmt     *ytype;
+    char          *restype;
+    cvec          *regexps;
+
+    if ((ytype = yang_find(ys, Y_TYPE, NULL)) == NULL){
+	clicon_err(OE_DB, ENOENT, "mandatory type object is not found");
+	goto done;
+    }
+    if ((lt = malloc(sizeof(*lt))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(lt, 0, sizeof(*lt));
+    lt->lt_ytype = ytype;
+    if (nodeid_split(yang_argument_get(ytype), NULL, &lt->lt_origtype) < 0)
+	goto done;
+    if (yang_type_resolve(ys, ys, ytype, &lt->lt_restype, &lt->lt_options,
+			  &lt->lt_cvv, NULL, NULL, &lt->lt_fraction) < 0)
+	goto done;
+    restype = lt->lt_restype?lt->lt_restype->ys_argument:NULL;
+    if (clicon_type2cv(lt->lt_origtype, restype, ys, &lt->lt_cvtype) < 0)
+	goto done;
+    /* Compile patterns into the type cache. If compilation fails, it is
+     * retried and reported when a value is validated, as before */
+    if (yang_type_cache_regexps(h, ytype, &regexps) < 0)
+	clicon_err_reset();
+    if (ys->ys_leaftype)
+	yang_leaftype_free(ys->ys_leaftype);
+    ys->ys_leaftype = lt;
+    lt = NULL;
+    retval = 0;
+ done:
+    if (lt)
+	yang_leaftype_free(lt);
+    return retval;
+}
+
+int
+yang_leaftype_free(yang_leaftype *lt)
+{
+    if (lt->lt_origtype)
+	free(lt->lt_origtype);
+    free(lt);
+    return 0;
+}
+
+/*! Get cligen type and fraction-digits of a leaf or leaf-list
+ * Uses the resolved leaf type, which is set (if not already) on first call.
+ * @param[in]  ys        Leaf or leaf-list
+ * @param[out] cvtype    Cligen type of resolved type
+ * @param[out] fraction  Fraction digits if decimal64 (if given)
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+int
+yang_leaftype_cv(yang_stmt    *ys,
+		 enum cv_type *cvtype,
+		 uint8_t      *fraction)
+{
+    int            retval = -1;
+    yang_leaftype *lt;
+
+    if ((lt = ys->ys_leaftype) == NULL){
+	if (yang_leaftype_set(NULL, ys) < 0)
+	    goto done;
+	lt = ys->ys_leaftype;
+    }
+    *cvtype = lt->lt_cvtype;
+    if (fraction)
+	*fraction = lt->lt_fraction;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Translate from a yang type to a cligen variable type
  *
  * Currently many built-in types from RFC6020 and some RFC6991 types.
@@ -1033,6 +1200,223 @@ ys_cv_validate_union(clicon_handle h,
     return retval;
 }
 
+/*! Resolve union members recursively into a flat member vector
+ * @param[in]     h        Clicon handle
+ * @param[in]     ys       Leaf or leaf-list of original resolving
+ * @param[in]     yunion   Resolved union type statement
+ * @param[in,out] vec      Vector of members, (re)allocated and appended to
+ * @param[in,out] len      Length of vec
+ * @retval        0        OK
+ * @retval       -1        Error
+ */
+static int
+yang_type_union_resolve(clicon_handle       h,
+			yang_stmt          *ys,
+			yang_stmt          *yunion,
+			yang_union_member **vec,
+			int                *len)
+{
+    int                retval = -1;
+    yang_stmt         *yt = NULL;
+    yang_stmt         *yrt;
+    yang_union_member *um;
+    cvec              *patterns = NULL;
+    cvec              *cvv = NULL;
+    int                options = 0;
+    uint8_t            fraction = 0;
+    char              *restype;
+
+    while ((yt = yn_each(yunion, yt)) != NULL){
+	if (yt->ys_keyword != Y_TYPE)
+	    continue;
+	if ((patterns = cvec_new(0)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_new");
+	    goto done;
+	}
+	cvv = NULL;
+	if (yang_type_resolve(ys, ys, yt, &yrt, &options, &cvv, patterns, NULL,
+			      &fraction) < 0)
+	    goto done;
+	restype = yrt?yrt->ys_argument:NULL;
+	if (restype && strcmp(restype, "union") == 0){ /* recursive union */
+	    if (yang_type_union_resolve(h, ys, yrt, vec, len) < 0)
+		goto done;
+	}
+	else {
+	    if ((*vec = realloc(*vec, (*len+1)*sizeof(**vec))) == NULL){
+		clicon_err(OE_UNIX, errno, "realloc");
+		goto done;
+	    }
+	    um = &(*vec)[(*len)++];
+	    memset(um, 0, sizeof(*um));
+	    um->um_ytype = yt;
+	    um->um_restype = yrt;
+	    um->um_cvtype = CGV_ERR; /* unresolved: translated from orig type */
+	    if (restype && clicon_type2cv(NULL, restype, ys, &um->um_cvtype) < 0)
+		goto done;
+	    um->um_options = options;
+	    um->um_cvv = cvv;
+	    um->um_fraction = fraction;
+	    if (cvec_len(patterns) != 0){
+		if ((um->um_regexps = cvec_new(0)) == NULL){
+		    clicon_err(OE_UNIX, errno, "cvec_new");
+		    goto done;
+		}
+		if (compile_pattern2regexp(h, patterns, um->um_regexps) < 1)
+		    goto done;
+	    }
+	}
+	cvec_free(patterns);
+	patterns = NULL;
+    }
+    retval = 0;
+ done:
+    if (patterns)
+	cvec_free(patterns);
+    return retval;
+}
+
+/*! Resolve a union type once and cache its members in the type cache
+ * Each member is resolved to a built-in type with restrictions and compiled
+ * regexps, so that validation of a union value does not resolve types.
+ * @param[in]  h       Clicon handle
+ * @param[in]  ys      Leaf or leaf-list of original resolving
+ * @param[in]  yunion  Resolved union type statement, must have a type cache
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+yang_type_union_cache_set(clicon_handle h,
+			  yang_stmt    *ys,
+			  yang_stmt    *yunion)
+{
+    int                retval = -1;
+    yang_type_cache   *ycache = yunion->ys_typecache;
+    yang_union_member *vec = NULL;
+    int                len = 0;
+    int                i;
+
+    if (yang_type_union_resolve(h, ys, yunion, &vec, &len) < 0)
+	goto done;
+    if ((ycache->yc_order = calloc(len?len:1, sizeof(int))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<len; i++)
+	ycache->yc_order[i] = i;
+    ycache->yc_rxmode = clicon_yang_regexp(h);
+    ycache->yc_members = vec;
+    ycache->yc_nmembers = len;
+    vec = NULL;
+    retval = 0;
+ done:
+    if (vec){
+	for (i=0; i<len; i++)
+	    if (vec[i].um_regexps)
+		yang_type_regexps_free(clicon_yang_regexp(h), vec[i].um_regexps);
+	free(vec);
+    }
+    return retval;
+}
+
+/*! Validate a value against cached union members
+ * Members are tried in order of how often they have matched previously, 
+ * so that common values (eg ipv4 of ip-address) hit the first member. If no 
+ * member matches, the reason of the last member in yang order is returned
+ * which is the same as if tried in yang order.
+ * @param[in]  h       Clicon handle
+ * @param[in]  ys      Leaf or leaf-list
+ * @param[out] reason  If given, and return value is 0, contains malloced string
+ * @param[in]  ycache  Type cache of union with resolved members
+ * @param[in]  type    Original type
+ * @param[in]  val     Value to validate
+ * @retval -1  Error (fatal), with errno set to indicate error
+ * @retval 0   Validation not OK, malloced reason is returned. Free reason with free()
+ * @retval 1   Validation OK
+ * @see ys_cv_validate_union  Uncached variant
+ */
+static int
+ys_cv_validate_union_cache(clicon_handle    h,
+			   yang_stmt       *ys,
+			   char           **reason,
+			   yang_type_cache *ycache,
+			   char            *type,
+			   char            *val)
+{
+    int                retval = -1;
+    yang_union_member *um;
+    enum cv_type       cvtype;
+    cg_var            *cvt = NULL;
+    char              *reason1 = NULL;  /* saved reason */
+    int                ireason = -1;    /* member index of saved reason */
+    int                i;
+    int                j;
+    int                tmp;
+
+    if (ycache->yc_nmembers == 0){
+	retval = 1;
+	goto done;
+    }
+    if ((cvt = cv_new(CGV_STRING)) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_new");
+	goto done;
+    }
+    for (i=0; i<ycache->yc_nmembers; i++){
+	j = ycache->yc_order[i];
+	um = &ycache->yc_members[j];
+	if (um->um_restype != NULL)
+	    cvtype = um->um_cvtype;
+	else if (clicon_type2cv(type, NULL, ys, &cvtype) < 0)
+	    goto done;
+	/* reparse value with the member type */
+	cv_reset(cvt);
+	cv_type_set(cvt, cvtype);
+	if ((retval = cv_parse1(val, cvt, reason)) < 0){
+	    clicon_err(OE_UNIX, errno, "cv_parse");
+	    goto done;
+	}
+	if (retval == 1 &&
+	    (retval = cv_validate1(h, cvt, cvtype, um->um_options, um->um_cvv,
+				   um->um_regexps, um->um_restype,
+				   um->um_restype?um->um_restype->ys_argument:NULL,
+				   reason)) < 0)
+	    goto done;
+	if (retval == 1){ /* Enough that one type validates value */
+	    um->um_hits++;
+	    /* Move member one step forward if it is more frequent */
+	    if (i > 0 &&
+		um->um_hits > ycache->yc_members[ycache->yc_order[i-1]].um_hits){
+		tmp = ycache->yc_order[i-1];
+		ycache->yc_order[i-1] = j;
+		ycache->yc_order[i] = tmp;
+	    }
+	    break;
+	}
+	/* If validation failed, save reason of last member in yang order */
+	if (reason && *reason != NULL){
+	    if (j > ireason){
+		if (reason1)
+		    free(reason1);
+		reason1 = *reason;
+		ireason = j;
+	    }
+	    else
+		free(*reason);
+	    *reason = NULL;
+	}
+    }
+ done:
+    if (retval == 0 && reason1){
+	*reason = reason1;
+	reason1 = NULL;
+    }
+    if (reason1)
+	free(reason1);
+    if (cvt)
+	cv_free(cvt);
+    return retval;
+}
+
 /*! Validate cligen variable cv using yang statement as spec
  *
  * @param[in]  h       Clicon handle     
@@ -1052,20 +1436,15 @@ ys_cv_validate(clicon_handle h,
 	       yang_stmt    *ys, 
 	       char        **reason)
 {
-    int             retval = -1; 
-    cg_var         *ycv;        /* cv of yang-statement */  
-    int             options = 0;
-    cvec           *cvv = NULL;
-    cvec           *patterns = NULL;
-    cvec           *regexps = NULL;
-    enum cv_type    cvtype;
-    char           *origtype = NULL;  /* orig type */
-    yang_stmt      *yrestype; /* resolved type */
-    char           *restype;
-    uint8_t         fraction = 0; 
-    int             retval2;
-    char           *val;
-    cg_var         *cvt=NULL;
+    int              retval = -1; 
+    cg_var          *ycv;        /* cv of yang-statement */  
+    yang_leaftype   *lt;         /* resolved type of leaf */
+    yang_type_cache *ycache;
+    cvec            *regexps = NULL;
+    enum cv_type     cvtype;
+    char            *restype;
+    int              retval2;
+    char            *val;
 
     if (reason)
 	*reason=NULL;
@@ -1074,23 +1453,13 @@ ys_cv_validate(clicon_handle h,
 	goto done;
     }
     ycv = ys->ys_cv;
-    if ((regexps = cvec_new(0)) == NULL){
-	clicon_err(OE_UNIX, errno, "cvec_new");
-	goto done;
-    }
-    if ((patterns = cvec_new(0)) == NULL){
-	clicon_err(OE_UNIX, errno, "cvec_new");
-	goto done;
+    if ((lt = ys->ys_leaftype) == NULL){
+	if (yang_leaftype_set(h, ys) < 0)
+	    goto done;
+	lt = ys->ys_leaftype;
     }
-    if (yang_type_get(ys, &origtype, &yrestype, 
-		      &options, &cvv,
-		      patterns, regexps,
-		      &fraction) < 0)
-	goto done;
-    restype = yrestype?yrestype->ys_argument:NULL;
-    if (clicon_type2cv(origtype, restype, ys, &cvtype) < 0)
-	goto done;
-
+    restype = lt->lt_restype?lt->lt_restype->ys_argument:NULL;
+    cvtype = lt->lt_cvtype;
     if (cv_type_get(ycv) != cvtype){
 	/* special case: dbkey has rest syntax-> cv but yang cant have that */
 	if (cvtype == CGV_STRING && cv_type_get(ycv) == CGV_REST)
@@ -1105,7 +1474,17 @@ ys_cv_validate(clicon_handle h,
     if (restype && strcmp(restype, "union") == 0){ 
 	assert(cvtype == CGV_REST);
 	val = cv_string_get(cv);
-	if ((retval2 = ys_cv_validate_union(h, ys, reason, yrestype, origtype, val)) < 0)
+	if ((ycache = lt->lt_restype->ys_typecache) != NULL){
+	    /* Resolve union members once, then validate using cache */
+	    if (ycache->yc_members == NULL &&
+		yang_type_union_cache_set(h, ys, lt->lt_restype) < 0)
+		goto done;
+	    if ((retval2 = ys_cv_validate_union_cache(h, ys, reason, ycache,
+						      lt->lt_origtype, val)) < 0)
+		goto done;
+	}
+	else if ((retval2 = ys_cv_validate_union(h, ys, reason, lt->lt_restype,
+						 lt->lt_origtype, val)) < 0)
 	    goto done;
 	retval = retval2; /* invalid (0) with latest reason or valid 1 */
     }
@@ -1113,29 +1492,13 @@ ys_cv_validate(clicon_handle h,
 	/* The regexp cache may be invalidated, in that case re-compile
 	 * eg due to copying
 	 */
-	if (cvec_len(patterns)!=0 && cvec_len(regexps)==0){
-	    yang_stmt      *yt;
-	    if (compile_pattern2regexp(h, patterns, regexps) < 1)
-		goto done;
-	    yt = yang_find(ys, Y_TYPE, NULL);
-	    if (yang_type_cache_regexp_set(yt,
-					   clicon_yang_regexp(h),
-					   regexps) < 0)
-		goto done;
-	}
-	if ((retval = cv_validate1(h, cv, cvtype, options, cvv,
-				   regexps, yrestype, restype, reason)) < 0)
+	if (yang_type_cache_regexps(h, lt->lt_ytype, &regexps) < 0)
+	    goto done;
+	if ((retval = cv_validate1(h, cv, cvtype, lt->lt_options, lt->lt_cvv,
+				   regexps, lt->lt_restype, restype, reason)) < 0)
 	    goto done;
     }
   done:
-    if (origtype)
-	free(origtype);
-    if (regexps)
-	cvec_free(regexps);
-    if (patterns)
-	cvec_free(patterns);
-    if (cvt)
-	cv_free(cvt);
     return retval;
 }
 
@@ -1469,9 +1832,27 @@ yang_type_get(yang_stmt    *ys,
     int retval = -1;
     yang_stmt    *ytype;        /* type */
     char         *type = NULL;
+    yang_leaftype *lt;
 
     if (options)
 	*options = 0x0;
+    /* Use resolved leaf type if no patterns are requested */
+    if ((lt = ys->ys_leaftype) != NULL && patterns == NULL && regexps == NULL){
+	if (origtype &&
+	    (*origtype = strdup(lt->lt_origtype)) == NULL){
+	    clicon_err(OE_XML, errno, "stdup");
+	    goto done;
+	}
+	*yrestype = lt->lt_restype;
+	if (options)
+	    *options = lt->lt_options;
+	if (cvv)
+	    *cvv = lt->lt_cvv;
+	if (fraction)
+	    *fraction = lt->lt_fraction;
+	retval = 0;
+	goto done;
+    }
     /* Find mandatory type */
     if ((ytype = yang_find(ys, Y_TYPE, NULL)) == NULL){
 	clicon_err(OE_DB, ENOENT, "mandatory type object is not found");
@@ -1508,6 +1889,8 @@ yang_type2cv(yang_stmt  *ys)
     char           *origtype=NULL;   /* original type */
     enum cv_type    cvtype = CGV_ERR;
     
+    if (ys->ys_leaftype)
+	return ys->ys_leaftype->lt_cvtype;
     /* Find type specification */
     if (yang_type_get(ys, &origtype, &yrestype, NULL, NULL, NULL, NULL, NULL)
  < 0)
@@ -0,0 +1,78 @@
+#!/usr/bin/env bash
+# Backend client sessions and output queues (CLICON_BACKEND_CLIENT_STATE)
+# Many requests in one session are all dispatched, and queue statistics of
+# the sessions are state data of clixon-lib backend-clients
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of requests in one session
+: ${perfreq:=100}
+
+APPNAME=example
+
+cfg=$dir/config.xml
+fyang=$dir/queue.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_CLIENT_STATE>true</CLICON_BACKEND_CLIENT_STATE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module queue{
+  yang-version 1.1;
+  namespace "urn:example:queue";
+  prefix q;
+  leaf x{
+    type string;
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "netconf $perfreq pings in one session"
+nr=$(for (( i=0; i<$perfreq; i++ )); do
+    echo "<rpc><ping xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>"
+done | $clixon_netconf -qf $cfg | grep -o "<rpc-reply><ok/></rpc-reply>" | wc -l)
+if [ $nr -ne $perfreq ]; then
+    err "$perfreq" "$nr"
+fi
+
+new "netconf get backend-clients state"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get><filter type='xpath' select=\"/cl:backend-clients\" xmlns:cl='http://clicon.org/lib'/></get></rpc>]]>]]>" "^<rpc-reply><data><backend-clients xmlns=\"http://clicon.org/lib\"><client><number>[0-9]*</number><session-id>[0-9]*</session-id><in-msgs>[0-9]*</in-msgs><out-msgs>[0-9]*</out-msgs><queue-msgs>0</queue-msgs><queue-bytes>0</queue-bytes><queue-peak>[0-9]*</queue-peak><dropped>0</dropped><paused>0</paused></client></backend-clients></data></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
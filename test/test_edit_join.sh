@@ -0,0 +1,130 @@
+#!/usr/bin/env bash
+# Edit-config of many list and leaf-list entries into an existing list
+# Large sorted modifications are matched by a merge-join of the base and
+# modification trees, and new entries are merged into sorted place afterwards
+# Check the result is same as entries were added one by one
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list/leaf-list entries in each edit
+: ${perfnr:=100}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+fconfig=$dir/config.xml
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type int32;
+      }
+    }
+    leaf-list c {
+       type int32;
+    }
+    leaf d {
+       type string;
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "generate config with $perfnr even entries"
+echo -n "<rpc><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">" > $fconfig
+for (( i=0; i<$perfnr; i++ )); do  
+    echo -n "<y><a>$((2*i))</a><b>0</b></y><c>$((2*i))</c>" >> $fconfig
+done
+echo "</x></config></edit-config></rpc>]]>]]>" >> $fconfig
+
+new "netconf write even entries"
+expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+# Reverse order and interleaved with the existing entries, every fourth
+# existing entry is modified
+new "generate config with $perfnr odd entries"
+echo -n "<rpc><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><d>hello</d>" > $fconfig
+for (( i=$perfnr-1; i>=0; i-- )); do  
+    echo -n "<c>$((2*i+1))</c><y><a>$((2*i+1))</a><b>1</b></y>" >> $fconfig
+    if [ $((i%2)) -eq 0 ]; then
+	echo -n "<y><a>$((2*i))</a><b>2</b></y>" >> $fconfig
+    fi
+done
+echo "</x></config></edit-config></rpc>]]>]]>" >> $fconfig
+
+new "netconf merge odd entries"
+expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+expect="<rpc-reply><data><x xmlns=\"urn:example:clixon\">"
+for (( i=0; i<2*$perfnr; i++ )); do
+    if [ $((i%2)) -eq 1 ]; then
+	b=1
+    elif [ $((i%4)) -eq 0 ]; then
+	b=2
+    else
+	b=0
+    fi
+    expect="$expect<y><a>$i</a><b>$b</b></y>"
+done
+for (( i=0; i<2*$perfnr; i++ )); do
+    expect="$expect<c>$i</c>"
+done
+expect="$expect<d>hello</d></x></data></rpc-reply>]]>]]>"
+
+new "netconf get-config sorted"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^$expect$"
+
+new "netconf get single entry"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=$perfnr]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply><data><x xmlns=\"urn:example:clixon\"><y><a>$perfnr</a><b>[02]</b></y></x></data></rpc-reply>]]>]]>$"
+
+new "netconf validate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
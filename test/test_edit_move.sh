@@ -0,0 +1,128 @@
+#!/usr/bin/env bash
+# Bulk load: edit-config of new subtrees moves them into the datastore
+# Load into empty datastore, replace, and subtrees that cannot be moved
+# (operation attributes, ordered-by user, identityref prefixes)
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries
+: ${perfnr:=100}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+fconfig=$dir/config.xml
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   identity base;
+   identity foo {
+      base base;
+   }
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      container z {
+        leaf-list c {
+          type string;
+        }
+      }
+    }
+    list u {
+      ordered-by user;
+      key "k";
+      leaf k {
+        type string;
+      }
+    }
+    leaf id {
+      type identityref {
+        base base;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "generate config with $perfnr entries in reverse order"
+echo -n "<rpc><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">" > $fconfig
+for (( i=$perfnr-1; i>=0; i-- )); do  
+    echo -n "<y><a>$i</a><z><c>b$i</c><c>a$i</c></z></y>" >> $fconfig
+done
+echo "</x></config></edit-config></rpc>]]>]]>" >> $fconfig
+
+new "netconf load into empty datastore"
+expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+expect="<rpc-reply><data><x xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$perfnr; i++ )); do
+    expect="$expect<y><a>$i</a><z><c>a$i</c><c>b$i</c></z></y>"
+done
+expect="$expect</x></data></rpc-reply>]]>]]>"
+
+new "netconf get-config sorted"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^$expect$"
+
+new "netconf replace with ordered-by user list and identityref"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><x xmlns=\"urn:example:clixon\" xmlns:ex=\"urn:example:clixon\"><u><k>b</k></u><u><k>a</k></u><id>ex:foo</id><y><a>1</a><z><c>x</c></z></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config after replace"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply><data><x xmlns=\"urn:example:clixon\"[^>]*><y><a>1</a><z><c>x</c></z></y><u><k>b</k></u><u><k>a</k></u><id>ex:foo</id></x></data></rpc-reply>]]>]]>$"
+
+new "netconf new entries with operation attribute"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><y><a>2</a><z><c>y</c><c>x</c></z></y><y><a>3</a><z nc:operation=\"create\"><c>y</c></z></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config after merge"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply><data><x xmlns=\"urn:example:clixon\"[^>]*><y><a>1</a><z><c>x</c></z></y><y><a>2</a><z><c>x</c><c>y</c></z></y><y><a>3</a><z><c>y</c></z></y><u><k>b</k></u><u><k>a</k></u><id>ex:foo</id></x></data></rpc-reply>]]>]]>$"
+
+new "netconf validate"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
@@ -1,6 +1,7 @@
 #!/usr/bin/env bash
 # Test netconf filter, subtree and xpath
-# Note subtree namespaces not implemented
+# Subtree filters are translated to xpath and evaluated in the backend if possible,
+# otherwise all data is fetched and filtered in the netconf client
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -74,6 +75,18 @@ expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><running/></sou
 new "get subtree one"
 expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get><filter type='subtree'><x xmlns='urn:example:filter'><y><a>1</a></y></x></filter></get></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:filter"><y><a>1</a><b>1</b></y></x></data></rpc-reply>]]>]]>$'
 
+new "get-config subtree selection node"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><running/></source><filter type='subtree'><x xmlns='urn:example:filter'><y><a>2</a><b/></y></x></filter></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:filter"><y><a>2</a><b>2</b></y></x></data></rpc-reply>]]>]]>$'
+
+new "get-config subtree containment node"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><running/></source><filter type='subtree'><x xmlns='urn:example:filter'/></filter></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:filter"><y><a>1</a><b>1</b></y><y><a>2</a><b>2</b></y></x></data></rpc-reply>]]>]]>$'
+
+new "get-config subtree no match"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><running/></source><filter type='subtree'><x xmlns='urn:example:filter'><y><a>3</a></y></x></filter></get-config></rpc>]]>]]>" '^<rpc-reply><data/></rpc-reply>]]>]]>$'
+
+new "get-config subtree quote in content, filtered locally"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><running/></source><filter type='subtree'><x xmlns='urn:example:filter'><y><a>1'</a></y></x></filter></get-config></rpc>]]>]]>" '^<rpc-reply><data/></rpc-reply>]]>]]>$'
+
 new "get-config xpath one"
 expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get><filter type='xpath' select=\"/fi:x/fi:y[fi:a='1']\" xmlns:fi='urn:example:filter' /></get></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:filter"><y><a>1</a><b>1</b></y></x></data></rpc-reply>]]>]]>$'
 
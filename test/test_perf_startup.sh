@@ -118,4 +118,35 @@ for mode in startup running; do
     done
 done
 
+# Yang cache: first load parses yang files and writes cache, second reads it
+ycache=$dir/ycache
+mkdir -p $ycache
+
+new "Build yang cache (cold)"
+expectfn "clixon_util_yang_cache -f $cfg -y $fyang -d $ycache" 0 "modules loaded in"
+
+new "Check yang cache file written"
+if ! ls $ycache/scaling.yang.*.yb > /dev/null 2>&1; then
+    err "$ycache/scaling.yang.<hash>.yb" "no such file"
+fi
+
+new "Load yang from cache (warm)"
+expectfn "clixon_util_yang_cache -f $cfg -y $fyang -d $ycache" 0 "modules loaded in"
+
+# Post-processing (features, types, grouping, augment) is not cached: show its
+# share of the load time without and with cache
+new "Load yang without cache: post-processing and total time"
+mkdir -p $dir/nocache
+clixon_util_yang_cache -D 1 -f $cfg -y $fyang -d $dir/nocache 2>&1 | grep -E "post-processing|modules loaded in" | sed -e 's/^.*yang_parse_post //'
+rm -rf $dir/nocache
+
+new "Load yang from cache: post-processing and total time"
+clixon_util_yang_cache -D 1 -f $cfg -y $fyang -d $ycache 2>&1 | grep -E "post-processing|modules loaded in" | sed -e 's/^.*yang_parse_post //'
+
+new "Startup with yang cache"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s init -f $cfg -y $fyang -o CLICON_YANG_CACHE_DIR=$ycache 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+new "Startup without yang cache"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s init -f $cfg -y $fyang 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
 rm -rf $dir
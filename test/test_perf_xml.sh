@@ -1,6 +1,7 @@
 #!/usr/bin/env bash
 # Test: XML performance test 
 # See https://github.com/clicon/clixon/issues/96
+# Also memory per node of a parsed list
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 
@@ -24,5 +25,21 @@ echo "]]></stdout></rpc-reply>" >> $fxml
 new "xml parse long CDATA"
 expecteof_file "time $clixon_util_xml" 0 "$fxml"
 
+flist=$dir/list.xml
+
+new "generate list file $flist"
+echo -n "<x>" > $flist
+for (( i=0; i<$perfnr; i++ )); do  
+    echo -n "<y><a>$i</a><b>value$i</b></y>" >> $flist
+done
+echo "</x>" >> $flist
+
+# Each list entry is five nodes: y, a, b and two bodies
+new "xml parse list memory"
+expecteof_file "$clixon_util_xml -m" 0 "$flist" "^nodes:$(( 5*perfnr + 2 )) memory:[0-9]* names:[0-9]* names-memory:[0-9]* per-node:[0-9]*$"
+
+new "xml memory per node of $perfnr list entries"
+$clixon_util_xml -m -f $flist | awk -F'per-node:' '{print $2}'
+
 rm -rf $dir
 
@@ -0,0 +1,192 @@
+#!/usr/bin/env bash
+# Restconf response cache (CLICON_RESTCONF_CACHE_MAX)
+# Repeated GETs are served from cache, and replies are removed when the
+# backend notifies changes of their subtree
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+  container z {
+    leaf c {
+      type string;
+    }
+  }
+  container w {
+    leaf f {
+      type string;
+    }
+    leaf e {
+      type string;
+      default "e0";
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_RESTCONF_CACHE_MAX>100000</CLICON_RESTCONF_CACHE_MAX>
+  <CLICON_XMLDB_CHANGE_STREAM>true</CLICON_XMLDB_CHANGE_STREAM>
+  <CLICON_STREAM_DISCOVERY_RFC8040>true</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "kill old restconf daemon"
+sudo pkill -u $wwwuser -f clixon_restconf
+
+new "start restconf daemon"
+start_restconf -f $cfg
+
+new "waiting"
+wait_restconf
+
+# Get a response cache counter
+# Args: 1: counter name, eg hits
+cachestat(){
+    curl -s -X GET http://localhost/restconf/data/ietf-restconf-monitoring:restconf-state/clixon-restconf:response-cache | grep -o "\"$1\":\"\?[0-9]*" | grep -o "[0-9]*$"
+}
+
+# Check a response cache counter
+# Args: 1: counter name, 2: expected value
+expectstat(){
+    v=$(cachestat $1)
+    if [ "$v" != "$2" ]; then
+	err "$1 $2" "$v"
+    fi
+}
+
+new "restconf put 42"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:x/y=42 -d '{"example:y":{"a":"42","b":"42"}}')" 0 ""
+
+new "restconf put z"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:z -d '{"example:z":{"c":"0"}}')" 0 ""
+
+new "restconf response-cache state"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/ietf-restconf-monitoring:restconf-state/clixon-restconf:response-cache)" 0 "HTTP/1.1 200 OK" '"clixon-restconf:response-cache":{"hits":"0","misses":"0"'
+
+new "restconf get 42 miss"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" 'ETag: W/"' '{"example:y":\[{"a":"42","b":"42"}\]}'
+expectstat misses 1
+expectstat entries 1
+
+new "restconf get 42 hit"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" 'ETag: W/"' '{"example:y":\[{"a":"42","b":"42"}\]}'
+expectstat hits 1
+
+new "restconf get 42 xml is other entry"
+expectpart "$(curl -si -X GET -H 'Accept: application/yang-data+xml' http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" '<y xmlns="urn:example:clixon"><a>42</a><b>42</b></y>'
+expectstat misses 2
+expectstat entries 2
+
+new "restconf get 42 hit If-None-Match not modified"
+etag=$(curl -si -X GET http://localhost/restconf/data/example:x/y=42 | grep -i "^ETag:" | sed -e 's/^[Ee][Tt][Aa][Gg]: *//' -e 's/\r$//')
+expectpart "$(curl -si -X GET -H "If-None-Match: $etag" http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 304 Not Modified"
+expectstat hits 3
+
+new "restconf get z miss"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:z)" 0 "HTTP/1.1 200 OK" '{"example:z":{"c":"0"}}'
+expectstat entries 3
+
+new "restconf modify z"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:z -d '{"example:z":{"c":"1"}}')" 0 ""
+
+new "restconf get z is invalidated"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:z)" 0 "HTTP/1.1 200 OK" '{"example:z":{"c":"1"}}'
+expectstat invalidations 1
+
+new "restconf get 42 still cached"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" '{"example:y":\[{"a":"42","b":"42"}\]}'
+expectstat hits 4
+
+new "restconf modify 42"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:x/y=42 -d '{"example:y":{"a":"42","b":"99"}}')" 0 ""
+
+new "restconf get 42 modified"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" '{"example:y":\[{"a":"42","b":"99"}\]}'
+
+new "restconf delete x"
+expecteq "$(curl -s -X DELETE http://localhost/restconf/data/example:x)" 0 ""
+
+new "restconf get 42 after delete not found"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 404 Not Found"
+
+new "restconf get with other query parameter is not cached"
+n=$(cachestat entries)
+expectpart "$(curl -si -X GET 'http://localhost/restconf/data/example:z?fields=c')" 0 "HTTP/1.1 200 OK"
+expectstat entries $n
+
+new "restconf put w"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:w -d '{"example:w":{"f":"1"}}')" 0 ""
+
+new "restconf get w with default"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:w)" 0 "HTTP/1.1 200 OK" '"e":"e0"'
+
+new "restconf get w with-defaults=trim is cached separately"
+n=$(cachestat entries)
+ret=$(curl -si -X GET 'http://localhost/restconf/data/example:w?with-defaults=trim')
+expectpart "$ret" 0 "HTTP/1.1 200 OK" '{"example:w":{"f":"1"}}'
+if [ -n "$(echo "$ret" | grep e0)" ]; then
+    err "no default" "$ret"
+fi
+expectstat entries $(( n + 1 ))
+
+new "restconf get w with default from cache"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:w)" 0 "HTTP/1.1 200 OK" '"e":"e0"'
+
+new "Kill restconf daemon"
+stop_restconf
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
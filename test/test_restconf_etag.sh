@@ -0,0 +1,209 @@
+#!/usr/bin/env bash
+# Restconf entity-tags and conditional GET (ETag, Last-Modified, If-None-Match)
+# Entity-tags are backed by backend generations of top-level subtrees
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+# Backend debug log, to check which rpcs restconf makes
+belog=$dir/backend.log
+fyang=$dir/example.yang
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+  container z {
+    leaf c {
+      type string;
+    }
+  }
+  container s {
+    config false;
+    leaf d {
+      type string;
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg -D 1 -l f$belog
+fi
+
+new "waiting"
+wait_backend
+
+new "kill old restconf daemon"
+sudo pkill -u $wwwuser -f clixon_restconf
+
+new "start restconf daemon"
+start_restconf -f $cfg
+
+new "waiting"
+wait_restconf
+
+# Get ETag header value of a GET
+# Args: 1: url
+getetag(){
+    curl -si -X GET $1 | grep -i "^ETag:" | sed -e 's/^[Ee][Tt][Aa][Gg]: *//' -e 's/\r$//'
+}
+
+new "restconf put 42"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:x/y=42 -d '{"example:y":{"a":"42","b":"42"}}')" 0 ""
+
+new "restconf put z"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:z -d '{"example:z":{"c":"0"}}')" 0 ""
+
+new "restconf get 42 with ETag and Last-Modified"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" 'ETag: W/"' "Last-Modified: " '{"example:y":\[{"a":"42","b":"42"}\]}'
+
+etag=$(getetag http://localhost/restconf/data/example:x/y=42)
+new "restconf get 42 ETag: $etag"
+if [ -z "$etag" ]; then
+    err "ETag" "$etag"
+fi
+
+new "restconf head 42 has same ETag"
+expectpart "$(curl -si -I http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" "ETag: $etag"
+
+new "restconf get 42 If-None-Match not modified"
+ret=$(curl -si -X GET -H "If-None-Match: $etag" http://localhost/restconf/data/example:x/y=42)
+expectpart "$ret" 0 "HTTP/1.1 304 Not Modified" "ETag: $etag"
+match=$(echo "$ret" | grep -c '"a":"42"')
+if [ $match -ne 0 ]; then
+    err "No data" "$ret"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "restconf get 42 If-None-Match not modified makes no get rpc"
+    sudo truncate -s 0 $belog
+    expectpart "$(curl -si -X GET -H "If-None-Match: $etag" http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 304 Not Modified"
+    rpcs=$(sudo grep -o "rpc:[a-z-]*" $belog | tr '\n' ' ')
+    if [ "$rpcs" != "rpc:generation " ]; then
+	err "rpc:generation" "$rpcs"
+    fi
+
+    new "restconf get 42 If-None-Match modified makes get rpc"
+    sudo truncate -s 0 $belog
+    expectpart "$(curl -si -X GET -H 'If-None-Match: W/"0"' http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK"
+    rpcs=$(sudo grep -o "rpc:[a-z-]*" $belog | tr '\n' ' ')
+    if [ "$rpcs" != "rpc:generation rpc:get " ]; then
+	err "rpc:generation rpc:get" "$rpcs"
+    fi
+
+    new "restconf get 42 without If-None-Match makes one get rpc"
+    sudo truncate -s 0 $belog
+    expectpart "$(curl -si -X GET http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK"
+    rpcs=$(sudo grep -o "rpc:[a-z-]*" $belog | tr '\n' ' ')
+    if [ "$rpcs" != "rpc:get " ]; then
+	err "rpc:get" "$rpcs"
+    fi
+fi
+
+new "restconf get 42 If-None-Match in list of entity-tags"
+expectpart "$(curl -si -X GET -H "If-None-Match: W/\"0\", $etag" http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 304 Not Modified"
+
+new "restconf get 42 If-None-Match other entity-tag"
+expectpart "$(curl -si -X GET -H 'If-None-Match: W/"0"' http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" '{"example:y":\[{"a":"42","b":"42"}\]}'
+
+new "restconf modify other subtree z"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:z -d '{"example:z":{"c":"1"}}')" 0 ""
+
+new "restconf get 42 still not modified"
+expectpart "$(curl -si -X GET -H "If-None-Match: $etag" http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 304 Not Modified"
+
+new "restconf get datastore config not modified"
+etagd=$(getetag "http://localhost/restconf/data?content=config")
+expectpart "$(curl -si -X GET -H "If-None-Match: $etagd" "http://localhost/restconf/data?content=config")" 0 "HTTP/1.1 304 Not Modified"
+
+new "restconf modify 42"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:x/y=42 -d '{"example:y":{"a":"42","b":"99"}}')" 0 ""
+
+new "restconf get 42 modified"
+expectpart "$(curl -si -X GET -H "If-None-Match: $etag" http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" '{"example:y":\[{"a":"42","b":"99"}\]}'
+
+new "restconf get datastore modified"
+expectpart "$(curl -si -X GET -H "If-None-Match: $etagd" "http://localhost/restconf/data?content=config")" 0 "HTTP/1.1 200 OK"
+
+new "restconf new ETag differs"
+etag2=$(getetag http://localhost/restconf/data/example:x/y=42)
+if [ "$etag" = "$etag2" ]; then
+    err "New ETag" "$etag2"
+fi
+
+new "restconf delete x"
+expecteq "$(curl -s -X DELETE http://localhost/restconf/data/example:x)" 0 ""
+
+new "restconf get 42 after delete not found"
+expectpart "$(curl -si -X GET -H "If-None-Match: $etag2" http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 404 Not Found"
+
+new "restconf get state data has no ETag"
+ret=$(curl -si -X GET http://localhost/restconf/data/example:s)
+match=$(echo "$ret" | grep -ci "^ETag:")
+if [ $match -ne 0 ]; then
+    err "No ETag" "$ret"
+fi
+
+new "restconf get datastore with state data has no ETag"
+ret=$(curl -si -X GET http://localhost/restconf/data)
+match=$(echo "$ret" | grep -ci "^ETag:")
+if [ $match -ne 0 ]; then
+    err "No ETag" "$ret"
+fi
+
+new "netconf generation rpc"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><generation xmlns="http://clicon.org/lib"><subtree>example:z</subtree></generation></rpc>]]>]]>' '^<rpc-reply><generation xmlns="http://clicon.org/lib">[0-9]*</generation><modified xmlns="http://clicon.org/lib">[0-9]*</modified></rpc-reply>]]>]]>$'
+
+new "netconf get with generation of subtree"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get content="config" generation="example:z"><filter type="xpath" select="/ex:z" xmlns:ex="urn:example:clixon"/></get></rpc>]]>]]>' '^<rpc-reply><data generation="[0-9]*" nacm-generation="0" modified="[0-9]*"><z xmlns="urn:example:clixon"><c>1</c></z></data></rpc-reply>]]>]]>$'
+
+new "Kill restconf daemon"
+stop_restconf
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
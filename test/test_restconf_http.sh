@@ -0,0 +1,192 @@
+#!/usr/bin/env bash
+# Restconf native HTTP/1.1 listener (CLICON_RESTCONF_HTTP_PORT)
+# Requests directly to clixon_restconf, keep-alive and pipelining, a client
+# that does not read its responses does not stall other clients, and a
+# throughput comparison with the FastCGI path via the webserver using
+# concurrent clients (ab if installed, otherwise parallel curl)
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Port of native listener
+: ${port:=8008}
+
+# Number of requests in time comparison
+: ${perfreq:=100}
+
+# Number of concurrent clients in throughput comparison
+: ${perfconc:=10}
+
+# Print requests per second of $perfreq GET requests of a url with $perfconc
+# concurrent clients
+# Arguments:
+# - url
+loadgen(){
+    u=$1
+    if which ab > /dev/null; then
+	ab -k -q -n $perfreq -c $perfconc $u 2>&1 | awk '/Requests per second/ {print $4}'
+    else
+	t=$({ time -p seq $perfreq | xargs -P $perfconc -I{} curl -sG -o /dev/null $u; } 2>&1 | awk '/real/ {print $2}')
+	echo "$perfreq $t" | awk '{ if ($2 > 0) printf "%.1f\n", $1/$2; else print "-" }'
+    fi
+}
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_RESTCONF_HTTP_PORT>$port</CLICON_RESTCONF_HTTP_PORT>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "kill old restconf daemon"
+sudo pkill -u $wwwuser -f clixon_restconf
+
+new "start restconf daemon"
+start_restconf -f $cfg
+
+new "waiting"
+wait_restconf
+
+url=http://127.0.0.1:$port
+
+new "native restconf root"
+expectpart "$(curl -si -X GET -H 'Accept: application/yang-data+json' $url/restconf)" 0 "HTTP/1.1 200 OK" "Content-Type: application/yang-data+json" "Content-Length: " '{"ietf-restconf:restconf":{"data":{},"operations":{},"yang-library-version":"2016-06-21"}}'
+
+new "native restconf put 42"
+expectpart "$(curl -si -X PUT -H "Content-Type: application/yang-data+json" $url/restconf/data/example:x/y=42 -d '{"example:y":{"a":"42","b":"42"}}')" 0 "HTTP/1.1 201 Created"
+
+new "native restconf get 42"
+expectpart "$(curl -si -X GET $url/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" '{"example:y":\[{"a":"42","b":"42"}\]}'
+
+new "native restconf get 42 via webserver (FastCGI)"
+expectpart "$(curl -si -X GET http://localhost/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" '{"example:y":\[{"a":"42","b":"42"}\]}'
+
+new "native restconf not found"
+expectpart "$(curl -si -X GET $url/restconf/data/example:x/y=99)" 0 "HTTP/1.1 404 Not Found"
+
+new "native restconf keep-alive, two requests on one connection"
+ret=$(curl -sv -X GET $url/restconf/data/example:x/y=42 $url/restconf/data/example:x/y=42 2>&1)
+match=$(echo "$ret" | grep -c "Re-using existing connection")
+if [ $match -lt 1 ]; then
+    err "Re-using existing connection" "$ret"
+fi
+
+if which nc > /dev/null; then
+new "native restconf pipelining, two requests in one write"
+ret=$(printf "GET /restconf/data/example:x/y=42 HTTP/1.1\r\nHost: localhost\r\n\r\nGET /restconf/data/example:x/y=42 HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n" | nc -q 2 127.0.0.1 $port)
+nr=$(echo "$ret" | grep -c "HTTP/1.1 200 OK")
+if [ $nr -ne 2 ]; then
+    err 2 "$nr"
+fi
+fi # nc
+
+if which python3 > /dev/null; then
+new "native restconf client not reading its responses does not stall others"
+# Pipeline many requests and do not read the responses for 5 seconds
+python3 -c "
+import socket,time
+s=socket.create_connection(('127.0.0.1',$port))
+s.sendall(b'GET /restconf/data/example:x/y=42 HTTP/1.1\r\nHost: localhost\r\n\r\n'*20000)
+time.sleep(5)
+" &
+slowpid=$!
+sleep 1
+expectpart "$(curl -si -m 3 -X GET $url/restconf/data/example:x/y=42)" 0 "HTTP/1.1 200 OK" '{"example:y":\[{"a":"42","b":"42"}\]}'
+wait $slowpid
+fi # python3
+
+new "native restconf delete 42"
+ret=$(curl -si -X DELETE $url/restconf/data/example:x/y=42)
+expectpart "$ret" 0 "HTTP/1.1 204 No Content"
+
+new "native restconf 204 without Content-Length"
+match=$(echo "$ret" | grep -ci "Content-Length")
+if [ $match -ne 0 ]; then
+    err "No Content-Length" "$ret"
+fi
+
+# Time comparison of native and FastCGI path
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" $url/restconf/data/example:x/y=1 -d '{"example:y":{"a":"1","b":"1"}}')" 0 ""
+
+new "restconf get $perfreq via webserver (FastCGI)"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    curl -sG http://localhost/restconf/data/example:x/y=1 > /dev/null
+done } 2>&1 | awk '/real/ {print $2}'
+
+new "restconf get $perfreq native"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    curl -sG $url/restconf/data/example:x/y=1 > /dev/null
+done } 2>&1 | awk '/real/ {print $2}'
+
+new "restconf get $perfreq native on one connection"
+urls=""
+for (( i=0; i<$perfreq; i++ )); do
+    urls="$urls $url/restconf/data/example:x/y=1"
+done
+{ time -p curl -sG $urls > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+new "restconf get $perfreq via webserver (FastCGI) with $perfconc clients, requests/s"
+loadgen http://localhost/restconf/data/example:x/y=1
+
+new "restconf get $perfreq native with $perfconc clients, requests/s"
+loadgen $url/restconf/data/example:x/y=1
+
+new "Kill restconf daemon"
+stop_restconf
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
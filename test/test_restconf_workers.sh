@@ -0,0 +1,123 @@
+#!/usr/bin/env bash
+# Restconf with several worker processes (CLICON_RESTCONF_WORKERS)
+# Send requests in parallel and check that all are served correctly
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/example.yang
+
+# Nr of restconf workers
+: ${workers:=4}
+
+# Nr of parallel requests
+: ${nr:=40}
+
+cat <<EOF > $fyang
+module example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_RESTCONF_WORKERS>$workers</CLICON_RESTCONF_WORKERS>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "kill old restconf daemon"
+sudo pkill -u $wwwuser -f clixon_restconf
+
+new "start restconf daemon"
+start_restconf -f $cfg
+
+new "waiting"
+wait_restconf
+
+new "restconf workers started"
+n=$(pgrep -u $wwwuser -f clixon_restconf | wc -l)
+if [ $n -le $workers ]; then
+    err "$workers workers and parent" "$n"
+fi
+
+new "restconf put 42"
+expecteq "$(curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:x/y=42 -d '{"example:y":{"a":"42","b":"42"}}')" 0 ""
+
+new "restconf $nr parallel gets"
+for (( i=0; i<$nr; i++ )); do
+    curl -s -X GET http://localhost/restconf/data/example:x/y=42 > $dir/get$i &
+done
+wait
+for (( i=0; i<$nr; i++ )); do
+    ret=$(cat $dir/get$i)
+    expect='{"example:y":\[{"a":"42","b":"42"}\]}'
+    match=$(echo "$ret" | grep -Eo "$expect")
+    if [ -z "$match" ]; then
+	err "$expect" "$ret"
+    fi
+done
+
+new "restconf $nr parallel puts"
+for (( i=0; i<$nr; i++ )); do
+    curl -s -X PUT -H "Content-Type: application/yang-data+json" http://localhost/restconf/data/example:x/y=$i -d "{\"example:y\":{\"a\":\"$i\",\"b\":\"$i\"}}" > $dir/put$i &
+done
+wait
+
+new "restconf get all entries"
+n=$(curl -s -X GET http://localhost/restconf/data/example:x | grep -o '"a":' | wc -l)
+if [ $n -ne $((nr+1)) ]; then
+    err "$((nr+1))" "$n"
+fi
+
+new "Kill restconf daemon"
+stop_restconf
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
@@ -0,0 +1,177 @@
+#!/usr/bin/env bash
+# Stream publishing to a pub/sub server (CLICON_STREAM_PUB) using a local HTTP stub
+# instead of nginx/nchan. Requires clixon built with --enable-publish and python3.
+# Assumes the Clixon example backend generating an EXAMPLE notification every 5s
+# 1. The stub fails the first posts, which are retried STREAM_PUB_RETRY_S apart
+# 2. Each post is one notification
+# 3. Events are dropped but the backend runs when the stub is gone
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+NCWAIT=10 # Wait (netconf valgrind may need more time)
+
+cfg=$dir/conf.xml
+fyang=$dir/stream.yang
+stub=$dir/stub.py
+posts=$dir/posts
+pport=8089 # Port of pub/sub stub
+
+if ! which python3 > /dev/null; then
+    echo "...skipped: no python3"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+if ! ldd $(which $clixon_backend) | grep -q libcurl; then
+    echo "...skipped: not built with --enable-publish"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+if [ $BE -eq 0 ]; then
+    exit # Backend must be started by this test
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>$dir/backend.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+  <CLICON_STREAM_PUB>http://127.0.0.1:$pport/pub</CLICON_STREAM_PUB>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   notification event {
+      leaf event-class {
+         type string;
+      }
+      container reportingEntity {
+         leaf card {
+            type string;
+         }
+      }
+      leaf severity {
+         type string;
+      }
+   }
+   container state {
+      config false;
+      leaf-list op {
+         type string;
+      }
+   }
+}
+EOF
+
+# Pub/sub stub: fails the first two posts with 500, then logs one line per post:
+#   FAIL <time> <path>  or  OK <time> <path> <nr of notifications> <body>
+cat <<EOF > $stub
+import sys, time
+from http.server import HTTPServer, BaseHTTPRequestHandler
+fails = 2
+class Pub(BaseHTTPRequestHandler):
+    def do_POST(self):
+        global fails
+        body = self.rfile.read(int(self.headers['Content-Length'])).decode()
+        with open("$posts", "a") as f:
+            if fails > 0:
+                fails -= 1
+                f.write("FAIL %f %s\n" % (time.time(), self.path))
+                self.send_response(500)
+            else:
+                f.write("OK %f %s %d %s\n" % (time.time(), self.path,
+                                              body.count("<notification"),
+                                              body.replace("\n", " ")))
+                self.send_response(200)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+    def log_message(self, *args):
+        pass
+HTTPServer(("127.0.0.1", $pport), Pub).serve_forever()
+EOF
+
+rm -f $posts
+new "start pub/sub stub on port $pport"
+python3 $stub &
+stubpid=$!
+sleep 1
+
+new "test params: -f $cfg"
+
+new "kill old backend"
+sudo clixon_backend -zf $cfg
+if [ $? -ne 0 ]; then
+    err
+fi
+new "start backend -s init -f $cfg"
+start_backend -s init -f $cfg
+
+new "waiting"
+wait_backend
+
+new "Wait for events to be published"
+sleep 12
+
+new "Failed posts are retried"
+nr=$(grep -c "^FAIL" $posts)
+if [ $nr -ne 2 ]; then
+    err 2 "$nr"
+fi
+
+new "Retries are at least STREAM_PUB_RETRY_S apart"
+t0=$(grep -m 1 "^FAIL" $posts | awk '{print $2}')
+t1=$(grep -m 1 "^OK" $posts | awk '{print $2}')
+if [ -z "$t1" ]; then
+    err "OK" "$(cat $posts)"
+fi
+if ! python3 -c "import sys; sys.exit(0 if $t1 - $t0 >= 2 else 1)"; then
+    err ">= 2s between first failure and success" "$t0 $t1"
+fi
+
+new "Events are posted to <CLICON_STREAM_PUB>/EXAMPLE"
+nr=$(grep "^OK" $posts | grep -vc " /pub/EXAMPLE ")
+if [ $nr -ne 0 ]; then
+    err 0 "$(cat $posts)"
+fi
+
+new "Each post is one notification"
+nr=$(grep "^OK" $posts | awk '{print $4}' | grep -vc "^1$")
+if [ $nr -ne 0 ]; then
+    err 0 "$(cat $posts)"
+fi
+
+new "Two events published"
+nr=$(grep -c "^OK.*<event xmlns=\"urn:example:clixon\"><event-class>fault</event-class>" $posts)
+if [ $nr -lt 2 ]; then
+    err 2 "$nr"
+fi
+
+new "Stop pub/sub stub"
+kill $stubpid
+wait $stubpid 2> /dev/null
+
+new "Wait for events to be dropped"
+sleep 10
+
+new "Backend runs when events cannot be published"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><ping xmlns="http://clicon.org/lib"/></rpc>]]>]]>' '^<rpc-reply><ok/></rpc-reply>]]>]]>$'
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+rm -rf $dir
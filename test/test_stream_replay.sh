@@ -0,0 +1,112 @@
+#!/usr/bin/env bash
+# Stream replay log in segment files (CLICON_STREAM_REPLAY_DIR)
+# Events are stored in mmap:ed segment files and replayed after backend restart.
+# Assumes the Clixon example backend generating an EXAMPLE notification every 5s
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+NCWAIT=10 # Wait (netconf valgrind may need more time)
+
+cfg=$dir/conf.xml
+fyang=$dir/stream.yang
+replaydir=$dir/replay
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>$dir/backend.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+  <CLICON_STREAM_RETENTION>60</CLICON_STREAM_RETENTION>
+  <CLICON_STREAM_REPLAY_DIR>$replaydir</CLICON_STREAM_REPLAY_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   notification event {
+      leaf event-class {
+         type string;
+      }
+      container reportingEntity {
+         leaf card {
+            type string;
+         }
+      }
+      leaf severity {
+         type string;
+      }
+   }
+   container state {
+      config false;
+      leaf-list op {
+         type string;
+      }
+   }
+}
+EOF
+
+mkdir -p $replaydir
+sudo chmod 777 $replaydir
+
+new "test params: -f $cfg"
+
+if [ $BE -eq 0 ]; then
+    exit # Backend must be restarted by this test
+fi
+
+new "kill old backend"
+sudo clixon_backend -zf $cfg
+if [ $? -ne 0 ]; then
+    err
+fi
+new "start backend -s init -f $cfg"
+start_backend -s init -f $cfg
+
+new "waiting"
+wait_backend
+
+# Start time before any event is generated
+START=$(date -u +"%Y-%m-%dT%H:%M:%SZ")
+
+new "Wait for events to be logged"
+sleep 11
+
+new "Replay segment file created"
+if [ -z "$(ls $replaydir/EXAMPLE-*.replay 2> /dev/null)" ]; then
+    err "$replaydir/EXAMPLE-*.replay" "no segment file"
+fi
+
+new "Kill backend"
+stop_backend -f $cfg
+
+new "Restart backend -s running -f $cfg"
+start_backend -s running -f $cfg
+
+new "waiting"
+wait_backend
+
+new "netconf EXAMPLE replay after restart"
+expectwait "$clixon_netconf -qf $cfg" "<rpc><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><startTime>$START</startTime></create-subscription></rpc>]]>]]>" '^<rpc-reply><ok/></rpc-reply>]]>]]><notification xmlns="urn:ietf:params:xml:ns:netconf:notification:1.0"><eventTime>20' 1
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+sudo rm -rf $replaydir
+rm -rf $dir
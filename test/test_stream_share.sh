@@ -0,0 +1,258 @@
+#!/usr/bin/env bash
+# Restconf stream subscribers served in-process, using a FastCGI client on the
+# restconf FastCGI socket instead of a webserver. Requires python3.
+# Events are datastore changes on the CLIXON stream (CLICON_XMLDB_CHANGE_STREAM)
+# 1. Subscribers of the same user, stream and filter share one backend session
+# 2. Subscribers of different users have different backend sessions
+# 3. Closing one subscriber does not affect another
+# 4. An aborted request (FCGI_ABORT_REQUEST) is ended gracefully
+# 5. A subscriber that does not read is dropped (CLICON_RESTCONF_STREAM_QUEUE_MAX)
+#    while another subscriber gets all events
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/share.yang
+fcgi=$dir/fcgi.py
+fcgisock=/www-data/fastcgi_restconf.sock # default CLICON_RESTCONF_PATH
+
+# Number of commits in slow subscriber test
+: ${perfnr:=1000}
+
+if ! which python3 > /dev/null; then
+    echo "...skipped: no python3"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+if [ $BE -eq 0 ]; then
+    exit # Backend must be started by this test
+fi
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_RESTCONF_DIR>/usr/local/lib/$APPNAME/restconf</CLICON_RESTCONF_DIR>
+  <CLICON_RESTCONF_WORKERS>1</CLICON_RESTCONF_WORKERS>
+  <CLICON_RESTCONF_STREAM_QUEUE_MAX>4096</CLICON_RESTCONF_STREAM_QUEUE_MAX>
+  <CLICON_BACKEND_CLIENT_STATE>true</CLICON_BACKEND_CLIENT_STATE>
+  <CLICON_XMLDB_CHANGE_STREAM>true</CLICON_XMLDB_CHANGE_STREAM>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module share{
+  yang-version 1.1;
+  namespace "urn:example:share";
+  prefix sh;
+  container x{
+    leaf y{
+      type string;
+    }
+  }
+}
+EOF
+
+# FastCGI stream subscriber: fcgi.py <socket> <uri> <user> <seconds> <mode>
+# mode read:   read events during seconds, then close
+#      noread: do not read during seconds, then read what is left
+#      abort:  read events during seconds, then abort request, read until end
+# Prints nr of running datastore-change events and state: end (END_REQUEST),
+# eof (closed without END_REQUEST) or open
+cat <<EOF > $fcgi
+import socket, struct, sys, time, select, base64
+sock, uri, user, secs, mode = sys.argv[1], sys.argv[2], sys.argv[3], float(sys.argv[4]), sys.argv[5]
+def rec(t, c=b""):
+    return struct.pack("!BBHHBB", 1, t, 1, len(c), 0, 0) + c
+def nv(n, v):
+    return bytes([len(n), len(v)]) + n.encode() + v.encode()
+auth = "Basic " + base64.b64encode((user + ":bar").encode()).decode()
+params = (nv("REQUEST_METHOD", "GET") + nv("REQUEST_URI", uri) +
+          nv("DOCUMENT_URI", uri) + nv("QUERY_STRING", "") +
+          nv("HTTP_ACCEPT", "text/event-stream") + nv("HTTP_AUTHORIZATION", auth))
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.connect(sock)
+s.sendall(rec(1, struct.pack("!HB5x", 1, 0)) + rec(4, params) + rec(4) + rec(5))
+buf = b""
+out = b""
+state = "open"
+def readfor(secs):
+    global buf, out, state
+    end = time.time() + secs
+    while state == "open" and time.time() < end:
+        r, w, e = select.select([s], [], [], end - time.time())
+        if not r:
+            break
+        d = s.recv(65536)
+        if not d:
+            state = "eof"
+            break
+        buf += d
+        while len(buf) >= 8:
+            v, t, i, clen, plen, x = struct.unpack("!BBHHBB", buf[:8])
+            if len(buf) < 8 + clen + plen:
+                break
+            if t == 6:
+                out += buf[8:8+clen]
+            elif t == 3:
+                state = "end"
+            buf = buf[8+clen+plen:]
+if mode == "noread":
+    time.sleep(secs)
+    readfor(5)
+else:
+    readfor(secs)
+    if mode == "abort":
+        s.sendall(rec(2))
+        readfor(5)
+print(out.count(b"<datastore>running</datastore>"), state)
+EOF
+
+# Start a FastCGI subscriber of the CLIXON stream in background
+# Args: 1: user 2: seconds 3: mode 4: output file
+subscribe(){
+    sudo -u $wwwuser python3 $fcgi $fcgisock /streams/CLIXON $1 $2 $3 > $4 &
+}
+
+# Number of backend client sessions, including the netconf session asking
+nclients(){
+    echo "<rpc><get><filter type='xpath' select=\"/cl:backend-clients/cl:client\" xmlns:cl='http://clicon.org/lib'/></get></rpc>]]>]]>" | $clixon_netconf -qf $cfg | grep -o "<client>" | wc -l
+}
+
+# Commit changes of running, one datastore change event each
+# Args: 1: first value 2: number of commits
+commits(){
+    for (( i=$1; i<$1+$2; i++ )); do
+	echo "<rpc><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:share\"><y>$i</y></x></config></edit-config></rpc>]]>]]>"
+	echo "<rpc><commit/></rpc>]]>]]>"
+    done | $clixon_netconf -qf $cfg > /dev/null
+}
+
+# Check number of backend client sessions
+# Args: 1: expected number
+checkclients(){
+    nr=$(nclients)
+    if [ $nr -ne $1 ]; then
+	err "$1" "$nr"
+    fi
+}
+
+# Check output of a subscriber
+# Args: 1: output file 2: expected output (regexp)
+checksub(){
+    ret=$(cat $1)
+    match=$(echo "$ret" | grep -Eo "$2")
+    if [ -z "$match" ]; then
+	err "$2" "$ret"
+    fi
+}
+
+new "test params: -f $cfg"
+new "kill old backend"
+sudo clixon_backend -zf $cfg
+if [ $? -ne 0 ]; then
+    err
+fi
+new "start backend -s init -f $cfg"
+start_backend -s init -f $cfg
+
+new "waiting"
+wait_backend
+
+new "kill old restconf daemon"
+sudo pkill -u $wwwuser -f clixon_restconf
+
+new "start restconf daemon (-a is enable http basic auth)"
+start_restconf -f $cfg -- -a
+
+new "waiting"
+sleep $RCWAIT
+
+new "No stream subscriptions"
+checkclients 1
+
+new "Two subscribers of andy"
+subscribe andy 6 read $dir/a1
+subscribe andy 12 read $dir/a2
+sleep 2
+
+new "Subscribers of same user and stream share one backend session"
+checkclients 2
+
+new "Subscriber of wilma"
+subscribe wilma 10 read $dir/w
+sleep 1
+
+new "Subscribers of different users have different backend sessions"
+checkclients 3
+
+new "Commit a change"
+commits 0 1
+sleep 4 # First andy subscriber closes
+
+new "First andy subscriber got event and closed"
+checksub $dir/a1 "^1 open$"
+
+new "Backend session shared with closed subscriber remains"
+checkclients 3
+
+new "Commit another change"
+commits 1 1
+sleep 6 # Other subscribers close
+
+new "Second andy subscriber got both events"
+checksub $dir/a2 "^2 open$"
+
+new "wilma subscriber got both events"
+checksub $dir/w "^2 open$"
+
+new "Backend sessions closed with subscribers"
+checkclients 1
+
+new "Aborted subscriber ends request"
+subscribe andy 2 abort $dir/b
+sleep 4
+checksub $dir/b "^0 end$"
+
+new "Subscriber reading and subscriber not reading"
+subscribe andy 60 read $dir/r
+rpid=$!
+subscribe andy 30 noread $dir/s
+spid=$!
+sleep 1
+
+new "Commit $perfnr changes"
+commits 2 $perfnr
+
+new "Wait for not reading subscriber"
+wait $spid
+
+new "Subscriber not reading is dropped"
+checksub $dir/s "^[0-9]* eof$"
+nr=$(cut -d' ' -f1 $dir/s)
+if [ $nr -ge $perfnr ]; then
+    err "< $perfnr" "$nr"
+fi
+
+new "Reading subscriber got all events"
+wait $rpid
+checksub $dir/r "^$perfnr open$"
+
+new "Kill restconf daemon"
+stop_restconf
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+stop_backend -f $cfg
+
+rm -rf $dir
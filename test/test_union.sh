@@ -47,6 +47,15 @@ module example3{
   typedef t{
     type string;
   }
+  typedef nu{
+     description "nested union with a pattern member";
+     type union {
+       type u;
+       type string{
+          pattern '[a-z]+';
+       }
+     }
+  }
 }
 EOF
 cat <<EOF > $fyang2
@@ -61,6 +70,9 @@ module example2{
     leaf ulle{
       type ex3:u;
     }
+    leaf nulle{
+      type ex3:nu;
+    }
   }
 }
 EOF
@@ -101,6 +113,26 @@ expectfn "$clixon_cli -1f $cfg -l o set c ulle 33" 0 "^$"
 new "cli set transitive union error"
 expectfn "$clixon_cli -1f $cfg -l o set c ulle kalle" 255 "^CLI syntax error: \"set c ulle kalle\": 'kalle' is not a number$"
 
+# Nested unions are resolved once and then validated using the type cache
+# Values matching different members are validated several times since
+# members are reordered by match frequency
+for v in 33 unbounded abc 4 xyz; do
+    new "netconf set nested union $v"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><nulle>$v</nulle></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate nested union $v"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+done
+
+new "netconf set nested union invalid"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><c xmlns="urn:example:clixon"><nulle>ABC</nulle></c></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf validate nested union should fail with reason of last member"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>nulle</bad-element></error-info><error-severity>error</error-severity><error-message>regexp match fail:"
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><discard-changes/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
 if [ $BE -eq 0 ]; then
     exit # BE
 fi
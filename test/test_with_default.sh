@@ -3,11 +3,15 @@
 # Test what clixon has
 # These are the modes defined in RFC 6243:
 # o  report-all
-# (o  report-all-tagged)
+# o  report-all-tagged
 # o  trim
 # o  explicit
-# Clixon supports explicit, bit the testcases define the other cases as well
-# in case others will be supported
+# Clixon get and get-config use report-all by default. Default values are
+# not stored in the datastore, they are added when replying according to the
+# RFC 6243 <with-defaults> parameter, (Clixon extension) with-defaults attribute,
+# or RFC 8040 with-defaults query parameter.
+# The typedef default in container c is not supported, only the leaf default in
+# container d.
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -32,7 +36,8 @@ cat <<EOF > $cfg
   <CLICON_RESTCONF_DIR>/usr/local/lib/$APPNAME/restconf</CLICON_RESTCONF_DIR>
   <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
   <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
-  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
   <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
   <CLICON_CLI_GENMODEL_COMPLETION>1</CLICON_CLI_GENMODEL_COMPLETION>
   <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
@@ -60,6 +65,23 @@ cat <<EOF > $fyang
           }
         }
       }
+      container d{
+        list x {
+          key k;
+          leaf k{
+            type string;
+          }
+          leaf y {
+            type int32;
+            default 42;
+          }
+          leaf z {
+            /* Only valid if y is 42, also if y is not set */
+            when "../y = 42";
+            type string;
+          }
+        }
+      }
    }
 EOF
 
@@ -105,6 +127,84 @@ expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></
 new "Check config (Clixon supports explicit)"
 expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>' "^<rpc-reply><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
 
+# Same as above but with leaf default in container d
+XML='<d xmlns="urn:example:default"><x><k>default</k><y>42</y></x><x><k>notset</k></x><x><k>other</k><y>99</y></x></d>'
+REPORT_ALL='<d xmlns="urn:example:default"><x><k>default</k><y>42</y></x><x><k>notset</k><y>42</y></x><x><k>other</k><y>99</y></x></d>'
+TRIM='<d xmlns="urn:example:default"><x><k>default</k></x><x><k>notset</k></x><x><k>other</k><y>99</y></x></d>'
+EXPLICIT='<d xmlns="urn:example:default"><x><k>default</k><y>42</y></x><x><k>notset</k></x><x><k>other</k><y>99</y></x></d>'
+
+new "Set leaf defaults"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config>$XML</config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Check config default report-all"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/></get-config></rpc>]]>]]>' "^<rpc-reply><data>$REPORT_ALL</data></rpc-reply>]]>]]>$"
+
+new "Check config report-all"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config with-defaults="report-all"><source><candidate/></source><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/></get-config></rpc>]]>]]>' "^<rpc-reply><data>$REPORT_ALL</data></rpc-reply>]]>]]>$"
+
+new "Check config trim"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config with-defaults="trim"><source><candidate/></source><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/></get-config></rpc>]]>]]>' "^<rpc-reply><data>$TRIM</data></rpc-reply>]]>]]>$"
+
+new "Check config explicit"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config with-defaults="explicit"><source><candidate/></source><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/></get-config></rpc>]]>]]>' "^<rpc-reply><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
+
+new "Check config invalid with-defaults"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config with-defaults="foo"><source><candidate/></source></get-config></rpc>]]>]]>' "^<rpc-reply><rpc-error><error-type>application</error-type><error-tag>bad-attribute</error-tag><error-info><bad-attribute>with-defaults</bad-attribute></error-info><error-severity>error</error-severity><error-message>Unrecognized value of with-defaults attribute</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+new "Check config RFC 6243 trim"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/><with-defaults xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults">trim</with-defaults></get-config></rpc>]]>]]>' "^<rpc-reply><data>$TRIM</data></rpc-reply>]]>]]>$"
+
+new "Check config RFC 6243 explicit"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/><with-defaults xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults">explicit</with-defaults></get-config></rpc>]]>]]>' "^<rpc-reply><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
+
+# report-all-tagged: as report-all, but leafs with default value are tagged
+WD='xmlns:wd="urn:ietf:params:xml:ns:netconf:default:1.0" wd:default="true"'
+TAGGED="<d xmlns=\"urn:example:default\"><x><k>default</k><y $WD>42</y></x><x><k>notset</k><y $WD>42</y></x><x><k>other</k><y>99</y></x></d>"
+
+new "Check get RFC 6243 report-all-tagged"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/><with-defaults xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults">report-all-tagged</with-defaults></get></rpc>]]>]]>' "^<rpc-reply><data>$TAGGED</data></rpc-reply>]]>]]>$"
+
+new "Check config RFC 6243 invalid with-defaults"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><with-defaults xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults">foo</with-defaults></get-config></rpc>]]>]]>' "^<rpc-reply><rpc-error><error-type>application</error-type>"
+
+new "Check xpath of default value"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/ex:d/ex:x[ex:y=42]/ex:k" xmlns:ex="urn:example:default"/></get-config></rpc>]]>]]>' "^<rpc-reply><data><d xmlns=\"urn:example:default\"><x><k>default</k><y>42</y></x><x><k>notset</k><y>42</y></x></d></data></rpc-reply>]]>]]>$"
+
+new "Set z when y has default value"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><d xmlns=\"urn:example:default\"><x><k>notset</k><z>foo</z></x></d></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Validate when of default value"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "kill old restconf daemon"
+sudo pkill -u $wwwuser -f clixon_restconf
+
+new "start restconf daemon"
+start_restconf -f $cfg
+
+new "waiting"
+wait_restconf
+
+new "restconf with-defaults=trim"
+expectpart "$(curl -si -X GET -H 'Accept: application/yang-data+xml' http://localhost/restconf/data/example-default:d/x=notset?with-defaults=trim)" 0 "HTTP/1.1 200 OK" '<x xmlns="urn:example:default"><k>notset</k><z>foo</z></x>'
+
+new "restconf with-defaults=report-all"
+expectpart "$(curl -si -X GET -H 'Accept: application/yang-data+xml' http://localhost/restconf/data/example-default:d/x=default?with-defaults=report-all)" 0 "HTTP/1.1 200 OK" '<x xmlns="urn:example:default"><k>default</k><y>42</y></x>'
+
+new "restconf with-defaults=report-all-tagged xml"
+expectpart "$(curl -si -X GET -H 'Accept: application/yang-data+xml' http://localhost/restconf/data/example-default:d/x=notset?with-defaults=report-all-tagged)" 0 "HTTP/1.1 200 OK" "<x xmlns=\"urn:example:default\"><k>notset</k><y $WD>42</y><z>foo</z></x>"
+
+new "restconf with-defaults=report-all-tagged json"
+expectpart "$(curl -si -X GET -H 'Accept: application/yang-data+json' http://localhost/restconf/data/example-default:d/x=notset?with-defaults=report-all-tagged)" 0 "HTTP/1.1 200 OK" '{"example-default:x":\[{"k":"notset","y":42,"@y":{"ietf-netconf-with-defaults:default":true},"z":"foo"}\]}'
+
+new "restconf invalid with-defaults"
+expectpart "$(curl -si -X GET -H 'Accept: application/yang-data+xml' http://localhost/restconf/data/example-default:d?with-defaults=foo)" 0 "HTTP/1.1 400 Bad Request" "<error-tag>bad-attribute</error-tag>"
+
+new "Kill restconf daemon"
+stop_restconf
 
 if [ $BE -eq 0 ]; then
     exit # BE
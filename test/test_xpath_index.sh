@@ -0,0 +1,135 @@
+#!/usr/bin/env bash
+# Element-name index of datastores (CLICON_XMLDB_INDEX)
+# XPath descendant steps, eg //y, are evaluated using the index.
+# Check results with and without index, and that the index follows edits
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in datastore
+: ${perfnr:=1000}
+
+# Number of requests made
+: ${perfreq:=100}
+
+APPNAME=example
+
+cfg=$dir/config.xml
+fyang=$dir/index.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module index{
+  yang-version 1.1;
+  namespace "urn:example:index";
+  prefix ix;
+  container x{
+     list y {
+        key a;
+        leaf a{
+          type string;
+        }
+        leaf b{
+          type string;
+        }
+        container z{
+          leaf b{
+            type string;
+          }
+        }
+     }
+  }
+}
+EOF
+
+# Generate config with $perfnr list entries
+echo -n "<rpc><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:index\">" > $fconfig
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>$i</b></y>" >> $fconfig
+done
+echo "</x></config></edit-config></rpc>]]>]]>" >> $fconfig
+
+# Run tests with index enabled or disabled
+# Args:
+# 1: true/false
+testrun(){
+    index=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_XMLDB_INDEX>$index</CLICON_XMLDB_INDEX>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    new "netconf write large config"
+    expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf get-config //y index:$index"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"//ix:y[ix:a='42']\" xmlns:ix='urn:example:index'/></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:index"><y><a>42</a><b>42</b></y></x></data></rpc-reply>]]>]]>$'
+
+    new "netconf get-config //b index:$index"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"//ix:b[.='7']\" xmlns:ix='urn:example:index'/></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:index"><y><a>7</a><b>7</b></y></x></data></rpc-reply>]]>]]>$'
+
+    new "netconf get-config descendant of list entry index:$index"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/ix:x/ix:y[ix:a='8']//ix:b\" xmlns:ix='urn:example:index'/></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:index"><y><a>8</a><b>8</b></y></x></data></rpc-reply>]]>]]>$'
+
+    new "netconf get-config wrong namespace index:$index"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"//xx:y\" xmlns:xx='urn:example:xx'/></get-config></rpc>]]>]]>" '^<rpc-reply><data/></rpc-reply>]]>]]>$'
+
+    new "netconf add nested b index:$index"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><x xmlns='urn:example:index'><y><a>9</a><z><b>99</b></z></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf get-config added nested b index:$index"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"//ix:b[.='99']\" xmlns:ix='urn:example:index'/></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:index"><y><a>9</a><z><b>99</b></z></y></x></data></rpc-reply>]]>]]>$'
+
+    new "netconf delete entry index:$index"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><default-operation>none</default-operation><config><x xmlns='urn:example:index' xmlns:nc='urn:ietf:params:xml:ns:netconf:base:1.0'><y nc:operation='delete'><a>42</a></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf get-config deleted entry index:$index"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"//ix:y[ix:a='42']\" xmlns:ix='urn:example:index'/></get-config></rpc>]]>]]>" '^<rpc-reply><data/></rpc-reply>]]>]]>$'
+
+    new "netconf get-config $perfreq //y reqs index:$index"
+    { time -p for (( i=0; i<$perfreq; i++ )); do
+	rnd=$(( ( RANDOM % $perfnr ) ))
+	echo "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"//ix:y[ix:a='$rnd']\" xmlns:ix='urn:example:index'/></get-config></rpc>]]>]]>"
+    done | $clixon_netconf -qf $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+    if [ $BE -eq 0 ]; then
+	return
+    fi
+
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+}
+
+testrun false
+testrun true
+
+rm -rf $dir
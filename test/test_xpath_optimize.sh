@@ -0,0 +1,170 @@
+#!/usr/bin/env bash
+# XPATH list and leaf-list lookup optimization (XPATH_LIST_OPTIMIZE)
+# Each xpath is evaluated with and without optimization, the results must be
+# equal. Also check the number of result nodes and if the optimization is used.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xpath:=clixon_util_xpath}
+
+xml=$dir/xml.xml
+fyang=$dir/example.yang
+
+cat <<EOF > $fyang
+module example{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container c {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf b {
+        type string;
+      }
+    }
+    list z {
+      key "k1 k2";
+      leaf k1 {
+        type string;
+      }
+      leaf k2 {
+        type uint32;
+      }
+      leaf v {
+        type string;
+      }
+    }
+    leaf-list ll {
+      type string;
+    }
+    leaf-list nl {
+      type int32;
+    }
+    list u {
+      key "a";
+      ordered-by user;
+      leaf a {
+        type string;
+      }
+    }
+    list r {
+      key "name";
+      leaf name {
+        type string;
+      }
+      leaf ref {
+        type leafref {
+          path "../../y/a";
+        }
+      }
+    }
+  }
+}
+EOF
+
+echo -n '<c xmlns="urn:example:clixon">' > $xml
+for (( i=1; i<=20; i++ )); do
+    echo -n "<y><a>$i</a><b>b$i</b></y>" >> $xml
+done
+for k1 in a b c; do
+    for k2 in 1 2 10; do
+	echo -n "<z><k1>$k1</k1><k2>$k2</k2><v>$k1$k2</v></z>" >> $xml
+    done
+done
+echo -n '<ll>x</ll><ll>y</ll><ll>zz</ll>' >> $xml
+echo -n '<nl>1</nl><nl>2</nl><nl>10</nl>' >> $xml
+echo -n '<u><a>c</a></u><u><a>a</a></u><u><a>b</a></u>' >> $xml
+echo -n '<r><name>r1</name><ref>3</ref></r><r><name>r2</name><ref>7</ref></r>' >> $xml
+echo '</c>' >> $xml
+
+# Evaluate xpath with and without optimization and compare
+# Args:
+# 1: xpath
+# 2: Expected number of nodes in result, or "*" to skip check
+# 3: 1 if optimization is used, 0 if not
+# 4: Extra options, eg initial xpath or namespace context
+testxpath(){
+    xp=$1
+    nr=$2
+    hit=$3
+    opts=$4
+    new "xpath optimize $opts $xp"
+    ref=$($clixon_util_xpath -X -f $xml -y $fyang $opts -p "$xp" 2> /dev/null)
+    if [ -z "$ref" ]; then
+	err "result" "$ref"
+    fi
+    ret=$($clixon_util_xpath -f $xml -y $fyang $opts -p "$xp" 2> /dev/null)
+    if [ "$ret" != "$ref" ]; then
+	err "$ref" "$ret"
+    fi
+    if [ "$nr" != "*" ]; then
+	n=$(echo "$ret" | grep -o "[0-9]*:<[a-z]" | wc -l)
+	if [ $n -ne $nr ]; then
+	    err "$nr nodes" "$n"
+	fi
+    fi
+    n=$($clixon_util_xpath -D 1 -f $xml -y $fyang $opts -p "$xp" 2>&1 > /dev/null | grep -o "optimize hits: [0-9]*" | grep -o "[0-9]*$")
+    if [ $hit -eq 0 -a "$n" != "0" ]; then
+	err "no optimization" "hits: $n"
+    fi
+    if [ $hit -ne 0 -a "$n" = "0" ]; then
+	err "optimization" "hits: $n"
+    fi
+}
+
+# Single key
+testxpath "c/y[a='3']" 1 1
+testxpath "c/y[a='99']" 0 1
+testxpath "c/y['3'=a]" 1 1
+testxpath "c/y[a='3']/b" 1 1
+testxpath "c/y[a=3]" 1 0
+testxpath "c/y[b='b3']" 1 0
+testxpath "c/y[a='3'][b='b3']" 1 1
+testxpath "c/y[a='3'][b='x']" 0 1
+testxpath "c/y[b='b3'][a='3']" 1 1
+testxpath "c/y[a='3' and b='b3']" 1 1
+testxpath "c/y[a='3' or a='4']" 2 0
+testxpath "c/y[a!='3']" 19 0
+testxpath "c/y[a='1'][1]" "*" 1
+testxpath "c/y[1][a='1']" "*" 0
+testxpath "count(c/y[a='3'])" "*" 1
+
+# Multiple keys, full and partial
+testxpath "c/z[k1='b']" 3 1
+testxpath "c/z[k1='b'][k2=2]" 1 1
+testxpath "c/z[k1='b'][k2='2']" 1 1
+testxpath "c/z[k2=2][k1='c']" 1 1
+testxpath "c/z[k1='b' and k2=10]" 1 1
+testxpath "c/z[k1='b'][k2=7]" 0 1
+testxpath "c/z[k1='b'][k2='x']" 0 1
+testxpath "c/z[k2=2]" 3 0
+testxpath "c/z[k1='a'][v='a10']" 1 1
+
+# Leaf-lists
+testxpath "c/ll[.='y']" 1 1
+testxpath "c/ll[.='q']" 0 1
+testxpath "c/nl[.=10]" 1 1
+testxpath "c/nl[.='10']" 1 1
+
+# Ordered-by user is not sorted
+testxpath "c/u[a='a']" 1 0
+
+# Absolute and current() relative values (leafref)
+testxpath "c/r[name='r1']/ref" 1 1
+testxpath "c/y[a=current()/c/r[name='r1']/ref]" 1 1
+testxpath "c/y[a=/c/r[name='r2']/ref]" 1 1
+testxpath "c/y[a=/c/r/ref]" 2 0
+testxpath "c/y[a=/c/nonexist]" 0 1
+testxpath "../y[a=current()/ref]" 1 1 "-i /c/r[name='r1']"
+testxpath "../y[a=current()/name]" 0 1 "-i /c/r[name='r1']"
+
+# Namespace context
+testxpath "ex:c/ex:y[ex:a='3']" 1 1 "-n ex:urn:example:clixon"
+testxpath "ex:c/ex:y[a='3']" 0 1 "-n ex:urn:example:clixon"
+testxpath "c/y[a='3']" 1 1 "-n null:urn:example:clixon"
+
+rm -rf $dir
@@ -0,0 +1,141 @@
+#!/usr/bin/env bash
+# Secondary value index of a non-key leaf (CLICON_XMLDB_VALUE_INDEX)
+# XPath equality predicates on the leaf are looked up in the index.
+# Check that the index follows edits, and datastore-index state
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in datastore
+: ${perfnr:=1000}
+
+# Number of requests made
+: ${perfreq:=100}
+
+APPNAME=example
+
+cfg=$dir/config.xml
+fyang=$dir/vindex.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_XMLDB_VALUE_INDEX>/vi:x/vi:y/vi:b</CLICON_XMLDB_VALUE_INDEX>
+  <CLICON_XMLDB_VALUE_INDEX>/vi:x/vi:y/vi:a</CLICON_XMLDB_VALUE_INDEX>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module vindex{
+  yang-version 1.1;
+  namespace "urn:example:vindex";
+  prefix vi;
+  container x{
+     list y {
+        key a;
+        leaf a{
+          type int32;
+        }
+        leaf b{
+          type string;
+        }
+     }
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "generate config with $perfnr list entries"
+echo -n "<rpc><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:vindex\">" > $fconfig
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>v$(( i % 10 ))</b></y>" >> $fconfig
+done
+echo "</x></config></edit-config></rpc>]]>]]>" >> $fconfig
+
+new "netconf write large config"
+expecteof_file "$clixon_netconf -qf $cfg" 0 "$fconfig" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config b=v3 count"
+ret=$(echo "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v3']\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg)
+nr=$(echo "$ret" | grep -o "<b>v3</b>" | wc -l)
+if [ $nr -ne $(( perfnr / 10 )) ]; then
+    err "$(( perfnr / 10 ))" "$nr"
+fi
+
+new "netconf get-config b=v3 and a"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v3' and vi:a=13]\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:vindex"><y><a>13</a><b>v3</b></y></x></data></rpc-reply>]]>]]>$'
+
+new "netconf get-config no match"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v42']\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>" '^<rpc-reply><data/></rpc-reply>]]>]]>$'
+
+new "netconf change b of entry 13"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><x xmlns='urn:example:vindex'><y><a>13</a><b>v42</b></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config changed value"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v42']\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:vindex"><y><a>13</a><b>v42</b></y></x></data></rpc-reply>]]>]]>$'
+
+new "netconf get-config old value"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v3' and vi:a=13]\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>" '^<rpc-reply><data/></rpc-reply>]]>]]>$'
+
+new "netconf delete entry 13"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><default-operation>none</default-operation><config><x xmlns='urn:example:vindex' xmlns:nc='urn:ietf:params:xml:ns:netconf:base:1.0'><y nc:operation='delete'><a>13</a></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config deleted entry"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v42']\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>" '^<rpc-reply><data/></rpc-reply>]]>]]>$'
+
+new "netconf remove b of entry 14"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><default-operation>none</default-operation><config><x xmlns='urn:example:vindex' xmlns:nc='urn:ietf:params:xml:ns:netconf:base:1.0'><y><a>14</a><b nc:operation='delete'/></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config removed value"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v4' and vi:a=14]\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>" '^<rpc-reply><data/></rpc-reply>]]>]]>$'
+
+new "netconf commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config running b=v5"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><running/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v5' and vi:a=25]\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>" '^<rpc-reply><data><x xmlns="urn:example:vindex"><y><a>25</a><b>v5</b></y></x></data></rpc-reply>]]>]]>$'
+
+# One entry deleted and one b removed, a key leaf is not indexed
+new "netconf get datastore-index state"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get><filter type='xpath' select=\"/cl:datastore-index\" xmlns:cl='http://clicon.org/lib'/></get></rpc>]]>]]>" "<datastore-index xmlns=\"http://clicon.org/lib\">.*<value-index><datastore>running</datastore><path>/vi:x/vi:y/vi:b</path><entries>$(( perfnr - 2 ))</entries><values>10</values><memory>[0-9]*</memory><lookups>[0-9]*</lookups><updates>[0-9]*</updates></value-index>.*</datastore-index>"
+
+new "netconf get-config $perfreq b reqs"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    rnd=$(( ( RANDOM % 10 ) ))
+    echo "<rpc><get-config><source><candidate/></source><filter type='xpath' select=\"/vi:x/vi:y[vi:b='v$rnd'][1]\" xmlns:vi='urn:example:vindex'/></get-config></rpc>]]>]]>"
+done | $clixon_netconf -qf $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
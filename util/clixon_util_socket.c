@@ -84,7 +84,7 @@ main(int    argc,
     int                logdst = CLICON_LOG_STDERR;
     struct clicon_msg *msg = NULL;
     char              *sockpath = NULL;
-    char              *retdata = NULL;
+    struct clicon_msg *reply = NULL; /* In receive buffer of h, dont free */
     int                jsonin = 0;
     char              *input_filename = NULL;
     int                fd = 0; /* stdin */
@@ -164,13 +164,14 @@ main(int    argc,
     if ((msg = clicon_msg_encode(getpid(), "%s", cbuf_get(cb))) < 0)
 	goto done;
     if (strcmp(family, "UNIX")==0){
-	if (clicon_rpc_connect_unix(h, msg, sockpath, &retdata, NULL) < 0)
+	if (clicon_rpc_connect_unix(h, msg, sockpath, &reply, NULL) < 0)
 	    goto done;
     }
     else
-	if (clicon_rpc_connect_inet(h, msg, sockpath, 4535, &retdata, NULL) < 0)
+	if (clicon_rpc_connect_inet(h, msg, sockpath, 4535, &reply, NULL) < 0)
 	    goto done;
-    fprintf(stdout, "%s\n", retdata);
+    if (reply)
+	fprintf(stdout, "%s\n", reply->op_body);
     retval = 0;
  done:
     if (xerr)
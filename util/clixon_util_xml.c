@@ -52,6 +52,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <sys/time.h>
@@ -74,6 +75,7 @@ usage(char *argv0)
 	    "\t-J \t\tInput as JSON\n"
 	    "\t-j \t\tOutput as JSON\n"
 	    "\t-l <s|e|o> \tLog on (s)yslog, std(e)rr, std(o)ut (stderr is default)\n"
+	    "\t-m \t\tPrint number of nodes and memory usage of the parsed tree\n"
 	    "\t-o \t\tOutput the file\n"
 	    "\t-v \t\tValidate the result in terms of Yang model (requires -y)\n"
 	    "\t-p \t\tPretty-print output\n"
@@ -104,6 +106,11 @@ main(int    argc,
     int           pretty = 0;
     int           validate = 0;
     int           output = 0;
+    int           memory = 0;
+    uint64_t      nr;
+    size_t        sz;
+    uint64_t      nrnames;
+    size_t        sznames;
     clicon_handle h;
     struct stat   st;
     int           fd = 0; /* stdin */
@@ -120,7 +127,7 @@ main(int    argc,
     clicon_conf_xml_set(h, xcfg);
     optind = 1;
     opterr = 0;
-    while ((c = getopt(argc, argv, "hD:f:Jjl:pvoy:Y:")) != -1)
+    while ((c = getopt(argc, argv, "hD:f:Jjl:mpvoy:Y:")) != -1)
 	switch (c) {
 	case 'h':
 	    usage(argv[0]);
@@ -142,6 +149,9 @@ main(int    argc,
 	    if ((logdst = clicon_log_opt(optarg[0])) < 0)
 		usage(argv[0]);
 	    break;
+	case 'm':
+	    memory++;
+	    break;
 	case 'o':
 	    output++;
 	    break;
@@ -243,6 +253,14 @@ main(int    argc,
 	    goto done;
 	}
     }
+    /* Memory usage, names are shared by all nodes */
+    if (memory){
+	xml_stats(xt, &nr, &sz);
+	xml_stats_global(&nrnames, &sznames);
+	fprintf(stdout, "nodes:%" PRIu64 " memory:%zu names:%" PRIu64 " names-memory:%zu per-node:%" PRIu64 "\n",
+		nr, sz, nrnames, sznames, nr?(uint64_t)((sz+sznames)/nr):0);
+	fflush(stdout);
+    }
     /* 4. Output data (xml/json) */
     if (output){
 	xc = NULL;
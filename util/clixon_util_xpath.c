@@ -58,7 +58,7 @@ See https://www.w3.org/TR/xpath/
 #include "clixon/clixon.h"
 
 /* Command line options to be passed to getopt(3) */
-#define XPATH_OPTS "hD:f:p:i:n:cy:Y:x"
+#define XPATH_OPTS "hD:f:p:i:n:cy:Y:xX"
 
 static int
 usage(char *argv0)
@@ -75,6 +75,7 @@ usage(char *argv0)
 	    "\t-y <filename> \tYang filename or dir (load all files)\n"
     	    "\t-Y <dir> \tYang dirs (can be several)\n"
 	    "\t-x \t\tXPath optimize\n"
+	    "\t-X \t\tDisable XPath list optimization\n"
 	    "and the following extra rules:\n"
 	    "\tif -f is not given, XML input is expected on stdin\n"
 	    "\tif -p is not given, <xpath> is expected as the first line on stdin\n"
@@ -137,6 +138,7 @@ main(int    argc,
     struct stat st;
     cvec       *nsc = NULL;
     int         canonical = 0;
+    int         hits = 0;
 
     clicon_log_init("xpath", LOG_DEBUG, CLICON_LOG_STDERR); 
 
@@ -198,9 +200,11 @@ main(int    argc,
 		goto done;
 	    break;
 	case 'x': /* xpath optimize. Only if XPATH_LIST_OPTIMIZE is set */ 
-
 	    xpath_list_optimize_set(1);
 	    break;
+	case 'X': /* disable xpath optimize */ 
+	    xpath_list_optimize_set(0);
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -323,23 +327,11 @@ main(int    argc,
     }
     else
 	x = x0;
-#ifdef XPATH_LIST_OPTIMIZE /* Experimental */
-    {
-	int hits = 0;
-	int j;
-
-	xpath_list_optimize_stats(&hits);
-	for (j=0;j<1;j++){
-	    if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
-		return -1;
-	}
-	xpath_list_optimize_stats(&hits);
-	fprintf(stderr, "hits after:%d\n", hits);
-    }
-#else
+    xpath_list_optimize_stats(&hits); /* reset */
     if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
 	return -1;
-#endif
+    xpath_list_optimize_stats(&hits);
+    clicon_debug(1, "xpath optimize hits: %d", hits);
     /* Print results */
     cb = cbuf_new();
     ctx_print2(cb, xc);
@@ -0,0 +1,172 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Build the binary yang cache of an application, see CLICON_YANG_CACHE_DIR.
+  * Loads the yang modules of a clixon config file in the same way as the
+  * clixon daemons do, which writes a cache file for every parsed yang file.
+  * Run it again to measure the load time with a warm cache.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <string.h>
+#include <syslog.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon/clixon.h"
+
+/* Command line options to be passed to getopt(3) */
+#define YANG_CACHE_OPTS "hD:f:d:y:"
+
+static int
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+	    "where options are\n"
+            "\t-h \t\tHelp\n"
+    	    "\t-D <level> \tDebug\n"
+	    "\t-f <file> \tClixon config file (mandatory)\n"
+	    "\t-d <dir> \tYang cache directory (override CLICON_YANG_CACHE_DIR)\n"
+	    "\t-y <file> \tYang main file (override CLICON_YANG_MAIN_FILE)\n",
+	    argv0);
+    exit(0);
+}
+
+int
+main(int argc, char **argv)
+{
+    int            retval = -1;
+    clicon_handle  h = NULL;
+    yang_stmt     *yspec = NULL;
+    int            c;
+    char          *argv0 = argv[0];
+    char          *str;
+    yang_stmt     *ym;
+    int            nr = 0;
+    struct timeval t0;
+    struct timeval t1;
+
+    clicon_log_init("clixon_util_yang_cache", LOG_INFO, CLICON_LOG_STDERR); 
+    if ((h = clicon_handle_init()) == NULL)
+	goto done;
+    /* getopt in two steps, first find config-file before over-riding options. */
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, YANG_CACHE_OPTS)) != -1)
+	switch (c) {
+	case 'h':
+	    usage(argv0);
+	    break;
+    	case 'D':
+	    if (sscanf(optarg, "%d", &debug) != 1)
+		usage(argv0);
+	    break;
+	case 'f': /* config file */
+	    if (!strlen(optarg))
+		usage(argv0);
+	    clicon_option_str_set(h, "CLICON_CONFIGFILE", optarg);
+	    break;
+	}
+    clicon_log_init("clixon_util_yang_cache", debug?LOG_DEBUG:LOG_INFO, CLICON_LOG_STDERR); 
+    clicon_debug_init(debug, NULL); 
+    if (clicon_option_str(h, "CLICON_CONFIGFILE") == NULL)
+	usage(argv0);
+    /* Find, read and parse configfile */
+    if (clicon_options_main(h) < 0)
+	goto done;
+    /* Now rest of options */
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, YANG_CACHE_OPTS)) != -1)
+	switch (c) {
+	case 'h': /* fall through */
+	case 'D':
+	case 'f':
+	    break; /* see above */
+	case 'd': /* yang cache dir */
+	    if (clicon_option_str_set(h, "CLICON_YANG_CACHE_DIR", optarg) < 0)
+		goto done;
+	    break;
+	case 'y': /* yang main file */
+	    if (clicon_option_str_set(h, "CLICON_YANG_MAIN_FILE", optarg) < 0)
+		goto done;
+	    break;
+	default:
+	    usage(argv0);
+	    break;
+	}
+    if (clicon_option_str(h, "CLICON_YANG_CACHE_DIR") == NULL){
+	clicon_err(OE_YANG, 0, "No yang cache directory, set CLICON_YANG_CACHE_DIR or use -d");
+	goto done;
+    }
+    if ((yspec = yspec_new()) == NULL)
+	goto done;
+    gettimeofday(&t0, NULL);
+    /* Load yang modules in the same order as the clixon daemons */
+    if ((str = clicon_yang_main_file(h)) != NULL)
+	if (yang_spec_parse_file(h, str, yspec) < 0)
+	    goto done;
+    if ((str = clicon_yang_module_main(h)) != NULL)
+	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
+				   yspec) < 0)
+	    goto done;
+    if ((str = clicon_yang_main_dir(h)) != NULL)
+	if (yang_spec_load_dir(h, str, yspec) < 0)
+	    goto done;
+    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
+	goto done;
+    gettimeofday(&t1, NULL);
+    timersub(&t1, &t0, &t1);
+    ym = NULL;
+    while ((ym = yn_each(yspec, ym)) != NULL)
+	nr++;
+    fprintf(stdout, "%d modules loaded in %ld.%06ld s\n",
+	    nr, (long)t1.tv_sec, (long)t1.tv_usec);
+    retval = 0;
+ done:
+    if (yspec)
+	yspec_free(yspec);
+    if (h)
+	clicon_handle_exit(h);
+    return retval;
+}